@@ -1,3 +1,4 @@
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include <interface.h>
 
@@ -10,6 +11,10 @@ void _setup_gpio() {
     pinMode(UP_BTN, INPUT); // Sets the power btn as an INPUT
     pinMode(SEL_BTN, INPUT);
     pinMode(DW_BTN, INPUT);
+    // every key is a GPIO, the input task sleeps until one changes
+    inputWakeOnPin(UP_BTN);
+    inputWakeOnPin(SEL_BTN);
+    inputWakeOnPin(DW_BTN);
     pinMode(4, OUTPUT);    // Keeps the Stick alive after take off the USB cable
     digitalWrite(4, HIGH); // Keeps the Stick alive after take off the USB cable
     gpio_pulldown_dis(GPIO_NUM_36);
@@ -1,3 +1,4 @@
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include <interface.h>
 
@@ -12,6 +13,12 @@ void _setup_gpio() {
     pinMode(DW_BTN, INPUT);
     pinMode(R_BTN, INPUT);
     pinMode(L_BTN, INPUT);
+    // every key is a GPIO, the input task sleeps until one changes
+    inputWakeOnPin(UP_BTN);
+    inputWakeOnPin(SEL_BTN);
+    inputWakeOnPin(DW_BTN);
+    inputWakeOnPin(R_BTN);
+    inputWakeOnPin(L_BTN);
 
     bruceConfig.colorInverted = 0;
     bruceConfigPins.rotation = 0; // portrait mode for Phantom
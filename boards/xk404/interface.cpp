@@ -1,3 +1,4 @@
+#include "core/input_events.h"
 #include "core/powerSave.h"
 
 /***************************************************************************************
@@ -20,6 +21,12 @@ void _setup_gpio() {
     pinMode(DW_BTN, INPUT);
     pinMode(R_BTN, INPUT);
     pinMode(L_BTN, INPUT);
+    // every key is a GPIO, the input task sleeps until one changes
+    inputWakeOnPin(UP_BTN);
+    inputWakeOnPin(SEL_BTN);
+    inputWakeOnPin(DW_BTN);
+    inputWakeOnPin(R_BTN);
+    inputWakeOnPin(L_BTN);
 
     pinMode(CC1101_SS_PIN, OUTPUT);
     pinMode(NRF24_SS_PIN, OUTPUT);
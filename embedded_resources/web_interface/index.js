@@ -174,6 +174,30 @@ async function requestPost(url, data) {
   });
 }
 
+async function requestBinary(method, url, data, body) {
+  return new Promise((resolve, reject) => {
+    let req = new XMLHttpRequest();
+    let realUrl = url;
+    if (IS_DEV) realUrl = "/bruce" + url;
+    if (data) realUrl += "?" + new URLSearchParams(data).toString();
+    req.open(method, realUrl, true);
+    req.responseType = "arraybuffer";
+    req.onload = () => {
+      if (req.status >= 200 && req.status < 300) {
+        resolve(req);
+      } else if (req.status === 401) {
+        handleAuthError();
+        reject(new Error(`Unauthorized access (401)`));
+      } else {
+        reject(new Error(`Request failed with status ${req.status}`));
+      }
+    };
+    req.onerror = () => reject(new Error("Network error"));
+    if (body !== undefined) req.setRequestHeader("Content-Type", "application/octet-stream");
+    req.send(body);
+  });
+}
+
 function stringToId(str) {
   let hash = 0, i, chr;
   if (str.length === 0) return hash.toString();
@@ -325,9 +349,15 @@ function syncScrolling() {
   lineNumbers.scrollTop = textarea.scrollTop;
 }
 
-function renderFileRow(fileList) {
-  $("table.explorer tbody").innerHTML = "";
-  fileList.split("\n").sort((a, b) => {
+// Returns the cursor of the next page, or null on the last one
+function renderFileRow(fileList, append = false) {
+  let next = null;
+  if (!append) $("table.explorer tbody").innerHTML = "";
+  fileList.split("\n").filter((line) => {
+    if (!line.startsWith("nx:")) return true;
+    next = line.substring(3);
+    return false;
+  }).sort((a, b) => {
     let [aFirst, ...aRest] = a.split(':');
     let [bFirst, ...bRest] = b.split(':');
 
@@ -344,7 +374,7 @@ function renderFileRow(fileList) {
     if (size === undefined) return;
     let dPath = ((currentPath.endsWith("/") ? currentPath : currentPath + "/") + name).replace(/\/\//g, "/");
     if (type === "pa") {
-      if (dPath === "/") return;
+      if (dPath === "/" || append) return;
       e = T.pathRow();
       let preFolder = currentPath.substring(0, currentPath.lastIndexOf('/'));
       if (preFolder === "") preFolder = "/";
@@ -381,8 +411,10 @@ function renderFileRow(fileList) {
     }
     $("table.explorer tbody").appendChild(e);
   });
+  return next;
 }
 
+const FILE_PAGE_SIZE = 200;
 let sdCardAvailable = false;
 let currentDrive;
 let currentPath;
@@ -421,12 +453,33 @@ async function fetchFiles(drive, path) {
   $(`.act-browse.active`)?.classList.remove("active");
   $(`.act-browse[data-drive='${drive}']`).classList.add("active");
   $(".current-path").textContent = drive + ":/" + path;
-  let req = await requestGet("/listfiles", {
+  await fetchFilePage(drive, path, "");
+  btnRefreshFolder.classList.remove("reloading");
+}
+
+// Appends the page of entries after `cursor`, a last row loads the next page
+async function fetchFilePage(drive, path, cursor) {
+  let req = await requestGet("/listpage", {
     fs: drive,
-    folder: path
+    folder: path,
+    sort: "name",
+    limit: FILE_PAGE_SIZE,
+    cursor: cursor
   });
-  renderFileRow(req);
-  btnRefreshFolder.classList.remove("reloading");
+  if (currentDrive !== drive || currentPath !== path) return; // another folder was opened meanwhile
+
+  $(".load-more-row")?.remove();
+  let next = renderFileRow(req, cursor !== "");
+  if (next === null) return;
+
+  let row = document.createElement("tr");
+  row.className = "load-more-row";
+  row.innerHTML = '<td colspan="3" style="text-align:center;cursor:pointer">Load more...</td>';
+  row.addEventListener("click", () => {
+    row.querySelector("td").textContent = "Loading...";
+    fetchFilePage(drive, path, next);
+  }, { once: true });
+  $("table.explorer tbody").appendChild(row);
 }
 
 async function fetchSystemInfo() {
@@ -440,6 +493,35 @@ async function fetchSystemInfo() {
   Dialog.loading.hide();
 }
 
+const EDIT_CHUNK_SIZE = 32 * 1024;
+// Pages the file in by byte ranges, the decoder keeps UTF-8 characters split between two ranges
+async function readEditorFile(drive, file) {
+  let decoder = new TextDecoder();
+  let text = "";
+  let offset = 0;
+  let size = 0;
+  do {
+    let req = await requestBinary("GET", "/fileread", { fs: drive, name: file, offset: offset, length: EDIT_CHUNK_SIZE });
+    size = parseInt(req.getResponseHeader("X-File-Size"), 10) || 0;
+    if (req.response.byteLength === 0) break;
+    text += decoder.decode(req.response, { stream: true });
+    offset += req.response.byteLength;
+  } while (offset < size);
+  return text + decoder.decode();
+}
+
+// Saves in byte chunks to a temp file on the device, the last chunk swaps it with the file
+async function writeEditorFile(drive, file, text) {
+  let data = new TextEncoder().encode(text);
+  let offset = 0;
+  do {
+    let chunk = data.subarray(offset, offset + EDIT_CHUNK_SIZE);
+    let final = offset + chunk.length >= data.length ? 1 : 0;
+    await requestBinary("POST", "/filewrite", { fs: drive, name: file, offset: offset, final: final }, chunk);
+    offset += chunk.length;
+  } while (offset < data.length);
+}
+
 async function saveEditorFile(runFile = false) {
   Dialog.loading.show('Saving...');
   let editor = $(".dialog.editor .file-content");
@@ -447,11 +529,7 @@ async function saveEditorFile(runFile = false) {
   if (isModified(editor)) {
     $(".act-save-edit-file").disabled = true;
     editor.setAttribute("data-hash", calcHash(editor.value));
-    await requestPost("/edit", {
-      fs: currentDrive,
-      name: filename,
-      content: editor.value
-    });
+    await writeEditorFile(currentDrive, filename, editor.value);
   }
 
   if (runFile) {
@@ -917,7 +995,7 @@ $(".container").addEventListener("click", async (e) => {
 
     // Load file content
     Dialog.loading.show('Fetching content...');
-    let r = await requestGet(`/file?fs=${currentDrive}&name=${encodeURIComponent(file)}&action=edit`);
+    let r = await readEditorFile(currentDrive, file);
     editor.value = r;
     editor.setAttribute("data-hash", calcHash(r));
 
@@ -1449,7 +1527,7 @@ window.addEventListener('popstate', (event) => {
           editor.value = "";
 
           Dialog.loading.show('Fetching content...');
-          let r = await requestGet(`/file?fs=${event.state.drive}&name=${encodeURIComponent(event.state.editFile)}&action=edit`);
+          let r = await readEditorFile(event.state.drive, event.state.editFile);
           editor.value = r;
           editor.setAttribute("data-hash", calcHash(r));
 
@@ -1488,7 +1566,7 @@ window.addEventListener('popstate', (event) => {
           editor.value = "";
 
           Dialog.loading.show('Fetching content...');
-          let r = await requestGet(`/file?fs=${drive}&name=${encodeURIComponent(urlParams.editFile)}&action=edit`);
+          let r = await readEditorFile(drive, urlParams.editFile);
           editor.value = r;
           editor.setAttribute("data-hash", calcHash(r));
 
@@ -1544,7 +1622,7 @@ window.addEventListener('popstate', (event) => {
 
         // Load file content
         Dialog.loading.show('Fetching content...');
-        let r = await requestGet(`/file?fs=${currentDrive}&name=${encodeURIComponent(editFile)}&action=edit`);
+        let r = await readEditorFile(currentDrive, editFile);
         editor.value = r;
         editor.setAttribute("data-hash", calcHash(r));
 
@@ -2,6 +2,7 @@
 #define __MENU_ITEM_INTERFACE_H__
 
 #include "core/display.h"
+#include "core/sprite_canvas.h"
 #include <globals.h>
 
 class MenuItemInterface {
@@ -20,31 +21,67 @@ public:
             if (bruceConfig.themePath != "") {
                 // Image is not available for active theme, clear larger area
                 tft.fillRect(0, 27, tftWidth, tftHeight - 27, bruceConfig.bgColor);
+                invalidateCanvases();
+                renderStats.add(tftWidth * (tftHeight - 27));
             }
             drawIcon(scale);
+            renderStats.add(iconAreaW * iconAreaH); // icons clear their area and draw directly
             drawArrows(scale);
             drawTitle(scale);
         } else {
             if (bruceConfig.theme.label)
                 drawTitle(scale); // If using .GIF, labels are draw after complete, which takes some time
             drawIconImg();
+            invalidateCanvases();
             if (bruceConfig.theme.label) drawTitle(scale); // Makes sure to draw over the image
         }
         drawStatusBar();
+        renderStats.endFrame(menuTitleCanvas.isActive());
     }
 
     void drawArrows(float scale = 1) {
-        tft.fillRect(arrowAreaX, iconAreaY, arrowAreaW, iconAreaH, bruceConfig.bgColor);
-        tft.fillRect(
-            tftWidth - arrowAreaX - arrowAreaW, iconAreaY, arrowAreaW, iconAreaH, bruceConfig.bgColor
-        );
-
         int arrowSize = scale * 10;
         int lineWidth = scale * 3;
 
         int arrowX = BORDER_PAD_X + 1.5 * arrowSize;
         int arrowY = iconCenterY + 1.5 * arrowSize;
 
+#ifdef HAS_SCREEN
+        if (menuArrowCanvas.begin(arrowAreaW, iconAreaH)) {
+            // The arrows are the same for every item, only pushed again after being drawn over
+            uint32_t key = canvasKey(&scale, sizeof(scale));
+            key = canvasKey(&iconCenterY, sizeof(iconCenterY), key);
+            key = canvasKey(&bruceConfig.priColor, sizeof(bruceConfig.priColor), key);
+            key = canvasKey(&bruceConfig.bgColor, sizeof(bruceConfig.bgColor), key);
+            if (!menuArrowCanvas.changed(key) && !menuArrowCanvas.isStale()) return;
+
+            TFT_eSprite &s = menuArrowCanvas.sprite();
+            uint16_t fg = bruceConfig.priColor;
+            uint16_t bg = bruceConfig.bgColor;
+            int x = arrowX - arrowAreaX;
+            int y = arrowY - iconAreaY;
+            s.fillSprite(bg);
+            s.drawWideLine(x, y, x + arrowSize, y + arrowSize, lineWidth, fg, bg);
+            s.drawWideLine(x, y, x + arrowSize, y - arrowSize, lineWidth, fg, bg);
+            menuArrowCanvas.damageAll();
+            menuArrowCanvas.flush(arrowAreaX, iconAreaY);
+
+            x = arrowAreaW - x; // mirrored inside the right area
+            s.fillSprite(bg);
+            s.drawWideLine(x, y, x - arrowSize, y + arrowSize, lineWidth, fg, bg);
+            s.drawWideLine(x, y, x - arrowSize, y - arrowSize, lineWidth, fg, bg);
+            menuArrowCanvas.damageAll();
+            menuArrowCanvas.flush(tftWidth - arrowAreaX - arrowAreaW, iconAreaY);
+            return;
+        }
+#endif
+
+        tft.fillRect(arrowAreaX, iconAreaY, arrowAreaW, iconAreaH, bruceConfig.bgColor);
+        tft.fillRect(
+            tftWidth - arrowAreaX - arrowAreaW, iconAreaY, arrowAreaW, iconAreaH, bruceConfig.bgColor
+        );
+        renderStats.add(2 * arrowAreaW * iconAreaH);
+
         // Left Arrow
         tft.drawWideLine(
             arrowX,
@@ -91,9 +128,34 @@ public:
 
         tft.setTextSize(FM);
         tft.drawPixel(0, 0, 0);
-        tft.fillRect(arrowAreaX, titleY, tftWidth - 2 * arrowAreaX, LH * FM, bruceConfig.bgColor);
         int nchars = (tftWidth - 16) / (LW * FM);
+#ifdef HAS_SCREEN
+        if (menuTitleCanvas.begin(tftWidth - 2 * arrowAreaX, LH * FM)) {
+            static int shownWidth = 0; // width of the title on the screen
+            String title = getName().substring(0, nchars);
+            uint32_t key = canvasKey(title.c_str(), title.length());
+            key = canvasKey(&tft.textcolor, sizeof(tft.textcolor), key);
+            key = canvasKey(&bruceConfig.bgColor, sizeof(bruceConfig.bgColor), key);
+            if (menuTitleCanvas.changed(key)) {
+                TFT_eSprite &s = menuTitleCanvas.sprite();
+                int center = iconCenterX - arrowAreaX;
+                int width = title.length() * LW * FM;
+                s.fillSprite(bruceConfig.bgColor);
+                s.setTextSize(FM);
+                s.setTextColor(tft.textcolor, bruceConfig.bgColor);
+                s.drawCentreString(title, center, 0, 1);
+                // Both titles are centered, the wider one covers the other
+                int damaged = max(width, shownWidth);
+                menuTitleCanvas.damage(center - damaged / 2 - FM, 0, damaged + 2 * FM, LH * FM);
+                shownWidth = width;
+            }
+            menuTitleCanvas.flush(arrowAreaX, titleY);
+            return;
+        }
+#endif
+        tft.fillRect(arrowAreaX, titleY, tftWidth - 2 * arrowAreaX, LH * FM, bruceConfig.bgColor);
         tft.drawCentreString(getName().substring(0, nchars), iconCenterX, titleY, 1);
+        renderStats.add((tftWidth - 2 * arrowAreaX) * LH * FM);
     }
 
 protected:
@@ -23,6 +23,8 @@ public:
     virtual void flush() = 0;
 
     virtual int available() = 0;
+    // Next received byte, -1 when nothing is waiting, never blocks
+    virtual int read() = 0;
     virtual String readStringUntil(char terminator);
     virtual ~SerialDevice() = default;
 };
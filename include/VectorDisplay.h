@@ -4,6 +4,8 @@
 #ifndef ARDUINO
 #define NO_SERIAL
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #define pgm_read_byte_near(a) (*(uint8_t *)(a))
 
 #include <string>
@@ -17,6 +19,11 @@ uint32_t millis() {
     return t.millitm + t.time * 1000;
 }
 
+void delay(uint32_t ms) {
+    uint32_t t0 = millis();
+    while (millis() - t0 < ms);
+}
+
 class Print {
 public:
     virtual size_t write(uint8_t c) = 0;
@@ -66,6 +73,13 @@ public:
 #define VECTOR_DISPLAY_SEND_DELAY 0
 #endif
 
+#ifndef VECTOR_DISPLAY_BATCH_SIZE
+#define VECTOR_DISPLAY_BATCH_SIZE 1024 // commands packed into one 'X' frame, bytes before RLE
+#endif
+#define VECTOR_DISPLAY_BATCH_MS 20      // a batch this old goes out with the next command
+#define VECTOR_DISPLAY_ACK_TIMEOUT 500  // per batch, when waitForAck is set
+#define VECTOR_DISPLAY_BATCH_RETRIES 3  // resends of a batch that was not acked
+
 #define TFT_BLACK 0x0000       /*   0,   0,   0 */
 #define TFT_NAVY 0x000F        /*   0,   0, 128 */
 #define TFT_DARKGREEN 0x03E0   /*   0, 128,   0 */
@@ -145,6 +159,37 @@ struct VectorDisplayMessage {
     } data;
 } __attribute__((packed));
 
+/*
+ * Batch frame, sent instead of single commands after setBatching(true):
+ *   'X', 'X' ^ 0xFF, VectorDisplayBatchHeader, payload, CRC-16/CCITT of header and payload
+ * The payload is the usual command stream (c, c ^ 0xFF, arguments, sum ^ 0xFF), where the
+ * record 0x00 n repeats the previous command n more times and 0x01 k sends again the k-th last
+ * command of the batch that was written in full. With VECTOR_DISPLAY_BATCH_RLE set it is
+ * PackBits coded: n < 128 is followed by n + 1 literal bytes, n > 128 by one byte
+ * repeated 257 - n times. The receiver answers "Acknwld" 'X' per batch.
+ */
+#define VECTOR_DISPLAY_BATCH_RLE 1
+#define VECTOR_DISPLAY_BATCH_REPEAT 0x00
+#define VECTOR_DISPLAY_BATCH_REFERENCE 0x01
+#define VECTOR_DISPLAY_BATCH_REFS 32 // commands a reference can reach back
+
+struct VectorDisplayBatchHeader {
+    uint8_t flags;
+    uint16_t commands; // commands in the batch, repeats included
+    uint16_t rawLength; // payload length before RLE
+    uint16_t length;    // payload length as sent
+} __attribute__((packed));
+
+struct VectorDisplayBatchStats {
+    uint32_t commands = 0;  // commands sent, batched or not
+    uint32_t repeats = 0;   // of which sent as a repeat or reference record
+    uint32_t batches = 0;
+    uint32_t rawBytes = 0;  // the same commands without batching
+    uint32_t sentBytes = 0; // written to the remote, resends included
+    uint32_t retries = 0;   // batches sent again after an ack timeout
+    uint32_t lost = 0;      // batches never acked
+};
+
 class VectorDisplayClass : public Print {
 private:
     static const uint32_t MAX_BUFFER = (uint32_t)1024 * 256;
@@ -169,6 +214,7 @@ private:
     bool fixCP437 = true;
     uint16_t polyLineCount;
     uint8_t polyLineSum;
+    bool polyInBatch = false;
     uint32_t delayTime = 0;
 
     uint8_t readBuf[VECTOR_DISPLAY_MESSAGE_SIZE];
@@ -243,6 +289,19 @@ private:
     } args;
     uint32_t lastSend = 0;
 
+    uint8_t *batch = NULL;       // commands of the open batch
+    uint8_t *batchPacked = NULL; // the same after RLE
+    uint16_t batchSize = 0;
+    uint16_t batchLength = 0;
+    uint16_t batchCommands = 0;
+    uint32_t batchStart = 0;
+    uint16_t lastCommandStart = 0; // last command in the batch, what a repeat record repeats
+    uint16_t lastCommandLength = 0;
+    int32_t repeatPos = -1; // count byte of the repeat record after it, -1 when there is none
+    uint16_t literalStart[VECTOR_DISPLAY_BATCH_REFS]; // the last commands sent in full, for references
+    uint16_t literalLength[VECTOR_DISPLAY_BATCH_REFS];
+    uint16_t batchLiterals = 0;
+
 private:
     inline void sendDelay() {
         if (delayTime > 0) {
@@ -251,6 +310,110 @@ private:
         }
     }
 
+    static uint16_t crc16(const void *data, size_t n, uint16_t crc) {
+        const uint8_t *p = (const uint8_t *)data;
+        while (n-- > 0) {
+            crc ^= (uint16_t)*p++ << 8;
+            for (uint8_t i = 0; i < 8; i++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        return crc;
+    }
+
+    // PackBits, `out` needs n + n / 128 + 1 bytes
+    static uint16_t packBits(const uint8_t *in, uint16_t n, uint8_t *out) {
+        uint16_t i = 0, o = 0;
+        while (i < n) {
+            uint16_t run = 1;
+            while (i + run < n && run < 128 && in[i + run] == in[i]) run++;
+            if (run >= 3) {
+                out[o++] = 257 - run;
+                out[o++] = in[i];
+                i += run;
+                continue;
+            }
+            // literals up to the next run of three
+            uint16_t start = i;
+            while (i < n && i - start < 128) {
+                if (i + 2 < n && in[i] == in[i + 1] && in[i] == in[i + 2]) break;
+                i++;
+            }
+            out[o++] = i - start - 1;
+            memcpy(out + o, in + start, i - start);
+            o += i - start;
+        }
+        return o;
+    }
+
+    bool sameCommand(
+        uint16_t start, uint16_t length, char c, const void *arguments, int argumentsLength, uint8_t sum
+    ) {
+        const uint8_t *p = batch + start;
+        return length == argumentsLength + 3 && p[0] == (uint8_t)c &&
+               p[argumentsLength + 2] == (uint8_t)(sum ^ 0xFF) && !memcmp(p + 2, arguments, argumentsLength);
+    }
+
+    // Two byte record for a command already in the batch, false when there is none
+    bool batchRepeat(char c, const void *arguments, int argumentsLength, uint8_t sum) {
+        if (batchLength + 2 > batchSize) return false;
+        if (lastCommandLength > 0 &&
+            sameCommand(lastCommandStart, lastCommandLength, c, arguments, argumentsLength, sum)) {
+            if (repeatPos >= 0 && batch[repeatPos] < 255) {
+                batch[repeatPos]++;
+                return true;
+            }
+            batch[batchLength++] = VECTOR_DISPLAY_BATCH_REPEAT;
+            batch[batchLength++] = 1;
+            repeatPos = batchLength - 1;
+            return true;
+        }
+        // menus redraw the same rows, colors and labels over and over
+        uint8_t count = batchLiterals < VECTOR_DISPLAY_BATCH_REFS ? batchLiterals : VECTOR_DISPLAY_BATCH_REFS;
+        for (uint8_t back = 1; back <= count; back++) {
+            uint8_t i = (batchLiterals - back) % VECTOR_DISPLAY_BATCH_REFS;
+            if (!sameCommand(literalStart[i], literalLength[i], c, arguments, argumentsLength, sum)) continue;
+            batch[batchLength++] = VECTOR_DISPLAY_BATCH_REFERENCE;
+            batch[batchLength++] = back;
+            lastCommandStart = literalStart[i];
+            lastCommandLength = literalLength[i];
+            repeatPos = -1;
+            return true;
+        }
+        return false;
+    }
+
+    void batchCommand(char c, const void *arguments, int argumentsLength, uint8_t sum) {
+        if (batchLength > 0 && batchRepeat(c, arguments, argumentsLength, sum)) {
+            batchCommands++;
+            batchStats.repeats++;
+            return;
+        }
+
+        uint16_t n = argumentsLength + 3;
+        if (batchLength + n > batchSize) flushBatch();
+        if (batchLength == 0) batchStart = millis();
+        lastCommandStart = batchLength;
+        lastCommandLength = n;
+        repeatPos = -1;
+        literalStart[batchLiterals % VECTOR_DISPLAY_BATCH_REFS] = batchLength;
+        literalLength[batchLiterals % VECTOR_DISPLAY_BATCH_REFS] = n;
+        batchLiterals++;
+        batch[batchLength++] = c;
+        batch[batchLength++] = c ^ 0xFF;
+        if (argumentsLength > 0) memcpy(batch + batchLength, arguments, argumentsLength);
+        batchLength += argumentsLength;
+        batch[batchLength++] = sum ^ 0xFF;
+        batchCommands++;
+    }
+
+    bool waitBatchAck() {
+        readPos = 0;
+        uint32_t t0 = millis();
+        while (millis() - t0 < VECTOR_DISPLAY_ACK_TIMEOUT) {
+            if (readMessage(NULL) && !memcmp(readBuf, "Acknwld", 7) && readBuf[7] == 'X') return true;
+        }
+        return false;
+    }
+
 public:
     int cursor_x = 0;
     int cursor_y = 0;
@@ -259,8 +422,83 @@ public:
     uint32_t textcolor = TFT_WHITE;
     uint32_t textbgcolor = TFT_BLACK;
 
+    VectorDisplayBatchStats batchStats;
+
+    virtual ~VectorDisplayClass() {
+        free(batch);
+        free(batchPacked);
+    }
+
     void setWaitForAck(bool wait) { waitForAck = wait; }
 
+    /*
+     * Packs commands into 'X' frames of up to `size` bytes. A batch goes out when it is full,
+     * on update(), on commands that need an ack, before bitmaps and polygons, and with the first
+     * command after VECTOR_DISPLAY_BATCH_MS. Acks and setDelay() then apply per batch.
+     * Off by default, receivers that only know single commands cannot read the frames.
+     */
+    bool setBatching(bool on, uint16_t size = VECTOR_DISPLAY_BATCH_SIZE) {
+        flushBatch();
+        free(batch);
+        free(batchPacked);
+        batch = batchPacked = NULL;
+        batchSize = 0;
+        if (!on) return true;
+
+        // room for the longest command, text included
+        if (size < VECTOR_DISPLAY_MAX_STRING + 8) size = VECTOR_DISPLAY_MAX_STRING + 8;
+        if (size > 32768) size = 32768;
+        batch = (uint8_t *)malloc(size);
+        batchPacked = (uint8_t *)malloc(size + size / 128 + 1);
+        if (batch == NULL || batchPacked == NULL) {
+            free(batch);
+            free(batchPacked);
+            batch = batchPacked = NULL;
+            return false;
+        }
+        batchSize = size;
+        return true;
+    }
+
+    bool isBatching() { return batch != NULL; }
+
+    // Sends the open batch, if any
+    void flushBatch() {
+        if (batch == NULL || batchLength == 0) return;
+
+        VectorDisplayBatchHeader header;
+        uint16_t packed = packBits(batch, batchLength, batchPacked);
+        const uint8_t *payload = packed < batchLength ? batchPacked : batch;
+        header.flags = payload == batchPacked ? VECTOR_DISPLAY_BATCH_RLE : 0;
+        header.commands = batchCommands;
+        header.rawLength = batchLength;
+        header.length = payload == batchPacked ? packed : batchLength;
+        uint16_t crc = crc16(payload, header.length, crc16(&header, sizeof(header), 0xFFFF));
+
+        for (uint8_t attempt = 0;; attempt++) {
+            sendDelay();
+            remoteWrite('X');
+            remoteWrite('X' ^ 0xFF);
+            remoteWrite(&header, sizeof(header));
+            remoteWrite(payload, header.length);
+            remoteWrite(&crc, sizeof(crc));
+            batchStats.sentBytes += 2 + sizeof(header) + header.length + sizeof(crc);
+            if (!waitForAck || waitBatchAck()) break;
+            if (attempt == VECTOR_DISPLAY_BATCH_RETRIES) {
+                batchStats.lost++;
+                break;
+            }
+            batchStats.retries++;
+        }
+        batchStats.batches++;
+
+        batchLength = 0;
+        batchCommands = 0;
+        batchLiterals = 0;
+        lastCommandLength = 0;
+        repeatPos = -1;
+    }
+
     void setDelay(uint32_t delayMillis) {
         delayTime = delayMillis;
         lastSend = millis();
@@ -276,7 +514,9 @@ public:
     virtual void remoteWrite(const void *data, size_t n) = 0;
     virtual size_t remoteAvailable() = 0;
 
+#ifdef ARDUINO
     inline SPIClass &getSPIinstance() { return SPI; }
+#endif
 
     void attribute8(char a, uint8_t value) {
         args.attribute8.attr = a;
@@ -303,16 +543,31 @@ public:
     }
 
     void sendCommand(char c, const void *arguments, int argumentsLength) {
+        uint8_t sum = 0;
+        for (int i = 0; i < argumentsLength; i++) sum += ((uint8_t *)arguments)[i];
+        batchStats.commands++;
+        batchStats.rawBytes += argumentsLength + 3;
+        if (batch != NULL) {
+            batchCommand(c, arguments, argumentsLength, sum);
+            if (millis() - batchStart >= VECTOR_DISPLAY_BATCH_MS) flushBatch();
+            return;
+        }
+
         sendDelay();
         remoteWrite(c);
         remoteWrite(c ^ 0xFF);
         if (argumentsLength > 0) remoteWrite((uint8_t *)arguments, argumentsLength);
-        uint8_t sum = 0;
-        for (int i = 0; i < argumentsLength; i++) sum += ((uint8_t *)arguments)[i];
         remoteWrite((uint8_t)(sum ^ 0xFF));
+        batchStats.sentBytes += argumentsLength + 3;
     }
 
     void sendCommandWithAck(char c, const void *arguments, int argumentsLength) {
+        if (batch != NULL) {
+            // acked with its batch
+            sendCommand(c, arguments, argumentsLength);
+            flushBatch();
+            return;
+        }
         readPos = 0;
         bool done = false;
         do {
@@ -350,12 +605,41 @@ public:
         return s;
     }
 
+    // Batched when the whole polygon fits, otherwise sent on its own after the open batch
+    void polyWrite(const void *data, size_t n) {
+        if (!polyInBatch) {
+            remoteWrite(data, n);
+            return;
+        }
+        memcpy(batch + batchLength, data, n);
+        batchLength += n;
+    }
+
     void startPoly(char c, uint16_t n) {
+        uint32_t length = 5 + (uint32_t)n * 4;
+        polyInBatch = batch != NULL && length <= batchSize;
+        if (polyInBatch) {
+            if (batchLength + length > batchSize) flushBatch();
+            if (batchLength == 0) batchStart = millis();
+            batchCommands++;
+            // a literal for the receiver's count, never matches a command
+            literalStart[batchLiterals % VECTOR_DISPLAY_BATCH_REFS] = batchLength;
+            literalLength[batchLiterals % VECTOR_DISPLAY_BATCH_REFS] = length;
+            batchLiterals++;
+            lastCommandLength = 0; // not repeated
+            repeatPos = -1;
+        } else {
+            flushBatch();
+        }
+        batchStats.commands++;
+        batchStats.rawBytes += length;
+        if (!polyInBatch) batchStats.sentBytes += length;
+
         polyLineCount = n;
-        remoteWrite(c);
-        remoteWrite(c ^ 0xFF);
+        uint8_t header[2] = {(uint8_t)c, (uint8_t)(c ^ 0xFF)};
+        polyWrite(header, 2);
         args.twoByte[0] = n;
-        remoteWrite((uint8_t *)&args, 2);
+        polyWrite(&args, 2);
         polyLineSum = args.bytes[0] + args.bytes[1];
     }
 
@@ -367,10 +651,13 @@ public:
         if (polyLineCount > 0) {
             args.twoByte[0] = x;
             args.twoByte[1] = y;
-            remoteWrite((uint8_t *)&args, 4);
+            polyWrite(&args, 4);
             polyLineSum += args.bytes[0] + args.bytes[1] + args.bytes[2] + args.bytes[3];
             polyLineCount--;
-            if (polyLineCount == 0) { remoteWrite(0xFF ^ polyLineSum); }
+            if (polyLineCount == 0) {
+                uint8_t sum = 0xFF ^ polyLineSum;
+                polyWrite(&sum, 1);
+            }
         }
     }
 
@@ -609,7 +896,10 @@ public:
 
     void clear() { sendCommand('C', NULL, 0); }
 
-    void update() { sendCommand('F', NULL, 0); }
+    void update() {
+        sendCommand('F', NULL, 0);
+        flushBatch();
+    }
 
     /*    void reset() {
             sendCommandWithAck('E', NULL, 0);
@@ -739,6 +1029,7 @@ public:
 
         if (fullSize + 1 > MAX_BUFFER) return;
 
+        flushBatch();
         sendDelay();
         remoteWrite('K');
         remoteWrite('K' ^ 0xFF);
@@ -781,6 +1072,7 @@ public:
 
         if (fullSize + 1 > MAX_BUFFER) return;
 
+        flushBatch();
         sendDelay();
         remoteWrite('K');
         remoteWrite('K' ^ 0xFF);
@@ -216,17 +216,16 @@ extern volatile int EncoderLedChange;
 #endif
 
 extern TaskHandle_t xHandle;
+
+// core/input_events.cpp: the check() taking a press under the input lock, from the queue or the flag
+bool inputConsume(volatile bool &btn);
+// core/input_events.cpp: drops the queued presses, after a loop acted on a flag it read directly
+void inputDrain(void);
+
 extern inline bool check(volatile bool &btn) {
 
 #ifndef USE_TFT_eSPI_TOUCH
-    if (!btn) return false;
-    vTaskSuspend(xHandle);
-    btn = false;
-    AnyKeyPress = false;
-    SerialCmdPress = false;
-    delay(10);
-    vTaskResume(xHandle);
-    return true;
+    return inputConsume(btn);
 #else
 
     InputHandler();
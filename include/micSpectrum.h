@@ -0,0 +1,65 @@
+#ifndef __MIC_SPECTRUM
+#define __MIC_SPECTRUM
+#include <fft.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// One FFT plan and window table kept for the whole spectrum session, the plan owns the
+// input and output buffers. Plain C++ so tools/mic_fft_bench.cpp builds it on the host.
+class MicSpectrum {
+public:
+    ~MicSpectrum() { end(); }
+
+    bool begin(int size) {
+        end();
+        plan = fft_init(size, FFT_REAL, FFT_FORWARD, NULL, NULL);
+        window = (float *)malloc(size * sizeof(float));
+        if (plan == nullptr || window == nullptr) {
+            end();
+            return false;
+        }
+        // Hann, doubled to keep the levels of the unwindowed frames, with the int16 scale folded in
+        for (int i = 0; i < size; i++) {
+            window[i] = (1.0f - cosf(2.0f * (float)M_PI * i / (size - 1))) / 32768.0f;
+        }
+        this->size = size;
+        return true;
+    }
+
+    void end() {
+        if (plan) fft_destroy(plan);
+        free(window);
+        plan = nullptr;
+        window = nullptr;
+        size = 0;
+    }
+
+    // Levels 0..255 of one frame of size samples, lowest frequency in the last row. Row 0 stays
+    // empty like the first bin, which is the DC offset of the microphone.
+    void column(const int16_t *samples, uint8_t *out, int rows) {
+        for (int i = 0; i < size; i++) plan->input[i] = samples[i] * window[i];
+        fft_execute(plan);
+
+        out[0] = 0;
+        for (int i = 1; i < rows; i++) {
+            if (i >= size / 4) {
+                out[rows - i] = 0;
+                continue;
+            }
+            float re = plan->output[2 * i];
+            float im = plan->output[2 * i + 1];
+            float mag = re * re + im * im;
+            if (mag > 1.0f) mag = 1.0f;
+            out[rows - i] = (uint8_t)((int)(mag * 2000) * 255 / 2000);
+        }
+    }
+
+    int size = 0;
+
+private:
+    fft_config_t *plan = nullptr;
+    float *window = nullptr;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef __TFT_LOG_STORE
+#define __TFT_LOG_STORE
+#include <stddef.h>
+#include <stdint.h>
+
+enum tftFuncs : uint8_t { // DO NOT CHANGE THE ORDER, ADD NEW FUNCTIONS TO THE END!!!
+    FILLSCREEN,           // 0
+    DRAWRECT,             // 1
+    FILLRECT,             // 2
+    DRAWROUNDRECT,        // 3
+    FILLROUNDRECT,        // 4
+    DRAWCIRCLE,           // 5
+    FILLCIRCLE,           // 6
+    DRAWTRIAGLE,          // 7
+    FILLTRIANGLE,         // 8
+    DRAWELIPSE,           // 9
+    FILLELIPSE,           // 10
+    DRAWLINE,             // 11
+    DRAWARC,              // 12
+    DRAWWIDELINE,         // 13
+    DRAWCENTRESTRING,     // 14
+    DRAWRIGHTSTRING,      // 15
+    DRAWSTRING,           // 16
+    PRINT,                // 17
+    DRAWIMAGE,            // 18
+    DRAWPIXEL,            // 19
+    DRAWFASTVLINE,        // 20
+    DRAWFASTHLINE,        // 21
+    LOG_DELTA,            // 22 AA 1B 16 seq(4) since(4) set(8) cleared(8), big endian, bit i is log slot i
+    LOG_IMAGE,            // 23 AA SS 17 slot path, image path table of a delta
+    // Add new ones here
+
+    SCREEN_INFO = 99 // 99
+};
+#define MAX_LOG_ENTRIES 64
+#define MAX_LOG_SIZE 128
+#define MAX_LOG_IMAGES 3
+#define MAX_LOG_IMG_PATH 512
+#define LOG_PACKET_HEADER 0xAA
+#define LOG_DELTA_SIZE 27
+// getBinLogSince() output: screen info, delta header, image paths and entries
+#define MAX_LOG_DELTA_SIZE (MAX_LOG_ENTRIES * MAX_LOG_SIZE + 16 + LOG_DELTA_SIZE + MAX_LOG_IMAGES * 255)
+struct tftLog {
+    uint8_t data[MAX_LOG_SIZE];
+};
+
+/*
+ * The drawing log behind the WebUI navigator and the screen frames, kept apart
+ * from the display driver so it builds on a host. Every change bumps a sequence
+ * number and stamps the slots it touched, which lets delta() return only the
+ * slots a client has not seen since its cursor:
+ *
+ *   [SCREEN_INFO] LOG_DELTA [LOG_IMAGE...] [entry...]
+ *
+ * Entries follow in slot order for the `set` bits, DRAWIMAGE ones without their
+ * path (AA 0D 12 .. slot), paths come once in LOG_IMAGE packets. A client keeps
+ * the 64 slots and the image paths, applies the deltas in order and gets the
+ * same bytes as snapshot() by writing the slots out in order.
+ *
+ * A cursor is the session (top byte, never 0) and the low 24 bits of the
+ * sequence. A cursor of 0, one of another session (before a reboot, or before
+ * the sequence wrapped its 24 bits) or one ahead of the store gets every slot.
+ */
+class TftLogStore {
+public:
+    TftLogStore() { clear(); }
+
+    // Something unique to this boot, so cursors of the previous one are told apart
+    void setSession(uint8_t id) { session = id ? id : 1; }
+
+    void clear(void);
+    // Adds the entry unless the same one is already logged, true when added
+    bool push(const tftLog &l);
+    // Drops entries whose origin lies inside the rectangle
+    bool removeInsideRect(int rx, int ry, int rw, int rh);
+    // Drops images drawn with the same placement
+    void removeImages(int x, int y, int center, int ms);
+    // Slot of an image path, stored if new, 0xFF when the table is full
+    uint8_t imageSlot(const char *path);
+    const char *image(uint8_t slot) { return images[slot]; }
+
+    // All entries, DRAWIMAGE ones with their path, after `info`
+    void snapshot(const uint8_t *info, uint8_t infoSize, uint8_t *out, size_t &outSize);
+    // What changed since the cursor `since`, everything when it is 0 or unknown, returns the new cursor
+    uint32_t delta(uint32_t since, const uint8_t *info, uint8_t infoSize, uint8_t *out, size_t &outSize);
+    // Cursor of the current state
+    uint32_t sequence(void) { return cursorOf(seq, session); }
+
+private:
+    tftLog log[MAX_LOG_ENTRIES];
+    char images[MAX_LOG_IMAGES][MAX_LOG_IMG_PATH];
+    uint8_t logWriteIndex;
+    uint8_t logCount;
+    uint32_t seq = 0;                  // bumped by every change
+    uint8_t session = 1;               // changes when seq wraps its low 24 bits
+    uint32_t slotSeq[MAX_LOG_ENTRIES]; // last change of each slot
+    uint32_t imageSeq[MAX_LOG_IMAGES];
+
+    uint32_t bump(void);
+    static uint32_t cursorOf(uint32_t s, uint8_t id) { return (uint32_t)id << 24 | (s & 0xFFFFFF); }
+};
+
+/*
+ * LZ pass over a log packet stream, tokens:
+ *   0x00-0x7F  n + 1 literal bytes follow
+ *   0x80-0xFF  copy (n & 0x7F) + 3 bytes from distance d, d follows as u16 little endian
+ * `out` needs n + n / 128 + 1 bytes, both return the output size, 0 on error.
+ */
+size_t tftLogCompress(const uint8_t *in, size_t n, uint8_t *out);
+size_t tftLogExpand(const uint8_t *in, size_t n, uint8_t *out, size_t outSize);
+
+#endif //__TFT_LOG_STORE
@@ -7,47 +7,11 @@
 #include <VectorDisplay.h>
 #define BRUCE_TFT_DRIVER SerialDisplayClass
 #endif
-enum tftFuncs : uint8_t { // DO NOT CHANGE THE ORDER, ADD NEW FUNCTIONS TO THE END!!!
-    FILLSCREEN,           // 0
-    DRAWRECT,             // 1
-    FILLRECT,             // 2
-    DRAWROUNDRECT,        // 3
-    FILLROUNDRECT,        // 4
-    DRAWCIRCLE,           // 5
-    FILLCIRCLE,           // 6
-    DRAWTRIAGLE,          // 7
-    FILLTRIANGLE,         // 8
-    DRAWELIPSE,           // 9
-    FILLELIPSE,           // 10
-    DRAWLINE,             // 11
-    DRAWARC,              // 12
-    DRAWWIDELINE,         // 13
-    DRAWCENTRESTRING,     // 14
-    DRAWRIGHTSTRING,      // 15
-    DRAWSTRING,           // 16
-    PRINT,                // 17
-    DRAWIMAGE,            // 18
-    DRAWPIXEL,            // 19
-    DRAWFASTVLINE,        // 20
-    DRAWFASTHLINE,        // 21
-    // Add new ones here
-
-    SCREEN_INFO = 99 // 99
-};
-#define MAX_LOG_ENTRIES 64
-#define MAX_LOG_SIZE 128
-#define MAX_LOG_IMAGES 3
-#define MAX_LOG_IMG_PATH 512
-#define LOG_PACKET_HEADER 0xAA
-struct tftLog {
-    uint8_t data[MAX_LOG_SIZE];
-};
+#include <tftLogStore.h>
+
 class tft_logger : public BRUCE_TFT_DRIVER {
 private:
-    tftLog log[MAX_LOG_ENTRIES];
-    char images[MAX_LOG_IMAGES][MAX_LOG_IMG_PATH];
-    uint8_t logWriteIndex = 0;
-    uint8_t logCount = 0;
+    TftLogStore store;
     bool isSleeping = false;
     bool logging = false;
     bool _logging = false;
@@ -69,6 +33,8 @@ public:
     void inline setSleepMode(bool mode) { isSleeping = mode; }
 
     void getBinLog(uint8_t *outBuffer, size_t &outSize);
+    // Changes since the cursor a previous call returned, 0 for all, outBuffer holds MAX_LOG_DELTA_SIZE
+    uint32_t getBinLogSince(uint32_t since, uint8_t *outBuffer, size_t &outSize);
     bool removeLogEntriesInsideRect(int rx, int ry, int rw, int rh);
     void removeOverlappedImages(int x, int y, int center, int ms);
 
@@ -130,7 +96,6 @@ public:
     size_t printf(const char *format, ...);
 
 protected:
-    bool isLogEqual(const tftLog &a, const tftLog &b);
     void pushLogIfUnique(const tftLog &l);
     // void checkAndLog(tftFuncs f, std::initializer_list<int32_t> values);
     template <typename... Args> void checkAndLog(tftFuncs f, Args... args) {
@@ -150,7 +115,7 @@ protected:
         logging = false;
     }
     void restoreLogger();
-    void addLogEntry(const uint8_t *buffer, uint8_t size);
+    uint8_t screenInfo(uint8_t *buffer);
     void logWriteHeader(uint8_t *buffer, uint8_t &pos, tftFuncs fn);
     void writeUint16(uint8_t *buffer, uint8_t &pos, uint16_t value);
 };
@@ -77,8 +77,9 @@ public:
     size_t sectorSize();
     uint64_t totalBytes();
     uint64_t usedBytes();
-    bool readRAW(uint8_t *buffer, uint32_t sector);
-    bool writeRAW(uint8_t *buffer, uint32_t sector);
+    // `count` consecutive sectors in one transfer
+    bool readRAW(uint8_t *buffer, uint32_t sector, uint32_t count = 1);
+    bool writeRAW(uint8_t *buffer, uint32_t sector, uint32_t count = 1);
 };
 
 } // namespace fs
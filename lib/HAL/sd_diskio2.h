@@ -28,7 +28,8 @@ uint8_t sdcard_unmount(uint8_t pdrv);
 sdcard_type_t sdcard_type(uint8_t pdrv);
 uint32_t sdcard_num_sectors(uint8_t pdrv);
 uint32_t sdcard_sector_size(uint8_t pdrv);
-bool sd_read_raw(uint8_t pdrv, uint8_t *buffer, uint32_t sector);
-bool sd_write_raw(uint8_t pdrv, uint8_t *buffer, uint32_t sector);
+// `count` > 1 uses one multi-block command
+bool sd_read_raw(uint8_t pdrv, uint8_t *buffer, uint32_t sector, uint32_t count = 1);
+bool sd_write_raw(uint8_t pdrv, uint8_t *buffer, uint32_t sector, uint32_t count = 1);
 
 #endif /* _SD_DISKIO_H_ */
@@ -125,7 +125,8 @@ def prepare_www_files():
     for extension in filetypes_to_gzip:
         files_to_gzip.extend(glob.glob(join(data_src_dir, "*." + extension)))
 
-    files_checksum = hash_files(files_to_gzip)
+    # the suffix forces headers made by older versions of this script to be regenerated
+    files_checksum = hash_files(files_to_gzip) + "-etag"
     if files_checksum == checksum:
         print("[GZIP & EMBED INTO HEADER] - Nothing to process.")
         return
@@ -141,6 +142,8 @@ def prepare_www_files():
         header.write(
             "// THIS FILE IS AUTOGENERATED DO NOT MODIFY IT. MODIFY FILES IN /embedded_resources/web_interface\n\n"
         )
+        # ETag of the embedded files, changes whenever one of them does
+        header.write(f'#define WEB_FILES_HASH "{files_checksum[:16]}"\n\n')
 
         for file in files_to_gzip:
             gz_file = file + ".gz"
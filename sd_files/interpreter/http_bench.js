@@ -0,0 +1,27 @@
+// Repeated-fetch benchmark: requests per second and lowest free heap while polling one URL.
+// The first request opens the connection, the next ones reuse it (see "reused").
+var wifi = require('wifi');
+var device = require('device');
+
+var URL = "http://example.com/";
+var REQUESTS = 20;
+
+var minFree = device.getFreeHeapSize().ram_free;
+var bytes = 0;
+var start = now();
+for (var i = 0; i < REQUESTS; i++) {
+    var response = wifi.httpFetch(URL, { method: "GET" });
+    bytes += response.body.length;
+    var free = device.getFreeHeapSize().ram_free;
+    if (free < minFree) minFree = free;
+}
+var seconds = (now() - start) / 1000;
+var stats = wifi.httpStats();
+console.log(REQUESTS + " requests in " + seconds + " s: " + (REQUESTS / seconds).toFixed(2) + " req/s");
+console.log("reused connections: " + stats.reused + "/" + stats.requests + ", body bytes: " + bytes);
+console.log("lowest free heap: " + minFree + " B (" + device.getFreeHeapSize().ram_min_free + " B since boot)");
+
+// Large download streamed to a file in 1 KB reads, the body never sits in memory
+var download = wifi.httpFetch(URL, { stream: true });
+var written = download.pipeTo({ fs: "littlefs", path: "/http_bench.html" });
+console.log("streamed " + written + " B to /http_bench.html");
@@ -0,0 +1,108 @@
+#include "boot_trace.h"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+static BootPhase bootPhases[BOOT_TRACE_MAX];
+static uint8_t bootPhaseCount = 0;
+static portMUX_TYPE bootTraceLock = portMUX_INITIALIZER_UNLOCKED;
+static EventGroupHandle_t bootSteps = nullptr;
+static int64_t bootReadyTime = 0;
+
+struct BootJob {
+    const char *name;
+    BootStep step;
+    void (*job)(void);
+};
+
+static int beginPhase(const char *name) {
+    int phase = -1;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&bootTraceLock);
+    if (bootPhaseCount < BOOT_TRACE_MAX) {
+        phase = bootPhaseCount++;
+        bootPhases[phase] = {name, now, 0, (uint8_t)xPortGetCoreID()};
+    }
+    portEXIT_CRITICAL(&bootTraceLock);
+    return phase;
+}
+
+BootTrace::BootTrace(const char *name) : _phase(beginPhase(name)) {}
+
+BootTrace::~BootTrace() {
+    if (_phase >= 0) bootPhases[_phase].end = esp_timer_get_time();
+}
+
+static void runJob(const BootJob &job) {
+    {
+        BootTrace trace(job.name);
+        job.job();
+    }
+    xEventGroupSetBits(bootSteps, job.step);
+}
+
+static void bootJobTask(void *parameter) {
+    BootJob *job = (BootJob *)parameter;
+    runJob(*job);
+    delete job;
+    vTaskDelete(NULL);
+}
+
+void bootRun(const char *name, BootStep step, void (*job)(void), bool background) {
+    if (bootSteps == nullptr) bootSteps = xEventGroupCreate();
+    BootJob run = {name, step, job};
+    if (background) {
+        // the other core, the scheduler picks one on single core chips
+        BaseType_t core = portNUM_PROCESSORS > 1 ? !xPortGetCoreID() : tskNO_AFFINITY;
+        BootJob *task = new BootJob(run);
+        if (xTaskCreatePinnedToCore(
+                bootJobTask, name, BOOT_JOB_STACK_SIZE, task, uxTaskPriorityGet(NULL), NULL, core
+            ) == pdPASS)
+            return;
+        delete task; // not enough memory for the task, run it here
+    }
+    runJob(run);
+}
+
+void bootWait(uint32_t steps) {
+    if (bootSteps == nullptr || (xEventGroupGetBits(bootSteps) & steps) == steps) return;
+    BootTrace trace("(waiting)");
+    xEventGroupWaitBits(bootSteps, steps, pdFALSE, pdTRUE, portMAX_DELAY);
+}
+
+void bootTraceReady(void) {
+    if (bootReadyTime != 0) return;
+    bootReadyTime = esp_timer_get_time();
+    log_i("Reset to menu: %lld ms", bootReadyTime / 1000);
+}
+
+int64_t bootTraceReadyTime(void) { return bootReadyTime; }
+
+String bootTraceReport(void) {
+    BootPhase phases[BOOT_TRACE_MAX];
+    portENTER_CRITICAL(&bootTraceLock);
+    uint8_t count = bootPhaseCount;
+    memcpy(phases, bootPhases, count * sizeof(BootPhase));
+    portEXIT_CRITICAL(&bootTraceLock);
+
+    String report = "Phase              Core   Start ms    Took ms\n";
+    char line[64];
+    for (uint8_t i = 0; i < count; i++) {
+        const BootPhase &p = phases[i];
+        snprintf(line, sizeof(line), "%-18s %4u %10.1f ", p.name, p.core, p.start / 1000.0);
+        report += line;
+        if (p.end == 0) {
+            report += "   running\n";
+        } else {
+            snprintf(line, sizeof(line), "%10.1f\n", (p.end - p.start) / 1000.0);
+            report += line;
+        }
+    }
+    if (bootReadyTime == 0) {
+        report += "Menu not reached yet\n";
+    } else {
+        snprintf(line, sizeof(line), "Reset to menu: %.1f ms\n", bootReadyTime / 1000.0);
+        report += line;
+    }
+    return report;
+}
@@ -0,0 +1,54 @@
+#ifndef __BOOT_TRACE_H__
+#define __BOOT_TRACE_H__
+
+#include <Arduino.h>
+
+#define BOOT_TRACE_MAX 32          // phases kept, later ones are dropped
+#define BOOT_JOB_STACK_SIZE 8192   // stack of the tasks running boot phases in the background
+
+// Results of setup() phases, bootWait() blocks until they are available
+enum BootStep : uint32_t {
+    BOOT_LITTLEFS = 1 << 0,
+    BOOT_SDCARD = 1 << 1,
+    BOOT_THEME = 1 << 2,
+    BOOT_CLOCK = 1 << 3, // RTC and LED
+};
+
+struct BootPhase {
+    const char *name;
+    int64_t start; // microseconds since reset
+    int64_t end;   // 0 while running
+    uint8_t core;
+};
+
+// Records the phase until it goes out of scope
+class BootTrace {
+public:
+    explicit BootTrace(const char *name);
+    ~BootTrace();
+
+private:
+    int _phase;
+};
+
+/*
+ * Runs a setup() phase and marks `step` done. With `background` the phase runs
+ * in its own task on the core loop() does not use, so it overlaps the phases
+ * setup() keeps going with. Phases sharing a bus with the main core (SD on the
+ * display SPI bus) must not run in the background.
+ */
+void bootRun(const char *name, BootStep step, void (*job)(void), bool background = true);
+
+// Blocks until every step in `steps` is done, the time spent waiting is traced too
+void bootWait(uint32_t steps);
+
+// Marks the first interactive menu, only the first call counts
+void bootTraceReady(void);
+
+// Microseconds from reset to the first menu, 0 before it was reached
+int64_t bootTraceReadyTime(void);
+
+// Timing table of every phase in start order, followed by the reset to menu time
+String bootTraceReport(void);
+
+#endif
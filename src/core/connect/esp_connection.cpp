@@ -1,5 +1,6 @@
 #include "esp_connection.h"
 #include "core/display.h"
+#include "esp_transfer.h"
 #include <WiFi.h>
 
 // Initialize the static instance pointer
@@ -13,6 +14,9 @@ EspConnection::~EspConnection() {
     esp_now_unregister_recv_cb();
 
     esp_now_deinit();
+
+    free(recvRing);
+    recvRing = nullptr;
 }
 
 bool EspConnection::beginSend() {
@@ -36,6 +40,14 @@ bool EspConnection::beginSend() {
 }
 
 bool EspConnection::beginEspnow() {
+    if (recvRing == nullptr) recvRing = (RecvFrame *)malloc(ESP_RECV_RING_SIZE * sizeof(RecvFrame));
+    if (recvRing == nullptr) {
+        displayError("Out of memory");
+        delay(1000);
+        return false;
+    }
+    clearRecvQueue();
+
     WiFi.mode(WIFI_STA);
 
     if (esp_now_init() != ESP_OK) {
@@ -180,14 +192,71 @@ void EspConnection::appendPeerToList(const uint8_t *mac) {
 void EspConnection::onDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
     if (status == ESP_NOW_SEND_SUCCESS) {
         sendStatus = SUCCESS;
-        Serial.println("ESPNOW send success");
     } else {
         sendStatus = FAILED;
         Serial.println("ESPNOW send fail");
     }
 }
 
+bool EspConnection::pushFrame(const uint8_t *mac, const uint8_t *data, int len) {
+    if (recvRing == nullptr || len <= 0 || len > ESP_NOW_MAX_DATA_LEN) return false;
+
+    portENTER_CRITICAL(&recvMux);
+    uint16_t next = (recvHead + 1) % ESP_RECV_RING_SIZE;
+    if (next == recvTail) {
+        portEXIT_CRITICAL(&recvMux);
+        recvDropped++;
+        return false;
+    }
+    RecvFrame &frame = recvRing[recvHead];
+    memcpy(frame.mac, mac, 6);
+    frame.len = len;
+    memcpy(frame.data, data, len);
+    recvHead = next;
+    portEXIT_CRITICAL(&recvMux);
+    return true;
+}
+
+bool EspConnection::popFrame(RecvFrame &frame) {
+    if (recvRing == nullptr) return false;
+
+    portENTER_CRITICAL(&recvMux);
+    if (recvTail == recvHead) {
+        portEXIT_CRITICAL(&recvMux);
+        return false;
+    }
+    frame = recvRing[recvTail];
+    recvTail = (recvTail + 1) % ESP_RECV_RING_SIZE;
+    portEXIT_CRITICAL(&recvMux);
+    return true;
+}
+
+bool EspConnection::popMessage(Message &message) {
+    RecvFrame frame;
+    while (popFrame(frame)) {
+        if (frame.len != sizeof(Message)) continue;
+        memcpy(&message, frame.data, sizeof(Message));
+        return true;
+    }
+    return false;
+}
+
+void EspConnection::clearRecvQueue() {
+    portENTER_CRITICAL(&recvMux);
+    recvHead = 0;
+    recvTail = 0;
+    portEXIT_CRITICAL(&recvMux);
+    recvDropped = 0;
+}
+
 void EspConnection::onDataRecv(const uint8_t *mac, const uint8_t *incomingData, int len) {
+    // Transfer frames are handled by the UI loop, keep the WiFi task free
+    if (isXferFrame(incomingData, len)) {
+        pushFrame(mac, incomingData, len);
+        return;
+    }
+    if (len != sizeof(Message)) return;
+
     Message recvMessage;
 
     // Use reinterpret_cast and copy assignment
@@ -199,7 +268,7 @@ void EspConnection::onDataRecv(const uint8_t *mac, const uint8_t *incomingData,
     if (recvMessage.ping) return sendPong(mac);
     if (recvMessage.pong) return appendPeerToList(mac);
 
-    recvQueue.push_back(recvMessage);
+    pushFrame(mac, incomingData, len);
 }
 
 void EspConnection::onDataSentStatic(const wifi_tx_info_t *info, esp_now_send_status_t status) {
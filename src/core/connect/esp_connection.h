@@ -1,25 +1,16 @@
 #ifndef __ESP_CONNECTION_H__
 #define __ESP_CONNECTION_H__
 
+#include "esp_transfer.h"
 #include <esp_now.h>
 #include <globals.h>
 #include <vector>
 
-#define ESP_FILENAME_SIZE 30
-#define ESP_FILEPATH_SIZE 50
 #define ESP_DATA_SIZE 150
+#define ESP_RECV_RING_SIZE 32 // frames buffered between the WiFi task and the UI loop
 
-class EspConnection {
+class EspConnection : public EspStatus {
 public:
-    enum Status {
-        CONNECTING,
-        STARTED,
-        WAITING,
-        FAILED,
-        SUCCESS,
-        ABORTED,
-    };
-
     // Struct has to be 250 B max
     struct Message {
         char filename[ESP_FILENAME_SIZE];
@@ -39,6 +30,13 @@ public:
         }
     };
 
+    // Raw frame as received, queued by the ESP-NOW callback
+    struct RecvFrame {
+        uint8_t mac[6];
+        uint8_t len;
+        uint8_t data[ESP_NOW_MAX_DATA_LEN];
+    };
+
     EspConnection();
     ~EspConnection();
 
@@ -52,7 +50,11 @@ protected:
     Status sendStatus;
     uint8_t dstAddress[6];
     uint8_t broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-    std::vector<Message> recvQueue;
+    RecvFrame *recvRing = nullptr;
+    volatile uint16_t recvHead = 0;
+    volatile uint16_t recvTail = 0;
+    uint32_t recvDropped = 0;
+    portMUX_TYPE recvMux = portMUX_INITIALIZER_UNLOCKED;
 
     bool beginSend();
     bool beginEspnow();
@@ -62,6 +64,11 @@ protected:
     Message createPingMessage();
     Message createPongMessage();
 
+    bool pushFrame(const uint8_t *mac, const uint8_t *data, int len);
+    bool popFrame(RecvFrame &frame);
+    bool popMessage(Message &message);
+    void clearRecvQueue();
+
     void sendPing();
     void sendPong(const uint8_t *mac);
 
@@ -79,4 +86,9 @@ private:
     static EspConnection *instance;
 };
 
+// A transfer frame, as opposed to a legacy Message
+inline bool isXferFrame(const uint8_t *data, size_t len) {
+    return len >= sizeof(XferHeader) && len != sizeof(EspConnection::Message) && data[0] == XFER_MAGIC;
+}
+
 #endif
@@ -0,0 +1,426 @@
+#include "esp_transfer.h"
+#include <deque>
+#include <vector>
+
+// Exponential backoff, capped at 16x the base timeout
+static uint32_t retryTimeout(uint8_t tries) {
+    return XFER_RTO_MS << std::min<uint8_t>(tries > 0 ? tries - 1 : 0, 4);
+}
+
+// The callers already set legacy Messages aside (isXferFrame)
+static bool isFrame(const uint8_t *data, size_t len) {
+    return len >= sizeof(XferHeader) && data[0] == XFER_MAGIC;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Sender
+/////////////////////////////////////////////////////////////////////////////////////
+EspTransferSender::~EspTransferSender() { free(_slots); }
+
+bool EspTransferSender::begin(
+    uint16_t id, uint32_t totalBytes, const char *filename, const char *filepath, uint32_t now
+) {
+    if (_slots == nullptr) _slots = (Slot *)calloc(XFER_WINDOW, sizeof(Slot));
+    if (_slots == nullptr) return false;
+
+    _id = id;
+    _totalBytes = totalBytes;
+    _totalChunks = (totalBytes + XFER_CHUNK_SIZE - 1) / XFER_CHUNK_SIZE;
+    _base = 0;
+    _next = 0;
+    _started = false;
+    _ended = false;
+    _ctrlTries = 0;
+    _stats = XferStats();
+    _stats.startedAt = now;
+    _md5.begin();
+
+    memset(&_start, 0, sizeof(_start));
+    _start.h = {XFER_MAGIC, XFER_START, _id, 0};
+    _start.totalBytes = totalBytes;
+    _start.chunkSize = XFER_CHUNK_SIZE;
+    _start.window = XFER_WINDOW;
+    strncpy(_start.filename, filename, ESP_FILENAME_SIZE - 1);
+    strncpy(_start.filepath, filepath, ESP_FILEPATH_SIZE - 1);
+
+    _status = EspStatus::STARTED;
+    sendControl(&_start, sizeof(_start), now);
+    return true;
+}
+
+void EspTransferSender::abort() {
+    if (_status != EspStatus::STARTED) return;
+    XferHeader h = {XFER_MAGIC, XFER_ABORT, _id, 0};
+    _send((const uint8_t *)&h, sizeof(h));
+    _status = EspStatus::ABORTED;
+}
+
+bool EspTransferSender::sendControl(const void *frame, size_t len, uint32_t now) {
+    _ctrlSentAt = now;
+    _ctrlTries++;
+    return _send((const uint8_t *)frame, len);
+}
+
+bool EspTransferSender::sendData(Slot &slot, uint32_t now) {
+    if (!_send((const uint8_t *)&slot.frame, sizeof(XferHeader) + slot.len)) return false;
+    if (slot.tries > 0) _stats.retransmits++;
+    slot.tries++;
+    slot.sentAt = now;
+    slot.resend = false;
+    _stats.frames++;
+    return true;
+}
+
+void EspTransferSender::finish(EspStatus::Status status, uint32_t now) {
+    _status = status;
+    _stats.finishedAt = now;
+    _stats.bytes = status == EspStatus::SUCCESS ? _totalBytes : bytesAcked();
+}
+
+void EspTransferSender::onFrame(const uint8_t *data, size_t len, uint32_t now) {
+    if (!isFrame(data, len) || _status != EspStatus::STARTED) return;
+
+    XferHeader h;
+    memcpy(&h, data, sizeof(h));
+    if (h.id != _id) return;
+
+    switch (h.type) {
+        case XFER_START_ACK: _started = true; break;
+
+        case XFER_ACK: {
+            if (len < sizeof(XferAckFrame) || !_started) return;
+            XferAckFrame ack;
+            memcpy(&ack, data, sizeof(ack));
+
+            uint32_t cumulative = ack.h.seq;
+            if (cumulative > _next) cumulative = _next;
+            for (uint32_t seq = _base; seq < cumulative; seq++) _slots[seq % XFER_WINDOW].acked = true;
+
+            uint32_t highest = 0;
+            for (uint8_t i = 0; i < 32; i++) {
+                if (!(ack.sack & (1UL << i))) continue;
+                uint32_t seq = cumulative + 1 + i;
+                if (seq < _base || seq >= _next) continue;
+                _slots[seq % XFER_WINDOW].acked = true;
+                highest = seq;
+            }
+
+            // Selective retransmit: chunks reported missing below the highest
+            // received one are resent now instead of waiting for their timeout
+            for (uint32_t seq = std::max(_base, cumulative); seq < highest; seq++) {
+                Slot &slot = _slots[seq % XFER_WINDOW];
+                if (!slot.acked && slot.tries == 1) slot.resend = true;
+            }
+
+            while (_base < _next && _slots[_base % XFER_WINDOW].acked) _base++;
+            _stats.bytes = bytesAcked();
+            break;
+        }
+
+        case XFER_END_ACK:
+            if (!_ended || len < sizeof(XferEndAckFrame)) return;
+            finish(data[sizeof(XferHeader)] ? EspStatus::SUCCESS : EspStatus::FAILED, now);
+            break;
+
+        case XFER_ABORT: finish(EspStatus::ABORTED, now); break;
+    }
+}
+
+EspStatus::Status EspTransferSender::poll(uint32_t now) {
+    if (_status != EspStatus::STARTED) return _status;
+
+    // Waiting for START_ACK or END_ACK
+    if (!_started || _ended) {
+        if (now - _ctrlSentAt < retryTimeout(_ctrlTries)) return _status;
+        if (_ctrlTries >= XFER_MAX_RETRIES) {
+            finish(EspStatus::FAILED, now);
+            return _status;
+        }
+        _stats.retransmits++;
+        if (_ended) sendControl(&_end, sizeof(_end), now);
+        else sendControl(&_start, sizeof(_start), now);
+        return _status;
+    }
+
+    // Fill the window from the source
+    while (_next < _totalChunks && _next < _base + XFER_WINDOW) {
+        Slot &slot = _slots[_next % XFER_WINDOW];
+        size_t want = std::min<uint32_t>(XFER_CHUNK_SIZE, _totalBytes - _next * XFER_CHUNK_SIZE);
+        slot.len = _read(slot.frame.data, want);
+        if (slot.len != want) {
+            finish(EspStatus::FAILED, now);
+            return _status;
+        }
+        _md5.add(slot.frame.data, slot.len);
+        slot.frame.h = {XFER_MAGIC, XFER_DATA, _id, _next};
+        slot.tries = 0;
+        slot.acked = false;
+        slot.resend = true;
+        _next++;
+    }
+
+    // Send new chunks and retransmit the expired ones
+    for (uint32_t seq = _base; seq < _next; seq++) {
+        Slot &slot = _slots[seq % XFER_WINDOW];
+        if (slot.acked) continue;
+        if (!slot.resend) {
+            if (now - slot.sentAt < retryTimeout(slot.tries)) continue;
+            if (slot.tries >= XFER_MAX_RETRIES) {
+                finish(EspStatus::FAILED, now);
+                return _status;
+            }
+        }
+        if (!sendData(slot, now)) break; // radio queue full, continue on the next poll
+    }
+
+    if (_base == _totalChunks) {
+        _md5.calculate();
+        _end.h = {XFER_MAGIC, XFER_END, _id, _totalChunks};
+        _md5.getBytes(_end.md5);
+        _ended = true;
+        _ctrlTries = 0;
+        sendControl(&_end, sizeof(_end), now);
+    }
+
+    return _status;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Receiver
+/////////////////////////////////////////////////////////////////////////////////////
+EspTransferReceiver::~EspTransferReceiver() { free(_slots); }
+
+void EspTransferReceiver::sendHeader(XferType type, uint32_t seq) {
+    XferHeader h = {XFER_MAGIC, type, _id, seq};
+    _send((const uint8_t *)&h, sizeof(h));
+}
+
+void EspTransferReceiver::sendEndAck() {
+    XferEndAckFrame frame;
+    frame.h = {XFER_MAGIC, XFER_END_ACK, _id, _totalChunks};
+    frame.ok = _endOk;
+    _send((const uint8_t *)&frame, sizeof(frame));
+}
+
+void EspTransferReceiver::sendAck(uint32_t now) {
+    XferAckFrame ack;
+    ack.h = {XFER_MAGIC, XFER_ACK, _id, _expected};
+    ack.sack = 0;
+    for (uint8_t i = 0; i < 32; i++) {
+        uint32_t seq = _expected + 1 + i;
+        if (seq >= _expected + XFER_WINDOW || seq >= _totalChunks) break;
+        if (_slots[seq % XFER_WINDOW].valid) ack.sack |= 1UL << i;
+    }
+    _send((const uint8_t *)&ack, sizeof(ack));
+    _pendingAcks = 0;
+    _lastAckAt = now;
+}
+
+void EspTransferReceiver::onFrame(const uint8_t *data, size_t len, uint32_t now) {
+    if (!isFrame(data, len)) return;
+
+    XferHeader h;
+    memcpy(&h, data, sizeof(h));
+
+    if (h.type == XFER_START) {
+        if (len < sizeof(XferStartFrame)) return;
+        if (_status != EspStatus::WAITING) {
+            if (h.id != _id) return;
+            // our answer was lost
+            if (_status == EspStatus::STARTED) sendHeader(XFER_START_ACK, 0);
+            else if (_status == EspStatus::FAILED) sendHeader(XFER_ABORT, 0);
+            return;
+        }
+
+        XferStartFrame start;
+        memcpy(&start, data, sizeof(start));
+        start.filename[ESP_FILENAME_SIZE - 1] = '\0';
+        start.filepath[ESP_FILEPATH_SIZE - 1] = '\0';
+        _id = h.id;
+
+        if (start.chunkSize != XFER_CHUNK_SIZE || start.window > XFER_WINDOW) {
+            sendHeader(XFER_ABORT, 0);
+            return;
+        }
+        if (_slots == nullptr) _slots = (Slot *)calloc(XFER_WINDOW, sizeof(Slot));
+        if (_slots == nullptr || !_open(start)) {
+            sendHeader(XFER_ABORT, 0);
+            _status = EspStatus::FAILED;
+            return;
+        }
+
+        _totalBytes = start.totalBytes;
+        _totalChunks = (_totalBytes + XFER_CHUNK_SIZE - 1) / XFER_CHUNK_SIZE;
+        _expected = 0;
+        _pendingAcks = 0;
+        _stats = XferStats();
+        _stats.startedAt = now;
+        _md5.begin();
+        _active = true;
+        _status = EspStatus::STARTED;
+        sendHeader(XFER_START_ACK, 0);
+        return;
+    }
+
+    if (h.id != _id || _status == EspStatus::WAITING) return;
+
+    // Transfer already finished, the sender may still be missing our END_ACK
+    if (!_active) {
+        if (h.type == XFER_END) sendEndAck();
+        return;
+    }
+
+    switch (h.type) {
+        case XFER_DATA: {
+            uint32_t seq = h.seq;
+            size_t dataLen = len - sizeof(XferHeader);
+            if (seq < _expected) {
+                sendAck(now); // duplicate, our ack was lost
+                return;
+            }
+            if (seq >= _expected + XFER_WINDOW || seq >= _totalChunks || dataLen > XFER_CHUNK_SIZE) return;
+
+            Slot &slot = _slots[seq % XFER_WINDOW];
+            if (!slot.valid) {
+                memcpy(slot.data, data + sizeof(XferHeader), dataLen);
+                slot.len = dataLen;
+                slot.valid = true;
+                _stats.frames++;
+            }
+            if (seq != _expected) {
+                sendAck(now); // gap, tell the sender what is missing right away
+                return;
+            }
+
+            while (_expected < _totalChunks && _slots[_expected % XFER_WINDOW].valid) {
+                Slot &next = _slots[_expected % XFER_WINDOW];
+                if (!_write(next.data, next.len)) {
+                    sendHeader(XFER_ABORT, 0);
+                    _active = false;
+                    _status = EspStatus::FAILED;
+                    return;
+                }
+                _md5.add(next.data, next.len);
+                _stats.bytes += next.len;
+                next.valid = false;
+                _expected++;
+                _pendingAcks++;
+            }
+            if (_pendingAcks >= XFER_ACK_EVERY || _expected == _totalChunks) sendAck(now);
+            break;
+        }
+
+        case XFER_END: {
+            if (len < sizeof(XferEndFrame)) return;
+            if (h.seq != _totalChunks || _expected != _totalChunks) {
+                sendAck(now);
+                return;
+            }
+            XferEndFrame end;
+            memcpy(&end, data, sizeof(end));
+            uint8_t md5[16];
+            _md5.calculate();
+            _md5.getBytes(md5);
+
+            _endOk = memcmp(md5, end.md5, sizeof(md5)) == 0;
+            _active = false;
+            _stats.finishedAt = now;
+            _status = _endOk ? EspStatus::SUCCESS : EspStatus::FAILED;
+            sendEndAck();
+            break;
+        }
+
+        case XFER_ABORT:
+            _active = false;
+            _stats.finishedAt = now;
+            _status = EspStatus::ABORTED;
+            break;
+    }
+}
+
+EspStatus::Status EspTransferReceiver::poll(uint32_t now) {
+    if (_active && _pendingAcks > 0 && now - _lastAckAt >= XFER_ACK_DELAY_MS) sendAck(now);
+    return _status;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Loopback harness
+/////////////////////////////////////////////////////////////////////////////////////
+#define XFER_SIM_QUEUE 8 // frames the simulated radio accepts before send fails
+
+// Deterministic test pattern so the receiver can verify every byte
+static uint8_t loopbackPattern(uint32_t offset) { return (offset * 2654435761UL) >> 24; }
+
+XferLoopbackResult espTransferLoopback(
+    uint8_t lossPercent, uint32_t totalBytes, uint32_t seed, std::function<void()> idle
+) {
+    XferLoopbackResult result;
+    uint32_t rng = seed ? seed : 1;
+    auto lost = [&]() {
+        // xorshift32, the same losses on every platform
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng % 100 < lossPercent;
+    };
+
+    // Simulated link: 1 tick = 1 ms, one frame per tick in each direction
+    std::deque<std::vector<uint8_t>> toReceiver;
+    std::deque<std::vector<uint8_t>> toSender;
+
+    auto link = [&](std::deque<std::vector<uint8_t>> &queue, const uint8_t *data, size_t len) {
+        if (queue.size() >= XFER_SIM_QUEUE) return false;
+        if (lost()) {
+            result.dropped++;
+            return true; // lost on air, the sender does not know
+        }
+        queue.emplace_back(data, data + len);
+        return true;
+    };
+
+    uint32_t readOffset = 0;
+    uint32_t writeOffset = 0;
+    bool corrupted = false;
+
+    EspTransferSender sender(
+        [&](const uint8_t *data, size_t len) { return link(toReceiver, data, len); },
+        [&](uint8_t *buf, size_t len) {
+            for (size_t i = 0; i < len; i++) buf[i] = loopbackPattern(readOffset++);
+            return len;
+        }
+    );
+    EspTransferReceiver receiver(
+        [&](const uint8_t *data, size_t len) { return link(toSender, data, len); },
+        [&](const XferStartFrame &) { return true; },
+        [&](const uint8_t *data, size_t len) {
+            for (size_t i = 0; i < len; i++) {
+                if (data[i] != loopbackPattern(writeOffset++)) corrupted = true;
+            }
+            return true;
+        }
+    );
+
+    uint32_t tick = 0;
+    if (!sender.begin((uint16_t)rng, totalBytes, "loopback.bin", "/", tick)) return result;
+
+    EspStatus::Status status = EspStatus::STARTED;
+    while (status == EspStatus::STARTED) {
+        tick++;
+        if (!toReceiver.empty()) {
+            receiver.onFrame(toReceiver.front().data(), toReceiver.front().size(), tick);
+            toReceiver.pop_front();
+        }
+        if (!toSender.empty()) {
+            sender.onFrame(toSender.front().data(), toSender.front().size(), tick);
+            toSender.pop_front();
+        }
+        receiver.poll(tick);
+        status = sender.poll(tick);
+        if ((tick & 0xFF) == 0 && idle) idle();
+    }
+
+    result.stats = sender.stats();
+    result.ok = status == EspStatus::SUCCESS && receiver.poll(tick) == EspStatus::SUCCESS &&
+                writeOffset == totalBytes && !corrupted;
+    return result;
+}
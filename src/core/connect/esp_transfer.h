@@ -0,0 +1,203 @@
+#ifndef __ESP_TRANSFER_H__
+#define __ESP_TRANSFER_H__
+
+#include <MD5Builder.h>
+#include <algorithm>
+#include <functional>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Windowed transfer protocol used for file sharing over ESP-NOW.
+// Frames start with XFER_MAGIC and never have the size of a legacy Message,
+// so both can share the same ESP-NOW callbacks (isXferFrame in esp_connection.h).
+// Nothing here touches the radio, tools/esp_transfer_loopback_test.cpp runs it on the host.
+#define ESP_FILENAME_SIZE 30
+#define ESP_FILEPATH_SIZE 50
+#define XFER_MAGIC 0xB7
+#define XFER_CHUNK_SIZE 200  // payload of a DATA frame
+#define XFER_WINDOW 16       // chunks in flight, must be <= 33 (cumulative ack + 32 bit SACK)
+#define XFER_RTO_MS 60       // base retransmission timeout, doubled per retry
+#define XFER_MAX_RETRIES 20  // per chunk/control frame before giving up
+#define XFER_ACK_EVERY 4     // receiver acks after this many in-order chunks...
+#define XFER_ACK_DELAY_MS 10 // ...or after this many ms
+
+// Transfer states, EspConnection inherits them as EspConnection::Status
+struct EspStatus {
+    enum Status {
+        CONNECTING,
+        STARTED,
+        WAITING,
+        FAILED,
+        SUCCESS,
+        ABORTED,
+    };
+};
+
+enum XferType : uint8_t {
+    XFER_START = 1,
+    XFER_START_ACK,
+    XFER_DATA,
+    XFER_ACK,
+    XFER_END,
+    XFER_END_ACK,
+    XFER_ABORT,
+};
+
+struct __attribute__((packed)) XferHeader {
+    uint8_t magic;
+    uint8_t type;
+    uint16_t id;
+    uint32_t seq;
+};
+
+struct __attribute__((packed)) XferStartFrame {
+    XferHeader h;
+    uint32_t totalBytes;
+    uint16_t chunkSize;
+    uint8_t window;
+    char filename[ESP_FILENAME_SIZE];
+    char filepath[ESP_FILEPATH_SIZE];
+};
+
+struct __attribute__((packed)) XferDataFrame {
+    XferHeader h;
+    uint8_t data[XFER_CHUNK_SIZE];
+};
+
+struct __attribute__((packed)) XferAckFrame {
+    XferHeader h;  // seq = next expected chunk
+    uint32_t sack; // bit i set = chunk seq + 1 + i already received
+};
+
+struct __attribute__((packed)) XferEndFrame {
+    XferHeader h; // seq = total chunks
+    uint8_t md5[16];
+};
+
+struct __attribute__((packed)) XferEndAckFrame {
+    XferHeader h;
+    uint8_t ok;
+};
+
+struct XferStats {
+    uint32_t bytes = 0;
+    uint32_t frames = 0;
+    uint32_t retransmits = 0;
+    uint32_t startedAt = 0;
+    uint32_t finishedAt = 0;
+
+    uint32_t elapsed() const { return finishedAt - startedAt; }
+    float kbps() const { return elapsed() ? bytes / 1.024f / elapsed() : 0; }
+};
+
+class EspTransferSender {
+public:
+    using SendFn = std::function<bool(const uint8_t *data, size_t len)>;
+    using ReadFn = std::function<size_t(uint8_t *buf, size_t len)>;
+
+    EspTransferSender(SendFn send, ReadFn read) : _send(send), _read(read) {}
+    ~EspTransferSender();
+
+    // id tells this transfer's frames from those of an earlier one, pick it at random
+    bool begin(uint16_t id, uint32_t totalBytes, const char *filename, const char *filepath, uint32_t now);
+    void onFrame(const uint8_t *data, size_t len, uint32_t now);
+    EspStatus::Status poll(uint32_t now);
+    void abort(void);
+
+    uint32_t bytesAcked(void) { return std::min<uint32_t>(_base * XFER_CHUNK_SIZE, _totalBytes); }
+    uint32_t totalBytes(void) { return _totalBytes; }
+    const XferStats &stats(void) { return _stats; }
+
+private:
+    struct Slot {
+        uint32_t sentAt;
+        uint16_t len;
+        uint8_t tries;
+        bool acked;
+        bool resend;
+        XferDataFrame frame; // kept until acked, retransmitted as is
+    };
+
+    SendFn _send;
+    ReadFn _read;
+    Slot *_slots = nullptr;
+    MD5Builder _md5;
+    XferStartFrame _start;
+    XferEndFrame _end;
+    EspStatus::Status _status = EspStatus::WAITING;
+    uint16_t _id = 0;
+    uint32_t _totalBytes = 0;
+    uint32_t _totalChunks = 0;
+    uint32_t _base = 0; // oldest unacked chunk
+    uint32_t _next = 0; // next chunk to read from the source
+    uint32_t _ctrlSentAt = 0;
+    uint8_t _ctrlTries = 0;
+    bool _started = false;
+    bool _ended = false;
+    XferStats _stats;
+
+    bool sendControl(const void *frame, size_t len, uint32_t now);
+    bool sendData(Slot &slot, uint32_t now);
+    void finish(EspStatus::Status status, uint32_t now);
+};
+
+class EspTransferReceiver {
+public:
+    using SendFn = std::function<bool(const uint8_t *data, size_t len)>;
+    using OpenFn = std::function<bool(const XferStartFrame &start)>;
+    using WriteFn = std::function<bool(const uint8_t *data, size_t len)>;
+
+    EspTransferReceiver(SendFn send, OpenFn open, WriteFn write) : _send(send), _open(open), _write(write) {}
+    ~EspTransferReceiver();
+
+    void onFrame(const uint8_t *data, size_t len, uint32_t now);
+    EspStatus::Status poll(uint32_t now);
+    bool isActive(void) { return _active; }
+
+    uint32_t bytesReceived(void) { return _stats.bytes; }
+    uint32_t totalBytes(void) { return _totalBytes; }
+    const XferStats &stats(void) { return _stats; }
+
+private:
+    struct Slot {
+        uint16_t len;
+        bool valid;
+        uint8_t data[XFER_CHUNK_SIZE];
+    };
+
+    SendFn _send;
+    OpenFn _open;
+    WriteFn _write;
+    Slot *_slots = nullptr;
+    MD5Builder _md5;
+    EspStatus::Status _status = EspStatus::WAITING;
+    bool _active = false;
+    bool _endOk = false;
+    uint16_t _id = 0;
+    uint32_t _totalBytes = 0;
+    uint32_t _totalChunks = 0;
+    uint32_t _expected = 0; // next in-order chunk
+    uint8_t _pendingAcks = 0;
+    uint32_t _lastAckAt = 0;
+    XferStats _stats;
+
+    void sendAck(uint32_t now);
+    void sendHeader(XferType type, uint32_t seq);
+    void sendEndAck(void);
+};
+
+struct XferLoopbackResult {
+    bool ok = false;      // every byte arrived in order and both ends report SUCCESS
+    uint32_t dropped = 0; // frames the simulated link lost
+    XferStats stats;      // of the sender, in ticks of 1 ms
+};
+
+// Runs a sender and a receiver against each other over a simulated link that
+// carries one frame per 1 ms tick each way and drops `lossPercent` of the frames
+// in both directions, the same ones for the same seed. idle runs every 256 ticks.
+XferLoopbackResult espTransferLoopback(
+    uint8_t lossPercent, uint32_t totalBytes, uint32_t seed, std::function<void()> idle = nullptr
+);
+
+#endif
@@ -1,6 +1,10 @@
 #include "file_sharing.h"
 #include "core/display.h"
+#include "esp_transfer.h"
 #include <SD.h>
+
+#define PROGRESS_INTERVAL 250
+
 FileSharing::FileSharing() {}
 
 void FileSharing::sendFile() {
@@ -15,46 +19,58 @@ void FileSharing::sendFile() {
         return;
     }
 
-    Message message = createFileMessage(file);
-
-    esp_err_t response;
-    sendStatus = STARTED;
+    String path = String(file.path());
+    EspTransferSender sender(
+        [this](const uint8_t *data, size_t len) { return esp_now_send(dstAddress, data, len) == ESP_OK; },
+        [&file](uint8_t *buf, size_t len) { return file.read(buf, len); }
+    );
+    String folder = path.substring(0, path.lastIndexOf("/"));
+    if (!sender.begin((uint16_t)esp_random(), file.size(), file.name(), folder.c_str(), millis())) {
+        displayError("Out of memory");
+        file.close();
+        delay(1000);
+        return;
+    }
 
     drawMainBorderWithTitle("SEND FILE");
     padprintln("");
     padprintln("Sending...");
 
-    delay(100);
-
-    while (file.available()) {
-        if (check(EscPress)) sendStatus = ABORTED;
-
-        if (sendStatus == ABORTED || sendStatus == FAILED) {
-            message.done = true;
-            message.dataSize = 0;
-            esp_now_send(dstAddress, (uint8_t *)&message, sizeof(message));
-            displayError("Error sending file");
+    Status status = STARTED;
+    RecvFrame frame;
+    uint32_t lastProgress = 0;
+    while (status == STARTED) {
+        if (check(EscPress)) {
+            sender.abort();
+            status = ABORTED;
             break;
         }
 
-        size_t bytesRead = file.readBytes(message.data, ESP_DATA_SIZE);
-        message.dataSize = bytesRead;
-        message.bytesSent = min(message.bytesSent + bytesRead, message.totalBytes);
-        message.done = message.bytesSent == message.totalBytes;
+        while (popFrame(frame)) sender.onFrame(frame.data, frame.len, millis());
+        status = sender.poll(millis());
 
-        response = esp_now_send(dstAddress, (uint8_t *)&message, sizeof(message));
-        if (response != ESP_OK) {
-            Serial.printf("Send file response: %s\n", esp_err_to_name(response));
-            sendStatus = FAILED;
+        if (millis() - lastProgress > PROGRESS_INTERVAL) {
+            progressHandler(sender.bytesAcked(), sender.totalBytes(), "Sending...");
+            lastProgress = millis();
         }
-
-        progressHandler(file.position(), file.size(), "Sending...");
-        delay(100);
+        vTaskDelay(1);
     }
+    file.close();
 
-    if (message.bytesSent == message.totalBytes) displaySuccess("File sent");
+    const XferStats &stats = sender.stats();
+    Serial.printf(
+        "Send %s: %lu bytes in %lu ms (%.1f KB/s), %lu frames, %lu retransmits\n",
+        status == SUCCESS ? "done" : "failed",
+        stats.bytes,
+        stats.elapsed(),
+        stats.kbps(),
+        stats.frames,
+        stats.retransmits
+    );
+
+    if (status == SUCCESS) displaySuccess("File sent " + String(stats.kbps(), 1) + "KB/s");
+    else displayError("Error sending file");
 
-    file.close();
     delay(1000);
 }
 
@@ -64,42 +80,69 @@ void FileSharing::receiveFile() {
     padprintln("Waiting...");
 
     recvFileName = "";
-    recvQueue = {};
     recvStatus = CONNECTING;
 
     if (!beginEspnow()) return;
 
-    delay(100);
+    EspTransferReceiver receiver(
+        [this](const uint8_t *data, size_t len) { return esp_now_send(recvPeer, data, len) == ESP_OK; },
+        [this](const XferStartFrame &start) { return openRecvFile(start.filename, start.filepath); },
+        [this](const uint8_t *data, size_t len) { return recvFile.write(data, len) == len; }
+    );
 
+    RecvFrame frame;
+    uint32_t lastProgress = 0;
     while (1) {
         if (check(EscPress)) recvStatus = ABORTED;
-
-        if (recvStatus == ABORTED || recvStatus == FAILED) {
-            displayError("Error receiving file");
-            break;
-        }
-        if (recvStatus == SUCCESS) {
-            displaySuccess("File received");
-            break;
+        if (recvStatus == ABORTED || recvStatus == FAILED || recvStatus == SUCCESS) break;
+
+        while (popFrame(frame)) {
+            // The first START tells us who to answer to
+            if (!receiver.isActive() && recvStatus == CONNECTING && isXferFrame(frame.data, frame.len) &&
+                frame.data[1] == XFER_START) {
+                if (!setupPeer(frame.mac)) continue;
+                memcpy(recvPeer, frame.mac, 6);
+            }
+            receiver.onFrame(frame.data, frame.len, millis());
         }
+        Status status = receiver.poll(millis());
+        if (status != WAITING) recvStatus = status;
 
-        if (!recvQueue.empty()) {
-            Message recvFileMessage = recvQueue.front();
-            recvQueue.erase(recvQueue.begin());
+        if (recvStatus == STARTED && millis() - lastProgress > PROGRESS_INTERVAL) {
+            progressHandler(receiver.bytesReceived(), receiver.totalBytes(), "Receiving...");
+            lastProgress = millis();
+        }
+        vTaskDelay(1);
+    }
 
-            progressHandler(recvFileMessage.bytesSent, recvFileMessage.totalBytes, "Receiving...");
+    if (recvFile) recvFile.close();
 
-            if (!appendToFile(recvFileMessage)) {
-                recvStatus = FAILED;
-                Serial.println("Failed appending to file");
-            }
-            if (recvFileMessage.done) {
-                Serial.println("Recv done");
-                recvStatus = recvFileMessage.bytesSent == recvFileMessage.totalBytes ? SUCCESS : FAILED;
-            }
+    // Keep answering for a moment in case our END_ACK was lost
+    if (recvStatus == SUCCESS) {
+        uint32_t lingerStart = millis();
+        while (millis() - lingerStart < 500) {
+            while (popFrame(frame)) receiver.onFrame(frame.data, frame.len, millis());
+            vTaskDelay(10);
         }
+    }
+
+    const XferStats &stats = receiver.stats();
+    Serial.printf(
+        "Recv %s: %lu bytes in %lu ms (%.1f KB/s), %lu frames\n",
+        recvStatus == SUCCESS ? "done" : "failed",
+        stats.bytes,
+        stats.elapsed(),
+        stats.kbps(),
+        stats.frames
+    );
 
-        delay(100);
+    if (recvStatus == SUCCESS) {
+        displaySuccess("File received");
+    } else {
+        displayError("Error receiving file");
+        // A partial or corrupted file is of no use
+        FS *fs;
+        if (recvFileName != "" && getFsStorage(fs)) fs->remove(recvFileName);
     }
 
     delay(1000);
@@ -109,6 +152,7 @@ void FileSharing::receiveFile() {
         padprintln("");
         padprintln("File received: ");
         padprintln(recvFileName);
+        padprintln(String(stats.kbps(), 1) + " KB/s");
         padprintln("\n");
         padprintln("Press any key to leave");
         while (!check(AnyKeyPress)) vTaskDelay(50 / portTICK_PERIOD_MS);
@@ -133,25 +177,18 @@ File FileSharing::selectFile() {
     return file;
 }
 
-bool FileSharing::appendToFile(FileSharing::Message fileMessage) {
+bool FileSharing::openRecvFile(const char *filename, const char *filepath) {
     FS *fs;
     if (!getFsStorage(fs)) return false;
 
-    if (recvFileName == "") createFilename(fs, fileMessage);
-
-    File file = (*fs).open(recvFileName, FILE_APPEND);
-    if (!file) return false;
+    createFilename(fs, filename, filepath);
 
-    file.write((const uint8_t *)fileMessage.data, fileMessage.dataSize);
-    file.close();
-
-    return true;
+    // Kept open for the whole transfer, the FS layer buffers the small writes
+    recvFile = (*fs).open(recvFileName, FILE_WRITE);
+    return (bool)recvFile;
 }
 
-void FileSharing::createFilename(FS *fs, FileSharing::Message fileMessage) {
-    String messageFilename = String(fileMessage.filename);
-    String messageFilepath = String(fileMessage.filepath);
-
+void FileSharing::createFilename(FS *fs, String messageFilename, String messageFilepath) {
     String filename = messageFilename.substring(0, messageFilename.lastIndexOf("."));
     String ext = messageFilename.substring(messageFilename.lastIndexOf("."));
 
@@ -18,13 +18,15 @@ public:
 
 private:
     String recvFileName;
+    File recvFile;
+    uint8_t recvPeer[6];
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Helpers
     /////////////////////////////////////////////////////////////////////////////////////
     File selectFile();
-    bool appendToFile(Message fileMessage);
-    void createFilename(FS *fs, Message fileMessage);
+    bool openRecvFile(const char *filename, const char *filepath);
+    void createFilename(FS *fs, String messageFilename, String messageFilepath);
 };
 
 #endif
@@ -61,7 +61,6 @@ void EspSerialCmd::receiveCommands() {
     padprintln("Waiting...");
 
     recvCommand = "";
-    recvQueue.clear();
     recvStatus = CONNECTING;
     Message recvMessage;
 
@@ -85,10 +84,7 @@ void EspSerialCmd::receiveCommands() {
             recvStatus = WAITING;
         }
 
-        if (!recvQueue.empty()) {
-            recvMessage = recvQueue.front();
-            recvQueue.erase(recvQueue.begin());
-
+        if (popMessage(recvMessage)) {
             recvCommand = recvMessage.data;
             Serial.println(recvCommand);
 
@@ -1,8 +1,10 @@
 #include "display.h"
+#include "core/image_cache.h"
 #include "core/wifi/webInterface.h" // for server
 #include "core/wifi/wg.h"           //for isConnectedWireguard to print wireguard lock
 #include "mykeyboard.h"
 #include "settings.h" //for timeStr
+#include "sprite_canvas.h"
 #include "utils.h"
 #include <JPEGDecoder.h>
 #include <interface.h> //for charging ischarging to print charging indicator
@@ -477,6 +479,7 @@ int loopOptions(
             if (devModeCounter >= 5 && !bruceConfig.devMode) {
                 bruceConfig.setDevMode(true);
                 displayInfo("Dev Mode Enabled", true);
+                invalidateCanvases();
             }
             if (millis() - _clock_bat_timer > 30000) {
                 _clock_bat_timer = millis();
@@ -494,6 +497,7 @@ int loopOptions(
             bool renderedByLambda = false;
             if (options[index].hover)
                 renderedByLambda = options[index].hover(options[index].hoverPointer, true);
+            if (renderedByLambda && menuType != MENU_TYPE_MAIN) invalidateCanvases(); // drew over the list
 
             if (!renderedByLambda) {
                 if (menuType == MENU_TYPE_SUBMENU) drawSubmenu(index, options, subText);
@@ -532,8 +536,10 @@ int loopOptions(
             long _tmp = millis();
 #ifndef HAS_ENCODER // T-Embed doesn't need it
             LongPress = true;
+            bool arcDrawn = false;
             while (PrevPress && menuType != MENU_TYPE_MAIN) {
-                if (millis() - _tmp > 200)
+                if (millis() - _tmp > 200) {
+                    arcDrawn = true;
                     tft.drawArc(
                         tftWidth / 2,
                         tftHeight / 2,
@@ -544,14 +550,19 @@ int loopOptions(
                         getColorVariation(bruceConfig.priColor),
                         bruceConfig.bgColor
                     );
+                }
                 vTaskDelay(10 / portTICK_RATE_MS);
             }
-            tft.drawArc(
-                tftWidth / 2, tftHeight / 2, 25, 15, 0, 360, bruceConfig.bgColor, bruceConfig.bgColor
-            );
+            if (arcDrawn) {
+                tft.drawArc(
+                    tftWidth / 2, tftHeight / 2, 25, 15, 0, 360, bruceConfig.bgColor, bruceConfig.bgColor
+                );
+                invalidateCanvases(); // the erased ring cut through the list
+            }
             LongPress = false;
 #endif
             if (millis() - _tmp > 700) { // longpress detected to exit
+                inputDrain();
                 index = -1;
                 break;
             } else {
@@ -584,6 +595,7 @@ int loopOptions(
                 Serial.print("Forcely ");
             }
             Serial.println("Selected: " + String(options[chosen].label));
+            releaseMenuCanvases(); // give the RAM back to the app
             options[chosen].operation();
             break;
         }
@@ -614,6 +626,7 @@ int loopOptions(
         if (menuType != MENU_TYPE_MAIN && check(EscPress)) break;
 #endif
     }
+    releaseMenuCanvases();
     return index;
 }
 
@@ -632,6 +645,73 @@ void progressHandler(int progress, size_t total, String message) {
     tft.fillRect(20, tftHeight - 45, barWidth, 13, bruceConfig.priColor);
 }
 
+/***************************************************************************************
+** Function name: drawOptionsBuffered
+** Description:   drawOptions on the options canvas, only the rows that changed are
+**                redrawn and pushed to the screen
+***************************************************************************************/
+struct OptionRow {
+    String text;
+    uint16_t color;
+};
+static std::vector<OptionRow> optionRows;
+
+static Opt_Coord drawOptionsBuffered(
+    int index, std::vector<Option> &options, uint16_t fgcolor, uint16_t selcolor, uint16_t bgcolor,
+    bool firstRender
+) {
+    Opt_Coord coord;
+#ifdef HAS_SCREEN
+    TFT_eSprite &s = optionsCanvas.sprite();
+    int boxX = tftWidth * 0.10;
+    int boxW = tftWidth * 0.8;
+    int rowH = FM * 8 + 4;
+    int visible = min((int)options.size(), MAX_MENU_SIZE);
+    int boxH = rowH * visible + 10;
+    int boxY = tftHeight / 2 - visible * rowH / 2 - 5;
+    int chars = (boxW - 10) / (LW * FM) - 1;
+    int init = index >= MAX_MENU_SIZE ? index - MAX_MENU_SIZE + 1 : 0;
+
+    uint32_t key = canvasKey(&fgcolor, sizeof(fgcolor));
+    key = canvasKey(&bgcolor, sizeof(bgcolor), key);
+    key = canvasKey(&visible, sizeof(visible), key);
+    if (optionsCanvas.changed(key) || firstRender || (int)optionRows.size() != visible) {
+        s.fillSprite(bgcolor);
+        s.drawRoundRect(0, 0, boxW, boxH, 5, fgcolor);
+        optionRows.assign(visible, {"", bgcolor}); // forces every row below
+        optionsCanvas.damageAll();
+    }
+
+    s.setTextSize(FM);
+    for (int row = 0; row < visible; row++) {
+        int i = init + row;
+        int y = 9 + row * rowH; // text line inside the box
+        if (i == index) {
+            coord.x = boxX + 5 + FM * LW;
+            coord.y = boxY + y;
+            coord.size = chars;
+            coord.fgcolor = fgcolor;
+            coord.bgcolor = bgcolor;
+        }
+
+        String text = i == index ? ">" : " ";
+        text += options[i].label;
+        text = text.substring(0, chars);
+        uint16_t color = options[i].selected ? selcolor : fgcolor;
+        if (optionRows[row].text == text && optionRows[row].color == color) continue;
+
+        optionRows[row] = {text, color};
+        s.fillRect(5, y, boxW - 10, FM * 8, bgcolor);
+        s.setTextColor(color, bgcolor);
+        s.setCursor(5, y);
+        s.print(text);
+        optionsCanvas.damage(0, y, boxW, FM * 8); // full width, pushed as one window
+    }
+    optionsCanvas.flush(boxX, boxY);
+#endif
+    return coord;
+}
+
 /***************************************************************************************
 ** Function name: drawOptions
 ** Description:   Função para desenhar e mostrar as opçoes de contexto
@@ -649,6 +729,15 @@ Opt_Coord drawOptions(
 
     int32_t optionsTopY = tftHeight / 2 - menuSize * (FM * 8 + 4) / 2 - 5;
     tft.drawPixel(0, 0, bruceConfig.bgColor);
+    if (optionsCanvas.begin(tftWidth * 0.8, (FM * 8 + 4) * menuSize + 10)) {
+        coord = drawOptionsBuffered(index, options, fgcolor, selcolor, bgcolor, firstRender);
+#if defined(HAS_TOUCH)
+        TouchFooter();
+#endif
+        renderStats.endFrame(true);
+        return coord;
+    }
+
     if (firstRender) {
         tft.fillRoundRect(
             tftWidth * 0.10, optionsTopY, tftWidth * 0.8, (FM * 8 + 4) * menuSize + 10, 5, bgcolor
@@ -661,6 +750,7 @@ Opt_Coord drawOptions(
             5,
             fgcolor
         );
+        renderStats.add((int)(tftWidth * 0.8) * ((FM * 8 + 4) * menuSize + 10));
     }
 
     tft.setTextColor(fgcolor, bgcolor);
@@ -688,7 +778,9 @@ Opt_Coord drawOptions(
             } else text += " ";
             text += String(options[i].label) + "              ";
             tft.setCursor(tftWidth * 0.10 + 5, tft.getCursorY() + 4);
-            tft.println(text.substring(0, (tftWidth * 0.8 - 10) / (LW * FM) - 1));
+            text = text.substring(0, (tftWidth * 0.8 - 10) / (LW * FM) - 1);
+            tft.println(text);
+            renderStats.add(text.length() * LW * FM * 8 * FM);
             cont++;
         }
         if (cont > MAX_MENU_SIZE) goto Exit;
@@ -698,6 +790,7 @@ Exit:
 #if defined(HAS_TOUCH)
     TouchFooter();
 #endif
+    renderStats.endFrame(false);
     return coord;
 }
 
@@ -824,6 +917,7 @@ void drawMainBorder(bool clear) {
     if (clear) {
         tft.drawPixel(0, 0, 0);
         tft.fillScreen(bruceConfig.bgColor);
+        invalidateCanvases();
     }
     setTftDisplay(12, 12, bruceConfig.priColor, 1, bruceConfig.bgColor);
     tft.setTextDatum(0);
@@ -1088,9 +1182,6 @@ void jpegRender(int xpos, int ypos) {
     uint32_t max_x = JpegDec.width;
     uint32_t max_y = JpegDec.height;
 
-    bool swapBytes = tft.getSwapBytes();
-    tft.setSwapBytes(true);
-
     // Jpeg images are draw as a set of image block (tiles) called Minimum Coding Units (MCUs)
     // Typically these MCUs are 16x16 pixel blocks
     // Determine the width and height of the right and bottom edge image blocks
@@ -1101,19 +1192,21 @@ void jpegRender(int xpos, int ypos) {
     uint32_t win_w = mcu_w;
     uint32_t win_h = mcu_h;
 
-    // save the coordinate of the right and bottom edges to assist image cropping
-    // to the screen size
-    max_x += xpos;
-    max_y += ypos;
+    // MCUs are collected into strips of full MCU rows, pushImage crops them to the screen
+    ImageBlit blit;
+    if (!blit.begin(xpos, ypos, max_x, max_y, true, mcu_h)) {
+        JpegDec.abort();
+        return;
+    }
+    blit.setCapture(imageCache.capture(max_x, max_y, true));
 
     // Fetch data from the file, decode and display
-    tft.fillRect(xpos, ypos, JpegDec.width, JpegDec.height, TFT_BLACK);
     while (JpegDec.read()) {   // While there is more data in the file
         pImg = JpegDec.pImage; // Decode a MCU (Minimum Coding Unit, typically a 8x8 or 16x16 pixel block)
 
-        // Calculate coordinates of top left corner of current MCU
-        int mcu_x = JpegDec.MCUx * mcu_w + xpos;
-        int mcu_y = JpegDec.MCUy * mcu_h + ypos;
+        // Calculate coordinates of top left corner of current MCU, relative to the image
+        int mcu_x = JpegDec.MCUx * mcu_w;
+        int mcu_y = JpegDec.MCUy * mcu_h;
 
         // check if the image block size needs to be changed for the right edge
         if (mcu_x + mcu_w <= max_x) win_w = mcu_w;
@@ -1137,17 +1230,12 @@ void jpegRender(int xpos, int ypos) {
             }
         }
 
-        // calculate how many pixels must be drawn
-        uint32_t mcu_pixels = win_w * win_h;
+        blit.writeBlock(mcu_x, mcu_y, win_w, win_h, pImg);
 
-        // draw image MCU block only if it will fit on the screen
-        if ((mcu_x + win_w) <= tft.width() && (mcu_y + win_h) <= tft.height())
-            tft.pushImage(mcu_x, mcu_y, win_w, win_h, pImg);
-        else if ((mcu_y + win_h) > tft.height())
-            JpegDec.abort(); // Image has run off bottom of screen so abort decoding
+        // Image has run off bottom of screen so abort decoding, unless it is being cached
+        if (ypos + mcu_y + win_h > tft.height() && !imageCache.capturing()) JpegDec.abort();
     }
-
-    tft.setSwapBytes(swapBytes);
+    blit.end();
 }
 
 bool showJpeg(FS &fs, String filename, int x, int y, bool center) {
@@ -1160,41 +1248,20 @@ bool showJpeg(FS &fs, String filename, int x, int y, bool center) {
     const size_t data_size = picture.size();
 
     // Alloc memory into heap
-    uint8_t *data_array = new uint8_t[data_size];
+    uint8_t *data_array = new (std::nothrow) uint8_t[data_size];
     if (data_array == nullptr) {
         // Fail allocating memory
         picture.close();
-        delete[] data_array;
         return false;
     }
 
-    uint8_t data;
-    int i = 0;
-    byte line_len = 0;
-
-    while (picture.available()) {
-        data = picture.read();
-        data_array[i] = data;
-        i++;
-
-        // print array on Serial
-        /*
-        Serial.print("0x");
-        if (abs(data) < 16) {
-          Serial.print("0");
-        }
-
-        Serial.print(data, HEX);
-        Serial.print(","); // Add value and comma
-        line_len++;
-        if (line_len >= 32) {
-          line_len = 0;
-          Serial.println();
-        }
-        */
-    }
-
+    // One read for the whole file instead of a call per byte
+    size_t read_size = picture.read(data_array, data_size);
     picture.close();
+    if (read_size != data_size) {
+        delete[] data_array;
+        return false;
+    }
 
     bool decoded = false;
     if (data_array) {
@@ -1234,7 +1301,7 @@ bool showJpeg(FS &fs, String filename, int x, int y, bool center) {
 //  https://github.com/bitbank2/AnimatedGIF/blob/master/examples/best_practices_example/best_practices_example.ino
 // ####################################################################################################
 
-Gif::Gif() : gifPosition(0, 0) {}
+Gif::Gif() : gifPosition(0, 0) { gifPosition.blit = &blit; }
 
 Gif::~Gif() {
     gif->close();
@@ -1302,6 +1369,11 @@ void Gif::GIFDraw(GIFDRAW *pDraw) {
     usPalette = pDraw->pPalette;
     y = pDraw->iY + pDraw->y; // current line
 
+    // Opaque lines of a frame are collected into strips, one window per strip
+    if (pDraw->y == 0) {
+        position->blit->begin(pDraw->iX + position->x, y + position->y, iWidth, pDraw->iHeight, false);
+    }
+
     s = pDraw->pPixels;
     if (pDraw->ucDisposalMethod == 2) { // restore to background color
         for (x = 0; x < iWidth; x++) {
@@ -1311,6 +1383,7 @@ void Gif::GIFDraw(GIFDRAW *pDraw) {
     }
     // Apply the new pixels to the main image
     if (pDraw->ucHasTransparency) { // if transparency used
+        position->blit->sync();     // runs are pushed directly, strips would overwrite what shows through
         uint8_t *pEnd, c, ucTransparent = pDraw->ucTransparent;
         int x, iCount;
         pEnd = s + iWidth;
@@ -1350,8 +1423,12 @@ void Gif::GIFDraw(GIFDRAW *pDraw) {
         s = pDraw->pPixels;
         // Translate the 8-bit pixels through the RGB565 palette (already byte reversed)
         for (x = 0; x < iWidth; x++) usTemp[x] = usPalette[*s++];
-        tft.drawPixel(0, 0, 0);
-        tft.pushImage(pDraw->iX + position->x, y + position->y, iWidth, 1, (uint16_t *)usTemp);
+        if (position->blit->isActive()) {
+            position->blit->writeRow(pDraw->y, usTemp);
+        } else {
+            tft.drawPixel(0, 0, 0);
+            tft.pushImage(pDraw->iX + position->x, y + position->y, iWidth, 1, (uint16_t *)usTemp);
+        }
     }
 } /* GIFDraw() */
 
@@ -1382,7 +1459,10 @@ int Gif::playFrame(int x, int y, bool bSync) {
         lTime = millis();
         gifPosition.x = x;
         gifPosition.y = y;
-        return gif->playFrame(false, delayMilliseconds, &gifPosition);
+        int result = gif->playFrame(false, delayMilliseconds, &gifPosition);
+        blit.finish(); // push the last strip of the frame
+        if (result >= 0) frames++;
+        return result;
     }
 
     return 2;
@@ -1421,6 +1501,13 @@ bool showGif(FS *fs, const char *filename, int x, int y, bool center, int playDu
         if (playDurationMs == 0 && result == 0) break;
     } while (result >= 0);
 
+    unsigned long elapsed = millis() - timeStart;
+    Serial.printf(
+        "GIF: %lu frames in %lu ms, %.1f fps\n",
+        (unsigned long)gif.framesPlayed(),
+        elapsed,
+        elapsed ? gif.framesPlayed() * 1000.0f / elapsed : 0.0f
+    );
     return true;
 }
 #endif
@@ -1570,15 +1657,16 @@ bool drawBmp(FS &fs, String filename, int x, int y, bool center) {
         }
 
         if ((read16(bmpFS) == 1) && (read16(bmpFS) == 24) && (read32(bmpFS) == 0)) {
-            y += h - 1;
-
-            bool oldSwapBytes = tft.getSwapBytes();
-            tft.setSwapBytes(true);
             bmpFS.seek(seekOffset);
 
             uint16_t padding = (4 - ((w * 3) & 3)) & 3;
             uint8_t lineBuffer[w * 3 + padding];
 
+            // BMP rows are stored bottom up, strips are filled from the bottom
+            ImageBlit blit;
+            if (!blit.begin(x, y, w, h, true, 1, true)) goto ERROR;
+            blit.setCapture(imageCache.capture(w, h, true));
+
             for (row = 0; row < h; row++) {
 
                 bmpFS.read(lineBuffer, sizeof(lineBuffer));
@@ -1592,14 +1680,10 @@ bool drawBmp(FS &fs, String filename, int x, int y, bool center) {
                     *tptr++ = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
                 }
 
-                // Push the pixel row to screen, pushImage will crop the line if needed
-                // y is decremented as the BMP image is drawn bottom up
-                tft.drawPixel(
-                    0, 0, 0
-                ); // shared TFT_Spi devices struggle to work, need call a line first sometimes
-                tft.pushImage(x, y--, w, 1, (uint16_t *)lineBuffer);
+                // pushImage will crop the strips if needed
+                blit.writeRow(h - 1 - row, (uint16_t *)lineBuffer);
             }
-            tft.setSwapBytes(oldSwapBytes);
+            blit.end();
             Serial.print("BMP Loaded in ");
             Serial.print(millis() - startTime);
             Serial.println(" ms");
@@ -1616,15 +1700,60 @@ bool drawBmp(FS &fs, String filename, int x, int y, bool center) {
     return true;
 }
 
+// Theme images are drawn on every menu visit, keep them decoded in PSRAM
+static bool isThemeImage(FS &fs, const String &filename) {
+    if (bruceConfig.themePath.length() == 0 || &fs != bruceConfig.themeFS()) return false;
+    String themeDir = bruceConfig.themePath.substring(0, bruceConfig.themePath.lastIndexOf('/') + 1);
+    return filename.startsWith(themeDir);
+}
+
+static bool drawStaticImg(FS &fs, const String &filename, const String &ext, int x, int y, bool center) {
+    if (ext.endsWith("jpg")) return showJpeg(fs, filename, x, y, center);
+    else if (ext.endsWith("bmp")) return drawBmp(fs, filename, x, y, center);
+    else if (ext.endsWith("png")) return drawPNG(fs, filename, x, y, center);
+    return false;
+}
+
+static bool drawCachedImg(FS &fs, const String &filename, const String &ext, int x, int y, bool center) {
+    uint32_t start = millis();
+    File file = fs.open(filename, FILE_READ);
+    if (!file) return false;
+    time_t mtime = file.getLastWrite();
+    size_t size = file.size();
+    file.close();
+
+    bool ok;
+    const CachedImage *img = imageCache.find(fs, filename, mtime, size);
+    if (img) {
+        ok = imageCache.draw(img, x, y, center);
+    } else {
+        imageCache.beginCapture(fs, filename, mtime, size);
+        ok = drawStaticImg(fs, filename, ext, x, y, center);
+        imageCache.commit(ok);
+    }
+    Serial.printf(
+        "Theme img %s: %lu ms (%s, %u/%u hits, %u KB cached)\n",
+        filename.c_str(),
+        millis() - start,
+        img ? "cached" : "decoded",
+        (unsigned)imageCache.hits(),
+        (unsigned)(imageCache.hits() + imageCache.misses()),
+        (unsigned)(imageCache.bytes() / 1024)
+    );
+    return ok;
+}
+
 bool drawImg(FS &fs, String filename, int x, int y, bool center, int playDurationMs) {
     String ext = filename.substring(filename.lastIndexOf('.'));
     ext.toLowerCase();
     uint8_t fls = 2;         // 2 for Little FS
     if (&fs == &SD) fls = 0; // 0 for SD
     tft.imageToBin(fls, filename, x, y, center, playDurationMs);
-    if (ext.endsWith("jpg")) return showJpeg(fs, filename, x, y, center);
-    else if (ext.endsWith("bmp")) return drawBmp(fs, filename, x, y, center);
-    else if (ext.endsWith("png")) return drawPNG(fs, filename, x, y, center);
+    if (ext.endsWith("jpg") || ext.endsWith("bmp") || ext.endsWith("png")) {
+        if (imageCache.enabled() && isThemeImage(fs, filename))
+            return drawCachedImg(fs, filename, ext, x, y, center);
+        return drawStaticImg(fs, filename, ext, x, y, center);
+    }
 
 #if !defined(LITE_VERSION)
 
@@ -1648,6 +1777,7 @@ PNG *png = nullptr;
 // Optional pointer to write decoded lines into a cached BIN file
 static File *pngBinOut = nullptr;
 static bool pngCacheOnly = false;
+static ImageBlit *pngBlit = nullptr;
 // Optionally use heap capabilities on ESP32 to pick the best memory region for the decoder
 #if defined(ESP32)
 #include <esp_heap_caps.h>
@@ -1683,7 +1813,9 @@ int PNGDraw(PNGDRAW *pDraw) {
     uint8_t g = ((uint16_t)bruceConfig.bgColor & 0x07E0) >> 3;
     uint8_t b = ((uint16_t)bruceConfig.bgColor & 0x001F) << 3;
     png->getLineAsRGB565(pDraw, usPixels, PNG_RGB565_BIG_ENDIAN, b << 16 | g << 8 | r);
-    if (!pngCacheOnly) {
+    if (pngBlit) {
+        pngBlit->writeRow(pDraw->y, usPixels);
+    } else if (!pngCacheOnly) {
         tft.drawPixel(0, 0, 0);
         tft.drawPixel(0, 0, 0);
         tft.pushImage(xpos, ypos + pDraw->y, pDraw->iWidth, 1, usPixels);
@@ -1737,10 +1869,12 @@ static bool drawPngBin(FS &fs, const String &binPath, int x, int y, bool center)
     }
 
     std::unique_ptr<uint16_t[]> line(new (std::nothrow) uint16_t[w]);
-    if (!line) {
+    ImageBlit blit;
+    if (!line || !blit.begin(x, y, w, h, false)) {
         f.close();
         return false;
     }
+    blit.setCapture(imageCache.capture(w, h, false));
 
     size_t rowBytes = w * sizeof(uint16_t);
     for (uint16_t row = 0; row < h; ++row) {
@@ -1748,7 +1882,7 @@ static bool drawPngBin(FS &fs, const String &binPath, int x, int y, bool center)
             f.close();
             return false;
         }
-        tft.pushImage(x, y + row, w, 1, line.get());
+        blit.writeRow(row, line.get());
     }
 
     f.close();
@@ -1810,13 +1944,22 @@ bool drawPNG(FS &fs, String filename, int x, int y, bool center) {
         if (center) {
             xpos = x + (tftWidth - png->getWidth()) / 2;
             ypos = y + (tftHeight - png->getHeight()) / 2;
+        } else {
+            xpos = x;
+            ypos = y;
         }
 
         if (png->getWidth() > MAX_IMAGE_WIDTH) {
             Serial.println("Image too wide for allocated line buffer size!");
         } else {
+            ImageBlit blit;
+            if (!pngCacheOnly && blit.begin(xpos, ypos, png->getWidth(), png->getHeight(), false)) {
+                blit.setCapture(imageCache.capture(png->getWidth(), png->getHeight(), false));
+                pngBlit = &blit;
+            }
             rc = png->decode(NULL, 0);
             png->close();
+            pngBlit = nullptr;
         }
 
         if (pngBinOut) {
@@ -28,11 +28,13 @@ void displayScrollingText(const String &text, Opt_Coord &coord);
 
 #if !defined(LITE_VERSION)
 
+#include "core/image_cache.h"
 #include <AnimatedGIF.h>
 
 struct GifPosition {
     int x;
     int y;
+    ImageBlit *blit = nullptr;
 
     GifPosition(int xCoord, int yCoord) : x(xCoord), y(yCoord) {}
 };
@@ -59,6 +61,8 @@ public:
 
     int getLastError();
 
+    uint32_t framesPlayed() { return frames; }
+
     AnimatedGIF *gif;
 
 private:
@@ -70,6 +74,8 @@ private:
     int *delayMilliseconds = &zero;
 
     GifPosition gifPosition;
+    ImageBlit blit;
+    uint32_t frames = 0;
 
     static void *openFile(const char *fname, int32_t *pSize);
 
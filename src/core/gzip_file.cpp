@@ -0,0 +1,225 @@
+#include "gzip_file.h"
+#include <esp_rom_crc.h>
+
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+#define GZIP_NONE 0xFFFFFFFF
+
+static const uint16_t lengthBase[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t lengthExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distBase[] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+                                    33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+                                    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distExtra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+namespace {
+
+// Deflate bit stream, least significant bit first, written to the file in small blocks
+class BitWriter {
+public:
+    explicit BitWriter(File &out) : _out(out) {}
+
+    void bits(uint32_t value, uint8_t count) {
+        _acc |= value << _count;
+        _count += count;
+        while (_count >= 8) {
+            byte(_acc & 0xFF);
+            _acc >>= 8;
+            _count -= 8;
+        }
+    }
+
+    // Huffman codes are defined most significant bit first
+    void code(uint16_t value, uint8_t count) {
+        uint16_t reversed = 0;
+        for (uint8_t i = 0; i < count; i++) reversed |= ((value >> i) & 1) << (count - 1 - i);
+        bits(reversed, count);
+    }
+
+    void byte(uint8_t b) {
+        _buf[_len++] = b;
+        if (_len == sizeof(_buf)) flush();
+    }
+
+    bool finish() {
+        if (_count > 0) bits(0, 8 - _count);
+        flush();
+        return _ok;
+    }
+
+private:
+    File &_out;
+    uint8_t _buf[256];
+    size_t _len = 0;
+    uint32_t _acc = 0;
+    uint8_t _count = 0;
+    bool _ok = true;
+
+    void flush() {
+        if (_len > 0 && _out.write(_buf, _len) != _len) _ok = false;
+        _len = 0;
+    }
+};
+
+// Fixed Huffman literal/length alphabet (RFC 1951, 3.2.6)
+void putSymbol(BitWriter &w, uint16_t sym) {
+    if (sym < 144) w.code(0x30 + sym, 8);
+    else if (sym < 256) w.code(0x190 + sym - 144, 9);
+    else if (sym < 280) w.code(sym - 256, 7);
+    else w.code(0xC0 + sym - 280, 8);
+}
+
+void putMatch(BitWriter &w, uint16_t len, uint16_t dist) {
+    uint8_t i = sizeof(lengthBase) / sizeof(lengthBase[0]) - 1;
+    while (lengthBase[i] > len) i--;
+    putSymbol(w, 257 + i);
+    w.bits(len - lengthBase[i], lengthExtra[i]);
+
+    uint8_t d = sizeof(distBase) / sizeof(distBase[0]) - 1;
+    while (distBase[d] > dist) d--;
+    w.code(d, 5);
+    w.bits(dist - distBase[d], distExtra[d]);
+}
+
+void putLE32(BitWriter &w, uint32_t v) {
+    for (uint8_t i = 0; i < 4; i++) w.byte(v >> (i * 8));
+}
+
+inline uint32_t hash3(const uint8_t *p) {
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & ((1 << GZIP_HASH_BITS) - 1);
+}
+
+void *gzipAlloc(size_t bytes) { return psramFound() ? ps_malloc(bytes) : malloc(bytes); }
+
+} // namespace
+
+bool gzipFile(FS &fs, const String &src, const String &dst, uint32_t mtime) {
+    File in = fs.open(src, FILE_READ);
+    if (!in) return false;
+
+    // window holds the last GZIP_WINDOW bytes of history followed by the lookahead
+    uint8_t *window = (uint8_t *)gzipAlloc(2 * GZIP_WINDOW);
+    uint32_t *head = (uint32_t *)gzipAlloc((1 << GZIP_HASH_BITS) * sizeof(uint32_t));
+    uint32_t *prev = (uint32_t *)gzipAlloc(GZIP_WINDOW * sizeof(uint32_t));
+    File out;
+    if (window && head && prev) out = fs.open(dst, FILE_WRITE, true);
+    if (!out) {
+        free(window);
+        free(head);
+        free(prev);
+        return false;
+    }
+    memset(head, 0xFF, (1 << GZIP_HASH_BITS) * sizeof(uint32_t));
+    memset(prev, 0xFF, GZIP_WINDOW * sizeof(uint32_t));
+
+    BitWriter w(out);
+    const uint8_t header[] = {0x1F, 0x8B, 8, 0}; // magic, deflate, no flags
+    for (uint8_t b : header) w.byte(b);
+    putLE32(w, mtime);
+    w.byte(0);   // extra flags
+    w.byte(255); // unknown OS
+    w.bits(1, 1); // last block
+    w.bits(1, 2); // fixed Huffman codes
+
+    uint32_t start = 0; // file offset of window[0]
+    uint32_t len = 0;   // bytes in window
+    uint32_t pos = 0;   // file offset being encoded
+    uint32_t crc = 0;
+    bool eof = false;
+    while (true) {
+        if (!eof && start + len - pos < GZIP_MAX_MATCH) {
+            if (len == 2 * GZIP_WINDOW) {
+                memmove(window, window + GZIP_WINDOW, GZIP_WINDOW);
+                start += GZIP_WINDOW;
+                len -= GZIP_WINDOW;
+            }
+            int n = in.read(window + len, 2 * GZIP_WINDOW - len);
+            if (n <= 0) eof = true;
+            else {
+                crc = esp_rom_crc32_le(crc, window + len, n);
+                len += n;
+            }
+            continue;
+        }
+        if (pos >= start + len) break;
+
+        const uint8_t *p = window + (pos - start);
+        uint32_t avail = min(start + len - pos, (uint32_t)GZIP_MAX_MATCH);
+        uint32_t best = 0;
+        uint32_t bestDist = 0;
+        if (avail >= GZIP_MIN_MATCH) {
+            uint32_t h = hash3(p);
+            uint32_t cand = head[h];
+            for (uint8_t n = 0; n < GZIP_MAX_CHAIN && cand != GZIP_NONE && cand >= start; n++) {
+                if (pos - cand >= GZIP_WINDOW) break;
+                const uint8_t *c = window + (cand - start);
+                uint32_t l = 0;
+                while (l < avail && c[l] == p[l]) l++;
+                if (l > best) {
+                    best = l;
+                    bestDist = pos - cand;
+                    if (l == avail) break;
+                }
+                uint32_t next = prev[cand & (GZIP_WINDOW - 1)];
+                if (next >= cand) break; // slot reused by a newer position
+                cand = next;
+            }
+        }
+
+        uint32_t step = best >= GZIP_MIN_MATCH ? best : 1;
+        for (uint32_t i = 0; i < step; i++) {
+            // index every position covered, later matches can start inside this one
+            if (pos + i + GZIP_MIN_MATCH > start + len) break;
+            uint32_t h = hash3(p + i);
+            prev[(pos + i) & (GZIP_WINDOW - 1)] = head[h];
+            head[h] = pos + i;
+        }
+        if (best >= GZIP_MIN_MATCH) putMatch(w, best, bestDist);
+        else putSymbol(w, *p);
+        pos += step;
+    }
+    putSymbol(w, 256); // end of block
+    bool ok = w.finish();
+    putLE32(w, crc);
+    putLE32(w, pos);
+    ok = w.finish() && ok && pos == in.size();
+
+    in.close();
+    out.close();
+    free(window);
+    free(head);
+    free(prev);
+    if (!ok) fs.remove(dst);
+    return ok;
+}
+
+bool gzipFileInfo(FS &fs, const String &path, uint32_t &crc, uint32_t &size) {
+    File f = fs.open(path, FILE_READ);
+    if (!f) return false;
+
+    uint8_t header[2];
+    bool ok = f.size() >= 18 && f.read(header, sizeof(header)) == sizeof(header) && header[0] == 0x1F &&
+              header[1] == 0x8B && f.seek(f.size() - 8) && f.read((uint8_t *)&crc, 4) == 4 &&
+              f.read((uint8_t *)&size, 4) == 4;
+    f.close();
+    return ok;
+}
+
+bool fileCrc32(FS &fs, const String &path, uint32_t &crc, uint32_t &size) {
+    File f = fs.open(path, FILE_READ);
+    if (!f || f.isDirectory()) return false;
+
+    uint8_t buf[512];
+    crc = 0;
+    size = 0;
+    int n;
+    while ((n = f.read(buf, sizeof(buf))) > 0) {
+        crc = esp_rom_crc32_le(crc, buf, n);
+        size += n;
+    }
+    f.close();
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef __GZIP_FILE_H__
+#define __GZIP_FILE_H__
+
+#include <FS.h>
+
+#define GZIP_WINDOW 2048    // LZ77 window, power of two
+#define GZIP_MAX_CHAIN 16   // candidates tried per position
+#define GZIP_HASH_BITS 11
+
+/*
+ * Minimal gzip writer: one fixed Huffman deflate block with a small LZ77
+ * window, enough to shrink html/css/js to about a third. Needs ~20 KB while
+ * compressing (PSRAM when available), fails cleanly when it cannot get it.
+ */
+
+// Compresses `src` into `dst`, `mtime` is stored in the gzip header (0: none)
+bool gzipFile(FS &fs, const String &src, const String &dst, uint32_t mtime);
+// Reads back the CRC-32 and the uncompressed size from the trailer of a gzip file
+bool gzipFileInfo(FS &fs, const String &path, uint32_t &crc, uint32_t &size);
+// CRC-32 and size of a file, the CRC is the one gzipFile() stores for it
+bool fileCrc32(FS &fs, const String &path, uint32_t &crc, uint32_t &size);
+
+#endif
@@ -0,0 +1,231 @@
+#include "image_cache.h"
+#include <esp_heap_caps.h>
+
+ImageCache imageCache;
+
+bool ImageBlit::begin(int x, int y, int w, int h, bool swapBytes, int minLines, bool bottomUp) {
+    finish();
+    if (w <= 0 || h <= 0) return false;
+
+    _x = x;
+    _y = y;
+    _w = w;
+    _h = h;
+    _swap = swapBytes;
+    _bottomUp = bottomUp;
+    _lines = max(minLines, IMAGE_BLIT_STRIP_BYTES / (int)(w * sizeof(uint16_t)));
+    _lines = constrain(_lines, 1, h);
+
+    bool dma = false;
+#ifdef IMAGE_BLIT_DMA
+    dma = tft.DMA_Enabled;
+#endif
+    size_t stripBytes = _lines * _w * sizeof(uint16_t);
+    if (_strip[0] == nullptr || stripBytes > _capacity || (dma && _strip[1] == nullptr)) {
+        end();
+        _dma = dma;
+        _capacity = stripBytes;
+        for (uint8_t i = 0; i < (_dma ? 2 : 1); i++) {
+            _strip[i] = (uint16_t *)heap_caps_malloc(stripBytes, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        }
+        if (_strip[1] == nullptr) _dma = false;
+        if (_strip[0] == nullptr) {
+            // a strip of one row as last resort
+            _strip[0] = (uint16_t *)malloc(_w * sizeof(uint16_t));
+            _capacity = _w * sizeof(uint16_t);
+            _dma = false;
+        }
+        if (_strip[0] == nullptr) return false;
+    }
+    _lines = min(_lines, (int)(_capacity / (_w * sizeof(uint16_t))));
+
+    _current = 0;
+    _stripY = _bottomUp ? max(0, _h - _lines) : 0;
+    _minY = _h;
+    _maxY = -1;
+    _oldSwap = tft.getSwapBytes();
+#ifdef IMAGE_BLIT_DMA
+    if (_dma) tft.startWrite(); // keeps CS low between DMA transfers
+#endif
+    _active = true;
+    return true;
+}
+
+void ImageBlit::writeBlock(int bx, int by, int bw, int bh, const uint16_t *pixels) {
+    if (!_active || bx >= _w || by >= _h || bw <= 0 || bh <= 0) return;
+    int cw = min(bw, _w - bx);
+    int ch = min(bh, _h - by);
+
+    if (_capture) {
+        for (int r = 0; r < ch; r++) {
+            memcpy(_capture + (by + r) * _w + bx, pixels + r * bw, cw * sizeof(uint16_t));
+        }
+    }
+
+    if (ch > _lines) {
+        // taller than a strip (row fallback), push it row by row
+        sync();
+        tft.setSwapBytes(_swap);
+        for (int r = 0; r < ch; r++) {
+            memcpy(_strip[_current] + bx, pixels + r * bw, cw * sizeof(uint16_t));
+            tft.pushImage(_x + bx, _y + by + r, cw, 1, _strip[_current] + bx);
+        }
+        return;
+    }
+
+    if (by < _stripY || by + ch > _stripY + _lines) {
+        flush();
+        _stripY = _bottomUp ? by + ch - _lines : by;
+        _stripY = constrain(_stripY, 0, max(0, _h - _lines));
+    }
+
+    uint16_t *dst = _strip[_current] + (by - _stripY) * _w + bx;
+    for (int r = 0; r < ch; r++) memcpy(dst + r * _w, pixels + r * bw, cw * sizeof(uint16_t));
+    _minY = min(_minY, by);
+    _maxY = max(_maxY, by + ch - 1);
+}
+
+void ImageBlit::flush() {
+    if (!_active || _maxY < _minY) return;
+
+    uint16_t *data = _strip[_current] + (_minY - _stripY) * _w;
+    int rows = _maxY - _minY + 1;
+    tft.setSwapBytes(_swap);
+#ifdef IMAGE_BLIT_DMA
+    if (_dma) {
+        // waits for the previous strip, then this one is sent while the next is decoded
+        tft.pushImageDMA(_x, _y + _minY, _w, rows, data);
+        _current ^= 1;
+    } else
+#endif
+    {
+        tft.drawPixel(0, 0, 0); // shared TFT_Spi devices struggle to work, need call a line first sometimes
+        tft.pushImage(_x, _y + _minY, _w, rows, data);
+    }
+    _minY = _h;
+    _maxY = -1;
+}
+
+void ImageBlit::sync() {
+    flush();
+#ifdef IMAGE_BLIT_DMA
+    if (_active && _dma) tft.dmaWait();
+#endif
+}
+
+void ImageBlit::finish() {
+    if (!_active) return;
+    sync();
+#ifdef IMAGE_BLIT_DMA
+    if (_dma) tft.endWrite();
+#endif
+    tft.setSwapBytes(_oldSwap);
+    _capture = nullptr;
+    _active = false;
+}
+
+void ImageBlit::end() {
+    finish();
+    free(_strip[0]);
+    free(_strip[1]);
+    _strip[0] = _strip[1] = nullptr;
+    _capacity = 0;
+}
+
+bool ImageCache::enabled() {
+    if (!psramFound()) return false;
+    if (_budget == 0) _budget = min((size_t)IMAGE_CACHE_MAX_BYTES, (size_t)ESP.getFreePsram() / 4);
+    return _budget > 0;
+}
+
+const CachedImage *ImageCache::find(FS &fs, const String &path, time_t mtime, size_t size) {
+    for (CachedImage &img : _entries) {
+        if (img.fs == &fs && img.mtime == mtime && img.size == size && img.path == path) {
+            img.lastUse = millis();
+            _hits++;
+            return &img;
+        }
+    }
+    _misses++;
+    return nullptr;
+}
+
+bool ImageCache::draw(const CachedImage *img, int x, int y, bool center) {
+    if (center) {
+        x = x + (tftWidth - img->w) / 2;
+        y = y + (tftHeight - img->h) / 2;
+    }
+    if (x >= tft.width() || y >= tft.height()) return false;
+
+    ImageBlit blit;
+    if (!blit.begin(x, y, img->w, img->h, img->swapBytes)) return false;
+    // the whole image is already in memory, push it in strips straight from the cache
+    for (int row = 0; row < img->h; row++) blit.writeRow(row, img->pixels + row * img->w);
+    blit.finish();
+    return true;
+}
+
+bool ImageCache::makeRoom(size_t bytes) {
+    if (bytes > _budget) return false;
+    while (_bytes + bytes > _budget && !_entries.empty()) {
+        auto oldest = _entries.begin();
+        for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+            if ((int32_t)(it->lastUse - oldest->lastUse) < 0) oldest = it;
+        }
+        _bytes -= oldest->w * oldest->h * sizeof(uint16_t);
+        free(oldest->pixels);
+        _entries.erase(oldest);
+    }
+    return _bytes + bytes <= _budget;
+}
+
+void ImageCache::beginCapture(FS &fs, const String &path, time_t mtime, size_t size) {
+    commit(false);
+    if (!enabled()) return;
+    _pending = {};
+    _pending.fs = &fs;
+    _pending.path = path;
+    _pending.mtime = mtime;
+    _pending.size = size;
+    _capturing = true;
+}
+
+uint16_t *ImageCache::capture(uint16_t w, uint16_t h, bool swapBytes) {
+    if (!_capturing || _pending.pixels != nullptr) return nullptr;
+    size_t bytes = w * h * sizeof(uint16_t);
+    if (!makeRoom(bytes)) {
+        _capturing = false;
+        return nullptr;
+    }
+    // calloc so the parts a decoder skips (cropped edges) stay black
+    _pending.pixels = (uint16_t *)heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM);
+    if (_pending.pixels == nullptr) {
+        _capturing = false;
+        return nullptr;
+    }
+    _pending.w = w;
+    _pending.h = h;
+    _pending.swapBytes = swapBytes;
+    return _pending.pixels;
+}
+
+void ImageCache::commit(bool ok) {
+    if (_pending.pixels != nullptr) {
+        if (ok) {
+            _pending.lastUse = millis();
+            _bytes += _pending.w * _pending.h * sizeof(uint16_t);
+            _entries.push_back(_pending);
+        } else {
+            free(_pending.pixels);
+        }
+    }
+    _pending = {};
+    _capturing = false;
+}
+
+void ImageCache::clear() {
+    commit(false);
+    for (CachedImage &img : _entries) free(img.pixels);
+    _entries.clear();
+    _bytes = 0;
+}
@@ -0,0 +1,108 @@
+#ifndef __IMAGE_CACHE_H__
+#define __IMAGE_CACHE_H__
+
+#include <FS.h>
+#include <globals.h>
+#include <vector>
+
+#define IMAGE_BLIT_STRIP_BYTES 8192         // per strip, two strips when the panel has DMA enabled
+#define IMAGE_CACHE_MAX_BYTES (1024 * 1024) // upper bound of decoded theme assets kept in PSRAM
+
+// TFT_eSPI only builds its DMA functions for SPI panels
+#if defined(HAS_SCREEN) && defined(ESP32_DMA) && !defined(TFT_PARALLEL_8_BIT)
+#define IMAGE_BLIT_DMA
+#endif
+
+/*
+ * Collects decoded pixels into strips of full rows and pushes each strip with a
+ * single window instead of one pushImage per row or per MCU. Strips are
+ * allocated DMA capable and are sent with pushImageDMA when the panel has DMA
+ * enabled. Pixels can also be copied into a capture buffer to fill the cache.
+ */
+class ImageBlit {
+public:
+    ImageBlit() {}
+    ~ImageBlit() { end(); }
+
+    // minLines: decoders writing blocks (JPEG MCUs) need at least the block height
+    bool begin(int x, int y, int w, int h, bool swapBytes, int minLines = 1, bool bottomUp = false);
+    // Block at image coordinates (bx, by), `pixels` is bw * bh contiguous
+    void writeBlock(int bx, int by, int bw, int bh, const uint16_t *pixels);
+    void writeRow(int by, const uint16_t *pixels) { writeBlock(0, by, _w, 1, pixels); }
+    // Pushes the pending strip, sync() also waits for DMA so the panel can be used directly
+    void flush(void);
+    void sync(void);
+    // Finishes the image, strips are kept for the next begin() (GIF frames)
+    void finish(void);
+    // Finishes and frees the strips
+    void end(void);
+
+    void setCapture(uint16_t *capture) { _capture = capture; }
+    bool isActive(void) { return _active; }
+
+private:
+    uint16_t *_strip[2] = {nullptr, nullptr};
+    size_t _capacity = 0; // bytes per strip
+    bool _active = false;
+    uint16_t *_capture = nullptr;
+    uint8_t _current = 0;
+    bool _dma = false;
+    bool _swap = false;
+    bool _oldSwap = false;
+    bool _bottomUp = false;
+    int _x = 0, _y = 0, _w = 0, _h = 0;
+    int _lines = 0;
+    int _stripY = 0;
+    int _minY = 0, _maxY = -1; // rows written in the current strip
+};
+
+struct CachedImage {
+    FS *fs;
+    String path;
+    time_t mtime;
+    size_t size;
+    uint16_t w;
+    uint16_t h;
+    bool swapBytes; // byte order the decoder produced
+    uint16_t *pixels;
+    uint32_t lastUse;
+};
+
+/*
+ * PSRAM cache of decoded RGB565 images keyed by path, size and modification
+ * time. Only used on boards with PSRAM, least recently used entries are freed
+ * when the budget is reached.
+ */
+class ImageCache {
+public:
+    bool enabled(void);
+    const CachedImage *find(FS &fs, const String &path, time_t mtime, size_t size);
+    bool draw(const CachedImage *img, int x, int y, bool center);
+
+    // The next decoder calling capture() fills a new entry, commit() keeps it
+    void beginCapture(FS &fs, const String &path, time_t mtime, size_t size);
+    uint16_t *capture(uint16_t w, uint16_t h, bool swapBytes);
+    void commit(bool ok);
+    bool capturing(void) { return _pending.pixels != nullptr; }
+
+    void clear(void);
+
+    uint32_t hits(void) { return _hits; }
+    uint32_t misses(void) { return _misses; }
+    size_t bytes(void) { return _bytes; }
+
+private:
+    std::vector<CachedImage> _entries;
+    size_t _bytes = 0;
+    size_t _budget = 0;
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+    bool _capturing = false;
+    CachedImage _pending = {};
+
+    bool makeRoom(size_t bytes);
+};
+
+extern ImageCache imageCache;
+
+#endif
@@ -0,0 +1,164 @@
+#include "input_events.h"
+#include <esp_timer.h>
+#include <globals.h>
+
+InputStats inputStats;
+
+static SemaphoreHandle_t inputMutex = nullptr;
+static TaskHandle_t inputTask = nullptr;
+static volatile int64_t inputIrqTime = 0; // first edge since the last InputHandler() run
+
+static InputEvent inputQueue[INPUT_QUEUE_LEN];
+static uint8_t inputHead = 0; // oldest event
+static uint8_t inputQueued = 0;
+
+static uint8_t wakePins[INPUT_MAX_WAKE_PINS];
+static uint8_t wakeLevels[INPUT_MAX_WAKE_PINS];
+static uint8_t wakePinCount = 0;
+
+static uint16_t lastKeys = 0;
+static int64_t lastKeysTime = 0;
+static uint32_t lastActivity = 0; // millis() of the last press
+
+// Bit i of InputEvent::keys is inputFlags[i]
+static volatile bool *const inputFlags[] = {
+    &AnyKeyPress,
+    &NextPress,
+    &PrevPress,
+    &UpPress,
+    &DownPress,
+    &SelPress,
+    &EscPress,
+    &NextPagePress,
+    &PrevPagePress,
+};
+static const uint8_t inputFlagCount = sizeof(inputFlags) / sizeof(inputFlags[0]);
+
+InputLock::InputLock() {
+    if (inputMutex) xSemaphoreTakeRecursive(inputMutex, portMAX_DELAY);
+}
+
+InputLock::~InputLock() {
+    if (inputMutex) xSemaphoreGiveRecursive(inputMutex);
+}
+
+void inputBegin(void) {
+    if (!inputMutex) inputMutex = xSemaphoreCreateRecursiveMutex();
+}
+
+static void IRAM_ATTR inputPinIsr(void *arg) {
+    if (inputIrqTime == 0) inputIrqTime = esp_timer_get_time();
+    if (!inputTask) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(inputTask, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void inputWakeOnPin(uint8_t pin, uint8_t pressedLevel) {
+    if (wakePinCount == INPUT_MAX_WAKE_PINS) return;
+    wakePins[wakePinCount] = pin;
+    wakeLevels[wakePinCount] = pressedLevel;
+    wakePinCount++;
+    attachInterruptArg(digitalPinToInterrupt(pin), inputPinIsr, NULL, CHANGE);
+}
+
+static uint16_t keyOf(volatile bool &btn) {
+    for (uint8_t i = 0; i < inputFlagCount; i++) {
+        if (inputFlags[i] == &btn) return 1 << i;
+    }
+    return 0;
+}
+
+static InputEvent &queued(uint8_t i) { return inputQueue[(inputHead + i) % INPUT_QUEUE_LEN]; }
+
+static void removeQueued(uint8_t i) {
+    for (; i + 1 < inputQueued; i++) queued(i) = queued(i + 1);
+    inputQueued--;
+}
+
+static void dropExpired(int64_t now) {
+    while (inputQueued > 0 && now - queued(0).time > INPUT_EVENT_TTL_MS * 1000LL) {
+        inputHead = (inputHead + 1) % INPUT_QUEUE_LEN;
+        inputQueued--;
+        inputStats.expired++;
+    }
+}
+
+void inputCollect(void) {
+    inputStats.wakeups++;
+    int64_t irqTime = inputIrqTime;
+    inputIrqTime = 0;
+    if (irqTime) inputStats.irqWakeups++;
+
+    uint16_t keys = 0;
+    for (uint8_t i = 0; i < inputFlagCount; i++) {
+        if (*inputFlags[i]) keys |= 1 << i;
+    }
+    if (keys == 0) return;
+    keys |= INPUT_ANY;
+
+    int64_t now = esp_timer_get_time();
+    dropExpired(now);
+    // still held and not checked yet, or bouncing
+    if (inputQueued > 0 && queued(inputQueued - 1).keys == keys) return;
+    if (keys == lastKeys && now - lastKeysTime < INPUT_DEBOUNCE_MS * 1000LL) return;
+    lastKeys = keys;
+    lastKeysTime = now;
+    lastActivity = millis();
+
+    if (inputQueued == INPUT_QUEUE_LEN) {
+        inputHead = (inputHead + 1) % INPUT_QUEUE_LEN;
+        inputQueued--;
+        inputStats.dropped++;
+    }
+    queued(inputQueued) = {keys, irqTime ? irqTime : now};
+    inputQueued++;
+    inputStats.events++;
+}
+
+void inputWait(void) {
+    if (!inputTask) inputTask = xTaskGetCurrentTaskHandle();
+
+    uint32_t wait = INPUT_IDLE_POLL_MS;
+    if (wakePinCount == 0 || AnyKeyPress || LongPress || millis() - lastActivity < INPUT_ACTIVE_MS) {
+        wait = INPUT_POLL_MS;
+    } else {
+        // held keys repeat and long press from InputHandler(), they need the polling
+        for (uint8_t i = 0; i < wakePinCount; i++) {
+            if (digitalRead(wakePins[i]) == wakeLevels[i]) wait = INPUT_POLL_MS;
+        }
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+}
+
+bool inputConsume(volatile bool &btn) {
+    InputLock lock;
+    int64_t now = esp_timer_get_time();
+    dropExpired(now);
+
+    // The oldest queued press of this key, its flag may have been cleared since by the
+    // re-run of taskInputHandler. Flags raised outside InputHandler() have no event.
+    uint16_t key = keyOf(btn);
+    uint8_t i = 0;
+    while (key && i < inputQueued && !(queued(i).keys & key)) i++;
+    if (i < inputQueued) {
+        uint32_t latency = now - queued(i).time;
+        inputStats.latencySamples++;
+        inputStats.latencyTotal += latency;
+        if (latency > inputStats.latencyMax) inputStats.latencyMax = latency;
+        removeQueued(i);
+    } else if (!btn) {
+        return false;
+    }
+    inputStats.consumed++;
+    btn = false;
+    AnyKeyPress = false;
+    SerialCmdPress = false;
+    return true;
+}
+
+void inputDrain(void) {
+    InputLock lock;
+    inputHead = 0;
+    inputQueued = 0;
+}
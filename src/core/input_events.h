@@ -0,0 +1,73 @@
+#ifndef __INPUT_EVENTS_H__
+#define __INPUT_EVENTS_H__
+
+#include <Arduino.h>
+
+#define INPUT_POLL_MS 10        // InputHandler() period while a key is down or was pressed recently
+#define INPUT_ACTIVE_MS 1500    // fast polling goes on for this long after the last press
+#define INPUT_IDLE_POLL_MS 250  // period when nothing is pressed, for boards whose keys all wake the task
+#define INPUT_DEBOUNCE_MS 30    // the same keys again within this time are contact bounce
+#define INPUT_EVENT_TTL_MS 500  // queued presses nobody checked by then are dropped
+#define INPUT_QUEUE_LEN 16
+#define INPUT_MAX_WAKE_PINS 8
+
+// One bit per navigation flag, a press sets INPUT_ANY and the bits of the flags it raised
+enum InputKey : uint16_t {
+    INPUT_ANY = 1 << 0,
+    INPUT_NEXT = 1 << 1,
+    INPUT_PREV = 1 << 2,
+    INPUT_UP = 1 << 3,
+    INPUT_DOWN = 1 << 4,
+    INPUT_SEL = 1 << 5,
+    INPUT_ESC = 1 << 6,
+    INPUT_NEXT_PAGE = 1 << 7,
+    INPUT_PREV_PAGE = 1 << 8,
+};
+
+struct InputEvent {
+    uint16_t keys;
+    int64_t time; // esp_timer microseconds, the interrupt edge when a wake pin saw it first
+};
+
+// What the input pipeline did since boot or the last reset
+struct InputStats {
+    uint32_t since = millis();
+    uint32_t wakeups = 0;    // InputHandler() runs
+    uint32_t irqWakeups = 0; // of which started by a wake pin
+    uint32_t events = 0;     // presses queued
+    uint32_t consumed = 0;   // presses handed to check()
+    uint32_t expired = 0;    // presses dropped after INPUT_EVENT_TTL_MS
+    uint32_t dropped = 0;    // presses dropped because the queue was full
+    uint32_t latencySamples = 0; // presses handed with their queued event
+    uint64_t latencyTotal = 0;   // press to check(), microseconds
+    uint32_t latencyMax = 0;
+
+    void reset(void) { *this = InputStats(); }
+};
+
+extern InputStats inputStats;
+
+// Holds the input lock, the input task takes it while it clears and sets the navigation flags
+class InputLock {
+public:
+    InputLock();
+    ~InputLock();
+};
+
+// Creates the lock, before the input task starts
+void inputBegin(void);
+
+/*
+ * Wakes the input task on every edge of `pin`. Boards whose buttons all call
+ * this get InputHandler() every INPUT_IDLE_POLL_MS instead of INPUT_POLL_MS
+ * while nothing is pressed, presses wake the task at once. Boards with keys
+ * that cannot interrupt (I2C keyboards, touch panels) must not call it.
+ */
+void inputWakeOnPin(uint8_t pin, uint8_t pressedLevel = LOW);
+
+// Input task: queues the keys InputHandler() just raised, call with the lock held
+void inputCollect(void);
+// Input task: sleeps until the next poll or a wake pin edge
+void inputWait(void);
+
+#endif
@@ -3,14 +3,24 @@
 #include "massStorage.h"
 #include "core/display.h"
 #include <USB.h>
+#include <esp_heap_caps.h>
 #if defined(SOC_USB_OTG_SUPPORTED)
 bool MassStorage::shouldStop = false;
 int32_t MassStorage::status = -1;
+MscSdBackend mscBackend;
 
 MassStorage::MassStorage() { setup(); }
 
 MassStorage::~MassStorage() {
     msc.end();
+    mscBackend.end();
+    const MscStats &s = mscBackend.stats;
+    Serial.printf(
+        "[MSC] best read %.2f MB/s, best write %.2f MB/s, %lu card writes\n",
+        s.readPeak / 1048576.0f,
+        s.writePeak / 1048576.0f,
+        s.cardWrites
+    );
     USB.~ESPUSB();
 
     // Hack to make USB back to flash mode
@@ -27,6 +37,11 @@ void MassStorage::setup() {
         delay(1000);
         return;
     }
+    if (!mscBackend.begin()) {
+        displayError("SD card not readable.");
+        delay(1000);
+        return;
+    }
 
     beginUsb();
 
@@ -36,7 +51,25 @@ void MassStorage::setup() {
 
 void MassStorage::loop() {
     int32_t prev_status = -1;
+    uint32_t rateStart = millis();
+    uint32_t lastRead = 0;
+    uint32_t lastWrite = 0;
     while (!check(EscPress) && !shouldStop) {
+        mscBackend.flushIfIdle();
+
+        uint32_t elapsed = millis() - rateStart;
+        if (elapsed >= 1000) {
+            MscStats &s = mscBackend.stats;
+            uint32_t readRate = (uint64_t)(s.readBytes - lastRead) * 1000 / elapsed;
+            uint32_t writeRate = (uint64_t)(s.writeBytes - lastWrite) * 1000 / elapsed;
+            s.readPeak = max(s.readPeak, readRate);
+            s.writePeak = max(s.writePeak, writeRate);
+            if (readRate > 0 || writeRate > 0) displayRates(readRate, writeRate);
+            lastRead = s.readBytes;
+            lastWrite = s.writeBytes;
+            rateStart = millis();
+        }
+
         if (prev_status != status) {
             vTaskDelay(100 / portTICK_PERIOD_MS);
             switch (status) {
@@ -59,8 +92,8 @@ void MassStorage::beginUsb() {
 }
 
 void MassStorage::setupUsbCallback() {
-    uint32_t secSize = SD.sectorSize();
-    uint32_t numSectors = SD.numSectors();
+    uint32_t secSize = mscBackend.sectorSize();
+    uint32_t numSectors = mscBackend.numSectors();
 
     msc.vendorID("ESP32");
     msc.productID("BRUCE");
@@ -86,44 +119,139 @@ void MassStorage::displayMessage(String message) {
     padprintln(message);
 }
 
-int32_t usbWriteCallback(uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
-    // Verify freespace
-    uint64_t freeSpace = SD.totalBytes() - SD.usedBytes();
-    if (bufsize > freeSpace) {
-        return -1; // no space available
+void MassStorage::displayRates(uint32_t readRate, uint32_t writeRate) {
+    const MscStats &s = mscBackend.stats;
+    char line[64];
+    snprintf(
+        line,
+        sizeof(line),
+        "R %.2f W %.2f MB/s, best %.2f/%.2f",
+        readRate / 1048576.0f,
+        writeRate / 1048576.0f,
+        s.readPeak / 1048576.0f,
+        s.writePeak / 1048576.0f
+    );
+    Serial.printf("[MSC] %s\n", line);
+
+    int y = tftHeight - 20;
+    tft.fillRect(10, y, tftWidth - 20, 8, bruceConfig.bgColor);
+    tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor);
+    tft.drawCentreString(line, tftWidth / 2, y, 1);
+}
+
+bool MscSdBackend::begin() {
+    _secSize = SD.sectorSize();
+    _numSectors = SD.numSectors();
+    if (_secSize == 0 || _numSectors == 0) return false; // disk error
+    _freeBytes = SD.totalBytes() - SD.usedBytes();
+    Serial.printf(
+        "[MSC] %lu sectors of %lu bytes, %llu MB free\n",
+        _numSectors,
+        _secSize,
+        _freeBytes / 1048576
+    );
+
+    if (_lock == nullptr) _lock = xSemaphoreCreateMutex();
+    // without a cache every write goes straight to the card
+    if (_cache == nullptr) {
+        _cache = (uint8_t *)heap_caps_malloc(MSC_CACHE_SECTORS * _secSize, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
     }
+    _cacheCount = 0;
+    stats = MscStats();
+    return _lock != nullptr;
+}
 
-    // Verify sector size
-    const uint32_t secSize = SD.sectorSize();
-    if (secSize == 0) return -1; // disk error
+void MscSdBackend::end() {
+    flush();
+    heap_caps_free(_cache);
+    _cache = nullptr;
+}
 
-    // Write blocs
-    for (uint32_t x = 0; x < bufsize / secSize; ++x) {
-        uint8_t blkBuffer[secSize];
-        memcpy(blkBuffer, buffer + secSize * x, secSize);
-        if (!SD.writeRAW(blkBuffer, lba + x)) {
-            return -1; // write error
-        }
-    }
+bool MscSdBackend::cached(uint32_t lba, uint32_t count) {
+    return _cacheCount > 0 && lba < _cacheLba + _cacheCount && _cacheLba < lba + count;
+}
+
+bool MscSdBackend::flushLocked() {
+    if (_cacheCount == 0) return true;
+    bool ok = SD.writeRAW(_cache, _cacheLba, _cacheCount);
+    stats.cardWrites++;
+    // the host was told these sectors were written, a failure here can only be logged
+    if (!ok) log_e("MSC cache flush of %lu sectors at %lu failed", _cacheCount, _cacheLba);
+    _cacheCount = 0;
+    return ok;
+}
+
+bool MscSdBackend::flush() {
+    if (_lock == nullptr) return true;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    bool ok = flushLocked();
+    xSemaphoreGive(_lock);
+    return ok;
+}
+
+void MscSdBackend::flushIfIdle() {
+    if (_lock == nullptr) return;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if (_cacheCount > 0 && millis() - _lastWrite >= MSC_FLUSH_IDLE_MS) flushLocked();
+    xSemaphoreGive(_lock);
+}
+
+int32_t MscSdBackend::read(uint32_t lba, uint8_t *buffer, uint32_t bufsize) {
+    uint32_t count = _secSize ? bufsize / _secSize : 0;
+    if (count == 0 || lba + count > _numSectors) return -1;
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    // the card is behind the cache on these sectors
+    bool ok = (!cached(lba, count) || flushLocked()) && SD.readRAW(buffer, lba, count);
+    xSemaphoreGive(_lock);
+    if (!ok) return -1; // read error
+
+    stats.readBytes += bufsize;
     return bufsize;
 }
 
-int32_t usbReadCallback(uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
-    // Verify sector size
-    const uint32_t secSize = SD.sectorSize();
-    if (secSize == 0) return -1; // disk error
-
-    // Read blocs
-    for (uint32_t x = 0; x < bufsize / secSize; ++x) {
-        if (!SD.readRAW(reinterpret_cast<uint8_t *>(buffer) + (x * secSize), lba + x)) {
-            return -1; // read error
+int32_t MscSdBackend::write(uint32_t lba, const uint8_t *buffer, uint32_t bufsize) {
+    uint32_t count = _secSize ? bufsize / _secSize : 0;
+    if (count == 0 || lba + count > _numSectors) return -1;
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    bool ok = true;
+    if (_cacheCount > 0 && lba >= _cacheLba && lba + count <= _cacheLba + _cacheCount) {
+        // the same sectors again, FAT and directory updates mostly
+        memcpy(_cache + (lba - _cacheLba) * _secSize, buffer, count * _secSize);
+    } else if (_cache == nullptr || count >= MSC_CACHE_SECTORS) {
+        // large enough on its own, straight from the USB buffer
+        ok = (!cached(lba, count) || flushLocked()) && SD.writeRAW((uint8_t *)buffer, lba, count);
+        stats.cardWrites++;
+    } else {
+        // only a run of consecutive sectors is kept
+        if (_cacheCount > 0 && (lba != _cacheLba + _cacheCount || _cacheCount + count > MSC_CACHE_SECTORS)) {
+            ok = flushLocked();
         }
+        if (_cacheCount == 0) _cacheLba = lba;
+        memcpy(_cache + _cacheCount * _secSize, buffer, count * _secSize);
+        _cacheCount += count;
+        if (_cacheCount == MSC_CACHE_SECTORS) ok = flushLocked() && ok;
     }
+    _lastWrite = millis();
+    xSemaphoreGive(_lock);
+    if (!ok) return -1; // write error
+
+    stats.writeBytes += bufsize;
     return bufsize;
 }
 
+int32_t usbWriteCallback(uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
+    return mscBackend.write(lba, buffer, bufsize);
+}
+
+int32_t usbReadCallback(uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
+    return mscBackend.read(lba, reinterpret_cast<uint8_t *>(buffer), bufsize);
+}
+
 bool usbStartStopCallback(uint8_t power_condition, bool start, bool load_eject) {
     if (!start && load_eject) {
+        mscBackend.flush();
         MassStorage::setShouldStop(true);
         return false;
     }
@@ -5,6 +5,58 @@
 #if defined(SOC_USB_OTG_SUPPORTED)
 #include <USBMSC.h>
 
+#define MSC_CACHE_SECTORS 32  // write-back run, reaches the card as one multi-block write
+#define MSC_FLUSH_IDLE_MS 200 // a dirty cache is written after this long without writes
+
+struct MscStats {
+    uint32_t readBytes = 0; // wrap around, rates come from differences
+    uint32_t writeBytes = 0;
+    uint32_t readPeak = 0; // best one second, bytes/s: the sequential rate of a large copy
+    uint32_t writePeak = 0;
+    uint32_t cardWrites = 0; // write commands sent to the card
+};
+
+/*
+ * SD card behind the USB drive. Geometry and free space are read once when the
+ * drive starts, reads go straight into the USB buffer as multi-block transfers.
+ * Writes gather in a run of consecutive sectors that is written in one go when
+ * full, when something else is read or written, after MSC_FLUSH_IDLE_MS and on
+ * eject. USB callbacks and the MassStorage loop share it under a lock.
+ */
+class MscSdBackend {
+public:
+    bool begin(void);
+    // Flushes and frees the cache
+    void end(void);
+
+    int32_t read(uint32_t lba, uint8_t *buffer, uint32_t bufsize);
+    int32_t write(uint32_t lba, const uint8_t *buffer, uint32_t bufsize);
+    bool flush(void);
+    void flushIfIdle(void);
+
+    uint32_t sectorSize(void) { return _secSize; }
+    uint32_t numSectors(void) { return _numSectors; }
+    uint64_t freeBytes(void) { return _freeBytes; }
+
+    MscStats stats;
+
+private:
+    uint32_t _secSize = 0;
+    uint32_t _numSectors = 0;
+    uint64_t _freeBytes = 0;
+
+    uint8_t *_cache = nullptr;
+    uint32_t _cacheLba = 0;
+    uint32_t _cacheCount = 0; // sectors waiting in the cache
+    uint32_t _lastWrite = 0;
+    SemaphoreHandle_t _lock = nullptr;
+
+    bool flushLocked(void);
+    bool cached(uint32_t lba, uint32_t count);
+};
+
+extern MscSdBackend mscBackend;
+
 class MassStorage {
 public:
     static bool shouldStop;
@@ -31,6 +83,7 @@ public:
     // Display functions
     /////////////////////////////////////////////////////////////////////////////////////
     static void displayMessage(String message);
+    static void displayRates(uint32_t readRate, uint32_t writeRate);
 
 private:
     USBMSC msc;
@@ -3,6 +3,7 @@
 #include "core/firmware_update.h"
 #include "core/i2c_finder.h"
 #include "core/main_menu.h"
+#include "core/serialcmds.h"
 #include "core/settings.h"
 #include "core/utils.h"
 #include "core/wifi/wifi_common.h"
@@ -105,6 +106,7 @@ void ConfigMenu::devMenu() {
              pinMode(bruceConfigPins.uart_bus.tx, OUTPUT);
              Serial1.begin(115200, SERIAL_8N1, bruceConfigPins.uart_bus.rx, bruceConfigPins.uart_bus.tx);
              USBserial.setSerialOutput(&Serial1);
+             serialCommandsWakeOnReceive(Serial1);
          }                                                                       },
         {"Disable DevMode", [this]() { bruceConfig.setDevMode(false); }          },
         {"Back",            [this]() { optionsMenu(); }                          },
@@ -8,9 +8,11 @@
 
 void GpsMenu::optionsMenu() {
     options = {
-        {"Wardriving",  [=]() { Wardriving(); }   },
-        {"GPS Tracker", [=]() { GPSTracker(); }   },
-        {"Config",      [this]() { configMenu(); }},
+        {"Wardriving",        [=]() { Wardriving(); }                   },
+        {"GPS Tracker",       [=]() { GPSTracker(); }                   },
+        {"GPS Tracker (bin)", [=]() { GPSTracker(TrackWriter::BINARY); }},
+        {"Export Track",      [=]() { exportTrackToGpx(); }             },
+        {"Config",            [this]() { configMenu(); }                },
     };
     addOptionToMainMenu();
 
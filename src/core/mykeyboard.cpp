@@ -1,4 +1,5 @@
 #include "mykeyboard.h"
+#include "core/input_events.h"
 #include "core/wifi/webInterface.h"
 #include "modules/ir/TV-B-Gone.h"
 #include "modules/ir/custom_ir.h"
@@ -118,11 +119,9 @@ struct box_t {
 // This function is used in loopTask to get the latest key press.
 keyStroke _getKeyPress() {
 #ifndef USE_TFT_eSPI_TOUCH
-    vTaskSuspend(xHandle);
+    InputLock lock;
     keyStroke key = KeyStroke;
     KeyStroke.Clear();
-    delay(10);
-    vTaskResume(xHandle);
     return key;
 #else
     keyStroke key = KeyStroke;
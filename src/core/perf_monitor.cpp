@@ -0,0 +1,316 @@
+#include "perf_monitor.h"
+#include <ArduinoJson.h>
+#include <algorithm>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+
+PerfMonitor perfMonitor;
+
+static void perfMonitorTask(void *parameter) {
+    while (true) {
+        perfMonitor.sample();
+        vTaskDelay(pdMS_TO_TICKS(PERF_SAMPLE_MS));
+    }
+}
+
+static void readHeap(uint32_t caps, PerfHeap &heap) {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    heap.free = info.total_free_bytes;
+    heap.largest = info.largest_free_block;
+    heap.minFree = info.minimum_free_bytes;
+}
+
+static TaskHandle_t idleTask(int core) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+    return xTaskGetIdleTaskHandleForCore(core);
+#else
+    return xTaskGetIdleTaskHandleForCPU(core);
+#endif
+}
+
+static int8_t taskCore(TaskHandle_t task) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+    BaseType_t core = xTaskGetCoreID(task);
+#else
+    BaseType_t core = xTaskGetAffinity(task);
+#endif
+    return core == tskNO_AFFINITY ? -1 : core;
+}
+
+static configRUN_TIME_COUNTER_TYPE runtimeOf(const TaskStatus_t &task) {
+#if configGENERATE_RUN_TIME_STATS
+    return task.ulRunTimeCounter;
+#else
+    return 0;
+#endif
+}
+
+static char stateChar(eTaskState state) {
+    switch (state) {
+        case eRunning: return 'X';
+        case eReady: return 'R';
+        case eBlocked: return 'B';
+        case eSuspended: return 'S';
+        default: return 'D';
+    }
+}
+
+// Share of the free memory that a single allocation cannot get
+static uint8_t fragmentation(const PerfHeap &heap) {
+    return heap.free == 0 ? 0 : 100 - (uint64_t)heap.largest * 100 / heap.free;
+}
+
+void PerfMonitor::begin(void) {
+    if (_lock) return;
+    _lock = xSemaphoreCreateMutex();
+    size_t bytes = PERF_HISTORY * sizeof(PerfSample);
+    _history = (PerfSample *)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+    xTaskCreate(perfMonitorTask, "perfMonitor", PERF_TASK_STACK_SIZE, NULL, 1, NULL);
+}
+
+bool PerfMonitor::hasCpuStats(void) {
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PerfMonitor::sample(void) {
+    if (!_lock) return;
+    PerfSample s;
+    s.time = millis();
+    readHeap(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, s.internal);
+    if (psramFound()) readHeap(MALLOC_CAP_SPIRAM, s.psram);
+
+    UBaseType_t count = 0;
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    TaskStatus_t *status = nullptr;
+#if configUSE_TRACE_FACILITY
+    // room for tasks created between the two calls
+    UBaseType_t room = uxTaskGetNumberOfTasks() + 4;
+    status = (TaskStatus_t *)malloc(room * sizeof(TaskStatus_t));
+    if (status) count = uxTaskGetSystemState(status, room, &total);
+#endif
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    configRUN_TIME_COUNTER_TYPE elapsed = total - _prevTotal;
+    bool loads = hasCpuStats() && _prevCount > 0 && elapsed > 0;
+    TaskHandle_t idle[2] = {idleTask(0), portNUM_PROCESSORS > 1 ? idleTask(1) : nullptr};
+
+    s.tasks = min<UBaseType_t>(count, 255);
+    s.minStack = UINT16_MAX;
+    _taskCount = 0;
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t &t = status[i];
+        configRUN_TIME_COUNTER_TYPE before = 0; // tasks started after the previous sample
+        for (uint8_t p = 0; p < _prevCount; p++) {
+            if (_prevHandle[p] == t.xHandle) {
+                before = _prevRuntime[p];
+                break;
+            }
+        }
+        uint8_t cpu = loads ? min<uint64_t>(100, (uint64_t)(runtimeOf(t) - before) * 100 / elapsed) : 0;
+        for (uint8_t core = 0; core < 2; core++) {
+            if (loads && t.xHandle == idle[core]) s.cpu[core] = 100 - cpu;
+        }
+
+        // ESP-IDF stacks are counted in bytes
+        uint32_t stackFree = t.usStackHighWaterMark;
+        if (stackFree < s.minStack) {
+            s.minStack = stackFree;
+            strlcpy(s.minStackTask, t.pcTaskName, sizeof(s.minStackTask));
+        }
+        if (_taskCount < PERF_MAX_TASKS) {
+            PerfTask &task = _tasks[_taskCount++];
+            strlcpy(task.name, t.pcTaskName, sizeof(task.name));
+            task.stackFree = stackFree;
+            task.cpu = cpu;
+            task.core = taskCore(t.xHandle);
+            task.priority = t.uxCurrentPriority;
+            task.state = stateChar(t.eCurrentState);
+        }
+    }
+    std::sort(_tasks, _tasks + _taskCount, [](const PerfTask &a, const PerfTask &b) {
+        return a.cpu != b.cpu ? a.cpu > b.cpu : a.stackFree < b.stackFree;
+    });
+
+    _prevCount = min<UBaseType_t>(count, PERF_MAX_TASKS);
+    for (uint8_t i = 0; i < _prevCount; i++) {
+        _prevHandle[i] = status[i].xHandle;
+        _prevRuntime[i] = runtimeOf(status[i]);
+    }
+    _prevTotal = total;
+
+    if (_history) {
+        _history[_head] = s;
+        _head = (_head + 1) % PERF_HISTORY;
+        if (_count < PERF_HISTORY) _count++;
+    }
+    xSemaphoreGive(_lock);
+    free(status);
+}
+
+void PerfMonitor::resetHistory(void) {
+    if (!_lock) return;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    _head = 0;
+    _count = 0;
+    xSemaphoreGive(_lock);
+}
+
+// Call with the lock held
+const PerfSample *PerfMonitor::last(void) {
+    if (_count == 0) return nullptr;
+    return &_history[(_head + PERF_HISTORY - 1) % PERF_HISTORY];
+}
+
+String PerfMonitor::report(void) {
+    if (!_lock) return "Performance monitor not running\n";
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    const PerfSample *s = last();
+    if (!s) {
+        xSemaphoreGive(_lock);
+        return "No sample yet\n";
+    }
+
+    char line[96];
+    String out;
+    uint32_t age = (millis() - s->time) / 1000;
+    snprintf(line, sizeof(line), "Sampled %lu s ago, every %u s\n", age, PERF_SAMPLE_MS / 1000);
+    out += line;
+    snprintf(
+        line,
+        sizeof(line),
+        "RAM    free %lu, largest block %lu (%u%% fragmented), lowest %lu\n",
+        s->internal.free,
+        s->internal.largest,
+        fragmentation(s->internal),
+        s->internal.minFree
+    );
+    out += line;
+    if (psramFound()) {
+        snprintf(
+            line,
+            sizeof(line),
+            "PSRAM  free %lu, largest block %lu (%u%% fragmented), lowest %lu\n",
+            s->psram.free,
+            s->psram.largest,
+            fragmentation(s->psram),
+            s->psram.minFree
+        );
+        out += line;
+    }
+    if (hasCpuStats()) {
+        snprintf(line, sizeof(line), "CPU    core 0 %u%%, core 1 %u%%\n", s->cpu[0], s->cpu[1]);
+        out += line;
+    } else {
+        out += "CPU    no runtime statistics in this build\n";
+    }
+
+    out += "Task             Core Prio State  CPU%  Stack free\n";
+    for (uint8_t i = 0; i < _taskCount; i++) {
+        const PerfTask &t = _tasks[i];
+        snprintf(
+            line,
+            sizeof(line),
+            "%-16s %4s %4u %5c %5u %11lu\n",
+            t.name,
+            t.core < 0 ? "any" : String(t.core).c_str(),
+            t.priority,
+            t.state,
+            t.cpu,
+            t.stackFree
+        );
+        out += line;
+    }
+    xSemaphoreGive(_lock);
+    return out;
+}
+
+String PerfMonitor::historyReport(void) {
+    if (!_lock) return "Performance monitor not running\n";
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    String out = "  Age s   RAM free  RAM block  PSRAM free  CPU0  CPU1  Min stack\n";
+    char line[96];
+    uint32_t now = millis();
+    for (uint16_t i = 0; i < _count; i++) {
+        const PerfSample &s = _history[(_head + PERF_HISTORY - _count + i) % PERF_HISTORY];
+        snprintf(
+            line,
+            sizeof(line),
+            "%7lu %10lu %10lu %11lu %4u%% %4u%%  %u %s\n",
+            (now - s.time) / 1000,
+            s.internal.free,
+            s.internal.largest,
+            s.psram.free,
+            s.cpu[0],
+            s.cpu[1],
+            s.minStack,
+            s.minStackTask
+        );
+        out += line;
+    }
+    xSemaphoreGive(_lock);
+    return out;
+}
+
+static void heapToJson(JsonObject obj, const PerfHeap &heap) {
+    obj["free"] = heap.free;
+    obj["largest"] = heap.largest;
+    obj["min_free"] = heap.minFree;
+    obj["fragmentation"] = fragmentation(heap);
+}
+
+String PerfMonitor::toJson(bool history) {
+    JsonDocument doc;
+    doc["uptime"] = millis();
+    doc["interval"] = PERF_SAMPLE_MS;
+    doc["cpu_stats"] = hasCpuStats();
+    if (_lock) {
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        const PerfSample *s = last();
+        if (s) {
+            doc["sampled"] = s->time;
+            heapToJson(doc["heap"].to<JsonObject>(), s->internal);
+            if (psramFound()) heapToJson(doc["psram"].to<JsonObject>(), s->psram);
+            JsonArray cpu = doc["cpu"].to<JsonArray>();
+            for (uint8_t core = 0; core < portNUM_PROCESSORS && core < 2; core++) cpu.add(s->cpu[core]);
+        }
+        JsonArray tasks = doc["tasks"].to<JsonArray>();
+        for (uint8_t i = 0; i < _taskCount; i++) {
+            const PerfTask &t = _tasks[i];
+            JsonObject task = tasks.add<JsonObject>();
+            task["name"] = t.name;
+            task["core"] = t.core;
+            task["priority"] = t.priority;
+            task["state"] = String(t.state);
+            task["cpu"] = t.cpu;
+            task["stack_free"] = t.stackFree;
+        }
+        if (history) {
+            JsonArray samples = doc["history"].to<JsonArray>();
+            for (uint16_t i = 0; i < _count; i++) {
+                const PerfSample &h = _history[(_head + PERF_HISTORY - _count + i) % PERF_HISTORY];
+                JsonObject sample = samples.add<JsonObject>();
+                sample["time"] = h.time;
+                sample["heap_free"] = h.internal.free;
+                sample["heap_largest"] = h.internal.largest;
+                sample["psram_free"] = h.psram.free;
+                sample["psram_largest"] = h.psram.largest;
+                JsonArray cpu = sample["cpu"].to<JsonArray>();
+                cpu.add(h.cpu[0]);
+                cpu.add(h.cpu[1]);
+                sample["tasks"] = h.tasks;
+                sample["min_stack"] = h.minStack;
+                sample["min_stack_task"] = h.minStackTask;
+            }
+        }
+    }
+    // names point into the samples, serialized before the lock is released
+    String out;
+    serializeJson(doc, out);
+    if (_lock) xSemaphoreGive(_lock);
+    return out;
+}
@@ -0,0 +1,79 @@
+#ifndef __PERF_MONITOR_H__
+#define __PERF_MONITOR_H__
+
+#include <Arduino.h>
+
+#define PERF_SAMPLE_MS 10000       // time between two samples
+#define PERF_HISTORY 90            // samples kept, 15 minutes
+#define PERF_MAX_TASKS 40          // tasks listed in a sample
+#define PERF_TASK_STACK_SIZE 4096  // stack of the sampling task
+
+struct PerfHeap {
+    uint32_t free = 0;
+    uint32_t largest = 0; // largest free block, what a single allocation can get
+    uint32_t minFree = 0; // lowest free since boot
+};
+
+// One history entry, kept small since PERF_HISTORY of them stay in memory
+struct PerfSample {
+    uint32_t time = 0; // millis()
+    PerfHeap internal;
+    PerfHeap psram;
+    uint8_t cpu[2] = {0, 0};      // load of each core since the previous sample, percent
+    uint8_t tasks = 0;            // tasks alive
+    uint16_t minStack = 0;        // smallest stack headroom of all tasks, bytes
+    char minStackTask[16] = "";   // task owning it
+};
+
+struct PerfTask {
+    char name[16];
+    uint32_t stackFree; // stack never used since the task started, bytes
+    uint8_t cpu;        // share of one core since the previous sample, percent
+    int8_t core;        // -1 when the task can run on both cores
+    uint8_t priority;
+    char state;         // X running, R ready, B blocked, S suspended, D deleted
+};
+
+/*
+ * Samples FreeRTOS task runtime counters, stack high water marks and internal
+ * and PSRAM heap usage every PERF_SAMPLE_MS from a low priority task. The task
+ * list of the last sample and a ring of the last PERF_HISTORY heap/CPU samples
+ * are kept for the `perf` serial command, the /perf WebUI endpoint and
+ * device.getPerf() in scripts.
+ */
+class PerfMonitor {
+public:
+    void begin(void);
+    // Takes a sample now, the sampling task calls it every PERF_SAMPLE_MS
+    void sample(void);
+    void resetHistory(void);
+
+    // `perf` text output
+    String report(void);
+    String historyReport(void);
+    // {"uptime","interval","heap","psram","cpu","tasks"[, "history"]}
+    String toJson(bool history);
+
+    // false when the SDK was built without task runtime statistics
+    bool hasCpuStats(void);
+
+private:
+    SemaphoreHandle_t _lock = nullptr;
+    PerfSample *_history = nullptr;
+    uint16_t _head = 0; // next slot written
+    uint16_t _count = 0;
+    PerfTask _tasks[PERF_MAX_TASKS];
+    uint8_t _taskCount = 0;
+
+    // runtime counters of the previous sample, to turn them into a load
+    TaskHandle_t _prevHandle[PERF_MAX_TASKS];
+    uint32_t _prevRuntime[PERF_MAX_TASKS];
+    uint8_t _prevCount = 0;
+    uint32_t _prevTotal = 0;
+
+    const PerfSample *last(void);
+};
+
+extern PerfMonitor perfMonitor;
+
+#endif
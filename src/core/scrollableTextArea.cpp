@@ -1,4 +1,5 @@
 #include "scrollableTextArea.h"
+#include "mykeyboard.h"
 #define _scrollBuffer tft
 ScrollableTextArea::ScrollableTextArea(const String &title)
     : firstVisibleLine{0}, _redraw{true}, _title(title), _fontSize(FP), _startX(BORDER_PAD_X),
@@ -40,6 +41,7 @@ void ScrollableTextArea::setup() {
 }
 
 void ScrollableTextArea::scrollUp() {
+    if (_fileMode) return fileScrollUp();
     if (firstVisibleLine) {
         firstVisibleLine--;
         _redraw = true;
@@ -47,6 +49,7 @@ void ScrollableTextArea::scrollUp() {
 }
 
 void ScrollableTextArea::scrollDown() {
+    if (_fileMode) return fileScrollDown();
     if (firstVisibleLine + _maxVisibleLines <= linesBuffer.size()) {
         if (firstVisibleLine == 0) firstVisibleLine++;
         firstVisibleLine++;
@@ -55,6 +58,20 @@ void ScrollableTextArea::scrollDown() {
 }
 
 void ScrollableTextArea::scrollToLine(size_t lineNumber) {
+    if (_fileMode) {
+        uint32_t offset = 0;
+        if (!_index.seekLine(lineNumber, offset)) {
+            if (_index.lines() == 0) return;
+            lineNumber = _index.lines() - 1;
+            _index.seekLine(lineNumber, offset);
+        }
+        _topOffset = offset;
+        _topLine = lineNumber;
+        _topLineKnown = true;
+        _topRow = 0;
+        _redraw = true;
+        return;
+    }
     if (linesBuffer.empty()) return; // Ensure there's content to scroll
 
     if (lineNumber > linesBuffer.size() - _maxVisibleLines) {
@@ -78,7 +95,18 @@ void ScrollableTextArea::show(bool force) {
         update(force);
         yield();
     }
-    while (!check(SelPress)) {
+    while (true) {
+        if (check(SelPress)) {
+            if (_fileMode && fileMenu()) continue;
+            break;
+        }
+        if (_fileMode) {
+            if (check(EscPress)) break;
+            // Index the rest of the file while idle, a chunk per loop
+            bool indexing = !_index.complete();
+            _index.indexStep();
+            if (indexing && (_index.complete() || millis() - _lastStatus > 500)) drawFileStatus();
+        }
         update(force);
         yield();
     }
@@ -94,17 +122,48 @@ void ScrollableTextArea::update(bool force) {
 }
 
 void ScrollableTextArea::fromFile(File file) {
-    linesBuffer.clear();
-    while (file.available()) addLine(file.readStringUntil('\n'));
-
-    draw(true);
-    delay(100);
+    clear();
+    // Nothing is read ahead, the first page is drawn right away and the index is built by show()
+    if (!_index.begin(file)) return;
+    _fileMode = true;
+    _topOffset = 0;
+    _topLine = 0;
+    _topLineKnown = true;
+    _topRow = 0;
     draw(true);
 }
 
+void ScrollableTextArea::scrollToPercent(uint8_t percent) {
+    percent = min(percent, (uint8_t)100);
+    if (!_fileMode) {
+        scrollToLine(linesBuffer.size() * percent / 100);
+        _redraw = true;
+        return;
+    }
+
+    if (percent == 100) {
+        // Last line, then back up a page
+        uint32_t last = _index.size();
+        if (!_index.complete() || !_index.seekLine(_index.lines() - 1, last)) last = _index.prevLine(last);
+        _topOffset = last;
+        _topRow = 0;
+        _topLineKnown = _index.complete();
+        _topLine = _index.lines() ? _index.lines() - 1 : 0;
+        for (size_t i = 2; i < _maxVisibleLines; i++) fileScrollUp();
+    } else {
+        _topOffset = _index.alignLine((uint64_t)_index.size() * percent / 100);
+        _topRow = 0;
+        _topLine = 0;
+        _topLineKnown = _topOffset == 0; // found by drawFileStatus() once indexed
+    }
+    _redraw = true;
+}
+
 void ScrollableTextArea::clear() {
     firstVisibleLine = 0;
     linesBuffer.clear();
+    _index.end();
+    _fileMode = false;
 }
 
 void ScrollableTextArea::fromString(const String &text) {
@@ -132,6 +191,16 @@ void ScrollableTextArea::addLine(const String &text) {
         return;
     }
 
+    wrapLine(text, linesBuffer);
+    _redraw = true;
+}
+
+void ScrollableTextArea::wrapLine(const String &text, std::vector<String> &rows) {
+    if (text.isEmpty()) {
+        rows.emplace_back("");
+        return;
+    }
+
     String buff;
     size_t start = 0;
     bool firstLine = true;
@@ -149,15 +218,18 @@ void ScrollableTextArea::addLine(const String &text) {
         }
         if (buff.endsWith("\r")) buff.remove(buff.length() - 1);
 
-        linesBuffer.emplace_back(buff);
+        rows.emplace_back(buff);
         firstLine = false;
     }
-
-    _redraw = true;
 }
 
 void ScrollableTextArea::draw(bool force) {
     if (!_redraw && !force) return;
+    if (_fileMode) {
+        drawFile();
+        _redraw = false;
+        return;
+    }
 
     _scrollBuffer.fillRect(_startX, _startY, _width, _height, bruceConfig.bgColor);
     _scrollBuffer.setTextColor(bruceConfig.priColor);
@@ -195,3 +267,142 @@ void ScrollableTextArea::draw(bool force) {
 
     _redraw = false;
 }
+
+void ScrollableTextArea::drawFile() {
+    _scrollBuffer.fillRect(_startX, _startY, _width, _height, bruceConfig.bgColor);
+    _scrollBuffer.setTextColor(bruceConfig.priColor);
+    uint8_t _fSize = tft.textsize;
+    tft.setTextSize(FP);
+
+    // The last line shows the position in the file
+    size_t maxLines = _maxVisibleLines > 1 ? _maxVisibleLines - 1 : 1;
+    uint16_t yOffset = 0;
+    size_t lines = 0;
+
+    // if there is text above
+    if (_topOffset || _topRow) {
+        _scrollBuffer.drawString("...", 0 + _startX, _startY + yOffset);
+        yOffset += _pixelsPerLine;
+        lines++;
+    }
+
+    std::vector<String> rows;
+    uint32_t offset = _topOffset;
+    bool topLine = true;
+    _topLineRows = 1;
+    _moreBelow = false;
+    while (offset < _index.size() && !_moreBelow) {
+        String line;
+        uint32_t next = _index.readLine(offset, line);
+        rows.clear();
+        wrapLine(line, rows);
+
+        size_t row = 0;
+        if (topLine) {
+            _topLineRows = rows.size();
+            _topRow = min(_topRow, (uint16_t)(_topLineRows - 1));
+            row = _topRow;
+            topLine = false;
+        }
+        for (; row < rows.size(); row++) {
+            if (lines >= maxLines) {
+                _moreBelow = true;
+                break;
+            }
+            _scrollBuffer.drawString(rows[row], 0 + _startX, _startY + yOffset);
+            yOffset += _pixelsPerLine;
+            lines++;
+        }
+        offset = next;
+    }
+
+    drawFileStatus();
+    tft.setTextSize(_fSize);
+}
+
+void ScrollableTextArea::drawFileStatus() {
+    if (!_topLineKnown && (_index.complete() || _topOffset <= _index.indexedBytes())) {
+        _topLineKnown = _index.lineOf(_topOffset, _topLine);
+    }
+
+    uint32_t size = _index.size();
+    uint8_t percent = (!_moreBelow || size == 0) ? 100 : (uint64_t)_topOffset * 100 / size;
+    String status = "L" + (_topLineKnown ? String(_topLine + 1) : String("?")) + "/" +
+                    String(_index.lines()) + (_index.complete() ? " " : "+ ") + String(percent) + "%";
+
+    uint8_t _fSize = tft.textsize;
+    tft.setTextSize(FP);
+    int32_t y = _startY + (_maxVisibleLines - 1) * _pixelsPerLine;
+    _scrollBuffer.fillRect(_startX, y, _width, _pixelsPerLine, bruceConfig.bgColor);
+    _scrollBuffer.setTextColor(bruceConfig.secColor);
+    _scrollBuffer.drawRightString(status, _startX + _width, y, 1);
+    _scrollBuffer.setTextColor(bruceConfig.priColor);
+    tft.setTextSize(_fSize);
+    _lastStatus = millis();
+}
+
+void ScrollableTextArea::fileScrollDown() {
+    if (!_moreBelow) return;
+    if (_topRow + 1 < _topLineRows) {
+        _topRow++;
+    } else {
+        _topOffset = _index.nextLine(_topOffset);
+        _topRow = 0;
+        if (_topLineKnown) _topLine++;
+    }
+    _redraw = true;
+}
+
+void ScrollableTextArea::fileScrollUp() {
+    if (_topRow > 0) {
+        _topRow--;
+    } else if (_topOffset > 0) {
+        _topOffset = _index.prevLine(_topOffset);
+        String line;
+        std::vector<String> rows;
+        _index.readLine(_topOffset, line);
+        wrapLine(line, rows);
+        _topRow = rows.size() - 1;
+        if (_topLineKnown && _topLine > 0) _topLine--;
+        _moreBelow = true;
+    } else {
+        return;
+    }
+    _redraw = true;
+}
+
+/*********************************************************************
+**  Function: fileMenu
+**  Jumps inside the file, returns false to close the viewer
+**********************************************************************/
+bool ScrollableTextArea::fileMenu() {
+    int action = -1;
+    std::vector<Option> fileOptions = {
+        {"Go to line", [&]() { action = 0; }},
+        {"Go to %",    [&]() { action = 1; }},
+        {"Top",        [&]() { action = 2; }},
+        {"Bottom",     [&]() { action = 3; }},
+        {"Close",      [&]() { action = 4; }},
+    };
+    loopOptions(fileOptions, MENU_TYPE_SUBMENU, "View File");
+
+    if (action == 0) {
+        String line = num_keyboard("", 10, "Go to line:");
+        if (line != "\x1B" && line.toInt() > 0) {
+            if (!_index.complete()) displayRedStripe("Indexing...", TFT_WHITE, bruceConfig.priColor);
+            scrollToLine(line.toInt() - 1);
+        }
+    } else if (action == 1) {
+        String percent = num_keyboard("", 3, "Go to %:");
+        if (percent != "\x1B" && !percent.isEmpty()) scrollToPercent(constrain(percent.toInt(), 0, 100));
+    } else if (action == 2) {
+        scrollToPercent(0);
+    } else if (action == 3) {
+        scrollToPercent(100);
+    }
+
+    drawMainBorder();
+    if (!_title.isEmpty()) printTitle(_title);
+    draw(true);
+    return action != 4;
+}
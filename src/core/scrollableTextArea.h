@@ -1,4 +1,5 @@
 #include "display.h"
+#include "text_file_index.h"
 
 class ScrollableTextArea {
 public:
@@ -26,7 +27,10 @@ public:
 
     void fromString(const String &text);
 
+    // Shows the file a window at a time, the file must stay open while the area is used
     void fromFile(File file);
+    // Jumps in a file opened with fromFile()
+    void scrollToPercent(uint8_t percent);
 
     void draw(bool force = false);
 
@@ -53,4 +57,22 @@ private:
     void setup();
 
     void update(bool force = false);
+    void wrapLine(const String &text, std::vector<String> &rows);
+
+    // fromFile() state, lines are read from the file around the top line
+    TextFileIndex _index;
+    bool _fileMode = false;
+    uint32_t _topOffset = 0;    // file offset of the top line
+    uint32_t _topLine = 0;      // its line number, if _topLineKnown
+    bool _topLineKnown = false;
+    uint16_t _topRow = 0;       // wrapped rows of the top line scrolled past
+    uint16_t _topLineRows = 1;  // wrapped rows of the top line
+    bool _moreBelow = false;
+    uint32_t _lastStatus = 0;
+
+    void drawFile(void);
+    void drawFileStatus(void);
+    bool fileMenu(void);
+    void fileScrollUp(void);
+    void fileScrollDown(void);
 };
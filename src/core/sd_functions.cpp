@@ -20,6 +20,7 @@
 // SPIClass sdcardSPI;
 String fileToCopy;
 std::vector<FileList> fileList;
+uint32_t sdMountChanges = 0;
 
 /***************************************************************************************
 ** Function name: setupSdCard
@@ -86,10 +87,26 @@ bool setupSdCard() {
     } else {
         Serial.println("SDCARD mounted successfully");
         sdcardMounted = true;
+        sdMountChanges++;
         return true;
     }
 }
 
+/***************************************************************************************
+** Function name: sdcardSharesTftBus
+** Description:   true when mounting the SD card talks on the display SPI bus
+***************************************************************************************/
+bool sdcardSharesTftBus() {
+#if defined(USE_SD_MMC)
+    return false;
+#elif defined(USE_TFT_eSPI_TOUCH)
+    return true; // default SPI bus, shared with the panel and its touch controller
+#else
+    return bruceConfigPins.SDCARD_bus.mosi == (gpio_num_t)TFT_MOSI &&
+           bruceConfigPins.SDCARD_bus.mosi != GPIO_NUM_NC;
+#endif
+}
+
 /***************************************************************************************
 ** Function name: closeSdCard
 ** Description:   Turn Off SDCard, set sdcardMounted state to false
@@ -98,6 +115,7 @@ void closeSdCard() {
     SD.end();
     Serial.println("SD Card Unmounted...");
     sdcardMounted = false;
+    sdMountChanges++;
 }
 
 /***************************************************************************************
@@ -867,10 +885,9 @@ void viewFile(FS fs, String filepath) {
 
     ScrollableTextArea area = ScrollableTextArea("VIEW FILE");
     area.fromFile(file);
+    area.show();
 
     file.close();
-
-    area.show();
 }
 
 /*********************************************************************
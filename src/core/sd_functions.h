@@ -14,7 +14,11 @@ struct FileList {
 
 // extern SPIClass sdcardSPI;
 
+// Bumped on every SD mount and unmount, lets caches of SD contents notice a remount
+extern uint32_t sdMountChanges;
+
 bool setupSdCard();
+bool sdcardSharesTftBus();
 
 void closeSdCard();
 
@@ -0,0 +1,60 @@
+#include "ble_commands.h"
+#include "modules/ble/ble_common.h"
+#include "modules/ble/ble_device_table.h"
+#include <globals.h>
+
+static void printBleDevices() {
+    std::vector<BLEDeviceEntry> devices;
+    bleDeviceTable.snapshot(devices);
+
+    uint32_t now = millis();
+    serialDevice->println("Address            RSSI  Last  Seen  Name");
+    for (const BLEDeviceEntry &dev : devices) {
+        serialDevice->printf(
+            "%s  %4d  %3lus  %4u  %s\n",
+            dev.address().c_str(),
+            dev.rssi(),
+            (now - dev.lastSeen) / 1000,
+            dev.seen,
+            dev.name
+        );
+    }
+    serialDevice->printf(
+        "%u devices (%u max), %lu advertisements, %lu evicted\n",
+        devices.size(),
+        bleDeviceTable.capacity(),
+        bleDeviceTable.advertisements(),
+        bleDeviceTable.evictions()
+    );
+}
+
+uint32_t bleScanCallback(cmd *c) {
+    Command cmd(c);
+    int seconds = cmd.getArgument("seconds").getValue().toInt();
+    if (seconds <= 0) seconds = 5;
+    bool keep = cmd.getArgument("keep").isSet();
+
+    serialDevice->printf("Scanning BLE for %ds...\n", seconds);
+    if (!ble_scan_devices(seconds, keep)) {
+        serialDevice->println("Not enough memory for the device table");
+        return false;
+    }
+
+    printBleDevices();
+    return true;
+}
+
+uint32_t bleListCallback(cmd *c) {
+    printBleDevices();
+    return true;
+}
+
+void createBleCommands(SimpleCLI *cli) {
+    Command cmd = cli->addCompositeCmd("ble");
+
+    Command scanCmd = cmd.addCommand("scan", bleScanCallback);
+    scanCmd.addPosArg("seconds", "5");
+    scanCmd.addFlagArg("keep");
+
+    cmd.addCommand("list", bleListCallback);
+}
@@ -0,0 +1,8 @@
+#ifndef __SERIAL_BLE_CMD_H__
+#define __SERIAL_BLE_CMD_H__
+
+#include <SimpleCLI.h>
+
+void createBleCommands(SimpleCLI *cli);
+
+#endif
@@ -1,10 +1,12 @@
 #include "cli.h"
 #include "badusb_commands.h"
+#include "ble_commands.h"
 #include "core/sd_functions.h"
 #include "crypto_commands.h"
 #include "gpio_commands.h"
 #include "interpreter_commands.h"
 #include "ir_commands.h"
+#include "nrf_commands.h"
 #include "power_commands.h"
 #include "rf_commands.h"
 #include "screen_commands.h"
@@ -36,6 +38,7 @@ void SerialCli::setup() {
     createCryptoCommands(&_cli);
     createGpioCommands(&_cli);
     createIrCommands(&_cli);
+    createNrfCommands(&_cli);
     createPowerCommands(&_cli);
     createRfCommands(&_cli);
     createSettingsCommands(&_cli);
@@ -47,6 +50,7 @@ void SerialCli::setup() {
     createBadUsbCommands(&_cli);
 #endif
 #ifndef LITE_VERSION
+    createBleCommands(&_cli);
     createInterpreterCommands(&_cli);
 #endif
 #ifdef HAS_SCREEN
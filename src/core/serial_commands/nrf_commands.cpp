@@ -0,0 +1,48 @@
+#include "nrf_commands.h"
+#include "modules/NRF24/nrf_spectrum.h"
+#include <globals.h>
+
+// Streams binary NrfSpectrumFrames until `sweeps` are done, or until any byte
+// is received when sweeps is 0.
+uint32_t nrfSpectrumCallback(cmd *c) {
+    Command cmd(c);
+    int count = cmd.getArgument("sweeps").getValue().toInt();
+    bool withPeak = cmd.getArgument("peak").isSet();
+    bool withAvg = cmd.getArgument("avg").isSet();
+
+    if (!nrf_spectrum_begin()) {
+        serialDevice->println("NRF24 not found");
+        return false;
+    }
+    // drop what is already waiting, a later byte stops an endless feed
+    for (int n = serialDevice->available(); n > 0; n--) serialDevice->read();
+
+    NrfSpectrumFrame frame;
+    for (int i = 0; count <= 0 || i < count; i++) {
+        if (count <= 0 && serialDevice->available()) break;
+        nrf_spectrum_sweep();
+
+        nrf_spectrum_frame(NRF_SPECTRUM_LEVEL, frame);
+        serialDevice->write((uint8_t *)&frame, sizeof(frame));
+        if (withPeak) {
+            nrf_spectrum_frame(NRF_SPECTRUM_PEAK, frame);
+            serialDevice->write((uint8_t *)&frame, sizeof(frame));
+        }
+        if (withAvg) {
+            nrf_spectrum_frame(NRF_SPECTRUM_AVERAGE, frame);
+            serialDevice->write((uint8_t *)&frame, sizeof(frame));
+        }
+    }
+    serialDevice->flush();
+    nrf_spectrum_end(NRFSPI);
+    return true;
+}
+
+void createNrfCommands(SimpleCLI *cli) {
+    Command cmd = cli->addCompositeCmd("nrf");
+
+    Command spectrumCmd = cmd.addCommand("spectrum", nrfSpectrumCallback);
+    spectrumCmd.addPosArg("sweeps", "100");
+    spectrumCmd.addFlagArg("peak");
+    spectrumCmd.addFlagArg("avg");
+}
@@ -0,0 +1,8 @@
+#ifndef __SERIAL_NRF_CMD_H__
+#define __SERIAL_NRF_CMD_H__
+
+#include <SimpleCLI.h>
+
+void createNrfCommands(SimpleCLI *cli);
+
+#endif
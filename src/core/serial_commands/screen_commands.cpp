@@ -1,5 +1,6 @@
 #include "screen_commands.h"
 #include "core/settings.h"
+#include "core/sprite_canvas.h"
 #include "core/utils.h" // time
 #include <globals.h>
 
@@ -94,6 +95,34 @@ uint32_t clockCallback(cmd *c) {
     return true;
 }
 
+uint32_t statsCallback(cmd *c) {
+    // pixels pushed by the menu renderers
+    // e.g. "screen stats", "screen stats -reset"
+
+    Command cmd(c);
+
+    if (cmd.getArgument("reset").isSet()) {
+        renderStats.reset();
+        serialDevice->println("Render stats cleared");
+        return true;
+    }
+
+    uint32_t avg = renderStats.frames ? renderStats.totalPixels / renderStats.frames : 0;
+    serialDevice->printf(
+        "Menu frames: %lu (%lu buffered, %lu direct)\n",
+        (unsigned long)renderStats.frames,
+        (unsigned long)renderStats.buffered,
+        (unsigned long)(renderStats.frames - renderStats.buffered)
+    );
+    serialDevice->printf(
+        "Pixels/frame: last %lu, peak %lu, avg %lu\n",
+        (unsigned long)renderStats.lastPixels,
+        (unsigned long)renderStats.peakPixels,
+        (unsigned long)avg
+    );
+    return true;
+}
+
 void createScreenCommands(SimpleCLI *cli) {
     Command clockCmd = cli->addCommand("clock", clockCallback);
 
@@ -109,4 +138,7 @@ void createScreenCommands(SimpleCLI *cli) {
     rgbColorCmd.addPosArg("blue");
     Command hexColorCmd = colorCmd.addCommand("hex", hexColorCallback);
     hexColorCmd.addPosArg("value");
+
+    Command statsCmd = screenCmd.addCommand("stats", statsCallback);
+    statsCmd.addFlagArg("reset");
 }
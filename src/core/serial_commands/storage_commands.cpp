@@ -1,7 +1,13 @@
 #include "storage_commands.h"
 #include "core/sd_functions.h"
+#include "core/serialcmds.h"
 #include "helpers.h"
+#include <esp_rom_crc.h>
 #include <globals.h>
+#include <mbedtls/base64.h>
+
+#define STORAGE_BLOCK_SIZE 1024 // default readblock size
+#define STORAGE_BLOCK_MAX 4096
 
 uint32_t listCallback(cmd *c) {
     Command cmd(c);
@@ -136,7 +142,7 @@ uint32_t writeCallback(cmd *c) {
     Argument arg = cmd.getArgument("filepath");
     Argument sizeArg = cmd.getArgument("size");
     String filepath = arg.getValue();
-    String sizeStr = arg.getValue();
+    String sizeStr = sizeArg.getValue();
     filepath.trim();
     int fileSize = sizeStr.toInt();
 
@@ -149,8 +155,10 @@ uint32_t writeCallback(cmd *c) {
     FS *fs;
     if (!getFsStorage(fs)) return false;
 
+    uint32_t started = millis();
     char *txt = _readFileFromSerial(fileSize + 2);
     if (strlen(txt) == 0) return false;
+    serialCmdStats.upload(strlen(txt), millis() - started);
 
     File f = fs->open(filepath, FILE_WRITE, true);
     if (!f) return false;
@@ -162,6 +170,119 @@ uint32_t writeCallback(cmd *c) {
     serialDevice->println("File written: " + filepath);
     return true;
 }
+
+/*
+ * Block transfers for any serial console, binary safe and resumable. Blocks are
+ * base64 on one line with the CRC-32 of their bytes in hex:
+ *   storage readblock <path> <offset> [size]  ->  <offset> <length> <crc> <data>
+ *   storage writeblock <path> <offset> <crc> <data>  ->  OK <file size> | ERR <reason> <file size>
+ * A read shorter than asked ends the file. Writes go at an offset up to the file
+ * size, 0 starts the file over, and every block is closed on the storage before
+ * the reply, so after an interruption the size tells where to go on.
+ */
+static String blockPath(cmd *c) {
+    String filepath = Command(c).getArgument("filepath").getValue();
+    filepath.trim();
+    if (filepath.length() > 0 && !filepath.startsWith("/")) filepath = "/" + filepath;
+    return filepath;
+}
+
+// Times a transfer from its offset 0 block on, for `serial stats`
+static uint32_t blockTransferStart(uint32_t offset) {
+    static uint32_t started = 0;
+    if (offset == 0 || started == 0) started = millis();
+    return started;
+}
+
+uint32_t readBlockCallback(cmd *c) {
+    Command cmd(c);
+    String filepath = blockPath(c);
+    uint32_t offset = strtoul(cmd.getArgument("offset").getValue().c_str(), nullptr, 10);
+    size_t size = cmd.getArgument("size").getValue().toInt();
+    if (filepath.length() == 0 || size == 0 || size > STORAGE_BLOCK_MAX) return false;
+
+    FS *fs;
+    if (!getFsStorage(fs) || !(*fs).exists(filepath)) return false;
+    File f = fs->open(filepath, FILE_READ);
+    if (!f) return false;
+    if (offset > f.size() || !f.seek(offset)) {
+        serialDevice->printf("ERR offset %lu\n", (uint32_t)f.size());
+        f.close();
+        return false;
+    }
+
+    size_t encodedMax = 4 * ((size + 2) / 3) + 1;
+    uint8_t *data = (uint8_t *)malloc(size + encodedMax);
+    if (data == nullptr) {
+        f.close();
+        return false;
+    }
+    uint32_t started = blockTransferStart(offset);
+    size_t n = f.read(data, size);
+    f.close();
+
+    uint8_t *encoded = data + size;
+    size_t encodedLen = 0;
+    mbedtls_base64_encode(encoded, encodedMax, &encodedLen, data, n);
+    serialDevice->printf("%lu %u %08lX ", offset, n, esp_rom_crc32_le(0, data, n));
+    serialDevice->write(encoded, encodedLen);
+    serialDevice->println();
+    free(data);
+
+    if (n < size) serialCmdStats.download(offset + n, millis() - started);
+    return true;
+}
+
+uint32_t writeBlockCallback(cmd *c) {
+    Command cmd(c);
+    String filepath = blockPath(c);
+    uint32_t offset = strtoul(cmd.getArgument("offset").getValue().c_str(), nullptr, 10);
+    uint32_t crc = strtoul(cmd.getArgument("crc").getValue().c_str(), nullptr, 16);
+    String encoded = cmd.getArgument("data").getValue();
+    if (filepath.length() == 0) return false;
+
+    FS *fs;
+    if (!getFsStorage(fs)) return false;
+    uint32_t fileSize = 0;
+    if ((*fs).exists(filepath)) {
+        File f = fs->open(filepath, FILE_READ);
+        if (f) fileSize = f.size();
+        f.close();
+    }
+    if (offset > fileSize) {
+        serialDevice->printf("ERR offset %lu\n", fileSize);
+        return false;
+    }
+
+    uint8_t *data = (uint8_t *)malloc(STORAGE_BLOCK_MAX);
+    if (data == nullptr) return false;
+    size_t n = 0;
+    int err = mbedtls_base64_decode(
+        data, STORAGE_BLOCK_MAX, &n, (const unsigned char *)encoded.c_str(), encoded.length()
+    );
+    if (err != 0 || esp_rom_crc32_le(0, data, n) != crc) {
+        free(data);
+        serialDevice->printf("ERR crc %lu\n", fileSize);
+        return false;
+    }
+
+    uint32_t started = blockTransferStart(offset);
+    // "r+" writes in place, a resent block lands where it did the first time
+    File f = fs->open(filepath, offset == 0 ? FILE_WRITE : "r+", true);
+    bool ok = f && f.seek(offset) && f.write(data, n) == n;
+    if (f) {
+        fileSize = f.size();
+        f.close();
+    }
+    free(data);
+    if (!ok) {
+        serialDevice->printf("ERR write %lu\n", fileSize);
+        return false;
+    }
+    serialCmdStats.upload(offset + n, millis() - started);
+    serialDevice->printf("OK %lu\n", fileSize);
+    return true;
+}
 #endif
 uint32_t renameCallback(cmd *c) {
     Command cmd(c);
@@ -403,6 +524,17 @@ void createStorageCommand(SimpleCLI *cli) {
     Command cmdWrite = cmd.addCommand("write", writeCallback);
     cmdWrite.addPosArg("filepath");
     cmdWrite.addPosArg("size", "0");
+
+    Command cmdReadBlock = cmd.addCommand("readblock", readBlockCallback);
+    cmdReadBlock.addPosArg("filepath");
+    cmdReadBlock.addPosArg("offset", "0");
+    cmdReadBlock.addPosArg("size", String(STORAGE_BLOCK_SIZE).c_str());
+
+    Command cmdWriteBlock = cmd.addCommand("writeblock", writeBlockCallback);
+    cmdWriteBlock.addPosArg("filepath");
+    cmdWriteBlock.addPosArg("offset");
+    cmdWriteBlock.addPosArg("crc");
+    cmdWriteBlock.addPosArg("data", "");
 #endif
     Command cmdRename = cmd.addCommand("rename", renameCallback);
     cmdRename.addPosArg("filepath");
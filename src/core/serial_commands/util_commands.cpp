@@ -1,10 +1,17 @@
 #include "util_commands.h"
+#include "core/boot_trace.h"
+#include "core/input_events.h"
 #include "core/main_menu.h"
+#include "core/perf_monitor.h"
 #include "core/sd_functions.h"
+#include "core/serialcmds.h"
 #include "core/utils.h" // to return optionsJSON
 #include "core/wifi/webInterface.h"
 #include "core/wifi/wifi_common.h" //to return MAC addr
 #include "modules/badusb_ble/ducky_typer.h"
+#if !defined(LITE_VERSION)
+#include "modules/ble_api/services/BLESerialService.h"
+#endif
 #include <Wire.h>
 #include <globals.h>
 
@@ -21,6 +28,11 @@ uint32_t uptimeCallback(cmd *c) {
     return true;
 }
 
+uint32_t bootTraceCallback(cmd *c) {
+    serialDevice->print(bootTraceReport());
+    return true;
+}
+
 uint32_t dateCallback(cmd *c) {
     if (!clock_set) {
         serialDevice->println("Clock not set");
@@ -198,7 +210,13 @@ uint32_t helpCallback(cmd *c) {
         "  storage <list/remove/mkdir/rename/read/write/copy/md5/crc32> <file path>  - Common file "
         "management commands."
     );
+    serialDevice->println("  storage readblock <file path> <offset> [size]   - Base64 block and CRC-32.");
+    serialDevice->println("  storage writeblock <file path> <offset> <crc> <data>  - Resumable upload.");
     serialDevice->println("  ls - Same as storage list");
+    serialDevice->println("  serial stats [-reset]   - Serial command, transfer and BLE console rates.");
+    serialDevice->println("  boottrace               - Time taken by each boot phase.");
+    serialDevice->println("  perf [tasks/history/json/reset]  - Heap, CPU load and stack use of each task.");
+    serialDevice->println("  input stats [-reset]    - Input task wakeups and press to action latency.");
 
     serialDevice->println("\nSettings:");
     serialDevice->println("  settings                - View all the current settings.");
@@ -353,6 +371,125 @@ uint32_t displayCallback(cmd *c) {
     return true;
 }
 
+uint32_t serialCallback(cmd *c) {
+    Command cmd(c);
+    String opt = cmd.getArgument("option").getValue();
+    if (cmd.getArgument("reset").isSet()) {
+        serialCmdStats.reset();
+#if !defined(LITE_VERSION)
+        bleSerialStats.reset();
+#endif
+        serialDevice->println("Serial stats reset");
+        return true;
+    }
+    if (opt != "stats") {
+        serialDevice->println("Serial command accept:\nserial stats [-reset] : Command and transfer rates");
+        return false;
+    }
+
+    const SerialCmdStats &s = serialCmdStats;
+    uint32_t elapsed = max<uint32_t>(1, millis() - s.since);
+    serialDevice->printf("Commands: %lu\n", s.commands);
+    serialDevice->printf("Commands/s: %.2f avg, %lu peak\n", s.commands * 1000.0f / elapsed, s.peakRate);
+    serialDevice->printf("Received: %lu bytes\n", s.rxBytes);
+    serialDevice->printf("Frames: %lu ok, %lu bad\n", s.frames, s.badFrames);
+    if (s.uploadMs > 0) {
+        serialDevice->printf(
+            "Last upload: %lu bytes in %lu ms, %lu B/s\n",
+            s.uploadBytes,
+            s.uploadMs,
+            (uint32_t)((uint64_t)s.uploadBytes * 1000 / s.uploadMs)
+        );
+    } else {
+        serialDevice->println("Last upload: none");
+    }
+    if (s.downloadMs > 0) {
+        serialDevice->printf(
+            "Last download: %lu bytes in %lu ms, %lu B/s\n",
+            s.downloadBytes,
+            s.downloadMs,
+            (uint32_t)((uint64_t)s.downloadBytes * 1000 / s.downloadMs)
+        );
+    }
+#if !defined(LITE_VERSION)
+    const BleSerialStats &b = bleSerialStats;
+    if (b.txBytes > 0 || b.rxBytes > 0) {
+        serialDevice->printf(
+            "BLE sent: %lu bytes in %lu notifications, %lu stalls, %lu dropped\n",
+            b.txBytes,
+            b.notifications,
+            b.stalls,
+            b.txDropped
+        );
+        serialDevice->printf("BLE received: %lu bytes, %lu dropped\n", b.rxBytes, b.rxDropped);
+        if (b.busyMs > 0) {
+            serialDevice->printf(
+                "BLE sustained: %lu B/s, last burst %lu bytes in %lu ms\n",
+                (uint32_t)((uint64_t)b.txBytes * 1000 / b.busyMs),
+                b.lastBurstBytes,
+                b.lastBurstMs
+            );
+        }
+    }
+#endif
+    return true;
+}
+
+uint32_t inputCallback(cmd *c) {
+    Command cmd(c);
+    if (cmd.getArgument("reset").isSet()) {
+        inputStats.reset();
+        serialDevice->println("Input stats reset");
+        return true;
+    }
+
+    const InputStats &s = inputStats;
+    uint32_t elapsed = max<uint32_t>(1, millis() - s.since);
+    serialDevice->printf(
+        "Wakeups: %lu, %.1f/s, %lu by a key interrupt\n",
+        s.wakeups,
+        s.wakeups * 1000.0f / elapsed,
+        s.irqWakeups
+    );
+    serialDevice->printf(
+        "Presses: %lu queued, %lu handled, %lu expired, %lu dropped\n",
+        s.events,
+        s.consumed,
+        s.expired,
+        s.dropped
+    );
+    if (s.latencySamples > 0) {
+        serialDevice->printf(
+            "Press to action: %.1f ms avg, %.1f ms max\n",
+            s.latencyTotal / 1000.0f / s.latencySamples,
+            s.latencyMax / 1000.0f
+        );
+    }
+    return true;
+}
+
+uint32_t perfCallback(cmd *c) {
+    Command cmd(c);
+    String opt = cmd.getArgument("option").getValue();
+    if (opt == "tasks") {
+        serialDevice->print(perfMonitor.report());
+    } else if (opt == "history") {
+        serialDevice->print(perfMonitor.historyReport());
+    } else if (opt == "json") {
+        serialDevice->println(perfMonitor.toJson(true));
+    } else if (opt == "reset") {
+        perfMonitor.resetHistory();
+        serialDevice->println("Perf history cleared");
+    } else {
+        serialDevice->println(
+            "Perf command accept:\nperf [tasks] : Heap, CPU and stack of each task\n"
+            "perf history : Heap and CPU samples\nperf json : Everything as JSON\nperf reset : Clear history"
+        );
+        return false;
+    }
+    return true;
+}
+
 uint32_t loaderCallback(cmd *c) {
     Command cmd(c);
     String arg = cmd.getArgument("cmd").getValue();
@@ -413,6 +550,7 @@ uint32_t loaderCallback(cmd *c) {
 
 void createUtilCommands(SimpleCLI *cli) {
     cli->addCommand("uptime", uptimeCallback);
+    cli->addCommand("boottrace,boot_trace", bootTraceCallback);
     cli->addCommand("date", dateCallback);
     cli->addCommand("i2c", i2cCallback);
     cli->addCommand("free", freeCallback);
@@ -429,6 +567,17 @@ void createUtilCommands(SimpleCLI *cli) {
     Command opt = cli->addCommand("options,option", optionsCallback);
     opt.addPosArg("run", "-1");
 
+    Command serial = cli->addCommand("serial", serialCallback);
+    serial.addPosArg("option", "stats");
+    serial.addFlagArg("reset");
+
+    Command input = cli->addCommand("input", inputCallback);
+    input.addPosArg("option", "stats");
+    input.addFlagArg("reset");
+
+    Command perf = cli->addCommand("perf", perfCallback);
+    perf.addPosArg("option", "tasks");
+
     Command loader = cli->addCommand("loader", loaderCallback);
     loader.addPosArg("cmd");
     loader.addPosArg("appname", "none"); // optional
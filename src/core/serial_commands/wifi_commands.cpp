@@ -1,5 +1,7 @@
 #include "wifi_commands.h"
+#include "core/connect/esp_transfer.h"
 #include "core/wifi/webInterface.h"
+#include "core/wifi/web_assets.h"
 #include "core/wifi/wifi_common.h" //to return MAC addr
 #include <globals.h>
 #include <modules/ethernet/ARPScanner.h>
@@ -54,6 +56,16 @@ uint32_t wifiCallback(cmd *c) {
 uint32_t webuiCallback(cmd *c) {
     Command cmd(c);
 
+    if (cmd.getArgument("stats").isSet()) {
+        serialDevice->printf(
+            "WebUI assets: %lu requests, %lu not modified, %llu bytes sent\n",
+            webAssetStats.requests,
+            webAssetStats.notModified,
+            webAssetStats.bytes
+        );
+        return true;
+    }
+
     Argument arg = cmd.getArgument("noAp");
     bool noAp = arg.isSet();
 
@@ -72,7 +84,14 @@ uint32_t scanHostsCallback(cmd *c) {
           return false;
       }
 
-    ARPScanner{esp_netinterface};
+    Command cmd(c);
+    int inFlight = cmd.getArgument("inflight").getValue().toInt();
+    int retries = cmd.getArgument("retries").getValue().toInt();
+    if (inFlight <= 0) inFlight = ARP_SCAN_IN_FLIGHT;
+    if (inFlight > ARP_SCAN_MAX_IN_FLIGHT) inFlight = ARP_SCAN_MAX_IN_FLIGHT;
+    if (retries < 0 || retries > 10) retries = ARP_SCAN_RETRIES;
+
+    ARPScanner{esp_netinterface, (uint8_t)inFlight, (uint8_t)retries};
 
     return true;
 }
@@ -91,6 +110,41 @@ uint32_t listenTCPCallback(cmd *c) {
     return true;
 }
 
+uint32_t espnowLoopbackCallback(cmd *c) {
+    Command cmd(c);
+    int loss = cmd.getArgument("loss").getValue().toInt();
+    int kb = cmd.getArgument("kb").getValue().toInt();
+    if (loss < 0 || loss > 90 || kb <= 0) {
+        serialDevice->println("Usage: espnow_loopback [loss 0-90] [kb]");
+        return false;
+    }
+
+    uint32_t totalBytes = kb * 1024;
+    uint32_t wallStart = millis();
+    XferLoopbackResult result = espTransferLoopback(loss, totalBytes, esp_random(), []() {
+        vTaskDelay(1); // keep the watchdog fed
+    });
+    const XferStats &stats = result.stats;
+
+    serialDevice->printf(
+        "Loopback %s: %lu bytes, %u%% loss, %lu frames, %lu retransmits, %lu dropped\n",
+        result.ok ? "OK" : "FAILED",
+        totalBytes,
+        loss,
+        stats.frames,
+        stats.retransmits,
+        result.dropped
+    );
+    serialDevice->printf(
+        "Simulated link (1 frame/ms): %lu ms, %.1f KB/s, efficiency %.0f%%\n",
+        stats.elapsed(),
+        stats.kbps(),
+        stats.elapsed() ? 100.0f * totalBytes / XFER_CHUNK_SIZE / stats.elapsed() : 0
+    );
+    serialDevice->printf("Wall clock: %lu ms\n", millis() - wallStart);
+    return result.ok;
+}
+
 /*
 uint32_t responderCallback(cmd *c) {
     if (!wifiConnected) Serial.println("Connect to a WiFi first."); return false;
@@ -104,15 +158,22 @@ uint32_t responderCallback(cmd *c) {
 void createWifiCommands(SimpleCLI *cli) {
     Command webuiCmd = cli->addCommand("webui", webuiCallback);
     webuiCmd.addFlagArg("noAp");
+    webuiCmd.addFlagArg("stats");
 
     Command wifiCmd = cli->addCommand("wifi", wifiCallback);
     wifiCmd.addPosArg("status");
     wifiCmd.addPosArg("ssid", "");
     wifiCmd.addPosArg("pwd", "");
 
+    Command espnowLoopbackCmd = cli->addCommand("espnow_loopback", espnowLoopbackCallback);
+    espnowLoopbackCmd.addPosArg("loss", "10");
+    espnowLoopbackCmd.addPosArg("kb", "64");
+
     #if !defined(LITE_VERSION)
 
     Command ScanHostsCmd = cli->addCommand("arp", scanHostsCallback);
+    ScanHostsCmd.addPosArg("inflight", String(ARP_SCAN_IN_FLIGHT).c_str());
+    ScanHostsCmd.addPosArg("retries", String(ARP_SCAN_RETRIES).c_str());
 
     Command listenTCPCmd = cli->addCommand("listen", listenTCPCallback); //TODO: make possible to select port to open via Serial
     
@@ -0,0 +1,269 @@
+#include "serial_frames.h"
+#include "sd_functions.h"
+#include "serialcmds.h"
+#include "utils.h"
+#include <esp_rom_crc.h>
+#include <globals.h>
+
+#define FRAME_CRC_SIZE sizeof(uint32_t)
+
+bool SerialFramer::feed(uint8_t c, bool lineStart) {
+    if (_discarding) {
+        _lastByte = millis(); // poll() ends it after SERIAL_FRAME_TIMEOUT_MS of silence
+        return true;
+    }
+    if (_pos == 0 && !(lineStart && c == SERIAL_FRAME_MAGIC)) return false;
+    if (_buf == nullptr) {
+        // one spare byte to terminate a COMMAND payload
+        _buf = (uint8_t *)malloc(sizeof(SerialFrameHeader) + SERIAL_FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE + 1);
+        if (_buf == nullptr) return false;
+    }
+    _buf[_pos++] = c;
+    _lastByte = millis();
+    if (_pos < sizeof(SerialFrameHeader)) return true;
+
+    SerialFrameHeader hdr;
+    memcpy(&hdr, _buf, sizeof(hdr));
+    if (hdr.len > SERIAL_FRAME_MAX_PAYLOAD) {
+        _pos = 0;
+        _discarding = true;
+        serialCmdStats.badFrames++;
+        nak(hdr, FRAME_ERR_LENGTH);
+        return true;
+    }
+    size_t dataLen = sizeof(hdr) + hdr.len;
+    if (_pos < dataLen + FRAME_CRC_SIZE) return true;
+
+    _pos = 0;
+    uint32_t crc;
+    memcpy(&crc, _buf + dataLen, sizeof(crc));
+    if (crc != esp_rom_crc32_le(0, _buf, dataLen)) {
+        serialCmdStats.badFrames++;
+        nak(hdr, FRAME_ERR_CRC);
+        return true;
+    }
+    serialCmdStats.frames++;
+    handle(hdr, _buf + sizeof(hdr));
+
+    // keep the buffer only while a transfer is streaming frames
+    if (!_file && !_readFile) {
+        free(_buf);
+        _buf = nullptr;
+    }
+    return true;
+}
+
+void SerialFramer::poll() {
+    if ((_pos == 0 && !_discarding) || millis() - _lastByte < SERIAL_FRAME_TIMEOUT_MS) return;
+    if (_pos > 0) serialCmdStats.badFrames++;
+    _pos = 0;
+    _discarding = false;
+}
+
+void SerialFramer::end() {
+    if (_file) _file.close();
+    if (_readFile) _readFile.close();
+    free(_buf);
+    _buf = nullptr;
+    _pos = 0;
+    _discarding = false;
+}
+
+void SerialFramer::handle(const SerialFrameHeader &hdr, uint8_t *payload) {
+    switch (hdr.type) {
+        case FRAME_COMMAND: {
+            payload[hdr.len] = '\0';
+            String line = (const char *)payload;
+            uint8_t result = serialCli.parse(line);
+            serialCmdStats.command();
+            ack(hdr, &result, 1);
+            backToMenu();
+            break;
+        }
+        case FRAME_FILE_OPEN:
+        case FRAME_FILE_RESUME: openFile(hdr, payload); break;
+        case FRAME_FILE_DATA:
+            if (!_file) {
+                nak(hdr, FRAME_ERR_FILE);
+            } else if (hdr.seq == _nextSeq) {
+                if (_file.write(payload, hdr.len) != hdr.len) {
+                    nak(hdr, FRAME_ERR_FILE);
+                    break;
+                }
+                _written += hdr.len;
+                _nextSeq++;
+                ack(hdr);
+            } else if (hdr.seq == (uint16_t)(_nextSeq - 1)) {
+                ack(hdr); // already written, its ACK got lost
+            } else {
+                nak(hdr, FRAME_ERR_SEQUENCE);
+            }
+            break;
+        case FRAME_FILE_CLOSE: {
+            if (!_file) {
+                nak(hdr, FRAME_ERR_FILE);
+                break;
+            }
+            _file.close();
+            uint32_t ms = millis() - _started;
+            serialCmdStats.upload(_written - _resumedAt, ms);
+            if (_fileSize > 0 && _written != _fileSize) {
+                nak(hdr, FRAME_ERR_SIZE);
+                break;
+            }
+            uint32_t data[2] = {_written, ms};
+            ack(hdr, (const uint8_t *)data, sizeof(data));
+            break;
+        }
+        case FRAME_FILE_READ: readFile(hdr, payload); break;
+        case FRAME_SCREEN: sendScreen(hdr, payload); break;
+        default: nak(hdr, FRAME_ERR_TYPE); break;
+    }
+}
+
+void SerialFramer::openFile(const SerialFrameHeader &hdr, uint8_t *payload) {
+    if (hdr.len <= sizeof(uint32_t)) {
+        nak(hdr, FRAME_ERR_LENGTH);
+        return;
+    }
+    if (_file) _file.close(); // a new upload replaces an unfinished one
+    memcpy(&_fileSize, payload, sizeof(uint32_t));
+    payload[hdr.len] = '\0';
+    String path = (const char *)payload + sizeof(uint32_t);
+    if (!path.startsWith("/")) path = "/" + path;
+
+    bool resume = hdr.type == FRAME_FILE_RESUME;
+    FS *fs;
+    if (getFsStorage(fs)) _file = fs->open(path, resume ? FILE_APPEND : FILE_WRITE, true);
+    if (!_file) {
+        nak(hdr, FRAME_ERR_FILE);
+        return;
+    }
+    _resumedAt = resume ? _file.size() : 0;
+    if (_fileSize > 0 && _resumedAt > _fileSize) {
+        _file.close();
+        nak(hdr, FRAME_ERR_SIZE);
+        return;
+    }
+    _written = _resumedAt;
+    _nextSeq = 0;
+    _started = millis();
+    if (resume) ack(hdr, (const uint8_t *)&_resumedAt, sizeof(_resumedAt));
+    else ack(hdr);
+}
+
+void SerialFramer::readFile(const SerialFrameHeader &hdr, uint8_t *payload) {
+    const size_t pathAt = sizeof(uint32_t) + sizeof(uint16_t);
+    if (hdr.len <= pathAt) {
+        nak(hdr, FRAME_ERR_LENGTH);
+        return;
+    }
+    uint32_t offset;
+    uint16_t length;
+    memcpy(&offset, payload, sizeof(offset));
+    memcpy(&length, payload + sizeof(offset), sizeof(length));
+    length = min<uint16_t>(length, SERIAL_FRAME_READ_MAX);
+    payload[hdr.len] = '\0';
+    String path = (const char *)payload + pathAt;
+    if (!path.startsWith("/")) path = "/" + path;
+
+    if (_readFile && path != _readPath) _readFile.close();
+    if (!_readFile) {
+        FS *fs;
+        if (getFsStorage(fs) && fs->exists(path)) _readFile = fs->open(path, FILE_READ);
+        if (!_readFile) {
+            nak(hdr, FRAME_ERR_FILE);
+            return;
+        }
+        _readPath = path;
+        _readBytes = 0;
+        _readStarted = millis();
+    }
+    if (offset == 0) {
+        _readBytes = 0;
+        _readStarted = millis();
+    }
+    if (offset > _readFile.size()) {
+        nak(hdr, FRAME_ERR_SIZE);
+        return;
+    }
+
+    // the request is parsed, its buffer takes the answer
+    memcpy(payload, &offset, sizeof(offset));
+    size_t n = 0;
+    if (length > 0 && _readFile.seek(offset)) n = _readFile.read(payload + sizeof(offset), length);
+    send(FRAME_FILE_READ, hdr.seq, payload, sizeof(offset) + n);
+    _readBytes += n;
+    if (n < length) {
+        serialCmdStats.download(_readBytes, millis() - _readStarted);
+        _readFile.close();
+    }
+}
+
+void SerialFramer::send(uint8_t type, uint16_t seq, const uint8_t *payload, uint16_t len) {
+    if (_out == nullptr) return;
+    SerialFrameHeader hdr = {SERIAL_FRAME_MAGIC, type, seq, len};
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr, sizeof(hdr));
+    if (len > 0) crc = esp_rom_crc32_le(crc, payload, len);
+
+    _out->write((const uint8_t *)&hdr, sizeof(hdr));
+    if (len > 0) _out->write(payload, len);
+    _out->write((const uint8_t *)&crc, sizeof(crc));
+}
+
+void SerialFramer::ack(const SerialFrameHeader &hdr, const uint8_t *data, uint16_t len) {
+    uint8_t payload[1 + 2 * sizeof(uint32_t)];
+    len = min<uint16_t>(len, sizeof(payload) - 1);
+    payload[0] = hdr.type;
+    if (len > 0) memcpy(payload + 1, data, len);
+    send(FRAME_ACK, hdr.seq, payload, len + 1);
+}
+
+void SerialFramer::nak(const SerialFrameHeader &hdr, SerialFrameError reason) {
+    uint8_t payload[4] = {hdr.type, reason, (uint8_t)(_nextSeq & 0xFF), (uint8_t)(_nextSeq >> 8)};
+    send(FRAME_NAK, hdr.seq, payload, sizeof(payload));
+}
+
+void SerialFramer::sendScreen(const SerialFrameHeader &hdr, const uint8_t *payload) {
+    if (!tft.getLogging()) {
+        // nothing was logged yet, the redraw fills the log for the next request
+        tft.setLogging();
+        backToMenu();
+    }
+    bool incremental = hdr.len >= sizeof(uint32_t);
+    bool lz = hdr.len > sizeof(uint32_t) && (payload[sizeof(uint32_t)] & SCREEN_LZ);
+    size_t bufSize = incremental ? MAX_LOG_DELTA_SIZE : MAX_LOG_ENTRIES * MAX_LOG_SIZE;
+    uint8_t *log = (uint8_t *)malloc(bufSize + (lz ? bufSize + bufSize / 128 + 1 : 0));
+    if (log == nullptr) {
+        nak(hdr, FRAME_ERR_MEMORY);
+        return;
+    }
+    size_t size = 0;
+    if (incremental) {
+        uint32_t since;
+        memcpy(&since, payload, sizeof(since));
+        tft.getBinLogSince(since, log, size);
+    } else {
+        tft.getBinLog(log, size);
+    }
+    const uint8_t *out = log;
+    if (lz) {
+        size_t packed = tftLogCompress(log, size, log + bufSize);
+        if (packed == 0) {
+            free(log);
+            nak(hdr, FRAME_ERR_MEMORY);
+            return;
+        }
+        out = log + bufSize;
+        size = packed;
+    }
+
+    size_t offset = 0;
+    while (true) {
+        uint16_t len = min(size - offset, (size_t)SERIAL_FRAME_MAX_PAYLOAD);
+        send(FRAME_SCREEN, hdr.seq, out + offset, len);
+        offset += len;
+        if (len < SERIAL_FRAME_MAX_PAYLOAD) break;
+    }
+    free(log);
+}
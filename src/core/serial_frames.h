@@ -0,0 +1,108 @@
+#ifndef __SERIAL_FRAMES_H__
+#define __SERIAL_FRAMES_H__
+
+#include <FS.h>
+
+/*
+ * Length prefixed binary frames on the serial command port, for bulk transfers
+ * that do not fit the line based CLI. A frame is recognised when its magic byte
+ * starts a line, so text commands and frames can be mixed on the same port.
+ *
+ *   magic(0xA7) type(u8) seq(u16) len(u16) payload[len] crc32(u32)
+ *
+ * Integers are little endian, the CRC-32 covers the header and the payload.
+ * A header with a length over SERIAL_FRAME_MAX_PAYLOAD is NAKed and what
+ * follows it is dropped until SERIAL_FRAME_TIMEOUT_MS of silence: the payload
+ * is binary, a newline in it does not end the frame, so none of it reaches
+ * the text parser. After a FRAME_ERR_LENGTH NAK the sender pauses that long
+ * before its next frame or command.
+ * Every frame gets an ACK or a NAK with the same seq:
+ *   ACK payload: acked type, then data specific to the type
+ *   NAK payload: rejected type, reason, expected seq (u16)
+ *
+ * An interrupted upload goes on with FILE_RESUME from the size the device
+ * reports, the file is written as FILE_DATA arrives. Downloads are FILE_READ
+ * requests at explicit offsets, a lost answer is simply asked again.
+ */
+
+#define SERIAL_FRAME_MAGIC 0xA7
+#define SERIAL_FRAME_MAX_PAYLOAD 4096
+#define SERIAL_FRAME_TIMEOUT_MS 1000 // an incomplete frame is dropped after this long without bytes
+#define SERIAL_FRAME_READ_MAX (SERIAL_FRAME_MAX_PAYLOAD - sizeof(uint32_t)) // file bytes per FILE_READ
+
+enum SerialFrameType : uint8_t {
+    FRAME_ACK = 0x00,
+    FRAME_NAK = 0x01,
+    FRAME_COMMAND = 0x10,     // payload: command line, ACK data: result (u8)
+    FRAME_FILE_OPEN = 0x20,   // payload: size (u32, 0 if unknown), path
+    FRAME_FILE_DATA = 0x21,   // payload: file bytes, seq counts from 0 after FILE_OPEN
+    FRAME_FILE_CLOSE = 0x22,  // ACK data: bytes written (u32), upload time in ms (u32)
+    FRAME_FILE_RESUME = 0x23, // payload: size (u32), path, ACK data: bytes already in the file (u32)
+                              // FILE_DATA then appends, its seq counts from 0 again
+    FRAME_FILE_READ = 0x24,   // payload: offset (u32), length (u16), path, answered with a FILE_READ
+                              // frame: offset (u32), file bytes, fewer than asked at the end of the file
+    FRAME_SCREEN = 0x30,      // answered with SCREEN frames holding the tft log, the last one is short
+                              // payload: none for a full log, or a cursor (u32) for the LOG_DELTA since
+                              // then and flags (u8, SCREEN_LZ: tftLogCompress()ed)
+};
+
+#define SCREEN_LZ 0x01
+
+enum SerialFrameError : uint8_t {
+    FRAME_ERR_CRC = 1,
+    FRAME_ERR_LENGTH = 2,
+    FRAME_ERR_TYPE = 3,
+    FRAME_ERR_SEQUENCE = 4,
+    FRAME_ERR_FILE = 5,
+    FRAME_ERR_SIZE = 6,
+    FRAME_ERR_MEMORY = 7,
+};
+
+struct __attribute__((packed)) SerialFrameHeader {
+    uint8_t magic;
+    uint8_t type;
+    uint16_t seq;
+    uint16_t len;
+};
+
+class SerialFramer {
+public:
+    // Feeds one received byte, false if it does not belong to a frame
+    bool feed(uint8_t c, bool lineStart);
+    bool receiving(void) { return _pos > 0 || _discarding; }
+    // Drops a frame left incomplete, call while idle
+    void poll(void);
+    // Aborts an upload in progress and frees the buffers
+    void end(void);
+
+    void setOutput(Stream *out) { _out = out; }
+
+private:
+    Stream *_out = nullptr;
+    uint8_t *_buf = nullptr;
+    size_t _pos = 0;
+    uint32_t _lastByte = 0;
+    bool _discarding = false; // dropping the body of a frame with a bad length
+
+    File _file;
+    uint32_t _fileSize = 0;
+    uint32_t _written = 0;
+    uint32_t _resumedAt = 0; // file size when FILE_RESUME opened it
+    uint32_t _started = 0;
+    uint16_t _nextSeq = 0;
+
+    File _readFile; // kept open between FILE_READ frames, closed at the end of the file
+    String _readPath;
+    uint32_t _readBytes = 0;
+    uint32_t _readStarted = 0;
+
+    void handle(const SerialFrameHeader &hdr, uint8_t *payload);
+    void send(uint8_t type, uint16_t seq, const uint8_t *payload, uint16_t len);
+    void ack(const SerialFrameHeader &hdr, const uint8_t *data = nullptr, uint16_t len = 0);
+    void nak(const SerialFrameHeader &hdr, SerialFrameError reason);
+    void openFile(const SerialFrameHeader &hdr, uint8_t *payload);
+    void readFile(const SerialFrameHeader &hdr, uint8_t *payload);
+    void sendScreen(const SerialFrameHeader &hdr, const uint8_t *payload);
+};
+
+#endif
@@ -2,68 +2,204 @@
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "serial_frames.h"
 #include "utils.h"
 #include <globals.h>
 
 QueueHandle_t cmdQueue = nullptr;
 QueueHandle_t rspQueue = nullptr;
 TaskHandle_t serialcmdsTaskHandle;
+SerialCmdStats serialCmdStats;
+
+static volatile bool serialCmdsPaused = false;
+static volatile bool serialCmdsBusy = false;
+static portMUX_TYPE serialCmdsMux = portMUX_INITIALIZER_UNLOCKED;
+static SerialFramer serialFramer;
 
 struct CmdPacket {
-    char text[SAFE_STACK_BUFFER_SIZE];
+    char *text; // heap copy, freed by the serial commands task
+    uint32_t id;
+    bool reply;
+};
+
+struct CmdResponse {
+    uint32_t id;
+    bool result;
 };
+
+void SerialCmdStats::command() {
+    uint32_t now = millis();
+    if (now - _windowStart >= 1000) {
+        _windowStart = now;
+        _windowCount = 0;
+    }
+    commands++;
+    peakRate = max(peakRate, ++_windowCount);
+}
+
+void SerialCmdStats::upload(uint32_t bytes, uint32_t ms) {
+    uploadBytes = bytes;
+    uploadMs = ms;
+}
+
+void SerialCmdStats::download(uint32_t bytes, uint32_t ms) {
+    downloadBytes = bytes;
+    downloadMs = ms;
+}
+
+void SerialCmdStats::reset() {
+    *this = SerialCmdStats();
+    since = millis();
+}
+
+void serialCommandsNotify() {
+    if (serialcmdsTaskHandle) xTaskNotifyGive(serialcmdsTaskHandle);
+}
+
+void serialCommandsWakeOnReceive(HardwareSerial &port) {
+    port.onReceive([]() { serialCommandsNotify(); });
+}
+
+void pauseSerialCommands(bool pause) {
+    serialCmdsPaused = pause;
+    if (!pause) {
+        serialCommandsNotify(); // catch up with what arrived meanwhile
+        return;
+    }
+    if (xTaskGetCurrentTaskHandle() == serialcmdsTaskHandle) return;
+    uint32_t start = millis();
+    while (serialCmdsBusy && millis() - start < SERIAL_CMD_RESPONSE_MS) vTaskDelay(pdMS_TO_TICKS(5));
+}
+
 bool parseSerialCommand(const String &command, bool waitForResponse) {
     if (!cmdQueue || !rspQueue) {
         Serial.println("Command or response queue not initialized");
         return false;
     }
-    CmdPacket packet;
-    memset(&packet, 0, sizeof(packet));
-    strncpy(packet.text, command.c_str(), sizeof(packet.text) - 1);
+    // Called by a command running on the serial task, queueing would wait for ourselves
+    if (xTaskGetCurrentTaskHandle() == serialcmdsTaskHandle) return serialCli.parse(command);
+
+    static uint32_t lastId = 0;
+    CmdPacket packet = {strdup(command.c_str()), 0, waitForResponse};
+    if (packet.text == nullptr) return false;
+    taskENTER_CRITICAL(&serialCmdsMux);
+    packet.id = ++lastId;
+    taskEXIT_CRITICAL(&serialCmdsMux);
 
     // Enqueue the command packet for processing
     if (xQueueSend(cmdQueue, &packet, 0) != pdTRUE) {
         Serial.println("Failed to send command to queue");
+        free(packet.text);
         return false;
     }
+    serialCommandsNotify();
     if (!waitForResponse) { return true; }
-    // Wait for the response
-    bool result;
-    if (xQueueReceive(rspQueue, &result, pdMS_TO_TICKS(20))) { return result; }
+
+    // Wait for the response, skipping the late ones of callers that gave up
+    CmdResponse rsp;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(SERIAL_CMD_RESPONSE_MS);
+    TickType_t elapsed;
+    while ((elapsed = xTaskGetTickCount() - start) < timeout) {
+        if (xQueueReceive(rspQueue, &rsp, timeout - elapsed) != pdTRUE) break;
+        if (rsp.id == packet.id) return rsp.result;
+    }
     Serial.println("Failed to receive command response");
     return false;
 }
 
-void handleSerialCommands(SerialCli &serialCli) {
+static void runQueuedCommands() {
     CmdPacket packet;
-    if (cmdQueue && rspQueue) {
-        if (xQueueReceive(cmdQueue, &packet, 0) == pdTRUE) {
-            bool result = serialCli.parse(String(packet.text));
-            xQueueSend(rspQueue, &result, 0);
-            Serial.println("COMMAND: " + String(packet.text));
-            Serial.printf("[CLI] Result: %s\n", result ? "TRUE" : "FALSE");
+    while (!serialCmdsPaused && xQueueReceive(cmdQueue, &packet, 0) == pdTRUE) {
+        String text = packet.text;
+        free(packet.text);
+        bool result = serialCli.parse(text);
+        serialCmdStats.command();
+        if (packet.reply) {
+            CmdResponse rsp = {packet.id, result};
+            if (xQueueSend(rspQueue, &rsp, 0) != pdTRUE) {
+                CmdResponse stale;
+                xQueueReceive(rspQueue, &stale, 0);
+                xQueueSend(rspQueue, &rsp, 0);
+            }
         }
+        Serial.println("COMMAND: " + text);
+        Serial.printf("[CLI] Result: %s\n", result ? "TRUE" : "FALSE");
     }
-    if (!serialDevice->available()) return;
+}
 
-    String cmd_str = serialDevice->readStringUntil('\n');
-    Serial.println("COMMAND: " + cmd_str);
-    serialCli.parse(cmd_str);
+static void runLine(String &line) {
+    Serial.println("COMMAND: " + line);
+    serialCli.parse(line);
+    serialCmdStats.command();
     serialDevice->print("# "); // prompt
     backToMenu();              // forced menu redrawn
+    line = "";
+}
+
+// Reads what arrived so far without blocking. A line runs as soon as its '\n' is read,
+// so a command reading the rest of the input itself (storage write) finds it untouched.
+static void readSerialStream(Stream *in) {
+    static String line;
+    static uint32_t lastByte = 0;
+
+    serialFramer.setOutput(in);
+    while (!serialCmdsPaused && in->available()) {
+        int c = in->read();
+        if (c < 0) break;
+        serialCmdStats.rxBytes++;
+        lastByte = millis();
+        if (serialFramer.feed(c, line.isEmpty())) continue;
+        if (c == '\n') runLine(line);
+        else line += (char)c;
+    }
+    serialFramer.poll();
+    if (!serialCmdsPaused && !line.isEmpty() && millis() - lastByte >= SERIAL_LINE_TIMEOUT_MS) runLine(line);
+}
+
+void handleSerialCommands(SerialCli &serialCli) {
+    if (cmdQueue && rspQueue) runQueuedCommands();
+    if (serialCmdsPaused) return;
+
+    if (serialDevice == &USBserial) {
+        readSerialStream(USBserial.getSerialOutput());
+    } else if (serialDevice->available()) {
+        String cmd_str = serialDevice->readStringUntil('\n');
+        runLine(cmd_str);
+    }
+}
+
+#if ARDUINO_USB_CDC_ON_BOOT
+static void onUsbReceive(void *arg, esp_event_base_t base, int32_t id, void *data) { serialCommandsNotify(); }
+#endif
+
+static void registerReceiveWakeup() {
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+    Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, onUsbReceive);
+#elif ARDUINO_USB_CDC_ON_BOOT
+    Serial.onEvent(ARDUINO_USB_CDC_RX_EVENT, onUsbReceive);
+#else
+    serialCommandsWakeOnReceive(Serial);
+#endif
 }
 
 void _serialCmdsTaskLoop(void *pvParameters) {
     Serial.begin(115200);
+    registerReceiveWakeup();
+    serialCmdStats.reset();
     while (1) {
-        handleSerialCommands(serialCli);
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // Woken by received data and queued commands, the timeout covers BLE and line timeouts
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SERIAL_CMDS_IDLE_MS));
+        serialCmdsBusy = true;
+        if (!serialCmdsPaused) handleSerialCommands(serialCli);
+        serialCmdsBusy = false;
     }
 }
 
 void startSerialCommandsHandlerTask() {
-    cmdQueue = xQueueCreate(2, sizeof(CmdPacket));
-    rspQueue = xQueueCreate(2, sizeof(bool));
+    if (serialcmdsTaskHandle) return;
+    cmdQueue = xQueueCreate(SERIAL_CMD_QUEUE_DEPTH, sizeof(CmdPacket));
+    rspQueue = xQueueCreate(SERIAL_CMD_QUEUE_DEPTH, sizeof(CmdResponse));
 
     xTaskCreatePinnedToCore(
         _serialCmdsTaskLoop,         // Function to implement the task
@@ -3,9 +3,45 @@
 
 #include <Arduino.h>
 
+#define SERIAL_CMD_QUEUE_DEPTH 8
+#define SERIAL_CMD_RESPONSE_MS 2000 // longest wait of parseSerialCommand() for the result
+#define SERIAL_CMDS_IDLE_MS 100     // wake up period when no receive event arrives (BLE, timeouts)
+#define SERIAL_LINE_TIMEOUT_MS 1000 // a line without '\n' is run after this long, like readStringUntil
+
 extern TaskHandle_t serialcmdsTaskHandle;
 
+struct SerialCmdStats {
+    uint32_t commands = 0;
+    uint32_t rxBytes = 0;
+    uint32_t frames = 0;
+    uint32_t badFrames = 0;
+    uint32_t peakRate = 0; // commands within the busiest second
+    uint32_t since = 0;
+    uint32_t uploadBytes = 0; // last upload over serial
+    uint32_t uploadMs = 0;
+    uint32_t downloadBytes = 0; // last file read in blocks
+    uint32_t downloadMs = 0;
+
+    void command(void);
+    void upload(uint32_t bytes, uint32_t ms);
+    void download(uint32_t bytes, uint32_t ms);
+    void reset(void);
+
+private:
+    uint32_t _windowStart = 0;
+    uint32_t _windowCount = 0;
+};
+
+extern SerialCmdStats serialCmdStats;
+
 void startSerialCommandsHandlerTask();
 
 bool parseSerialCommand(const String &command, bool waitForResponse = true);
+
+// Wakes the serial commands task, safe from any task
+void serialCommandsNotify();
+// Wakes the serial commands task when `port` receives data, for ports selected after boot
+void serialCommandsWakeOnReceive(HardwareSerial &port);
+// Stops reading the serial port and running queued commands, returns once no command is running
+void pauseSerialCommands(bool pause);
 #endif
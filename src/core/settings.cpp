@@ -1543,7 +1543,9 @@ void setTheme() {
     if (fs == nullptr) return;
 
     String filepath = loopSD(*fs, true, "JSON");
-    if (bruceConfig.openThemeFile(fs, filepath, true)) {
+    bool opened = bruceConfig.openThemeFile(fs, filepath, true);
+    if (bruceConfig.themeFileError) displayError("5", true);
+    if (opened) {
         bruceConfig.themePath = filepath;
         if (fs == &LittleFS) bruceConfig.theme.fs = 1;
         else if (fs == &SD) bruceConfig.theme.fs = 2;
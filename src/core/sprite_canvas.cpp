@@ -0,0 +1,149 @@
+#include "sprite_canvas.h"
+#include <esp_heap_caps.h>
+
+RenderStats renderStats;
+SpriteCanvas optionsCanvas;
+SpriteCanvas menuTitleCanvas;
+SpriteCanvas menuArrowCanvas;
+
+static uint32_t canvasEpoch = 1;
+
+void invalidateCanvases() { canvasEpoch++; }
+
+void releaseMenuCanvases() {
+    optionsCanvas.end();
+    menuTitleCanvas.end();
+    menuArrowCanvas.end();
+}
+
+uint32_t canvasKey(const void *data, size_t len, uint32_t key) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) key = (key ^ p[i]) * 16777619u;
+    return key ? key : 1; // 0 is the key of an empty canvas
+}
+
+bool SpriteCanvas::begin(int16_t w, int16_t h) {
+#ifdef HAS_SCREEN
+    if (w <= 0 || h <= 0 || tft.getLogging()) {
+        end();
+        return false;
+    }
+    if (_active && _w == w && _h == h) return true;
+    end();
+
+    // TFT_eSprite goes to PSRAM when there is some and the panel is not using DMA
+    size_t bytes = w * h * sizeof(uint16_t);
+    bool room = psramFound() && !tft.DMA_Enabled && ESP.getMaxAllocPsram() > bytes;
+    if (!room) {
+        room = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) >
+               bytes + SPRITE_CANVAS_HEAP_RESERVE;
+    }
+    if (!room) return false;
+
+    _sprite.setColorDepth(16);
+    if (_sprite.createSprite(w, h) == nullptr) return false;
+    _w = w;
+    _h = h;
+    _count = 0;
+    _key = 0;
+    _epoch = canvasEpoch - 1; // nothing of it is on the screen yet
+    _active = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SpriteCanvas::end() {
+#ifdef HAS_SCREEN
+    if (_active) _sprite.deleteSprite();
+#endif
+    _active = false;
+    _count = 0;
+    _w = _h = 0;
+}
+
+bool SpriteCanvas::changed(uint32_t key) {
+    if (key == _key) return false;
+    _key = key;
+    return true;
+}
+
+bool SpriteCanvas::isStale() { return _epoch != canvasEpoch; }
+
+void SpriteCanvas::damage(int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (!_active) return;
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    w = min<int16_t>(w, _w - x);
+    h = min<int16_t>(h, _h - y);
+    if (w <= 0 || h <= 0) return;
+
+    Rect r = {x, y, w, h};
+    // Merge with every rectangle it overlaps or touches, each merge can reach new ones
+    for (uint8_t i = 0; i < _count;) {
+        Rect &o = _rects[i];
+        if (r.x <= o.x + o.w && o.x <= r.x + r.w && r.y <= o.y + o.h && o.y <= r.y + r.h) {
+            int16_t x2 = max(r.x + r.w, o.x + o.w);
+            int16_t y2 = max(r.y + r.h, o.y + o.h);
+            r.x = min(r.x, o.x);
+            r.y = min(r.y, o.y);
+            r.w = x2 - r.x;
+            r.h = y2 - r.y;
+            _rects[i] = _rects[--_count];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    if (_count == SPRITE_CANVAS_MAX_RECTS) {
+        // Too fragmented, push the bounding box
+        for (uint8_t i = 0; i < _count; i++) {
+            int16_t x2 = max(r.x + r.w, _rects[i].x + _rects[i].w);
+            int16_t y2 = max(r.y + r.h, _rects[i].y + _rects[i].h);
+            r.x = min(r.x, _rects[i].x);
+            r.y = min(r.y, _rects[i].y);
+            r.w = x2 - r.x;
+            r.h = y2 - r.y;
+        }
+        _count = 0;
+    }
+    _rects[_count++] = r;
+}
+
+uint32_t SpriteCanvas::flush(int32_t x, int32_t y) {
+    if (!_active) return 0;
+    if (isStale()) {
+        _count = 0;
+        damageAll();
+    }
+
+    uint32_t pixels = 0;
+#ifdef HAS_SCREEN
+    for (uint8_t i = 0; i < _count; i++) {
+        const Rect &r = _rects[i];
+        // full width rectangles are sent as a single window
+        _sprite.pushSprite(x + r.x, y + r.y, r.x, r.y, r.w, r.h);
+        pixels += r.w * r.h;
+    }
+#endif
+    _count = 0;
+    _epoch = canvasEpoch;
+    renderStats.add(pixels);
+    return pixels;
+}
+
+void RenderStats::endFrame(bool spriteCanvas) {
+    frames++;
+    if (spriteCanvas) buffered++;
+    lastPixels = pixels;
+    peakPixels = max(peakPixels, pixels);
+    totalPixels += pixels;
+    pixels = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef __SPRITE_CANVAS_H__
+#define __SPRITE_CANVAS_H__
+
+#include <globals.h>
+
+#define SPRITE_CANVAS_MAX_RECTS 6             // damaged rectangles kept before merging them all
+#define SPRITE_CANVAS_HEAP_RESERVE (48 * 1024) // internal heap left free after allocating a canvas
+
+/*
+ * Off-screen copy of a screen region. Drawing happens on sprite(), the caller
+ * marks what changed with damage() and flush() pushes only those rectangles.
+ * begin() fails when RAM is tight or when the WebUI is mirroring the screen
+ * (pushed sprites are not logged), the caller then draws directly on the tft.
+ */
+class SpriteCanvas {
+public:
+    bool begin(int16_t w, int16_t h);
+    void end(void);
+    bool isActive(void) { return _active; }
+#ifdef HAS_SCREEN
+    TFT_eSprite &sprite(void) { return _sprite; }
+#endif
+
+    // Returns true once per new key, used to skip redrawing unchanged content
+    bool changed(uint32_t key);
+    // The screen below was drawn over since the last flush (see invalidateCanvases)
+    bool isStale(void);
+
+    // Rectangles in sprite coordinates
+    void damage(int16_t x, int16_t y, int16_t w, int16_t h);
+    void damageAll(void) { damage(0, 0, _w, _h); }
+    // Pushes the damaged rectangles with the sprite placed at (x, y), returns pixels pushed
+    uint32_t flush(int32_t x, int32_t y);
+
+private:
+    struct Rect {
+        int16_t x, y, w, h;
+    };
+#ifdef HAS_SCREEN
+    TFT_eSprite _sprite = TFT_eSprite(&tft);
+#endif
+    Rect _rects[SPRITE_CANVAS_MAX_RECTS];
+    uint8_t _count = 0;
+    bool _active = false;
+    int16_t _w = 0;
+    int16_t _h = 0;
+    uint32_t _key = 0;
+    uint32_t _epoch = 0;
+};
+
+// Pixels written to the panel by the menu renderers, per frame
+struct RenderStats {
+    uint32_t frames = 0;
+    uint32_t buffered = 0; // frames drawn through a SpriteCanvas
+    uint32_t pixels = 0;   // frame being drawn
+    uint32_t lastPixels = 0;
+    uint32_t peakPixels = 0;
+    uint64_t totalPixels = 0;
+
+    void add(uint32_t n) { pixels += n; }
+    void endFrame(bool spriteCanvas);
+    void reset(void) { *this = RenderStats(); }
+};
+
+extern RenderStats renderStats;
+extern SpriteCanvas optionsCanvas;
+extern SpriteCanvas menuTitleCanvas;
+extern SpriteCanvas menuArrowCanvas;
+
+// FNV-1a, chain calls to build a key for SpriteCanvas::changed()
+uint32_t canvasKey(const void *data, size_t len, uint32_t key = 2166136261u);
+
+// Call after drawing over the screen directly, the next flush of every canvas pushes all of it
+void invalidateCanvases(void);
+// Frees the menu canvases before running an app
+void releaseMenuCanvases(void);
+
+#endif
@@ -0,0 +1,158 @@
+#include "text_file_index.h"
+#include <algorithm>
+
+bool TextFileIndex::begin(File &file) {
+    end();
+    if (!file || file.isDirectory()) return false;
+
+    _file = file;
+    _size = file.size();
+    _offsets.reserve(256);
+    _offsets.push_back(0);
+    _complete = _size == 0;
+    return true;
+}
+
+void TextFileIndex::end() {
+    _file = File();
+    _offsets.clear();
+    _offsets.shrink_to_fit();
+    _step = 1;
+    _size = 0;
+    _lines = 0;
+    _lineLen = 0;
+    _scanPos = 0;
+    _complete = true;
+}
+
+size_t TextFileIndex::readAt(uint32_t offset, uint8_t *buf, size_t len) {
+    if (!_file || offset >= _size) return 0;
+    if (!_file.seek(offset)) return 0;
+    return _file.read(buf, min(len, (size_t)(_size - offset)));
+}
+
+void TextFileIndex::lineEnded(uint32_t nextStart) {
+    _lines++;
+    _lineLen = 0;
+    if (nextStart >= _size || _lines % _step) return;
+
+    if (_offsets.size() == TEXT_INDEX_MAX_ENTRIES) {
+        // Full, keep every other offset and index half as densely from now on
+        for (size_t i = 0; i < _offsets.size() / 2; i++) _offsets[i] = _offsets[i * 2];
+        _offsets.resize(_offsets.size() / 2);
+        _step *= 2;
+        if (_lines % _step) return;
+    }
+    _offsets.push_back(nextStart);
+}
+
+bool TextFileIndex::indexStep() {
+    if (_complete) return false;
+
+    uint8_t buf[256];
+    uint32_t end = min(_scanPos + TEXT_INDEX_CHUNK, _size);
+    while (_scanPos < end) {
+        size_t len = readAt(_scanPos, buf, min(sizeof(buf), (size_t)(end - _scanPos)));
+        if (len == 0) {
+            _complete = true; // read error, keep what was indexed
+            return false;
+        }
+        for (size_t i = 0; i < len; i++) {
+            uint32_t pos = _scanPos + i;
+            if (buf[i] == '\n') {
+                lineEnded(pos + 1);
+            } else if (_lineLen == TEXT_INDEX_MAX_LINE) {
+                lineEnded(pos); // this byte starts the next piece of a long line
+                _lineLen = 1;
+            } else {
+                _lineLen++;
+            }
+        }
+        _scanPos += len;
+    }
+    _complete = _scanPos >= _size;
+    return !_complete;
+}
+
+uint32_t TextFileIndex::readLine(uint32_t offset, String &line) {
+    uint8_t buf[TEXT_INDEX_MAX_LINE + 2];
+    line = "";
+    size_t len = readAt(offset, buf, TEXT_INDEX_MAX_LINE + 1);
+    if (len == 0) return _size;
+
+    size_t n = 0;
+    while (n < len && buf[n] != '\n') n++;
+    uint32_t next = offset + (n < len ? n + 1 : min(n, (size_t)TEXT_INDEX_MAX_LINE));
+    n = min(n, (size_t)TEXT_INDEX_MAX_LINE);
+    if (n > 0 && buf[n - 1] == '\r') n--;
+    buf[n] = '\0';
+    line = (const char *)buf;
+    return next;
+}
+
+uint32_t TextFileIndex::nextLine(uint32_t offset) {
+    String line;
+    return readLine(offset, line);
+}
+
+uint32_t TextFileIndex::prevLine(uint32_t offset) {
+    if (offset == 0 || offset > _size) return 0;
+
+    uint8_t buf[TEXT_INDEX_MAX_LINE + 1];
+    uint8_t last = 0;
+    readAt(offset - 1, &last, 1);
+    if (last == '\n') {
+        // The previous line ends right here, its start is after the '\n' before it
+        uint32_t end = offset - 1;
+        uint32_t from = end > sizeof(buf) ? end - sizeof(buf) : 0;
+        size_t len = readAt(from, buf, end - from);
+        for (size_t i = len; i > 0; i--) {
+            if (buf[i - 1] == '\n') return from + i;
+        }
+        if (from == 0 && end <= TEXT_INDEX_MAX_LINE) return 0;
+    }
+
+    // Piece of a long line, walk from the closest indexed offset
+    if (offset <= _scanPos) {
+        auto it = std::upper_bound(_offsets.begin(), _offsets.end(), offset - 1);
+        uint32_t pos = *(it - 1);
+        while (true) {
+            uint32_t next = nextLine(pos);
+            if (next >= offset || next == pos) return pos;
+            pos = next;
+        }
+    }
+    return offset > TEXT_INDEX_MAX_LINE ? offset - TEXT_INDEX_MAX_LINE : 0;
+}
+
+uint32_t TextFileIndex::alignLine(uint32_t offset) {
+    if (offset == 0 || offset >= _size) return min(offset, _size);
+    uint8_t last = 0;
+    readAt(offset - 1, &last, 1);
+    if (last == '\n') return offset;
+    return nextLine(offset);
+}
+
+bool TextFileIndex::seekLine(uint32_t line, uint32_t &offset) {
+    while (!_complete && _lines <= line) indexStep();
+    if (line >= lines()) return false;
+
+    offset = _offsets[line / _step];
+    for (uint32_t i = line / _step * _step; i < line; i++) offset = nextLine(offset);
+    return true;
+}
+
+bool TextFileIndex::lineOf(uint32_t offset, uint32_t &line) {
+    if (offset > _scanPos && !_complete) return false;
+
+    auto it = std::upper_bound(_offsets.begin(), _offsets.end(), offset);
+    uint32_t pos = *(it - 1);
+    line = (it - 1 - _offsets.begin()) * _step;
+    while (pos < offset) {
+        uint32_t next = nextLine(pos);
+        if (next == pos) return false;
+        pos = next;
+        line++;
+    }
+    return pos == offset; // false when `offset` is not a line start
+}
@@ -0,0 +1,59 @@
+#ifndef __TEXT_FILE_INDEX_H__
+#define __TEXT_FILE_INDEX_H__
+
+#include <FS.h>
+#include <vector>
+
+#define TEXT_INDEX_MAX_ENTRIES 2048 // offsets kept, the step between them doubles when full
+#define TEXT_INDEX_MAX_LINE 512     // longer lines are split, keeps every read bounded
+#define TEXT_INDEX_CHUNK 2048       // bytes scanned by each indexStep()
+
+/*
+ * Sparse line index of a text file. Only the start offset of every `step`
+ * lines is kept, so memory stays below TEXT_INDEX_MAX_ENTRIES offsets whatever
+ * the size of the file. The file is scanned a chunk at a time by indexStep(),
+ * lines are read on demand from their offset.
+ *
+ * A line ends after '\n' or after TEXT_INDEX_MAX_LINE bytes without one.
+ */
+class TextFileIndex {
+public:
+    bool begin(File &file);
+    void end(void);
+
+    // Scans the next chunk, returns false once the whole file is indexed
+    bool indexStep(void);
+    bool complete(void) { return _complete; }
+
+    uint32_t size(void) { return _size; }
+    // Lines found so far, the total once complete()
+    uint32_t lines(void) { return _lines + (_complete && _lineLen > 0 ? 1 : 0); }
+    uint32_t indexedBytes(void) { return _scanPos; }
+
+    // Reads the line starting at `offset` without its line ending, returns the next line offset
+    uint32_t readLine(uint32_t offset, String &line);
+    uint32_t nextLine(uint32_t offset);
+    uint32_t prevLine(uint32_t offset);
+    // First line starting at or after `offset`, used to land on a line when jumping by position
+    uint32_t alignLine(uint32_t offset);
+
+    // Offset of line `line`, indexes ahead synchronously if needed
+    bool seekLine(uint32_t line, uint32_t &offset);
+    // Line number of the line at `offset`, false if that part is not indexed yet
+    bool lineOf(uint32_t offset, uint32_t &line);
+
+private:
+    File _file;
+    std::vector<uint32_t> _offsets; // _offsets[k] = start of line k * _step
+    uint32_t _step = 1;
+    uint32_t _size = 0;
+    uint32_t _lines = 0;    // complete lines scanned
+    uint32_t _lineLen = 0;  // bytes of the line being scanned
+    uint32_t _scanPos = 0;
+    bool _complete = true;
+
+    size_t readAt(uint32_t offset, uint8_t *buf, size_t len);
+    void lineEnded(uint32_t nextStart);
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include <stdlib.h>
+#include <string.h>
+#include <tftLogStore.h>
+
+#define LOG_IMAGE_BASE 12 // AA SS FN XX XX YY YY Ce Ce Ms Ms FS, then SLOT and the path
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (0x7F + LZ_MIN_MATCH)
+#define LZ_HASH_BITS 10
+
+uint32_t TftLogStore::bump() {
+    // cursors keep 24 bits of seq, a new session makes the ones from before the wrap unknown
+    if ((++seq & 0xFFFFFF) == 0) session = session % 255 + 1;
+    return seq;
+}
+
+void TftLogStore::clear() {
+    memset(log, 0, sizeof(log));
+    memset(images, 0, sizeof(images));
+    logWriteIndex = 0;
+    logCount = 0;
+    bump();
+    for (int i = 0; i < MAX_LOG_ENTRIES; i++) slotSeq[i] = seq;
+    for (int i = 0; i < MAX_LOG_IMAGES; i++) imageSeq[i] = seq;
+}
+
+bool TftLogStore::push(const tftLog &l) {
+    uint8_t size = l.data[1];
+    for (int i = 0; i < logCount; i++) {
+        if (log[i].data[1] == size && memcmp(log[i].data, l.data, size) == 0) {
+            return false; // Entry already exists
+        }
+    }
+    memcpy(log[logWriteIndex].data, l.data, size);
+    slotSeq[logWriteIndex] = bump();
+    logWriteIndex = (logWriteIndex + 1) % MAX_LOG_ENTRIES;
+    if (logCount < MAX_LOG_ENTRIES) ++logCount;
+    return true;
+}
+
+bool TftLogStore::removeInsideRect(int rx, int ry, int rw, int rh) {
+    bool r = false;
+    int rx1 = rx;
+    int ry1 = ry;
+    int rx2 = rx + rw;
+    int ry2 = ry + rh;
+
+    for (int i = 0; i < logCount; i++) {
+        uint8_t *data = log[i].data;
+        if (data[0] != LOG_PACKET_HEADER) continue;
+        int px = (data[3] << 8) | data[4];
+        int py = (data[5] << 8) | data[6];
+        if (px >= rx1 && px < rx2 && py >= ry1 && py < ry2) {
+            data[0] = 0; // Mark as deleted
+            if (!r) bump();
+            slotSeq[i] = seq;
+            r = true;
+        }
+    }
+    return r;
+}
+
+void TftLogStore::removeImages(int x, int y, int center, int ms) {
+    bool removed = false;
+    for (int i = 0; i < logCount; i++) {
+        uint8_t *data = log[i].data;
+        if (data[0] != LOG_PACKET_HEADER) continue;
+        uint8_t fn = data[2];
+        if (fn != DRAWIMAGE) continue;
+        int px = (data[3] << 8) | data[4];
+        int py = (data[5] << 8) | data[6];
+        int pcenter = (data[7] << 8) | data[8];
+        int pms = (data[9] << 8) | data[10];
+        if (px == x && py == y && pcenter == center && pms == ms) {
+            data[0] = 0; // Mark as deleted
+            if (!removed) bump();
+            slotSeq[i] = seq;
+            removed = true;
+        }
+    }
+}
+
+uint8_t TftLogStore::imageSlot(const char *path) {
+    for (int i = 0; i < MAX_LOG_IMAGES; ++i) {
+        if (strcmp(images[i], path) == 0) return i;
+    }
+    for (int i = 0; i < MAX_LOG_IMAGES; ++i) {
+        if (images[i][0] == 0) {
+            strncpy(images[i], path, sizeof(images[i]) - 1);
+            images[i][sizeof(images[i]) - 1] = 0;
+            imageSeq[i] = bump();
+            return i;
+        }
+    }
+    return 0xFF;
+}
+
+void TftLogStore::snapshot(const uint8_t *info, uint8_t infoSize, uint8_t *out, size_t &outSize) {
+    memcpy(out, info, infoSize);
+    outSize = infoSize;
+
+    for (int i = 0; i < logCount; i++) {
+        if (log[i].data[0] != LOG_PACKET_HEADER) continue;
+        uint8_t *entry = log[i].data;
+        uint8_t fn = entry[2];
+
+        if (fn == DRAWIMAGE) {
+            const char *imgPath = images[entry[LOG_IMAGE_BASE]];
+            size_t imgLen = strlen(imgPath);
+            if (outSize + LOG_IMAGE_BASE + imgLen > MAX_LOG_SIZE * MAX_LOG_ENTRIES) continue;
+
+            memcpy(out + outSize, entry, LOG_IMAGE_BASE);
+            outSize += LOG_IMAGE_BASE;
+            memcpy(out + outSize, imgPath, imgLen);
+            outSize += imgLen;
+
+            out[outSize - imgLen - LOG_IMAGE_BASE + 1] = LOG_IMAGE_BASE + imgLen; // update packet size
+        } else {
+            uint8_t size = entry[1];
+            if (outSize + size > MAX_LOG_SIZE * MAX_LOG_ENTRIES) continue;
+            memcpy(out + outSize, entry, size);
+            outSize += size;
+        }
+    }
+}
+
+static void writeUint32(uint8_t *out, size_t &pos, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out[pos++] = value >> shift;
+}
+
+uint32_t
+TftLogStore::delta(uint32_t since, const uint8_t *info, uint8_t infoSize, uint8_t *out, size_t &outSize) {
+    // one reading for the header and the return value, changes stamped during the scan
+    // are newer than the cursor handed out and come again with the next delta
+    const uint32_t snap = seq;
+    const uint8_t snapSession = session;
+    uint32_t from = 0;
+    if (since >> 24 == snapSession && (since & 0xFFFFFF) <= (snap & 0xFFFFFF)) {
+        from = (snap & ~0xFFFFFFu) | (since & 0xFFFFFF);
+    }
+    const uint32_t cursor = cursorOf(snap, snapSession);
+    memcpy(out, info, infoSize);
+    outSize = infoSize;
+
+    uint8_t *header = out + outSize;
+    memset(header, 0, LOG_DELTA_SIZE);
+    header[0] = LOG_PACKET_HEADER;
+    header[1] = LOG_DELTA_SIZE;
+    header[2] = LOG_DELTA;
+    size_t pos = 3;
+    writeUint32(header, pos, cursor);
+    writeUint32(header, pos, from ? since : 0);
+    uint8_t *set = header + pos;
+    uint8_t *cleared = set + MAX_LOG_ENTRIES / 8;
+    outSize += LOG_DELTA_SIZE;
+
+    for (int i = 0; i < MAX_LOG_IMAGES; i++) {
+        if (imageSeq[i] <= from || images[i][0] == 0) continue;
+        size_t len = strnlen(images[i], 255 - 4);
+        out[outSize++] = LOG_PACKET_HEADER;
+        out[outSize++] = 4 + len;
+        out[outSize++] = LOG_IMAGE;
+        out[outSize++] = i;
+        memcpy(out + outSize, images[i], len);
+        outSize += len;
+    }
+
+    for (int i = 0; i < MAX_LOG_ENTRIES; i++) {
+        if (slotSeq[i] <= from) continue;
+        const uint8_t *entry = log[i].data;
+        if (entry[0] != LOG_PACKET_HEADER) {
+            cleared[i / 8] |= 0x80 >> (i % 8);
+            continue;
+        }
+        set[i / 8] |= 0x80 >> (i % 8);
+        uint8_t size = entry[2] == DRAWIMAGE ? LOG_IMAGE_BASE + 1 : entry[1];
+        memcpy(out + outSize, entry, size);
+        out[outSize + 1] = size;
+        outSize += size;
+    }
+    return cursor;
+}
+
+static uint16_t lzHash(const uint8_t *p) {
+    return ((p[0] << 8 | p[1]) * 33 + p[2]) & ((1 << LZ_HASH_BITS) - 1);
+}
+
+static void lzLiterals(const uint8_t *in, size_t start, size_t end, uint8_t *out, size_t &o) {
+    while (start < end) {
+        size_t n = end - start > 128 ? 128 : end - start;
+        out[o++] = n - 1;
+        memcpy(out + o, in + start, n);
+        o += n;
+        start += n;
+    }
+}
+
+size_t tftLogCompress(const uint8_t *in, size_t n, uint8_t *out) {
+    if (n > UINT16_MAX) return 0;
+    uint16_t *table = (uint16_t *)malloc(sizeof(uint16_t) << LZ_HASH_BITS);
+    if (table == nullptr) return 0;
+    // position + 1 of the last place each hash was seen, 0 for none
+    memset(table, 0, sizeof(uint16_t) << LZ_HASH_BITS);
+
+    size_t o = 0, literal = 0, i = 0;
+    while (i + LZ_MIN_MATCH <= n) {
+        uint16_t h = lzHash(in + i);
+        size_t candidate = table[h];
+        table[h] = i + 1;
+        size_t len = 0;
+        if (candidate > 0) {
+            const uint8_t *m = in + candidate - 1;
+            while (i + len < n && len < LZ_MAX_MATCH && m[len] == in[i + len]) len++;
+        }
+        if (len < LZ_MIN_MATCH) {
+            i++;
+            continue;
+        }
+        lzLiterals(in, literal, i, out, o);
+        uint16_t distance = i - (candidate - 1);
+        out[o++] = 0x80 | (len - LZ_MIN_MATCH);
+        out[o++] = distance & 0xFF;
+        out[o++] = distance >> 8;
+        i += len;
+        literal = i;
+    }
+    lzLiterals(in, literal, n, out, o);
+    free(table);
+    return o;
+}
+
+size_t tftLogExpand(const uint8_t *in, size_t n, uint8_t *out, size_t outSize) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        uint8_t token = in[i++];
+        if (token < 0x80) {
+            size_t len = token + 1;
+            if (i + len > n || o + len > outSize) return 0;
+            memcpy(out + o, in + i, len);
+            i += len;
+            o += len;
+            continue;
+        }
+        if (i + 2 > n) return 0;
+        size_t len = (token & 0x7F) + LZ_MIN_MATCH;
+        size_t distance = in[i] | in[i + 1] << 8;
+        i += 2;
+        if (distance == 0 || distance > o || o + len > outSize) return 0;
+        // overlapping copies repeat the last bytes, byte by byte on purpose
+        for (size_t k = 0; k < len; k++, o++) out[o] = out[o - distance];
+    }
+    return o;
+}
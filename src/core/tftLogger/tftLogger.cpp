@@ -6,21 +6,10 @@ AUXILIARY FUNCTIONS TO CREATE THE JSONS
 */
 
 /* TFT LOGGER FUNCTIONS */
-tft_logger::tft_logger(int16_t w, int16_t h) : BRUCE_TFT_DRIVER(w, h) {}
+tft_logger::tft_logger(int16_t w, int16_t h) : BRUCE_TFT_DRIVER(w, h) { store.setSession(esp_random()); }
 tft_logger::~tft_logger() { clearLog(); }
 
-void tft_logger::clearLog() {
-    memset(log, 0, sizeof(log));
-    memset(images, 0, sizeof(images));
-    logWriteIndex = 0;
-    logCount = 0;
-}
-
-void tft_logger::addLogEntry(const uint8_t *buffer, uint8_t size) {
-    memcpy(log[logWriteIndex].data, buffer, size);
-    logWriteIndex = (logWriteIndex + 1) % MAX_LOG_ENTRIES;
-    if (logCount < MAX_LOG_ENTRIES) ++logCount;
-}
+void tft_logger::clearLog() { store.clear(); }
 
 void tft_logger::logWriteHeader(uint8_t *buffer, uint8_t &pos, tftFuncs fn) {
     buffer[pos++] = LOG_PACKET_HEADER;
@@ -35,9 +24,7 @@ void tft_logger::writeUint16(uint8_t *buffer, uint8_t &pos, uint16_t value) {
 
 void tft_logger::setLogging(bool _log) {
     logging = _logging = _log;
-    logWriteIndex = 0;
-    memset(log, 0, sizeof(log));
-    logCount = 0;
+    store.clear();
 };
 void tft_logger::asyncSerialTaskFunc(void *pv) {
     tft_logger *logger = static_cast<tft_logger *>(pv);
@@ -48,7 +35,7 @@ void tft_logger::asyncSerialTaskFunc(void *pv) {
             uint8_t fn = entry[2];
             if (fn == DRAWIMAGE) {
                 uint8_t imageSlot = entry[12];
-                const char *imgPath = logger->images[imageSlot];
+                const char *imgPath = logger->store.image(imageSlot);
                 size_t baseLen = 12; // AA SS FN XX XX YY YY Ce Ce Ms Ms FS
                 size_t imgLen = strlen(imgPath);
                 uint8_t packet[MAX_LOG_SIZE];
@@ -86,117 +73,48 @@ void tft_logger::stopAsyncSerial() {
     setLogging(false);
     // task will exit on its own and clear handle
 }
-void tft_logger::getTftInfo() {
-    uint8_t buffer[16];
+uint8_t tft_logger::screenInfo(uint8_t *buffer) {
     uint8_t pos = 0;
     logWriteHeader(buffer, pos, SCREEN_INFO);
     writeUint16(buffer, pos, width());
     writeUint16(buffer, pos, height());
     buffer[pos++] = rotation;
     buffer[1] = pos;
+    return pos;
+}
+
+void tft_logger::getTftInfo() {
     tftLog l;
-    memcpy(l.data, buffer, pos);
+    screenInfo(l.data);
     pushLogIfUnique(l);
 }
+
 void tft_logger::getBinLog(uint8_t *outBuffer, size_t &outSize) {
-    outSize = 0;
     // add Screen Info at the beginning of the Bin packet
-    uint8_t buffer[16];
-    uint8_t pos = 0;
-    logWriteHeader(buffer, pos, SCREEN_INFO);
-    writeUint16(buffer, pos, width());
-    writeUint16(buffer, pos, height());
-    buffer[pos++] = rotation;
-    buffer[1] = pos;
+    uint8_t info[16];
+    store.snapshot(info, screenInfo(info), outBuffer, outSize);
+}
 
-    memcpy(outBuffer + outSize, buffer, pos);
-    outSize += pos;
-
-    for (int i = 0; i < logCount; i++) {
-        if (log[i].data[0] != LOG_PACKET_HEADER) continue;
-        uint8_t *entry = log[i].data;
-        uint8_t fn = entry[2];
-
-        if (fn == DRAWIMAGE) {
-            uint8_t imageSlot = entry[12]; // AA SS FN XX XX YY YY Ce Ce Ms Ms FS SLOT
-                                           // 0  1  2  3  4  5  6  7  8  9  10 11 12
-            const char *imgPath = images[imageSlot];
-            size_t baseLen = 12; // AA SS FN XX XX YY YY Ce Ce Ms Ms FS + PATH
-            size_t imgLen = strlen(imgPath);
-            if (outSize + baseLen + imgLen > MAX_LOG_SIZE * MAX_LOG_ENTRIES) continue;
-
-            memcpy(outBuffer + outSize, entry, baseLen);
-            outSize += baseLen;
-            memcpy(outBuffer + outSize, imgPath, imgLen);
-            outSize += imgLen;
-
-            outBuffer[outSize - imgLen - baseLen + 1] = baseLen + imgLen; // update packet size
-        } else {
-            uint8_t size = entry[1];
-            if (outSize + size > MAX_LOG_SIZE * MAX_LOG_ENTRIES) continue;
-            memcpy(outBuffer + outSize, entry, size);
-            outSize += size;
-        }
-    }
+uint32_t tft_logger::getBinLogSince(uint32_t since, uint8_t *outBuffer, size_t &outSize) {
+    uint8_t info[16];
+    return store.delta(since, info, screenInfo(info), outBuffer, outSize);
 }
 
 void tft_logger::restoreLogger() {
     if (_logging) logging = true;
 }
 
-bool tft_logger::isLogEqual(const tftLog &a, const tftLog &b) {
-    uint8_t sizeA = a.data[1];
-    uint8_t sizeB = b.data[1];
-    if (sizeA != sizeB) return false;
-    return memcmp(a.data, b.data, sizeA) == 0;
-}
-
 void tft_logger::pushLogIfUnique(const tftLog &l) {
-    for (int i = 0; i < logCount; i++) {
-        if (isLogEqual(log[i], l)) {
-            return; // Entry already exists
-        }
-    }
-    memcpy(log[logWriteIndex].data, l.data, l.data[1]);
-    logWriteIndex = (logWriteIndex + 1) % MAX_LOG_ENTRIES;
-    if (logCount < MAX_LOG_ENTRIES) ++logCount;
+    if (!store.push(l)) return; // Entry already exists
     if (async_serial && asyncSerialQueue) { xQueueSend(asyncSerialQueue, &l, 0); }
 }
 
 bool tft_logger::removeLogEntriesInsideRect(int rx, int ry, int rw, int rh) {
-    bool r = false;
-    int rx1 = rx;
-    int ry1 = ry;
-    int rx2 = rx + rw;
-    int ry2 = ry + rh;
-
-    for (int i = 0; i < logCount; i++) {
-        uint8_t *data = log[i].data;
-        if (data[0] != LOG_PACKET_HEADER) continue;
-        int px = (data[3] << 8) | data[4];
-        int py = (data[5] << 8) | data[6];
-        if (px >= rx1 && px < rx2 && py >= ry1 && py < ry2) {
-            data[0] = 0; // Mark as deleted
-            r = true;
-        }
-    }
-    return r;
+    return store.removeInsideRect(rx, ry, rw, rh);
 }
 
 void tft_logger::removeOverlappedImages(int x, int y, int center, int ms) {
-    for (int i = 0; i < logCount; i++) {
-        uint8_t *data = log[i].data;
-        if (data[0] != LOG_PACKET_HEADER) continue;
-        uint8_t fn = data[2];
-        if (fn != DRAWIMAGE) continue;
-        int px = (data[3] << 8) | data[4];
-        int py = (data[5] << 8) | data[6];
-        int pcenter = (data[7] << 8) | data[8];
-        int pms = (data[9] << 8) | data[10];
-        if (px == x && py == y && pcenter == center && pms == ms) {
-            data[0] = 0; // Mark as deleted
-        }
-    }
+    store.removeImages(x, y, center, ms);
 }
 
 void tft_logger::fillScreen(int32_t color) {
@@ -213,24 +131,8 @@ void tft_logger::imageToBin(uint8_t fs, String file, int x, int y, bool center,
 
     removeOverlappedImages(x, y, center, Ms);
 
-    // Try to find or store in images[MAX_LOG_IMAGES][MAX_LOG_IMG_PATH];
-    uint8_t imageSlot = 0xFF;
-    for (int i = 0; i < MAX_LOG_IMAGES; ++i) {
-        if (strcmp(images[i], file.c_str()) == 0) {
-            imageSlot = i;
-            break;
-        }
-    }
-    if (imageSlot == 0xFF) {
-        for (int i = 0; i < MAX_LOG_IMAGES; ++i) {
-            if (images[i][0] == 0) {
-                strncpy(images[i], file.c_str(), sizeof(images[i]) - 1);
-                images[i][sizeof(images[i]) - 1] = 0;
-                imageSlot = i;
-                break;
-            }
-        }
-    }
+    // Try to find or store in the image path table
+    uint8_t imageSlot = store.imageSlot(file.c_str());
 
     // Use image path as identifier in log.data
     uint8_t buffer[MAX_LOG_SIZE];
@@ -245,10 +147,11 @@ void tft_logger::imageToBin(uint8_t fs, String file, int x, int y, bool center,
     buffer[pos++] = imageSlot;
 
     // Store the file path string in the remainder of the buffer
-    size_t fileLen = strlen(images[imageSlot]);
+    const char *path = store.image(imageSlot);
+    size_t fileLen = strlen(path);
     size_t maxLen = MAX_LOG_SIZE - pos;
     if (fileLen > maxLen) fileLen = maxLen;
-    memcpy(buffer + pos, images[imageSlot], fileLen);
+    memcpy(buffer + pos, path, fileLen);
     pos += fileLen;
 
     buffer[1] = pos; // update size
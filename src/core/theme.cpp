@@ -1,6 +1,7 @@
 #include "theme.h"
 #include "core/led_control.h"
 #include "display.h"
+#include "image_cache.h"
 
 struct ThemeEntry {
     const char *key;
@@ -11,6 +12,7 @@ struct ThemeEntry {
 void BruceTheme::removeTheme(void) {
     themeInfo t;
     theme = t;
+    imageCache.clear();
 }
 FS *BruceTheme::themeFS(void) {
     if (theme.fs == 1) return &LittleFS;
@@ -19,7 +21,9 @@ FS *BruceTheme::themeFS(void) {
 }
 bool BruceTheme::openThemeFile(FS *fs, String filepath, bool overwriteConfigSettings) {
 
+    themeFileError = false;
     if (fs == nullptr) return true;
+    imageCache.clear(); // images of the previous theme
     if (!fs->exists(filepath)) return false;
     File file;
     file = fs->open(filepath, FILE_READ);
@@ -32,7 +36,7 @@ bool BruceTheme::openThemeFile(FS *fs, String filepath, bool overwriteConfigSett
     // Deserialize the JSON document
     JsonDocument jsonDoc;
     if (deserializeJson(jsonDoc, file)) {
-        displayError("5", true);
+        themeFileError = true;
         log_e("THEME: %s. Using default theme", "Failed reading theme file");
         removeTheme();
         return false;
@@ -66,6 +66,8 @@ public:
     uint16_t priColor = DEFAULT_PRICOLOR;
     uint16_t secColor = DEFAULT_PRICOLOR - 0x2000;
     uint16_t bgColor = 0x0000;
+    // The last openThemeFile() could not parse its file, for the caller to show: it may run off the UI task
+    bool themeFileError = false;
 
     // UI Color
     void _setUiColor(uint16_t primary, uint16_t *secondary = nullptr, uint16_t *background = nullptr);
@@ -2,11 +2,16 @@
 #include "core/display.h"    // using displayRedStripe as error msg
 #include "core/mykeyboard.h" // using keyboard when calling rename
 #include "core/passwords.h"
+#include "core/perf_monitor.h"
 #include "core/sd_functions.h" // using sd functions called to rename and manage sd files
 #include "core/serialcmds.h"
 #include "core/settings.h"
 #include "core/utils.h"
+#include "core/wifi/web_assets.h"
+#include "core/wifi/web_editor.h"
+#include "core/wifi/web_listing.h"
 #include "core/wifi/wifi_common.h" // using common wifisetup
+#include "modules/NRF24/nrf_spectrum.h"
 #include "core/firmware_update.h"
 #include "esp_task_wdt.h"
 #include "webFiles.h"
@@ -14,14 +19,6 @@
 #include <esp_heap_caps.h>
 #include <globals.h>
 
-#if defined(CONFIG_IDF_TARGET_ESP32) && !defined(BOARD_HAS_PSRAM)
-#define MOUNT_SD_CARD setupSdCard()
-#define UNMOUNT_SD_CARD closeSdCard()
-#else
-#define MOUNT_SD_CARD
-#define UNMOUNT_SD_CARD
-#endif
-
 File uploadFile;
 FS _webFS = LittleFS;
 // WiFi as a Client
@@ -96,48 +93,30 @@ String humanReadableSize(uint64_t bytes) {
 }
 
 /**********************************************************************
-**  Function: listFiles
-**  list all of the files, if ishtml=true, return html rather than simple text
+**  Function: sendListing
+**  streams the listing of a folder, see web_listing.h for the format
 **********************************************************************/
-String listFiles(FS fs, String folder) {
-    // log_i("Listfiles Start");
-    String returnText = "pa:" + folder + ":0\n";
-    MOUNT_SD_CARD;
-    // Serial.println("Listing files stored on SD");
-
-    _webFS = fs;
-
-    File root = fs.open(folder);
+static void sendListing(AsyncWebServerRequest *request, const WebListingQuery &query) {
+    String folder = "/";
+    if (request->hasArg("folder")) { folder = request->arg("folder"); }
+    FS *fs = &LittleFS;
+    if (strcmp(request->arg("fs").c_str(), "SD") == 0) {
+        MOUNT_SD_CARD;
+        request->onDisconnect([]() { UNMOUNT_SD_CARD; }); // the listing is read while it is sent
+        fs = &SD;
+    }
+    // uploads go to the folder being browsed
+    _webFS = *fs;
     uploadFolder = folder;
+    request->send(beginListingResponse(request, *fs, folder, query));
+}
 
-    while (true) {
-        bool isDir;
-        String fullPath = root.getNextFileName(&isDir);
-        String nameOnly = fullPath.substring(fullPath.lastIndexOf("/") + 1);
-        if (fullPath == "") { break; }
-        // Serial.printf("Path: %s (isDir: %d)\n", fullPath.c_str(), isDir);
-
-        if (esp_get_free_heap_size() > (String("Fo:" + nameOnly + ":0\n").length()) + 1024) {
-            if (isDir) {
-                // Serial.printf("Directory: %s\n", fullPath.c_str());
-                returnText += "Fo:" + nameOnly + ":0\n";
-            } else {
-                // For files, we need to get the size, so we open the file briefly
-                // Serial.printf("Opening file for size check: %s\n", fullPath.c_str());
-                File file = fs.open(fullPath);
-                // Serial.printf("File size: %llu bytes\n", file.size());
-                if (file) {
-                    returnText += "Fi:" + nameOnly + ":" + humanReadableSize(file.size()) + "\n";
-                    file.close();
-                }
-            }
-        } else break;
-        esp_task_wdt_reset();
-    }
-    root.close();
-    UNMOUNT_SD_CARD;
-    // log_i("ListFiles End");
-    return returnText;
+// Storage named by the fs argument of the editor endpoints, SD stays mounted until the request is done
+static FS &editorFS(AsyncWebServerRequest *request) {
+    if (request->arg("fs") != "SD") return LittleFS;
+    MOUNT_SD_CARD;
+    request->onDisconnect([]() { UNMOUNT_SD_CARD; });
+    return SD;
 }
 
 /**********************************************************************
@@ -241,6 +220,7 @@ void handleUpload(
             // close the file handle as the upload is now done
             if (request->_tempFile) request->_tempFile.close();
             UNMOUNT_SD_CARD;
+            webAssetsInvalidate(); // in case it replaced a WebUI override
         }
     }
 }
@@ -308,7 +288,7 @@ String color565ToWebHex(uint16_t color565) {
 
 /**********************************************************************
 **  Function: serveWebUIFile
-**  serves files for WebUI and checks for custom WebUI files
+**  serves files for WebUI, overrides and caching are handled in web_assets
 **********************************************************************/
 void serveWebUIFile(AsyncWebServerRequest *request, String filename, const char *contentType) {
     serveWebUIFile(request, filename, contentType, false, nullptr, 0);
@@ -317,33 +297,7 @@ void serveWebUIFile(
     AsyncWebServerRequest *request, String filename, const char *contentType, bool gzip,
     const uint8_t *originaFile, uint32_t originalFileSize
 ) {
-    AsyncWebServerResponse *response = nullptr;
-    FS *fs = NULL;
-    if (setupSdCard()) {
-        if (SD.exists("/BruceWebUI/" + filename)) fs = &SD;
-        UNMOUNT_SD_CARD;
-
-    } else if (LittleFS.exists("/BruceWebUI/" + filename)) {
-        fs = &LittleFS;
-    }
-    if (fs) {
-        response = request->beginResponse(*fs, "/BruceWebUI/" + filename, contentType);
-        UNMOUNT_SD_CARD;
-    } else {
-        if (filename == "theme.css") {
-            String css = ":root{--color:" + color565ToWebHex(bruceConfig.priColor) +
-                         ";--sec-color:" + color565ToWebHex(bruceConfig.secColor) +
-                         ";--background:" + color565ToWebHex(bruceConfig.bgColor) + ";}";
-            AsyncWebServerResponse *themeResponse = request->beginResponse(200, "text/css", css);
-            request->send(themeResponse);
-            return;
-        }
-        response = request->beginResponse(200, String(contentType), originaFile, originalFileSize);
-        if (gzip) {
-            if (!response->addHeader("Content-Encoding", "gzip")) Serial.println("Failed to add gzip header");
-        }
-    }
-    request->send(response);
+    serveWebAsset(request, filename, contentType, gzip, originaFile, originalFileSize);
 }
 
 /**********************************************************************
@@ -473,14 +427,76 @@ void configureWebServer() {
         }
     });
 
-    // Get Screen
-    server->on("/getscreen", HTTP_GET, [](AsyncWebServerRequest *request) {
+    // Task, heap and stack samples, ?history=0 leaves the history ring out
+    server->on("/perf", HTTP_GET, [](AsyncWebServerRequest *request) {
         if (checkUserWebAuth(request)) {
+            bool history = !request->hasArg("history") || request->arg("history") != "0";
+            request->send(200, "application/json", perfMonitor.toJson(history));
+        }
+    });
+
+    // Get Screen, ?since=<cursor> answers with the changes since an earlier LOG_DELTA, lz=1 compresses them
+    server->on("/getscreen", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!checkUserWebAuth(request)) return;
+        if (!request->hasArg("since")) {
             uint8_t binData[MAX_LOG_ENTRIES * MAX_LOG_SIZE];
             size_t binSize = 0;
 
             tft.getBinLog(binData, binSize);
             request->send(200, "application/octet-stream", (const uint8_t *)binData, binSize);
+            return;
+        }
+
+        bool lz = request->hasArg("lz") && request->arg("lz") == "1";
+        size_t deltaSize = MAX_LOG_DELTA_SIZE;
+        uint8_t *delta = (uint8_t *)malloc(deltaSize + (lz ? deltaSize + deltaSize / 128 + 1 : 0));
+        if (delta == nullptr) {
+            request->send(503, "text/plain", "Out of memory");
+            return;
+        }
+        uint32_t seq = tft.getBinLogSince(strtoul(request->arg("since").c_str(), NULL, 10), delta, deltaSize);
+        const uint8_t *body = delta;
+        if (lz) {
+            uint8_t *packed = delta + MAX_LOG_DELTA_SIZE;
+            size_t packedSize = tftLogCompress(delta, deltaSize, packed);
+            if (packedSize == 0) lz = false;
+            else {
+                body = packed;
+                deltaSize = packedSize;
+            }
+        }
+        // the stream keeps its own copy, the buffers can go before it is sent
+        AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+        response->write(body, deltaSize);
+        free(delta);
+        response->addHeader("X-Log-Seq", String(seq));
+        response->addHeader("X-Log-Encoding", lz ? "lz" : "none");
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    });
+
+    // NRF24 spectrum, latest sweep as binary NrfSpectrumFrames (level, peak and average unless ?kind=)
+    server->on("/nrfspectrum", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (checkUserWebAuth(request)) {
+            String kind = request->hasArg("kind") ? request->arg("kind") : "all";
+            NrfSpectrumFrame frame;
+            if (!nrf_spectrum_frame(NRF_SPECTRUM_LEVEL, frame)) {
+                request->send(503, "text/plain", "Spectrum not running");
+                return;
+            }
+            AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+            if (kind == "all" || kind == "level") response->write((const uint8_t *)&frame, sizeof(frame));
+            if (kind == "all" || kind == "peak") {
+                nrf_spectrum_frame(NRF_SPECTRUM_PEAK, frame);
+                response->write((const uint8_t *)&frame, sizeof(frame));
+            }
+            if (kind == "all" || kind == "avg") {
+                nrf_spectrum_frame(NRF_SPECTRUM_AVERAGE, frame);
+                response->write((const uint8_t *)&frame, sizeof(frame));
+            }
+            response->addHeader("Cache-Control", "no-store");
+            response->addHeader("X-Millis", String(millis())); // to tell how old the sweep is
+            request->send(response);
         }
     });
 
@@ -492,6 +508,7 @@ void configureWebServer() {
                 String fileName = request->arg("fileName").c_str();
                 String filePath = request->arg("filePath").c_str();
                 String filePath2 = filePath.substring(0, filePath.lastIndexOf('/') + 1) + fileName;
+                webAssetsInvalidate();
                 // Rename the file of folder
                 if (fs == "SD") {
                     MOUNT_SD_CARD;
@@ -587,17 +604,12 @@ void configureWebServer() {
 
     // List files
     server->on("/listfiles", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (checkUserWebAuth(request)) {
-            String folder = "/";
-            if (request->hasArg("folder")) { folder = request->arg("folder"); }
-            if (strcmp(request->arg("fs").c_str(), "SD") == 0) {
-                MOUNT_SD_CARD;
-                request->send(200, "text/plain", listFiles(SD, folder));
-                UNMOUNT_SD_CARD;
-            } else {
-                request->send(200, "text/plain", listFiles(LittleFS, folder));
-            }
-        }
+        if (checkUserWebAuth(request)) sendListing(request, WebListingQuery()); // whole folder, unsorted
+    });
+
+    // Folder listing by pages: sort=name|size, limit=<entries>, cursor=<"nx" line of the previous page>
+    server->on("/listpage", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (checkUserWebAuth(request)) sendListing(request, listingQueryFromRequest(request));
     });
 
     // Download, create folder and delete
@@ -646,6 +658,7 @@ void configureWebServer() {
                         if (extension == "jpg") extension = "jpeg"; // www.rfc-editor.org/rfc/rfc2046.html
                         request->send(*fs, fileName, "image/" + extension);
                     } else if (strcmp(fileAction.c_str(), "delete") == 0) {
+                        webAssetsInvalidate();
                         if (deleteFromSd(*fs, fileName)) {
                             request->send(200, "text/plain", "Deleted : " + String(fileName));
                         } else {
@@ -667,14 +680,8 @@ void configureWebServer() {
                         }
 
                     } else if (strcmp(fileAction.c_str(), "edit") == 0) {
-                        File editFile = fs->open(fileName, FILE_READ);
-                        if (editFile) {
-                            String fileContent = editFile.readString();
-                            request->send(200, "text/plain", fileContent);
-                            editFile.close();
-                        } else {
-                            request->send(500, "text/plain", "Failed to open file for reading");
-                        }
+                        // whole file, sent from the file as it goes out (the editor reads /fileread ranges)
+                        request->send(*fs, fileName, "text/plain");
 
                     } else {
                         request->send(400, "text/plain", "ERROR: invalid action param supplied");
@@ -707,6 +714,7 @@ void configureWebServer() {
                     }
                 }
 
+                webAssetsInvalidate();
                 File editFile = fs->open(fileName, FILE_WRITE);
                 if (editFile) {
                     if (editFile.write((const uint8_t *)fileContent.c_str(), fileContent.length())) {
@@ -725,6 +733,25 @@ void configureWebServer() {
         }
     });
 
+    // Editor range read: fs, name, offset, length (bytes)
+    server->on("/fileread", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (checkUserWebAuth(request)) sendFileRange(request, editorFS(request), request->arg("name"));
+    });
+
+    // Editor chunked save: fs, name, offset, final=1 on the last chunk, the chunk is the raw body
+    server->on(
+        "/filewrite",
+        HTTP_POST,
+        [](AsyncWebServerRequest *request) {
+            if (checkUserWebAuth(request)) finishEditChunk(request, editorFS(request));
+        },
+        nullptr,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            if (index == 0 && !checkUserWebAuth(request)) return;
+            handleEditChunk(request, editorFS(request), data, len, index, total);
+        }
+    );
+
     // File upload
     server->on(
         "/upload",
@@ -9,10 +9,19 @@
 
 extern AsyncWebServer *server; // used to check if the webserver is running
 
+// Without PSRAM the SD card stays unmounted between requests on the ESP32 to spare RAM
+#if defined(CONFIG_IDF_TARGET_ESP32) && !defined(BOARD_HAS_PSRAM)
+#define MOUNT_SD_CARD setupSdCard()
+#define UNMOUNT_SD_CARD closeSdCard()
+#else
+#define MOUNT_SD_CARD
+#define UNMOUNT_SD_CARD
+#endif
+
 // function defaults
 String humanReadableSize(uint64_t bytes);
-String listFiles(FS fs, String folder);
 String readLineFromFile(File myFile);
+String color565ToWebHex(uint16_t color565);
 
 void loopOptionsWebUi();
 
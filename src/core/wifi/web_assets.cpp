@@ -0,0 +1,146 @@
+#include "web_assets.h"
+#include "core/gzip_file.h"
+#include "core/sd_functions.h"
+#include "webFiles.h"
+#include "webInterface.h"
+#include <globals.h>
+
+#ifndef WEB_FILES_HASH
+// webFiles.h generated before patch.py wrote the hash, any rebuild changes the ETag
+#define WEB_FILES_HASH BRUCE_VERSION "-" __DATE__ "-" __TIME__
+#endif
+
+WebAssetStats webAssetStats;
+
+struct WebAsset {
+    String name;
+    FS *fs = nullptr; // storage holding the override, nullptr for the embedded file
+    uint32_t size = 0;
+    uint32_t crc = 0; // CRC-32 of the override, file dates are uptime on boards without an RTC
+    uint32_t gzipSize = 0; // 0 when there is no usable compressed copy
+};
+
+static std::vector<WebAsset> webAssets;
+static uint32_t webAssetsMount = 0; // sdMountChanges when webAssets was last trusted
+
+void webAssetsInvalidate() { webAssets.clear(); }
+
+static String gzipPath(const WebAsset &asset) { return String(WEB_ASSET_GZIP_DIR "/") + asset.name + ".gz"; }
+
+// Makes sure the compressed copy matches the override, by the CRC and size in the gzip trailer
+static void updateGzip(FS &fs, WebAsset &asset) {
+    if (asset.size == 0 || asset.size > WEB_ASSET_GZIP_MAX) return;
+
+    String gz = gzipPath(asset);
+    uint32_t crc, size;
+    if (!gzipFileInfo(fs, gz, crc, size) || crc != asset.crc || size != asset.size) {
+        if (!fs.exists(WEB_ASSET_GZIP_DIR)) fs.mkdir(WEB_ASSET_GZIP_DIR);
+        // compress next to it and swap, a request never sees half a file
+        String tmp = gz + ".tmp";
+        if (!gzipFile(fs, WEB_ASSET_DIR + asset.name, tmp, 0)) return;
+        fs.remove(gz);
+        if (!fs.rename(tmp, gz)) {
+            fs.remove(tmp);
+            return;
+        }
+    }
+    File f = fs.open(gz, FILE_READ);
+    if (f && f.size() < asset.size) asset.gzipSize = f.size();
+    f.close();
+}
+
+static WebAsset &resolveWebAsset(const String &filename) {
+    if (sdMountChanges != webAssetsMount) webAssets.clear();
+    for (WebAsset &asset : webAssets) {
+        if (asset.name == filename) return asset;
+    }
+
+    WebAsset asset;
+    asset.name = filename;
+    String path = WEB_ASSET_DIR + filename;
+    if (setupSdCard()) {
+        if (SD.exists(path)) asset.fs = &SD;
+    } else if (LittleFS.exists(path)) {
+        asset.fs = &LittleFS;
+    }
+    if (asset.fs) {
+        if (fileCrc32(*asset.fs, path, asset.crc, asset.size)) updateGzip(*asset.fs, asset);
+        else asset.fs = nullptr;
+    }
+    UNMOUNT_SD_CARD;
+    webAssetsMount = sdMountChanges; // our own mount and unmount are not a remount
+    webAssets.push_back(asset);
+    return webAssets.back();
+}
+
+static void addValidators(AsyncWebServerResponse *response, const String &etag, const char *cacheControl) {
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+}
+
+void serveWebAsset(
+    AsyncWebServerRequest *request, const String &filename, const char *contentType, bool gzip,
+    const uint8_t *embedded, uint32_t embeddedSize
+) {
+    webAssetStats.requests++;
+    WebAsset &asset = resolveWebAsset(filename);
+
+    String etag;
+    String themeCss;
+    const char *cacheControl = "no-cache"; // reuse only after a 304
+    if (asset.fs) {
+        gzip = asset.gzipSize > 0 && request->header("Accept-Encoding").indexOf("gzip") >= 0;
+        etag = "\"o" + String(asset.size, HEX) + "-" + String(asset.crc, HEX) + (gzip ? "-gz\"" : "\"");
+    } else if (embedded) {
+        etag = "\"" WEB_FILES_HASH "\"";
+        if (strcmp(contentType, "text/html") != 0) cacheControl = "max-age=" WEB_ASSET_MAX_AGE;
+    } else if (filename == "theme.css") {
+        themeCss = ":root{--color:" + color565ToWebHex(bruceConfig.priColor) +
+                   ";--sec-color:" + color565ToWebHex(bruceConfig.secColor) +
+                   ";--background:" + color565ToWebHex(bruceConfig.bgColor) + ";}";
+        // the three 16 bit colours side by side, so no two themes share an ETag
+        char colors[13];
+        snprintf(
+            colors,
+            sizeof(colors),
+            "%04x%04x%04x",
+            (uint16_t)bruceConfig.priColor,
+            (uint16_t)bruceConfig.secColor,
+            (uint16_t)bruceConfig.bgColor
+        );
+        etag = "\"t" + String(colors) + "\"";
+    } else {
+        request->send(404, "text/plain", "Nothing in here Sharky");
+        return;
+    }
+
+    if (request->header("If-None-Match").indexOf(etag) >= 0) {
+        webAssetStats.notModified++;
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        addValidators(response, etag, cacheControl);
+        request->send(response);
+        return;
+    }
+
+    AsyncWebServerResponse *response;
+    if (asset.fs) {
+        MOUNT_SD_CARD;
+        if (gzip) response = request->beginResponse(*asset.fs, gzipPath(asset), contentType);
+        else response = request->beginResponse(*asset.fs, WEB_ASSET_DIR + filename, contentType);
+        UNMOUNT_SD_CARD;
+        response->addHeader("Vary", "Accept-Encoding");
+        webAssetStats.bytes += gzip ? asset.gzipSize : asset.size;
+    } else if (embedded) {
+        response = request->beginResponse(200, String(contentType), embedded, embeddedSize);
+        webAssetStats.bytes += embeddedSize;
+    } else {
+        response = request->beginResponse(200, "text/css", themeCss);
+        webAssetStats.bytes += themeCss.length();
+    }
+    if (gzip) {
+        if (!response->addHeader("Content-Encoding", "gzip")) Serial.println("Failed to add gzip header");
+    }
+    addValidators(response, etag, cacheControl);
+    request->send(response);
+    webAssetsMount = sdMountChanges;
+}
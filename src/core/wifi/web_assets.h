@@ -0,0 +1,37 @@
+#ifndef __WEB_ASSETS_H__
+#define __WEB_ASSETS_H__
+
+#include <ESPAsyncWebServer.h>
+
+#define WEB_ASSET_DIR "/BruceWebUI/"          // overrides of the embedded files
+#define WEB_ASSET_GZIP_DIR "/BruceWebUI/.gz" // compressed copies of the overrides
+#define WEB_ASSET_GZIP_MAX (256 * 1024)      // larger overrides are sent uncompressed
+#define WEB_ASSET_MAX_AGE "300"              // seconds the browser reuses embedded css/js without asking
+
+// What the WebUI static files cost since boot
+struct WebAssetStats {
+    uint32_t requests = 0;
+    uint32_t notModified = 0;
+    uint64_t bytes = 0; // response bodies
+
+    void reset(void) { *this = WebAssetStats(); }
+};
+
+extern WebAssetStats webAssetStats;
+
+/*
+ * Sends `filename` from /BruceWebUI when overridden there, else the embedded
+ * copy (gzipped by patch.py when `gzip`). Responses carry an ETag (build hash
+ * for embedded files, size and CRC-32 for overrides) and a 304 answers requests
+ * that already hold it. Overrides are sent from a gzip copy kept in
+ * WEB_ASSET_GZIP_DIR, rebuilt when the override changes.
+ */
+void serveWebAsset(
+    AsyncWebServerRequest *request, const String &filename, const char *contentType, bool gzip,
+    const uint8_t *embedded, uint32_t embeddedSize
+);
+
+// Forgets where each file was found, done on SD remount and after the WebUI changes files
+void webAssetsInvalidate(void);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __WEB_EDIT_CHUNKS_H__
+#define __WEB_EDIT_CHUNKS_H__
+
+/*
+ * File handling of the editor endpoints, without the web server, so that
+ * tools/web_editor_chunk_test.cpp runs it against an in-memory filesystem.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef FILE_WRITE // host builds, as in FS.h
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+#endif
+
+#define WEB_EDIT_CHUNK (32 * 1024)     // range length when the client gives none
+#define WEB_EDIT_MAX_CHUNK (64 * 1024) // longest range sent at once
+
+// Bytes to send for a range read into len, false when offset is past the end of the file
+inline bool webEditRange(uint32_t size, uint32_t offset, long length, size_t &len) {
+    if (offset > size) return false;
+    if (length < 0) length = 0;
+    if (length > WEB_EDIT_MAX_CHUNK) length = WEB_EDIT_MAX_CHUNK;
+    len = (uint32_t)length < size - offset ? (size_t)length : (size_t)(size - offset);
+    return true;
+}
+
+/*
+ * Brings back the old file that a power loss in the middle of a FAT replace
+ * left in <path>.bak, when nothing took its place. True if it was restored.
+ */
+template <typename Fs, typename Str> bool webEditRestore(Fs &fs, const Str &path) {
+    Str bak = path + ".bak";
+    return !fs.exists(path) && fs.exists(bak) && fs.rename(bak, path);
+}
+
+/*
+ * Puts the temp file in place of path. LittleFS renames over the old file in
+ * one step. FAT refuses, so the old file moves to <path>.bak and is removed only
+ * once the temp file took its place: a power loss in between leaves the old
+ * contents in the .bak for webEditRestore(), and a failed rename puts it back.
+ */
+template <typename Fs, typename Str> bool webEditReplace(Fs &fs, const Str &tmp, const Str &path) {
+    webEditRestore(fs, path);
+    if (fs.rename(tmp, path)) return true;
+    Str bak = path + ".bak";
+    fs.remove(bak);
+    if (fs.exists(path) && !fs.rename(path, bak)) return false;
+    if (!fs.rename(tmp, path)) {
+        fs.rename(bak, path);
+        return false;
+    }
+    fs.remove(bak);
+    return true;
+}
+
+/*
+ * Opens the temp file a chunk written at offset goes to, answers with an HTTP
+ * status. Offset 0 starts the file over, any other must be its size so far:
+ * a repeated or skipped chunk gets 409 and that size in expected to resume from.
+ */
+template <typename Fs, typename Str, typename File>
+int webEditOpenChunk(Fs &fs, const Str &tmp, uint32_t offset, File &file, uint32_t &expected) {
+    file = offset == 0 ? fs.open(tmp, FILE_WRITE, true) : fs.open(tmp, FILE_APPEND);
+    if (!file) return 500;
+    if (file.size() != offset) {
+        expected = file.size();
+        file.close();
+        return 409;
+    }
+    return 200;
+}
+
+// Ends a chunk once its body is written, the final one puts the temp file in place of path
+template <typename Fs, typename Str>
+int webEditFinishChunk(Fs &fs, const Str &tmp, const Str &path, bool final) {
+    if (!final) return 200;
+    return webEditReplace(fs, tmp, path) ? 200 : 500;
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "web_editor.h"
+#include "web_assets.h"
+#include <memory>
+
+static String editTempPath(const String &path) { return path + ".tmp"; }
+
+// The reason is kept in _tempObject (freed with the request) for finishEditChunk to send
+static void failEditChunk(AsyncWebServerRequest *request, const String &reason) {
+    if (request->_tempFile) request->_tempFile.close();
+    if (!request->_tempObject) request->_tempObject = strdup(reason.c_str());
+}
+
+void sendFileRange(AsyncWebServerRequest *request, FS &fs, const String &path) {
+    auto file = std::make_shared<File>(fs.open(path, FILE_READ));
+    if (!*file && webEditRestore(fs, path)) *file = fs.open(path, FILE_READ);
+    if (!*file || file->isDirectory()) {
+        request->send(404, "text/plain", "Failed to open file for reading");
+        return;
+    }
+    uint32_t size = file->size();
+    uint32_t offset = request->arg("offset").toInt();
+    long length = request->hasArg("length") ? request->arg("length").toInt() : WEB_EDIT_CHUNK;
+    size_t len;
+    if (!webEditRange(size, offset, length, len) || !file->seek(offset)) {
+        request->send(416, "text/plain", "Offset past the end of the file");
+        return;
+    }
+
+    AsyncWebServerResponse *response = request->beginResponse(
+        "application/octet-stream",
+        len,
+        [file, len](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+            if (index >= len) return 0;
+            int n = file->read(buf, min(maxLen, len - index));
+            return n > 0 ? n : 0;
+        }
+    );
+    response->addHeader("X-File-Size", String(size));
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+void handleEditChunk(
+    AsyncWebServerRequest *request, FS &fs, uint8_t *data, size_t len, size_t index, size_t total
+) {
+    if (request->_tempObject) return; // an earlier part of this body failed
+    if (index == 0) {
+        String tmp = editTempPath(request->arg("name"));
+        uint32_t expected = 0;
+        int status = webEditOpenChunk(fs, tmp, request->arg("offset").toInt(), request->_tempFile, expected);
+        if (status == 409) {
+            failEditChunk(request, "offset " + String(expected));
+            return;
+        }
+        if (status != 200) {
+            failEditChunk(request, "Failed to open file for writing: " + tmp);
+            return;
+        }
+    }
+    if (!request->_tempFile || request->_tempFile.write(data, len) != len) {
+        failEditChunk(request, "Failed to write to file: " + request->arg("name"));
+        return;
+    }
+    if (index + len >= total) request->_tempFile.close();
+}
+
+void finishEditChunk(AsyncWebServerRequest *request, FS &fs) {
+    String path = request->arg("name");
+    String tmp = editTempPath(path);
+    if (request->_tempObject) {
+        request->send(409, "text/plain", (const char *)request->_tempObject);
+        return;
+    }
+    if (request->contentLength() == 0 && request->arg("offset").toInt() == 0) {
+        // no body, the handler never ran: an empty file
+        File f;
+        uint32_t expected;
+        if (webEditOpenChunk(fs, tmp, 0, f, expected) != 200) {
+            request->send(500, "text/plain", "Failed to open file for writing: " + tmp);
+            return;
+        }
+        f.close();
+    }
+    bool final = request->arg("final") == "1";
+    if (final) webAssetsInvalidate();
+    if (webEditFinishChunk(fs, tmp, path, final) != 200) {
+        request->send(500, "text/plain", "Failed to replace file: " + path);
+        return;
+    }
+    request->send(200, "text/plain", final ? "File edited: " + path : String("OK"));
+}
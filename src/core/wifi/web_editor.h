@@ -0,0 +1,30 @@
+#ifndef __WEB_EDITOR_H__
+#define __WEB_EDITOR_H__
+
+#include "web_edit_chunks.h"
+#include <ESPAsyncWebServer.h>
+#include <FS.h>
+
+/*
+ * Sends bytes [offset, offset + length) of `path`, read from the file while
+ * the response goes out. The X-File-Size header holds the whole file size so
+ * the editor knows how many ranges are left.
+ */
+void sendFileRange(AsyncWebServerRequest *request, FS &fs, const String &path);
+
+/*
+ * Chunked saves: each POST body is written to "<name>.tmp" at the `offset`
+ * argument, which must be the size of the temp file so far (0 starts over).
+ * The body goes straight to the file. The chunk with final=1 puts the temp
+ * file in place of <name> (webEditReplace), which is one rename on LittleFS.
+ * On FAT it takes two, and until the second one is done the old file is only
+ * in <name>.bak, where the next read or save of <name> finds it.
+ */
+void handleEditChunk(
+    AsyncWebServerRequest *request, FS &fs, uint8_t *data, size_t len, size_t index, size_t total
+);
+
+// Answers the chunk once its body is written, 409 with the expected offset when it did not fit
+void finishEditChunk(AsyncWebServerRequest *request, FS &fs);
+
+#endif
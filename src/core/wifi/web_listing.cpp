@@ -0,0 +1,209 @@
+#include "web_listing.h"
+#include "webInterface.h"
+#include <algorithm>
+#include <esp_task_wdt.h>
+#include <memory>
+
+namespace {
+
+struct ListingEntry {
+    String name;
+    bool dir = false;
+    uint64_t size = 0;
+};
+
+// Folders first, then by size when asked, then by name ignoring case (exact name breaks ties)
+int compareEntries(const ListingEntry &a, const ListingEntry &b, WebListingSort sort) {
+    if (a.dir != b.dir) return a.dir ? -1 : 1;
+    if (sort == LISTING_BY_SIZE && a.size != b.size) return a.size < b.size ? -1 : 1;
+    int c = strcasecmp(a.name.c_str(), b.name.c_str());
+    return c != 0 ? c : strcmp(a.name.c_str(), b.name.c_str());
+}
+
+// Sorted cursors hold the last entry sent: "d" or "f", its size, '/', its name
+String cursorOf(const ListingEntry &e) { return (e.dir ? "d" : "f") + String(e.size) + "/" + e.name; }
+
+bool parseCursor(const String &cursor, ListingEntry &e) {
+    int slash = cursor.indexOf('/');
+    if (cursor.length() < 2 || slash < 1 || (cursor[0] != 'd' && cursor[0] != 'f')) return false;
+    e.dir = cursor[0] == 'd';
+    e.size = strtoull(cursor.substring(1, slash).c_str(), nullptr, 10);
+    e.name = cursor.substring(slash + 1);
+    return true;
+}
+
+class ListingStream {
+public:
+    ListingStream(FS &fs, const String &folder, const WebListingQuery &query)
+        : _fs(&fs), _folder(folder), _query(query) {
+        _base = folder.endsWith("/") ? folder : folder + "/";
+        if (_query.sort != LISTING_UNSORTED) {
+            if (_query.limit == 0) _query.limit = WEB_LISTING_MAX_PAGE;
+        } else {
+            _skip = _query.cursor.toInt();
+        }
+        _root = _fs->open(folder);
+    }
+
+    // Chunked response callback, 0 ends the response
+    size_t fill(uint8_t *buf, size_t maxLen) {
+        size_t n = 0;
+        while (n < maxLen) {
+            if (_linePos >= _line.length()) {
+                if (!nextLine(_line)) break;
+                _linePos = 0;
+            }
+            size_t len = min(maxLen - n, (size_t)(_line.length() - _linePos));
+            memcpy(buf + n, _line.c_str() + _linePos, len);
+            n += len;
+            _linePos += len;
+        }
+        return n;
+    }
+
+private:
+    FS *_fs;
+    String _folder;
+    String _base; // folder with a trailing '/'
+    WebListingQuery _query;
+    File _root;
+    uint8_t _stage = 0; // header, entries, next cursor, done
+    String _line;
+    size_t _linePos = 0;
+    String _next;
+
+    // unsorted: position in the directory
+    uint32_t _skip = 0;
+    uint32_t _index = 0;
+    uint32_t _sent = 0;
+
+    // sorted: the page, picked on the first entry
+    std::vector<ListingEntry> _page;
+    size_t _pageIndex = 0;
+    bool _selected = false;
+
+    bool nextLine(String &line) {
+        switch (_stage) {
+            case 0:
+                _stage = 1;
+                line = "pa:" + _folder + ":0\n";
+                return true;
+            case 1: {
+                ListingEntry e;
+                if (nextEntry(e)) {
+                    if (e.dir) line = "Fo:" + e.name + ":0\n";
+                    else line = "Fi:" + e.name + ":" + humanReadableSize(e.size) + "\n";
+                    return true;
+                }
+                _stage = 2;
+                return nextLine(line);
+            }
+            case 2:
+                _stage = 3;
+                if (_next.isEmpty()) return false;
+                line = "nx:" + _next + "\n";
+                return true;
+            default: return false;
+        }
+    }
+
+    // Next directory entry, the size costs opening the file so it is read only when needed
+    bool readEntry(ListingEntry &e, bool withSize) {
+        if (!_root || !_root.isDirectory()) return false;
+        if ((_index++ & 63) == 0) esp_task_wdt_reset();
+        if (!withSize) {
+            bool isDir;
+            String path = _root.getNextFileName(&isDir);
+            if (path.isEmpty()) return false;
+            e.name = path.substring(path.lastIndexOf('/') + 1);
+            e.dir = isDir;
+            e.size = 0;
+            return true;
+        }
+        File f = _root.openNextFile();
+        if (!f) return false;
+        e.name = f.name();
+        e.dir = f.isDirectory();
+        e.size = e.dir ? 0 : f.size();
+        f.close();
+        return true;
+    }
+
+    bool nextEntry(ListingEntry &e) {
+        if (_query.sort != LISTING_UNSORTED) {
+            if (!_selected) selectPage();
+            if (_pageIndex >= _page.size()) return false;
+            e = _page[_pageIndex++];
+            return true;
+        }
+
+        while (_index < _skip) {
+            if (!readEntry(e, false)) return false;
+        }
+        if (_query.limit > 0 && _sent == _query.limit) {
+            if (readEntry(e, false)) _next = String(_skip + _sent);
+            return false;
+        }
+        if (!readEntry(e, true)) return false;
+        _sent++;
+        return true;
+    }
+
+    // One pass over the folder keeping the `limit` first entries after the cursor
+    void selectPage() {
+        _selected = true;
+        ListingEntry after;
+        bool hasCursor = parseCursor(_query.cursor, after);
+        bool bySize = _query.sort == LISTING_BY_SIZE;
+        WebListingSort sort = _query.sort;
+        auto less = [sort](const ListingEntry &a, const ListingEntry &b) {
+            return compareEntries(a, b, sort) < 0;
+        };
+
+        _page.reserve(_query.limit);
+        bool more = false;
+        ListingEntry e;
+        while (readEntry(e, bySize)) {
+            if (hasCursor && compareEntries(e, after, sort) <= 0) continue;
+            if (_page.size() == _query.limit) {
+                more = true;
+                if (!less(e, _page.back())) continue;
+                _page.pop_back();
+            }
+            _page.insert(std::upper_bound(_page.begin(), _page.end(), e, less), e);
+        }
+        _root.close();
+
+        if (!bySize) {
+            for (ListingEntry &p : _page) {
+                if (p.dir) continue;
+                File f = _fs->open(_base + p.name);
+                if (f) p.size = f.size();
+                f.close();
+            }
+        }
+        if (more) _next = cursorOf(_page.back());
+    }
+};
+
+} // namespace
+
+AsyncWebServerResponse *beginListingResponse(
+    AsyncWebServerRequest *request, FS &fs, const String &folder, const WebListingQuery &query
+) {
+    auto stream = std::make_shared<ListingStream>(fs, folder, query);
+    return request->beginChunkedResponse("text/plain", [stream](uint8_t *buf, size_t maxLen, size_t index) {
+        return stream->fill(buf, maxLen);
+    });
+}
+
+WebListingQuery listingQueryFromRequest(AsyncWebServerRequest *request) {
+    WebListingQuery query;
+    String sort = request->arg("sort");
+    if (sort == "name") query.sort = LISTING_BY_NAME;
+    else if (sort == "size") query.sort = LISTING_BY_SIZE;
+    query.cursor = request->arg("cursor");
+    long limit = request->hasArg("limit") ? request->arg("limit").toInt() : WEB_LISTING_PAGE;
+    query.limit = constrain(limit, 1, WEB_LISTING_MAX_PAGE);
+    return query;
+}
@@ -0,0 +1,37 @@
+#ifndef __WEB_LISTING_H__
+#define __WEB_LISTING_H__
+
+#include <ESPAsyncWebServer.h>
+#include <FS.h>
+
+#define WEB_LISTING_PAGE 200     // default entries per page
+#define WEB_LISTING_MAX_PAGE 500 // entries per page accepted from the client
+
+enum WebListingSort : uint8_t {
+    LISTING_UNSORTED, // directory order, the cursor is an entry index
+    LISTING_BY_NAME,  // folders first, then case-insensitive name
+    LISTING_BY_SIZE,  // folders first, then smallest file first
+};
+
+struct WebListingQuery {
+    WebListingSort sort = LISTING_UNSORTED;
+    String cursor;        // "" for the first page, else the "nx" value of the previous page
+    uint32_t limit = 0;   // 0 for the whole folder
+};
+
+/*
+ * Streams a folder listing in the /listfiles text format, one entry per line:
+ *   pa:<folder>:0  Fo:<name>:0  Fi:<name>:<size>
+ * When entries are left after `limit`, a last "nx:<cursor>" line gives the
+ * cursor of the next page. Lines are produced while the response is sent, so
+ * memory does not grow with the folder: unsorted pages are read straight from
+ * the directory, sorted pages scan it once and keep only the page entries.
+ */
+AsyncWebServerResponse *beginListingResponse(
+    AsyncWebServerRequest *request, FS &fs, const String &folder, const WebListingQuery &query
+);
+
+// Reads sort, cursor and limit from the request, limit defaults to WEB_LISTING_PAGE
+WebListingQuery listingQueryFromRequest(AsyncWebServerRequest *request);
+
+#endif
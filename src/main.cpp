@@ -1,6 +1,9 @@
 #include "core/main_menu.h"
 #include <globals.h>
 
+#include "core/boot_trace.h"
+#include "core/input_events.h"
+#include "core/perf_monitor.h"
 #include "core/powerSave.h"
 #include "core/serial_commands/cli.h"
 #include "core/utils.h"
@@ -61,6 +64,7 @@ void __attribute__((weak)) taskInputHandler(void *parameter) {
         // if AnyKeyPress is false, or rerun if it was not renewed within 75ms (arbitrary)
         // because AnyKeyPress will be true if didn´t passed through a check(bool var)
         if (!AnyKeyPress || millis() - timer > 75) {
+            InputLock lock; // check() and _getKeyPress() wait instead of suspending this task
             NextPress = false;
             PrevPress = false;
             UpPress = false;
@@ -75,10 +79,11 @@ void __attribute__((weak)) taskInputHandler(void *parameter) {
             touchPoint.Clear();
 #ifndef USE_TFT_eSPI_TOUCH
             InputHandler();
+            inputCollect();
 #endif
             timer = millis();
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        inputWait();
     }
 }
 // Public Globals Variables
@@ -147,13 +152,24 @@ volatile int tftHeight = VECTOR_DISPLAY_DEFAULT_WIDTH;
 #include "modules/rf/rf_utils.h"                 // for initCC1101once
 #include <Wire.h>
 
+/*********************************************************************
+ **  Function: mount_littlefs / mount_sdcard
+ **  Storage mounts, run by bootRun() while the display starts
+ *********************************************************************/
+void mount_littlefs() {
+    if (!LittleFS.begin(true)) { LittleFS.format(), LittleFS.begin(); }
+}
+
+void mount_sdcard() { setupSdCard(); }
+
 /*********************************************************************
  **  Function: begin_storage
  **  Config LittleFS and SD storage
  *********************************************************************/
 void begin_storage() {
-    if (!LittleFS.begin(true)) { LittleFS.format(), LittleFS.begin(); }
-    bool checkFS = setupSdCard();
+    bootWait(BOOT_LITTLEFS | BOOT_SDCARD);
+    BootTrace trace("config");
+    bool checkFS = sdcardMounted;
     bruceConfig.fromFile(checkFS);
     bruceConfigPins.fromFile(checkFS);
 }
@@ -397,21 +413,47 @@ void setup() {
     BLEConnected = false;
     bruceConfig.bright = 100; // theres is no value yet
     bruceConfigPins.rotation = ROTATION;
-    setup_gpio();
+    // Phases marked with bootRun() run on the other core, bootWait() joins them where their result is used
+    bootRun("littlefs", BOOT_LITTLEFS, mount_littlefs);
+    {
+        BootTrace trace("gpio");
+        setup_gpio();
+    }
+    // the SD card can only mount next to the display init when it has a bus of its own
+    bool sdOnTftBus = sdcardSharesTftBus();
+    if (!sdOnTftBus) bootRun("sdcard", BOOT_SDCARD, mount_sdcard);
+    {
+        BootTrace trace("display");
 #if defined(HAS_SCREEN)
-    tft.init();
-    tft.setRotation(bruceConfigPins.rotation);
-    tft.fillScreen(TFT_BLACK);
-    // bruceConfig is not read yet.. just to show something on screen due to long boot time
-    tft.setTextColor(TFT_PURPLE, TFT_BLACK);
-    tft.drawCentreString("Booting", tft.width() / 2, tft.height() / 2, 1);
+        tft.init();
+        tft.setRotation(bruceConfigPins.rotation);
+        tft.fillScreen(TFT_BLACK);
+        // bruceConfig is not read yet.. just to show something on screen due to long boot time
+        tft.setTextColor(TFT_PURPLE, TFT_BLACK);
+        tft.drawCentreString("Booting", tft.width() / 2, tft.height() / 2, 1);
 #else
-    tft.begin();
+        tft.begin();
 #endif
+    }
+    if (sdOnTftBus) bootRun("sdcard", BOOT_SDCARD, mount_sdcard, false);
     begin_storage();
-    begin_tft();
-    init_clock();
-    init_led();
+#if defined(HAS_SCREEN)
+    // decoded while the display, RTC and GPIO finish, the boot animation needs its colors
+    bootRun(
+        "theme",
+        BOOT_THEME,
+        [] { bruceConfig.openThemeFile(bruceConfig.themeFS(), bruceConfig.themePath, false); },
+        !(sdOnTftBus && bruceConfig.themeFS() == &SD)
+    );
+#endif
+    {
+        BootTrace trace("tft config");
+        begin_tft();
+    }
+    bootRun("rtc, led", BOOT_CLOCK, [] {
+        init_clock();
+        init_led();
+    });
 
     // Set WiFi country to avoid warnings and ensure max power
     wifi_country_t country = {
@@ -426,11 +468,15 @@ void setup() {
     esp_wifi_set_country(&country);
 
     // Some GPIO Settings (such as CYD's brightness control must be set after tft and sdcard)
-    _post_setup_gpio();
+    {
+        BootTrace trace("post gpio");
+        _post_setup_gpio();
+    }
     // end of post gpio begin
 
     // #ifndef USE_TFT_eSPI_TOUCH
     // This task keeps running all the time, will never stop
+    inputBegin();
     xTaskCreate(
         taskInputHandler,              // Task function
         "InputHandler",                // Task Name
@@ -441,8 +487,10 @@ void setup() {
     );
     // #endif
 #if defined(HAS_SCREEN)
-    bruceConfig.openThemeFile(bruceConfig.themeFS(), bruceConfig.themePath, false);
+    bootWait(BOOT_THEME);
+    if (bruceConfig.themeFileError) displayError("5", true);
     if (!bruceConfig.instantBoot) {
+        BootTrace trace("boot animation");
         boot_screen_anim();
         startup_sound();
     }
@@ -462,9 +510,15 @@ void setup() {
     startSerialCommandsHandlerTask();
 
     // Initialize firmware update system
-    initFirmwareUpdate();
-    checkPendingFirmware();
+    {
+        BootTrace trace("firmware update");
+        initFirmwareUpdate();
+        checkPendingFirmware();
+    }
+
+    perfMonitor.begin();
 
+    bootWait(BOOT_CLOCK); // the menu shows the clock
     wakeUpScreen();
     if (bruceConfig.startupApp != "" && !startupApp.startApp(bruceConfig.startupApp)) {
         bruceConfig.setStartupApp("");
@@ -482,8 +536,7 @@ void loop() {
 #if !defined(LITE_VERSION) && !defined(DISABLE_INTERPRETER)
     if (interpreter_start) {
         TaskHandle_t interpreterTaskHandler = NULL;
-        vTaskDelete(serialcmdsTaskHandle); // stop serial commands while in interpreter
-        vTaskDelay(pdMS_TO_TICKS(10));
+        pauseSerialCommands(true); // the interpreter reads the serial port and runs commands itself
         xTaskCreate(
             interpreterHandler,          // Task function
             "interpreterHandler",        // Task Name
@@ -494,13 +547,14 @@ void loop() {
         );
 
         while (interpreter_start == true) { vTaskDelay(pdMS_TO_TICKS(500)); }
-        startSerialCommandsHandlerTask();
+        pauseSerialCommands(false);
         interpreter_start = false;
         previousMillis = millis(); // ensure that will not dim screen when get back to menu
     }
 #endif
     tft.fillScreen(bruceConfig.bgColor);
 
+    bootTraceReady();
     mainMenu.begin();
     delay(1);
 }
@@ -524,6 +578,7 @@ void loop() {
 
     // Enable navigation through webUI
     tft.fillScreen(bruceConfig.bgColor);
+    bootTraceReady();
     mainMenu.begin();
     vTaskDelay(10 / portTICK_PERIOD_MS);
 }
@@ -148,7 +148,7 @@ void nrf_channel_jammer() {
     int OnX = 0;
     NRF24_MODE mode = nrf_setMode();
     uint8_t NRFOnline = 1;
-    uint8_t NRFSPI = 0;
+    uint8_t spiMode = 0;
     if (nrf_start(mode)) {
 
         int channel = 50;
@@ -159,7 +159,7 @@ void nrf_channel_jammer() {
             NRFradio.setAddressWidth(3);
             NRFradio.setPayloadSize(2);
             if (!NRFradio.setDataRate(RF24_2MBPS)) ;
-            NRFSPI = 1;
+            spiMode = 1;
         }
 
         drawMainBorder();
@@ -180,7 +180,7 @@ void nrf_channel_jammer() {
 
                         NRFOnline = (incomingNRFs.toInt());
                         if (CHECK_NRF_BOTH(mode)) {
-                            NRFOnline = (incomingNRFs.toInt()) + NRFSPI;
+                            NRFOnline = (incomingNRFs.toInt()) + spiMode;
                         }
                         redraw = true;
                         OnX = 1;
@@ -246,7 +246,7 @@ void nrf_channel_jammer() {
 void nrf_channel_hopper() {
     NRF24_MODE mode = nrf_setMode();
     uint8_t NRFOnline = 0;
-    uint8_t NRFSPI = 0;
+    uint8_t spiMode = 0;
 
     if (!nrf_start(mode)) {
         displayError("NRF24 not found");
@@ -258,7 +258,7 @@ void nrf_channel_hopper() {
         NRFradio.setPALevel(RF24_PA_MAX);
         NRFradio.startConstCarrier(RF24_PA_MAX, 50);
         if (!NRFradio.setDataRate(RF24_2MBPS)) ;
-        NRFSPI = 1;
+        spiMode = 1;
     }
 
     int startChannel = 0;
@@ -284,7 +284,7 @@ void nrf_channel_hopper() {
                 if (incomingNRFs.length() == 1 && isDigit(incomingNRFs.charAt(0))) {
                     NRFOnline = (incomingNRFs.toInt());
                     if (CHECK_NRF_BOTH(mode)) {
-                         NRFOnline = (incomingNRFs.toInt()) + NRFSPI;
+                         NRFOnline = (incomingNRFs.toInt()) + spiMode;
                     }
                     redraw = true;
                 }
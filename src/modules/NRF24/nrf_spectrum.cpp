@@ -2,9 +2,17 @@
 #include "../../core/display.h"
 #include "../../core/mykeyboard.h"
 
-#define CHANNELS 80
+#define CHANNELS 80 // drawn on screen, 2.40 to 2.48 GHz
 #define RGB565(r, g, b) ((((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)))
-uint8_t channel[CHANNELS];
+
+// Accumulators are updated once per sweep under the lock, so the WebUI task
+// always copies a complete sweep.
+static uint8_t channel[NRF_SPECTRUM_CHANNELS];
+static uint8_t peak[NRF_SPECTRUM_CHANNELS];
+static uint32_t hits[NRF_SPECTRUM_CHANNELS];
+static uint32_t sweeps = 0;
+static uint32_t lastSweep = 0;
+static portMUX_TYPE spectrumMux = portMUX_INITIALIZER_UNLOCKED;
 
 // Register Access Functions
 inline byte getRegister(SPIClass &SSPI, byte r) {
@@ -27,29 +35,99 @@ inline void setRegister(SPIClass &SSPI, byte r, byte v) {
 
 inline void powerDown(SPIClass &SSPI) { setRegister(SSPI, 0x00, getRegister(SSPI, 0x00) & ~0x02); }
 
-// scanning channels
-#define _BW tftWidth / CHANNELS
-String scanChannels(SPIClass *SSPI, bool web) {
-    String result = "{";
+bool nrf_spectrum_begin() {
+    if (!nrf_start(NRF_MODE_SPI)) return false; // This function only works on SPI
+    NRFradio.setAutoAck(false);
+    NRFradio.disableCRC();       // accept any signal we find
+    NRFradio.setAddressWidth(2); // a reverse engineering tactic (not typically recommended)
+    const uint8_t noiseAddress[][2] = {
+        {0x55, 0x55},
+        {0xAA, 0xAA},
+        {0xA0, 0xAA},
+        {0xAB, 0xAA},
+        {0xAC, 0xAA},
+        {0xAD, 0xAA}
+    };
+    for (uint8_t i = 0; i < 6; ++i) { NRFradio.openReadingPipe(i, noiseAddress[i]); }
+    NRFradio.setDataRate(RF24_1MBPS);
+    nrf_spectrum_reset();
+    return true;
+}
+
+void nrf_spectrum_end(SPIClass *SSPI) {
+    NRFradio.stopListening();
+    powerDown(*SSPI);
+}
 
-    uint8_t rpdValues[CHANNELS] = {0};
+void nrf_spectrum_reset() {
+    portENTER_CRITICAL(&spectrumMux);
+    memset(channel, 0, sizeof(channel));
+    memset(peak, 0, sizeof(peak));
+    memset(hits, 0, sizeof(hits));
+    sweeps = 0;
+    portEXIT_CRITICAL(&spectrumMux);
+}
+
+void nrf_spectrum_sweep() {
+    uint8_t rpd[NRF_SPECTRUM_CHANNELS];
     digitalWrite(bruceConfigPins.NRF24_bus.io0, LOW);
 
-    for (int i = 0; i < CHANNELS; i++) {
+    for (int i = 0; i < NRF_SPECTRUM_CHANNELS; i++) {
         NRFradio.setChannel(i);
         NRFradio.startListening();
         delayMicroseconds(128);
         NRFradio.stopListening();
-
-        int rpd = NRFradio.testRPD() ? 1 : 0;
-        channel[i] = (channel[i] * 3 + rpd * 125) / 4;
-        rpdValues[i] = channel[i];
+        rpd[i] = NRFradio.testRPD() ? 1 : 0;
     }
 
     digitalWrite(bruceConfigPins.NRF24_bus.io0, HIGH);
 
+    portENTER_CRITICAL(&spectrumMux);
+    for (int i = 0; i < NRF_SPECTRUM_CHANNELS; i++) {
+        channel[i] = (channel[i] * 3 + rpd[i] * 125) / 4;
+        if (channel[i] > peak[i]) peak[i] = channel[i];
+        hits[i] += rpd[i];
+    }
+    sweeps++;
+    lastSweep = millis();
+    portEXIT_CRITICAL(&spectrumMux);
+}
+
+bool nrf_spectrum_frame(NrfSpectrumKind kind, NrfSpectrumFrame &frame) {
+    frame.magic = NRF_SPECTRUM_MAGIC;
+    frame.kind = kind;
+    frame.channels = NRF_SPECTRUM_CHANNELS;
+    frame.reserved = 0;
+
+    portENTER_CRITICAL(&spectrumMux);
+    frame.timestamp = lastSweep;
+    frame.sweeps = sweeps;
+    switch (kind) {
+        case NRF_SPECTRUM_PEAK: memcpy(frame.level, peak, sizeof(frame.level)); break;
+        case NRF_SPECTRUM_AVERAGE:
+            for (int i = 0; i < NRF_SPECTRUM_CHANNELS; i++) {
+                frame.level[i] = sweeps ? (uint64_t)hits[i] * 125 / sweeps : 0;
+            }
+            break;
+        default: memcpy(frame.level, channel, sizeof(frame.level)); break;
+    }
+    portEXIT_CRITICAL(&spectrumMux);
+    return frame.sweeps > 0;
+}
+
+// scanning channels
+#define _BW tftWidth / CHANNELS
+void scanChannels(SPIClass *SSPI) {
+    nrf_spectrum_sweep();
+
+    uint8_t levels[CHANNELS];
+    portENTER_CRITICAL(&spectrumMux);
+    memcpy(levels, channel, CHANNELS);
+    portEXIT_CRITICAL(&spectrumMux);
+
+    char label[4];
     for (int i = 0; i < CHANNELS; i++) {
-        int level = rpdValues[i];
+        int level = levels[i];
         int x = i * _BW;
         int c = i;
 
@@ -62,17 +140,11 @@ String scanChannels(SPIClass *SSPI, bool web) {
         );                                                    /// for clearing
         tft.drawFastVLine(x, 0, level, bruceConfig.secColor); /// for top display
         // show 5 channel gap only
-        if (c % 5 == 0 && c != 0) { tft.drawCentreString(String(c).c_str(), x, tftHeight / 2, 1); }
-
-        if (web) {
-            if (i > 0) result += ",";
-            result += String(level);
+        if (c % 5 == 0 && c != 0) {
+            snprintf(label, sizeof(label), "%d", c);
+            tft.drawCentreString(label, x, tftHeight / 2, 1);
         }
     }
-
-    if (web) result += "}";
-    return result; // return a string in this format "{1,32,45,32,84,32 .... 12,54,65}" with 80 values to be
-                   // used in the WebUI (Future)
 }
 
 void nrf_spectrum(SPIClass *SSPI) {
@@ -82,24 +154,9 @@ void nrf_spectrum(SPIClass *SSPI) {
     tft.drawCentreString("2.44Ghz", tftWidth / 2, tftHeight - LH, 1);
     tft.drawRightString("2.48Ghz", tftWidth, tftHeight - LH, 1);
 
-    if (nrf_start(NRF_MODE_SPI)) { // This function only works on SPI
-        NRFradio.setAutoAck(false);
-        NRFradio.disableCRC();       // accept any signal we find
-        NRFradio.setAddressWidth(2); // a reverse engineering tactic (not typically recommended)
-        const uint8_t noiseAddress[][2] = {
-            {0x55, 0x55},
-            {0xAA, 0xAA},
-            {0xA0, 0xAA},
-            {0xAB, 0xAA},
-            {0xAC, 0xAA},
-            {0xAD, 0xAA}
-        };
-        for (uint8_t i = 0; i < 6; ++i) { NRFradio.openReadingPipe(i, noiseAddress[i]); }
-        NRFradio.setDataRate(RF24_1MBPS);
-
+    if (nrf_spectrum_begin()) {
         while (!check(EscPress)) { scanChannels(SSPI); }
-        NRFradio.stopListening();
-        powerDown(*SSPI);
+        nrf_spectrum_end(SSPI);
         delay(250);
         return;
 
@@ -3,8 +3,35 @@
 #include "modules/NRF24/nrf_common.h"
 #include <RF24.h>
 
+#define NRF_SPECTRUM_CHANNELS 126 // 2.400 to 2.525 GHz
+#define NRF_SPECTRUM_MAGIC 0xA5
+
+enum NrfSpectrumKind : uint8_t {
+    NRF_SPECTRUM_LEVEL = 0, // smoothed carrier level, 0-125
+    NRF_SPECTRUM_PEAK,      // highest level since the last reset
+    NRF_SPECTRUM_AVERAGE,   // share of sweeps with a carrier, scaled to 0-125
+};
+
+// Binary frame served by /nrfspectrum and streamed by the `nrf spectrum` command
+struct __attribute__((packed)) NrfSpectrumFrame {
+    uint8_t magic;
+    uint8_t kind;
+    uint8_t channels;
+    uint8_t reserved;
+    uint32_t timestamp; // millis() at the end of the sweep
+    uint32_t sweeps;    // since the accumulators were reset
+    uint8_t level[NRF_SPECTRUM_CHANNELS];
+};
+
 void nrf_spectrum(SPIClass *SSPI);
 
-String scanChannels(SPIClass *SSPI, bool web = false);
+void scanChannels(SPIClass *SSPI);
+
+// Feed used by the screen, the WebUI and the serial command
+bool nrf_spectrum_begin(void);
+void nrf_spectrum_end(SPIClass *SSPI);
+void nrf_spectrum_sweep(void);
+void nrf_spectrum_reset(void);
+bool nrf_spectrum_frame(NrfSpectrumKind kind, NrfSpectrumFrame &frame);
 
 #endif
@@ -0,0 +1,57 @@
+#if !defined(LITE_VERSION) && !defined(DISABLE_INTERPRETER)
+#include "ble_js.h"
+
+#include "helpers_js.h"
+#include "modules/ble/ble_common.h"
+#include "modules/ble/ble_device_table.h"
+
+duk_ret_t putPropBLEFunctions(duk_context *ctx, duk_idx_t obj_idx, uint8_t magic) {
+    bduk_put_prop_c_lightfunc(ctx, obj_idx, "scan", native_bleScan, 2, magic);
+    bduk_put_prop_c_lightfunc(ctx, obj_idx, "devices", native_bleDevices, 0, magic);
+    bduk_put_prop_c_lightfunc(ctx, obj_idx, "clear", native_bleClear, 0, magic);
+    return 0;
+}
+
+static void pushBLEDevices(duk_context *ctx) {
+    std::vector<BLEDeviceEntry> devices;
+    bleDeviceTable.snapshot(devices);
+
+    uint32_t now = millis();
+    duk_idx_t arr_idx = duk_push_array(ctx);
+    for (size_t i = 0; i < devices.size(); i++) {
+        const BLEDeviceEntry &dev = devices[i];
+        duk_idx_t obj_idx = duk_push_object(ctx);
+        bduk_put_prop(ctx, obj_idx, "address", duk_push_string, dev.address().c_str());
+        bduk_put_prop(ctx, obj_idx, "name", duk_push_string, dev.name);
+        bduk_put_prop(ctx, obj_idx, "rssi", duk_push_int, dev.rssi());
+        bduk_put_prop(ctx, obj_idx, "lastRssi", duk_push_int, dev.lastRssi);
+        bduk_put_prop(ctx, obj_idx, "seen", duk_push_uint, dev.seen);
+        bduk_put_prop(ctx, obj_idx, "lastSeenMs", duk_push_uint, now - dev.lastSeen);
+        duk_put_prop_index(ctx, arr_idx, i);
+    }
+}
+
+duk_ret_t native_bleScan(duk_context *ctx) {
+    // usage: scan(seconds? : number, keep? : boolean)
+    // returns: [{address, name, rssi, lastRssi, seen, lastSeenMs}], strongest first
+    int seconds = duk_get_int_default(ctx, 0, 5);
+    bool keep = duk_get_boolean_default(ctx, 1, false);
+    if (seconds <= 0) seconds = 5;
+
+    if (!ble_scan_devices(seconds, keep)) return duk_error(ctx, DUK_ERR_ERROR, "Out of memory");
+
+    pushBLEDevices(ctx);
+    return 1;
+}
+
+duk_ret_t native_bleDevices(duk_context *ctx) {
+    pushBLEDevices(ctx);
+    return 1;
+}
+
+duk_ret_t native_bleClear(duk_context *ctx) {
+    bleDeviceTable.clear();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#if !defined(LITE_VERSION) && !defined(DISABLE_INTERPRETER)
+#ifndef __BLE_JS_H__
+#define __BLE_JS_H__
+
+#include <duktape.h>
+
+duk_ret_t putPropBLEFunctions(duk_context *ctx, duk_idx_t obj_idx, uint8_t magic);
+
+duk_ret_t native_bleScan(duk_context *ctx);
+duk_ret_t native_bleDevices(duk_context *ctx);
+duk_ret_t native_bleClear(duk_context *ctx);
+
+#endif
+#endif
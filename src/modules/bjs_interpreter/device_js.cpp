@@ -2,6 +2,7 @@
 #include "device_js.h"
 #include <globals.h>
 
+#include "core/perf_monitor.h"
 #include "helpers_js.h"
 
 duk_ret_t putPropDeviceFunctions(duk_context *ctx, duk_idx_t obj_idx, uint8_t magic) {
@@ -13,6 +14,7 @@ duk_ret_t putPropDeviceFunctions(duk_context *ctx, duk_idx_t obj_idx, uint8_t ma
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "getBatteryDetailed", native_getBatteryDetailed, 0, magic);
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "getFreeHeapSize", native_getFreeHeapSize, 0, magic);
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "getEEPROMSize", native_getEEPROMSize, 0, magic);
+    bduk_put_prop_c_lightfunc(ctx, obj_idx, "getPerf", native_getPerf, 1, magic);
     return 0;
 }
 
@@ -24,6 +26,7 @@ duk_ret_t registerDevice(duk_context *ctx) {
     bduk_register_c_lightfunc(ctx, "getBatteryDetailed", native_getBatteryDetailed, 0);
     bduk_register_c_lightfunc(ctx, "getFreeHeapSize", native_getFreeHeapSize, 0);
     bduk_register_c_lightfunc(ctx, "getEEPROMSize", native_getEEPROMSize, 0);
+    bduk_register_c_lightfunc(ctx, "getPerf", native_getPerf, 1);
     return 0;
 }
 
@@ -102,4 +105,12 @@ duk_ret_t native_getEEPROMSize(duk_context *ctx) {
     return 1;
 }
 
+// getPerf(history = false): the /perf WebUI object, tasks sorted by CPU load
+duk_ret_t native_getPerf(duk_context *ctx) {
+    bool history = duk_get_boolean_default(ctx, 0, false);
+    duk_push_string(ctx, perfMonitor.toJson(history).c_str());
+    duk_json_decode(ctx, -1);
+    return 1;
+}
+
 #endif
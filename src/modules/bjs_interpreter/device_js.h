@@ -14,6 +14,7 @@ duk_ret_t native_getBattery(duk_context *ctx);
 duk_ret_t native_getBatteryDetailed(duk_context *ctx);
 duk_ret_t native_getFreeHeapSize(duk_context *ctx);
 duk_ret_t native_getEEPROMSize(duk_context *ctx);
+duk_ret_t native_getPerf(duk_context *ctx);
 
 #endif
 #endif
@@ -158,6 +158,7 @@ void interpreterHandler(void *pvParameters) {
     duk_destroy_heap(ctx);
 
     clearDisplayModuleData();
+    clearWiFiModuleData();
 
     // delay(1000);
     interpreter_start = false;
@@ -279,6 +280,8 @@ duk_ret_t native_require(duk_context *ctx) {
         putPropAudioFunctions(ctx, obj_idx, 0);
     } else if (filepath == "badusb") {
         putPropBadUSBFunctions(ctx, obj_idx, 0);
+    } else if (filepath == "ble") {
+        putPropBLEFunctions(ctx, obj_idx, 0);
     } else if (filepath == "blebeacon") {
 
     } else if (filepath == "dialog" || filepath == "gui") {
@@ -13,6 +13,7 @@ extern char *scriptName;
 
 #include "audio_js.h"
 #include "badusb_js.h"
+#include "ble_js.h"
 #include "device_js.h"
 #include "dialog_js.h"
 #include "display_js.h"
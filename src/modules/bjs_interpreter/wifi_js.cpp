@@ -5,6 +5,130 @@
 #include "helpers_js.h"
 #include <HTTPClient.h>
 #include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <memory>
+#include <vector>
+
+#define JS_HTTP_POOL_SIZE 4       // idle keep-alive connections kept between fetches
+#define JS_HTTP_TIMEOUT_MS 30000  // longest wait for the next part of a body
+#define JS_HTTP_STREAM_CHUNK 4096 // default size of a streamed read()
+
+// A keep-alive connection to one scheme://host:port, reused by the next fetch to the same origin
+struct JsHttpConnection {
+    String origin;
+    std::unique_ptr<WiFiClient> client;
+    HTTPClient http;
+    bool busy = false; // a streamed body still reads from it
+    uint32_t lastUsed = 0;
+};
+
+// Reads one response body: sized, chunked, or until the server closes
+struct JsHttpBody {
+    WiFiClient *stream = nullptr;
+    int32_t remaining = -1; // of the body, or of the current chunk when chunked, -1 until close
+    bool chunked = false;
+    bool done = false; // read to its end, the connection can serve the next request
+
+    // Next body bytes, 0 at the end of the body or after JS_HTTP_TIMEOUT_MS without data
+    size_t read(uint8_t *buf, size_t len) {
+        if (done) return 0;
+        if (chunked && remaining == 0 && !nextChunk()) return 0;
+
+        uint32_t start = millis();
+        while (stream->available() <= 0) {
+            if (!stream->connected()) {
+                done = remaining < 0; // a body without size ends with the connection
+                return 0;
+            }
+            if (millis() - start > JS_HTTP_TIMEOUT_MS) return 0;
+            delay(1);
+        }
+        size_t want = min(len, (size_t)stream->available());
+        if (remaining >= 0) want = min(want, (size_t)remaining);
+        int n = stream->read(buf, want);
+        if (n <= 0) return 0;
+        if (remaining > 0) {
+            remaining -= n;
+            if (remaining == 0 && chunked) stream->readStringUntil('\n'); // CRLF after the chunk data
+            else if (remaining == 0) done = true;
+        }
+        return n;
+    }
+
+    // Chunk size line, the last (empty) chunk is followed by trailers and an empty line
+    bool nextChunk() {
+        String line = stream->readStringUntil('\n');
+        if (line.isEmpty()) return false;
+        remaining = strtol(line.c_str(), NULL, 16);
+        if (remaining > 0) return true;
+        do { line = stream->readStringUntil('\n'); } while (line.length() > 1);
+        done = true;
+        return false;
+    }
+};
+
+struct JsHttpStream {
+    JsHttpConnection *conn;
+    JsHttpBody body;
+    bool binary;
+};
+
+static std::vector<std::unique_ptr<JsHttpConnection>> jsHttpPool;
+static uint32_t jsHttpRequests = 0;
+static uint32_t jsHttpReused = 0; // requests sent on an already open connection
+
+static String urlOrigin(const String &url) {
+    int scheme = url.indexOf("://");
+    int path = url.indexOf('/', scheme < 0 ? 0 : scheme + 3);
+    return path < 0 ? url : url.substring(0, path);
+}
+
+// Idle connection to the origin of `url`, a new one when there is none
+static JsHttpConnection *acquireConnection(const String &url) {
+    String origin = urlOrigin(url);
+    for (auto &conn : jsHttpPool) {
+        if (!conn->busy && conn->origin == origin) return conn.get();
+    }
+    if (jsHttpPool.size() >= JS_HTTP_POOL_SIZE) {
+        // make room by closing the least recently used idle connection
+        auto lru = jsHttpPool.end();
+        for (auto it = jsHttpPool.begin(); it != jsHttpPool.end(); ++it) {
+            if (!(*it)->busy && (lru == jsHttpPool.end() || (*it)->lastUsed < (*lru)->lastUsed)) lru = it;
+        }
+        if (lru != jsHttpPool.end()) {
+            (*lru)->client->stop();
+            jsHttpPool.erase(lru);
+        }
+    }
+
+    std::unique_ptr<JsHttpConnection> conn(new JsHttpConnection());
+    conn->origin = origin;
+    if (url.startsWith("https:")) {
+        WiFiClientSecure *tls = new WiFiClientSecure();
+        tls->setInsecure();
+        conn->client.reset(tls);
+    } else {
+        conn->client.reset(new WiFiClient());
+    }
+    conn->http.setReuse(true);
+    jsHttpPool.push_back(std::move(conn));
+    return jsHttpPool.back().get();
+}
+
+// The connection stays open for the next fetch only when its body was read to the end
+static void releaseConnection(JsHttpConnection *conn, bool bodyDone) {
+    if (!bodyDone) conn->client->stop();
+    conn->http.end();
+    conn->busy = false;
+    conn->lastUsed = millis();
+}
+
+void clearWiFiModuleData() {
+    for (auto &conn : jsHttpPool) conn->client->stop();
+    jsHttpPool.clear();
+    jsHttpRequests = 0;
+    jsHttpReused = 0;
+}
 
 duk_ret_t putPropWiFiFunctions(duk_context *ctx, duk_idx_t obj_idx, uint8_t magic) {
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "connected", native_wifiConnected, 0, magic);
@@ -13,6 +137,7 @@ duk_ret_t putPropWiFiFunctions(duk_context *ctx, duk_idx_t obj_idx, uint8_t magi
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "disconnect", native_wifiDisconnect, 0, magic);
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "scan", native_wifiScan, 0, magic);
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "httpFetch", native_httpFetch, 2, magic);
+    bduk_put_prop_c_lightfunc(ctx, obj_idx, "httpStats", native_httpStats, 0, magic);
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "getMACAddress", native_wifiMACAddress, 0, magic);
     bduk_put_prop_c_lightfunc(ctx, obj_idx, "getIPAddress", native_ipAddress, 0, magic);
     return 0;
@@ -25,6 +150,7 @@ duk_ret_t registerWiFi(duk_context *ctx) {
     bduk_register_c_lightfunc(ctx, "wifiScan", native_wifiScan, 0);
     bduk_register_c_lightfunc(ctx, "httpFetch", native_httpFetch, 2, 0);
     bduk_register_c_lightfunc(ctx, "httpGet", native_httpFetch, 2, 0);
+    bduk_register_c_lightfunc(ctx, "httpStats", native_httpStats, 0);
     bduk_register_c_lightfunc(ctx, "wifiMACAddress", native_wifiMACAddress, 0);
     bduk_register_c_lightfunc(ctx, "wifiIPAddress", native_ipAddress, 0);
     return 0;
@@ -123,16 +249,16 @@ duk_ret_t native_wifiDisconnect(duk_context *ctx) {
 }
 
 duk_ret_t native_httpFetch(duk_context *ctx) {
-    HTTPClient http;
-
-    http.setReuse(false);
-
     if (WiFi.status() != WL_CONNECTED) wifiConnectMenu();
 
     if (WiFi.status() != WL_CONNECTED) { return duk_error(ctx, DUK_ERR_ERROR, "WIFI Not Connected"); }
 
-    // Your Domain name with URL path or IP address with path
-    http.begin(duk_to_string(ctx, 0));
+    // Same origin as an earlier fetch: the request goes out on its still open connection
+    const char *url = duk_to_string(ctx, 0);
+    JsHttpConnection *conn = acquireConnection(url);
+    HTTPClient &http = conn->http;
+    bool reused = conn->client->connected();
+    http.begin(*conn->client, url);
 
     // Add Headers if headers are included.
     if (duk_is_array(ctx, 1)) {
@@ -174,7 +300,8 @@ duk_ret_t native_httpFetch(duk_context *ctx) {
     size_t bodyRequestLength = 0U;
 
     const char *requestType = "GET";
-    uint8_t returnResponseType = 0;
+    bool binaryResponse = false;
+    bool streamResponse = false;
 
     if (duk_is_object(ctx, 1)) {
         if (duk_get_prop_string(ctx, 1, "body")) {
@@ -200,9 +327,12 @@ duk_ret_t native_httpFetch(duk_context *ctx) {
 
         if (duk_get_prop_string(ctx, 1, "responseType")) {
             const char *returnResponseTypeString = duk_get_string_default(ctx, -1, "string");
-            returnResponseType = (strcmp(returnResponseTypeString, "string") == 0);
+            binaryResponse = (strcmp(returnResponseTypeString, "string") != 0);
         }
 
+        // stream: true returns before the body, read it with read() or pipeTo()
+        if (duk_get_prop_string(ctx, 1, "stream")) { streamResponse = duk_to_boolean(ctx, -1); }
+
         if (duk_get_prop_string(ctx, 1, "headers")) {
             bool headersIsArray = duk_is_array(ctx, -1);
 
@@ -256,19 +386,21 @@ duk_ret_t native_httpFetch(duk_context *ctx) {
     // MEMO: Docs is wrong: sendRequest returns httpResponseCode not
     // Content-Length
     int httpResponseCode = http.sendRequest(requestType, (uint8_t *)bodyRequest, bodyRequestLength);
+    jsHttpRequests++;
+    if (reused) jsHttpReused++;
 
     if (httpResponseCode <= 0) {
-        return duk_error(ctx, DUK_ERR_ERROR, http.errorToString(httpResponseCode).c_str());
+        releaseConnection(conn, false);
+        return duk_error(ctx, DUK_ERR_ERROR, "%s", HTTPClient::errorToString(httpResponseCode).c_str());
     }
 
-    WiFiClient *stream = http.getStreamPtr();
-
-    int contentLength = http.getSize();
-    bool isChunked = false;
-    if (contentLength == -1) {
-        String transferEncoding = http.header("transfer-encoding");
-        isChunked = transferEncoding.equalsIgnoreCase("chunked");
-    }
+    JsHttpBody body;
+    body.stream = conn->client.get();
+    body.chunked = http.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+    body.remaining = body.chunked ? 0 : http.getSize();
+    // a chunked body ends at its 0-length chunk, nextChunk() sees it
+    body.done = (!body.chunked && body.remaining == 0) || httpResponseCode == HTTP_CODE_NO_CONTENT ||
+                httpResponseCode == HTTP_CODE_NOT_MODIFIED || strcmp(requestType, "HEAD") == 0;
 
     duk_idx_t headersObjectIdx = duk_push_object(ctx);
     for (size_t i = 0; i < http.headers(); i++) {
@@ -277,89 +409,160 @@ duk_ret_t native_httpFetch(duk_context *ctx) {
         );
     }
 
-    bool psramFoundValue = psramFound();
-    int payloadSize = 1; // MEMO: 1 for null terminated string
-    char *payload = NULL;
     duk_idx_t obj_idx = duk_push_object(ctx);
-    if (!isChunked) {
-        payloadSize = contentLength < 1 ? (psramFoundValue ? 16384 : 4096) : contentLength + 1;
-        payload = (char *)duk_push_fixed_buffer(ctx, payloadSize);
+    duk_dup(ctx, headersObjectIdx);
+    duk_put_prop_string(ctx, obj_idx, "headers");
+    bduk_put_prop(ctx, obj_idx, "response", duk_push_int, httpResponseCode);
+    bduk_put_prop(ctx, obj_idx, "status", duk_push_int, httpResponseCode);
+    bduk_put_prop(ctx, obj_idx, "ok", duk_push_boolean, httpResponseCode >= 200 && httpResponseCode < 300);
 
-        if (payload == NULL) {
-            return duk_error(ctx, DUK_ERR_ERROR, "%s: Memory allocation failed!", "httpFetch");
-        }
+    if (streamResponse) {
+        conn->busy = true;
+        JsHttpStream *stream = new JsHttpStream{conn, body, binaryResponse};
+        bduk_put_prop(ctx, obj_idx, "contentLength", duk_push_int, http.getSize());
+        bduk_put_prop(ctx, obj_idx, DUK_HIDDEN_SYMBOL("httpStream"), duk_push_pointer, stream);
+        bduk_put_prop_c_lightfunc(ctx, obj_idx, "read", native_httpStreamRead, 1, 0);
+        bduk_put_prop_c_lightfunc(ctx, obj_idx, "pipeTo", native_httpStreamPipeTo, 2, 0);
+        bduk_put_prop_c_lightfunc(ctx, obj_idx, "close", native_httpStreamClose, 0, 0);
+        duk_push_c_lightfunc(ctx, native_httpStreamClose, 1, 1, 0);
+        duk_set_finalizer(ctx, obj_idx);
+        return 1;
     }
 
-    unsigned long startMillis = millis();
-    const unsigned long timeoutMillis = 30000;
-
+    // Whole body: sized bodies are allocated once, others grow as they arrive
+    size_t capacity = body.remaining > 0 ? body.remaining : 1024;
+    char *payload = (char *)duk_push_dynamic_buffer(ctx, capacity);
     size_t bytesRead = 0;
-    while (http.connected()) {
-        if (millis() - startMillis > timeoutMillis) {
-            Serial.println("Timeout while reading response!");
-            break;
+    while (payload != NULL) {
+        if (bytesRead == capacity) {
+            capacity *= 2;
+            payload = (char *)duk_resize_buffer(ctx, -1, capacity);
+            if (payload == NULL) break;
         }
+        size_t n = body.read((uint8_t *)payload + bytesRead, capacity - bytesRead);
+        if (n == 0) break;
+        bytesRead += n;
+    }
+    if (payload == NULL) {
+        releaseConnection(conn, false);
+        return duk_error(ctx, DUK_ERR_ERROR, "%s: Memory allocation failed!", "httpFetch");
+    }
+    if (!body.done) Serial.println("Timeout while reading response!");
+    releaseConnection(conn, body.done);
+    duk_resize_buffer(ctx, -1, bytesRead);
 
-        if (isChunked) { // if header Transfer-Encoding: chunked
-            // Read chunk size
-            String chunkSizeStr = stream->readStringUntil('\r');
-            stream->read();                                         // Consume '\n'
-            int chunkSize = strtol(chunkSizeStr.c_str(), NULL, 16); // Convert hex to int
-            if (chunkSize == 0) break;                              // Last chunk
-
-            payloadSize += chunkSize;
-            if (payload == NULL) {
-                payload = (char *)duk_push_dynamic_buffer(ctx, payloadSize);
-            } else {
-                payload = (char *)duk_resize_buffer(ctx, -1, payloadSize);
-            }
-
-            if (payload == NULL) {
-                return duk_error(ctx, DUK_ERR_ERROR, "%s: Memory allocation failed!", "httpFetch");
-            }
+    if (!binaryResponse) {
+        duk_buffer_to_string(ctx, -1);
+    } else {
+        duk_push_buffer_object(ctx, -1, 0, bytesRead, DUK_BUFOBJ_UINT8ARRAY);
+    }
+    duk_put_prop_string(ctx, obj_idx, "body");
+    duk_dup(ctx, obj_idx);
+    return 1;
+}
 
-            // Read chunk data
-            int toRead = chunkSize;
-            while (toRead > 0) {
-                int readNow = stream->readBytes(payload + bytesRead, toRead);
-                if (readNow <= 0) break;
-                bytesRead += readNow;
-                toRead -= readNow;
-            }
+static JsHttpStream *thisHttpStream(duk_context *ctx) {
+    duk_push_this(ctx);
+    duk_get_prop_string(ctx, -1, DUK_HIDDEN_SYMBOL("httpStream"));
+    JsHttpStream *stream = (JsHttpStream *)duk_get_pointer(ctx, -1);
+    duk_pop_2(ctx);
+    return stream;
+}
 
-            // Consume trailing "\r\n" after chunk
-            stream->read();
-            stream->read();
+// Gives the connection back as soon as the body is over, close() is then only needed to stop early
+static void finishHttpStream(JsHttpStream *stream) {
+    if (stream->conn == nullptr || !stream->body.done) return;
+    releaseConnection(stream->conn, true);
+    stream->conn = nullptr;
+}
 
-        } else {
-            int streamSize = stream->available();
-            if (streamSize > 0) {
-                size_t toRead = (streamSize > 512) ? 512 : streamSize;
-                if ((bytesRead + toRead + 1) > payloadSize) break;
-                int bytesReceived = stream->readBytes(payload + bytesRead, toRead);
+duk_ret_t native_httpStreamRead(duk_context *ctx) {
+    // usage: response.read() -> string | Uint8Array | null at the end of the body
+    // usage: response.read(maxBytes : number)
+    JsHttpStream *stream = thisHttpStream(ctx);
+    if (stream == NULL) { return duk_error(ctx, DUK_ERR_ERROR, "%s: Response is closed", "read"); }
+
+    size_t size = duk_get_uint_default(ctx, 0, JS_HTTP_STREAM_CHUNK);
+    if (size == 0) size = JS_HTTP_STREAM_CHUNK;
+    uint8_t *buf = (uint8_t *)duk_push_dynamic_buffer(ctx, size);
+    size_t n = stream->conn ? stream->body.read(buf, size) : 0;
+    finishHttpStream(stream);
+    if (n == 0) {
+        duk_push_null(ctx);
+        return 1;
+    }
+    duk_resize_buffer(ctx, -1, n);
+    if (stream->binary) {
+        duk_push_buffer_object(ctx, -1, 0, n, DUK_BUFOBJ_UINT8ARRAY);
+    } else {
+        duk_buffer_to_string(ctx, -1);
+    }
+    return 1;
+}
 
-                bytesRead += bytesReceived;
-            } else {
-                delay(1);
-            }
-            if ((bytesRead + 1) >= payloadSize) break;
+// Copies the rest of the body to the file, -1 when the file cannot be written
+static int64_t pipeHttpBody(JsHttpStream *stream, FS &fs, const String &path) {
+    File file = fs.open(path, FILE_WRITE, true);
+    if (!file) return -1;
+    uint8_t buf[1024];
+    int64_t total = 0;
+    size_t n;
+    while (stream->conn && (n = stream->body.read(buf, sizeof(buf))) > 0) {
+        if (file.write(buf, n) != n) {
+            total = -1;
+            break;
         }
-        startMillis = millis();
+        total += n;
     }
-    if (payload != NULL) { payload[bytesRead] = '\0'; }
+    file.close();
+    return total;
+}
 
-    if (returnResponseType == 0) {
-        duk_buffer_to_string(ctx, -1);
+duk_ret_t native_httpStreamPipeTo(duk_context *ctx) {
+    // usage: response.pipeTo(path : string) -> bytes written
+    // usage: response.pipeTo(path : {fs: string, path: string})
+    JsHttpStream *stream = thisHttpStream(ctx);
+    if (stream == NULL) { return duk_error(ctx, DUK_ERR_ERROR, "%s: Response is closed", "pipeTo"); }
+
+    int64_t written;
+    {
+        FileParamsJS fileParams = js_get_path_from_params(ctx, false);
+        written = pipeHttpBody(stream, *fileParams.fs, fileParams.path);
+    }
+    finishHttpStream(stream);
+    if (written < 0) { return duk_error(ctx, DUK_ERR_ERROR, "%s: Could not write the file", "pipeTo"); }
+    if (!stream->body.done) Serial.println("Timeout while reading response!");
+    duk_push_number(ctx, (double)written);
+    return 1;
+}
+
+duk_ret_t native_httpStreamClose(duk_context *ctx) {
+    // the finalizer gets the response as argument, close() as this
+    if (duk_is_object(ctx, 0)) {
+        duk_dup(ctx, 0);
     } else {
-        duk_push_buffer_object(ctx, -1, 0, payloadSize, DUK_BUFOBJ_UINT8ARRAY);
+        duk_push_this(ctx);
     }
-    duk_put_prop_string(ctx, obj_idx, "body");
-    bduk_put_prop(ctx, obj_idx, "response", duk_push_int, httpResponseCode);
-    bduk_put_prop(ctx, obj_idx, "status", duk_push_int, httpResponseCode);
-    bduk_put_prop(ctx, obj_idx, "ok", duk_push_boolean, httpResponseCode >= 200 && httpResponseCode < 300);
+    duk_idx_t obj_idx = duk_get_top_index(ctx);
+    JsHttpStream *stream = NULL;
+    if (duk_get_prop_string(ctx, obj_idx, DUK_HIDDEN_SYMBOL("httpStream"))) {
+        stream = (JsHttpStream *)duk_get_pointer(ctx, -1);
+    }
+    duk_pop(ctx);
+    if (stream == NULL) return 0;
 
-    // Free resources
-    http.end();
+    bduk_put_prop(ctx, obj_idx, DUK_HIDDEN_SYMBOL("httpStream"), duk_push_pointer, NULL);
+    // an unread rest of the body would be taken for the next response, so it closes the connection
+    if (stream->conn) releaseConnection(stream->conn, stream->body.done);
+    delete stream;
+    return 0;
+}
+
+duk_ret_t native_httpStats(duk_context *ctx) {
+    duk_idx_t obj_idx = duk_push_object(ctx);
+    bduk_put_prop(ctx, obj_idx, "requests", duk_push_uint, jsHttpRequests);
+    bduk_put_prop(ctx, obj_idx, "reused", duk_push_uint, jsHttpReused);
+    bduk_put_prop(ctx, obj_idx, "connections", duk_push_uint, jsHttpPool.size());
     return 1;
 }
 
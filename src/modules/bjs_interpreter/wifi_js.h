@@ -4,6 +4,9 @@
 
 #include <duktape.h>
 
+// Closes the keep-alive connections left by httpFetch
+void clearWiFiModuleData();
+
 duk_ret_t putPropWiFiFunctions(duk_context *ctx, duk_idx_t obj_idx, uint8_t magic);
 duk_ret_t registerWiFi(duk_context *ctx);
 
@@ -13,6 +16,10 @@ duk_ret_t native_wifiConnect(duk_context *ctx);
 duk_ret_t native_wifiScan(duk_context *ctx);
 duk_ret_t native_wifiDisconnect(duk_context *ctx);
 duk_ret_t native_httpFetch(duk_context *ctx);
+duk_ret_t native_httpStreamRead(duk_context *ctx);
+duk_ret_t native_httpStreamPipeTo(duk_context *ctx);
+duk_ret_t native_httpStreamClose(duk_context *ctx);
+duk_ret_t native_httpStats(duk_context *ctx);
 duk_ret_t native_wifiMACAddress(duk_context *ctx);
 duk_ret_t native_ipAddress(duk_context *ctx);
 
@@ -1,4 +1,5 @@
 #include "ble_common.h"
+#include "ble_device_table.h"
 #include "core/mykeyboard.h"
 #include "core/utils.h"
 #include "esp_mac.h"
@@ -62,40 +63,29 @@ void ble_info(String name, String address, String signal) {
 }
 #ifdef NIMBLE_V2_PLUS
 class AdvertisedDeviceCallbacks : public NimBLEScanCallbacks {
+    void onResult(const NimBLEAdvertisedDevice *advertisedDevice) override {
+        bleDeviceTable.update(advertisedDevice);
+    }
+};
 #else
 class AdvertisedDeviceCallbacks : public NimBLEAdvertisedDeviceCallbacks {
-#endif
-    void onResult(NimBLEAdvertisedDevice *advertisedDevice) {
-        String bt_title;
-        String bt_name;
-        String bt_address;
-        String bt_signal;
-
-        bt_name = advertisedDevice->getName().c_str();
-        bt_title = advertisedDevice->getName().c_str();
-        bt_address = advertisedDevice->getAddress().toString().c_str();
-        bt_signal = String(advertisedDevice->getRSSI());
-        // Serial.println("\n\nAddress - " + bt_address + "Name-"+ bt_name +"\n\n");
-        if (bt_title.isEmpty()) bt_title = bt_address;
-        if (bt_name.isEmpty()) bt_name = "<no name>";
-        // If BT name is empty, set NONAME
-        if (options.size() < 250)
-            options.emplace_back(bt_title.c_str(), [=]() { ble_info(bt_name, bt_address, bt_signal); });
-        else {
-            Serial.println("Memory low, stopping BLE scan...");
-            pBLEScan->stop();
-        }
-    }
+    void onResult(NimBLEAdvertisedDevice *advertisedDevice) { bleDeviceTable.update(advertisedDevice); }
 };
+#endif
+
+static AdvertisedDeviceCallbacks scanCallbacks;
 
 void ble_scan_setup() {
     BLEDevice::init("");
     pBLEScan = BLEDevice::getScan();
+    // Every advertisement goes to the device table (duplicates refresh RSSI),
+    // NimBLE does not need to keep its own copy of the results
 #ifdef NIMBLE_V2_PLUS
-    pBLEScan->setScanCallbacks(new NimBLEScanCallbacks());
+    pBLEScan->setScanCallbacks(&scanCallbacks, true);
 #else
-    pBLEScan->setAdvertisedDeviceCallbacks(new AdvertisedDeviceCallbacks());
+    pBLEScan->setAdvertisedDeviceCallbacks(&scanCallbacks, true);
 #endif
+    pBLEScan->setMaxResults(0);
 
     // Active scan uses more power, but get results faster
     pBLEScan->setActiveScan(true);
@@ -123,46 +113,56 @@ void ble_scan_setup() {
     vTaskDelay(100 / portTICK_PERIOD_MS);
 }
 
-void ble_scan() {
-    displayTextLine("Scanning..");
+bool ble_scan_devices(int seconds, bool keep) {
+    if (!keep || bleDeviceTable.capacity() == 0) {
+        if (!bleDeviceTable.begin()) return false;
+    }
 
-    options = {};
     ble_scan_setup();
 #ifdef NIMBLE_V2_PLUS
-    BLEScanResults foundDevices = pBLEScan->getResults(scanTime * 1000, false);
-    for (int i = 0; i < foundDevices.getCount(); i++) {
-        const NimBLEAdvertisedDevice *advertisedDevice = foundDevices.getDevice(i);
-        String bt_title;
-        String bt_name;
-        String bt_address;
-        String bt_signal;
-
-        bt_name = advertisedDevice->getName().c_str();
-        bt_title = advertisedDevice->getName().c_str();
-        bt_address = advertisedDevice->getAddress().toString().c_str();
-        bt_signal = String(advertisedDevice->getRSSI());
-        // Serial.println("\n\nAddress - " + bt_address + "Name-"+ bt_name +"\n\n");
-        if (bt_title.isEmpty()) bt_title = bt_address;
-        if (bt_name.isEmpty()) bt_name = "<no name>";
-        // If BT name is empty, set NONAME
-        if (options.size() < 250)
-            options.emplace_back(bt_title.c_str(), [=]() { ble_info(bt_name, bt_address, bt_signal); });
-        else {
-            Serial.println("Memory low, stopping BLE scan...");
-            pBLEScan->stop();
-        }
-    }
+    pBLEScan->getResults(seconds * 1000, false);
 #else
-    BLEScanResults foundDevices = pBLEScan->start(scanTime, false);
+    pBLEScan->start(seconds, false);
 #endif
+    pBLEScan->clearResults();
+
+    // The scan object is shared, give it back with NimBLE defaults
+#ifdef NIMBLE_V2_PLUS
+    pBLEScan->setScanCallbacks(nullptr, false);
+#else
+    pBLEScan->setAdvertisedDeviceCallbacks(nullptr, false);
+#endif
+    pBLEScan->setMaxResults(0xFF);
+    return true;
+}
+
+void ble_scan() {
+    displayTextLine("Scanning..");
+
+    if (!ble_scan_devices(scanTime)) {
+        displayError("Out of memory", true);
+        return;
+    }
+
+    // Menu entries are only built now, from a snapshot of the table
+    std::vector<BLEDeviceEntry> devices;
+    bleDeviceTable.snapshot(devices);
+
+    options = {};
+    for (const BLEDeviceEntry &dev : devices) {
+        String bt_address = dev.address();
+        String bt_name = dev.name[0] != '\0' ? String(dev.name) : "<no name>";
+        String bt_title = dev.name[0] != '\0' ? String(dev.name) : bt_address;
+        String bt_signal = String(dev.rssi());
+        options.emplace_back(bt_title.c_str(), [=]() { ble_info(bt_name, bt_address, bt_signal); });
+    }
+    devices.clear();
+    devices.shrink_to_fit();
 
     addOptionToMainMenu();
 
     loopOptions(options);
     options.clear();
-
-    // Delete results fromBLEScan buffer to release memory
-    pBLEScan->clearResults();
 }
 
 bool initBLEServer() {
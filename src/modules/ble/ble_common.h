@@ -17,6 +17,9 @@ void ble_test();
 
 void ble_scan();
 
+// Scans for `seconds` into bleDeviceTable, `keep` merges with the previous results
+bool ble_scan_devices(int seconds, bool keep = false);
+
 void disPlayBLESend();
 
 #endif
@@ -0,0 +1,129 @@
+#include "ble_device_table.h"
+#include <algorithm>
+
+#if __has_include(<NimBLEExtAdvertising.h>)
+#define NIMBLE_V2_PLUS 1
+#endif
+
+BLEDeviceTable bleDeviceTable;
+
+String BLEDeviceEntry::address() const {
+    char buf[18];
+    snprintf(
+        buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x", addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]
+    );
+    return String(buf);
+}
+
+bool BLEDeviceTable::begin(size_t capacity) {
+    if (_entries != nullptr && _capacity == capacity) {
+        clear();
+        return true;
+    }
+    end();
+
+    _entries = (BLEDeviceEntry *)calloc(capacity, sizeof(BLEDeviceEntry));
+    if (_entries == nullptr) return false;
+    _capacity = capacity;
+    clear();
+    return true;
+}
+
+void BLEDeviceTable::end() {
+    portENTER_CRITICAL(&_mux);
+    BLEDeviceEntry *entries = _entries;
+    _entries = nullptr;
+    _capacity = 0;
+    _size = 0;
+    portEXIT_CRITICAL(&_mux);
+    free(entries);
+}
+
+void BLEDeviceTable::clear() {
+    portENTER_CRITICAL(&_mux);
+    if (_entries != nullptr) memset(_entries, 0, _capacity * sizeof(BLEDeviceEntry));
+    _size = 0;
+    _evictions = 0;
+    _advertisements = 0;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void BLEDeviceTable::update(const NimBLEAdvertisedDevice *device) {
+    // Everything that allocates is done before taking the lock
+    const NimBLEAddress &address = device->getAddress();
+#ifdef NIMBLE_V2_PLUS
+    const uint8_t *raw = address.getVal();
+#else
+    const uint8_t *raw = address.getNative();
+#endif
+    uint8_t addr[6];
+    for (int i = 0; i < 6; i++) addr[i] = raw[5 - i]; // NimBLE keeps it little endian
+    uint8_t addrType = address.getType();
+    int rssi = device->getRSSI();
+    std::string name = device->haveName() ? device->getName() : std::string();
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&_mux);
+    if (_entries == nullptr) {
+        portEXIT_CRITICAL(&_mux);
+        return;
+    }
+    _advertisements++;
+
+    BLEDeviceEntry *slot = nullptr;
+    BLEDeviceEntry *free_slot = nullptr;
+    BLEDeviceEntry *oldest = nullptr;
+    for (size_t i = 0; i < _capacity; i++) {
+        BLEDeviceEntry &e = _entries[i];
+        if (!e.used) {
+            if (free_slot == nullptr) free_slot = &e;
+            continue;
+        }
+        if (e.addrType == addrType && memcmp(e.addr, addr, 6) == 0) {
+            slot = &e;
+            break;
+        }
+        if (oldest == nullptr || (int32_t)(e.lastSeen - oldest->lastSeen) < 0) oldest = &e;
+    }
+
+    if (slot != nullptr) {
+        slot->rssiQ4 += ((rssi * 16) - slot->rssiQ4) >> BLE_RSSI_SHIFT;
+    } else {
+        if (free_slot != nullptr) {
+            slot = free_slot;
+            _size++;
+        } else {
+            slot = oldest;
+            _evictions++;
+        }
+        memset(slot, 0, sizeof(BLEDeviceEntry));
+        memcpy(slot->addr, addr, 6);
+        slot->addrType = addrType;
+        slot->used = true;
+        slot->rssiQ4 = rssi * 16;
+        slot->firstSeen = now;
+    }
+
+    slot->lastRssi = rssi;
+    slot->lastSeen = now;
+    if (slot->seen < UINT16_MAX) slot->seen++;
+    // Names usually only come in scan responses, keep the last one seen
+    if (!name.empty()) strlcpy(slot->name, name.c_str(), sizeof(slot->name));
+    portEXIT_CRITICAL(&_mux);
+}
+
+size_t BLEDeviceTable::snapshot(std::vector<BLEDeviceEntry> &out) {
+    out.clear();
+    out.reserve(_capacity); // no allocation may happen inside the critical section
+
+    portENTER_CRITICAL(&_mux);
+    for (size_t i = 0; i < _capacity; i++) {
+        if (_entries[i].used) out.push_back(_entries[i]);
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    std::sort(out.begin(), out.end(), [](const BLEDeviceEntry &a, const BLEDeviceEntry &b) {
+        return a.rssiQ4 > b.rssiQ4;
+    });
+    return out.size();
+}
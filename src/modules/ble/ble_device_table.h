@@ -0,0 +1,58 @@
+#ifndef __BLE_DEVICE_TABLE_H__
+#define __BLE_DEVICE_TABLE_H__
+
+#include <NimBLEAdvertisedDevice.h>
+#include <globals.h>
+#include <vector>
+
+#define BLE_TABLE_CAPACITY 128 // devices tracked at once, least recently seen is evicted
+#define BLE_TABLE_NAME_LEN 24
+#define BLE_RSSI_SHIFT 2       // EMA weight of a new sample = 1 / (1 << BLE_RSSI_SHIFT)
+
+struct BLEDeviceEntry {
+    uint8_t addr[6];
+    uint8_t addrType;
+    bool used;
+    int16_t rssiQ4;   // smoothed RSSI in 1/16 dBm
+    int8_t lastRssi;
+    uint16_t seen;    // advertisements received, saturates
+    uint32_t firstSeen;
+    uint32_t lastSeen;
+    char name[BLE_TABLE_NAME_LEN];
+
+    int rssi() const { return rssiQ4 / 16; }
+    String address() const;
+};
+
+class BLEDeviceTable {
+public:
+    BLEDeviceTable() {}
+    ~BLEDeviceTable() { end(); }
+
+    bool begin(size_t capacity = BLE_TABLE_CAPACITY);
+    void end(void);
+    void clear(void);
+
+    // Called from the NimBLE host task for every advertisement
+    void update(const NimBLEAdvertisedDevice *device);
+
+    // Copies the live entries, strongest smoothed RSSI first
+    size_t snapshot(std::vector<BLEDeviceEntry> &out);
+
+    size_t size(void) { return _size; }
+    size_t capacity(void) { return _capacity; }
+    uint32_t evictions(void) { return _evictions; }
+    uint32_t advertisements(void) { return _advertisements; }
+
+private:
+    BLEDeviceEntry *_entries = nullptr;
+    size_t _capacity = 0;
+    size_t _size = 0;
+    uint32_t _evictions = 0;
+    uint32_t _advertisements = 0;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+extern BLEDeviceTable bleDeviceTable;
+
+#endif
@@ -43,6 +43,8 @@ void BLE_API::update_mtu(uint16_t mtu) {
 }
 
 void BLE_API::end() {
+    // back to USB before the BLE console frees its buffers
+    serialDevice = &USBserial;
     battery_service.end();
     serial_service.end();
 #if defined(CONFIG_IDF_TARGET_ESP32C5)
@@ -50,6 +52,5 @@ void BLE_API::end() {
 #else
     BLEDevice::deinit();
 #endif
-    serialDevice = &USBserial;
 }
 #endif
@@ -1,20 +1,34 @@
 #if !defined(LITE_VERSION)
 #include "BLESerialService.h"
+#include "core/serialcmds.h"
 #include <NimBLEDevice.h>
 
-BLESerialService::BLESerialService() : BruceBLEService() {}
+BleSerialStats bleSerialStats;
 
-BLESerialService::~BLESerialService() {}
+BLESerialService::BLESerialService() : BruceBLEService() {}
 
-static bool newValue = false;
+BLESerialService::~BLESerialService() {
+    if (txLock) vSemaphoreDelete(txLock);
+}
 
 class BLESerialCallbacks : public NimBLECharacteristicCallbacks {
+    BLESerialService *service;
+
     void onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) override {
-        newValue = true;
+        NimBLEAttValue value = pCharacteristic->getValue();
+        service->received(value.data(), value.size());
+        serialCommandsNotify();
     }
+
+    // Once per notification handed to the controller, whatever the status
+    void onStatus(NimBLECharacteristic *pCharacteristic, int code) override { service->notifyDone(); }
+
+public:
+    explicit BLESerialCallbacks(BLESerialService *service) : service(service) {}
 };
 
 void BLESerialService::setup(NimBLEServer *pServer) {
+    server = pServer;
     pService = pServer->createService("4371ec0b-3d43-49f9-b731-7c72a4a7bb91");
 
     serial_char = pService->createCharacteristic(
@@ -22,34 +36,163 @@ void BLESerialService::setup(NimBLEServer *pServer) {
         NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::WRITE
     );
 
-    callbacks = new BLESerialCallbacks();
+    callbacks = new BLESerialCallbacks(this);
     serial_char->setCallbacks(callbacks);
 
+    txBuffer = xStreamBufferCreate(BLE_SERIAL_TX_BUFFER, 1);
+    rxBuffer = xStreamBufferCreate(BLE_SERIAL_RX_BUFFER, 1);
+    if (txLock == nullptr) txLock = xSemaphoreCreateMutex();
+    credits = xSemaphoreCreateCounting(BLE_SERIAL_INFLIGHT, BLE_SERIAL_INFLIGHT);
+    bleSerialStats.reset();
+    running = true;
+    xTaskCreate(txTaskFunc, "bleSerialTx", 4096, this, 2, &txTask);
+
     pService->start();
     pServer->getAdvertising()->addServiceUUID(pService->getUUID());
 }
 
-void BLESerialService::end() { delete callbacks; }
+void BLESerialService::end() {
+    running = false;
+    // the task sees it within its receive timeout
+    for (int i = 0; txTask != nullptr && i < 50; i++) vTaskDelay(pdMS_TO_TICKS(10));
+    // a write() may still be waiting up to BLE_SERIAL_WRITE_TIMEOUT_MS for room in txBuffer
+    if (txLock) xSemaphoreTake(txLock, portMAX_DELAY);
+    if (txBuffer) vStreamBufferDelete(txBuffer);
+    if (rxBuffer) vStreamBufferDelete(rxBuffer);
+    if (credits) vSemaphoreDelete(credits);
+    txBuffer = rxBuffer = nullptr;
+    credits = nullptr;
+    if (txLock) xSemaphoreGive(txLock);
+    delete callbacks;
+}
+
+void BLESerialService::txTaskFunc(void *pv) {
+    BLESerialService *service = static_cast<BLESerialService *>(pv);
+    service->sendLoop();
+    service->txTask = nullptr;
+    vTaskDelete(NULL);
+}
+
+void BLESerialService::sendLoop() {
+    uint8_t chunk[BLE_SERIAL_MAX_PAYLOAD];
+    uint32_t burstStart = 0;
+    uint32_t burstBytes = 0;
 
-int BLESerialService::available() {
-    if (!newValue) return 0;
-    newValue = false;
+    while (running) {
+        size_t payload = min<size_t>(mtu > 23 ? mtu - 3 : 20, BLE_SERIAL_MAX_PAYLOAD);
+        size_t n = xStreamBufferReceive(txBuffer, chunk, payload, pdMS_TO_TICKS(100));
+        if (n == 0) continue;
+        txHeld = n;
+        if (burstStart == 0) {
+            burstStart = millis();
+            burstBytes = 0;
+        }
+
+        // fill the notification unless the output stops for BLE_SERIAL_COALESCE_MS
+        uint32_t waitStart = millis();
+        while (n < payload && !flushing && millis() - waitStart < BLE_SERIAL_COALESCE_MS) {
+            size_t more = xStreamBufferReceive(
+                txBuffer, chunk + n, payload - n, pdMS_TO_TICKS(BLE_SERIAL_COALESCE_MS)
+            );
+            if (more == 0) break;
+            n += more;
+            txHeld = n;
+        }
+
+        if (notifyChunk(chunk, n)) {
+            bleSerialStats.txBytes += n;
+            bleSerialStats.notifications++;
+            burstBytes += n;
+        } else {
+            bleSerialStats.txDropped += n;
+        }
+        txHeld = 0;
+
+        if (xStreamBufferIsEmpty(txBuffer)) {
+            uint32_t ms = millis() - burstStart;
+            bleSerialStats.busyMs += ms;
+            bleSerialStats.lastBurstBytes = burstBytes;
+            bleSerialStats.lastBurstMs = ms;
+            burstStart = 0;
+        }
+    }
+}
+
+bool BLESerialService::connected() { return server != nullptr && server->getConnectedCount() > 0; }
+
+bool BLESerialService::notifyChunk(const uint8_t *data, size_t size) {
+    uint32_t start = millis();
+    while (running && connected()) {
+        // a status that never came costs BLE_SERIAL_STATUS_TIMEOUT_MS, not the credit
+        xSemaphoreTake(credits, pdMS_TO_TICKS(BLE_SERIAL_STATUS_TIMEOUT_MS));
+        if (serial_char->notify(data, size)) return true;
+
+        // out of buffers in the stack, wait for it to send some
+        xSemaphoreGive(credits);
+        bleSerialStats.stalls++;
+        if (millis() - start > BLE_SERIAL_WRITE_TIMEOUT_MS) break;
+        vTaskDelay(1);
+    }
+    return false;
+}
 
-    return serial_char->getValue().size();
+void BLESerialService::notifyDone() {
+    if (credits) xSemaphoreGive(credits);
+}
+
+void BLESerialService::received(const uint8_t *data, size_t size) {
+    if (rxBuffer == nullptr) return;
+    size_t n = xStreamBufferSend(rxBuffer, data, size, 0);
+    bleSerialStats.rxBytes += n;
+    bleSerialStats.rxDropped += size - n;
+}
+
+int BLESerialService::available() { return rxBuffer ? xStreamBufferBytesAvailable(rxBuffer) : 0; }
+
+int BLESerialService::read() {
+    uint8_t c;
+    if (rxBuffer == nullptr || xStreamBufferReceive(rxBuffer, &c, 1, 0) == 0) return -1;
+    return c;
+}
+
+size_t BLESerialService::write(const uint8_t *str, size_t size) {
+    if (!running || txBuffer == nullptr) return 0;
+    if (!connected()) {
+        bleSerialStats.txDropped += size;
+        return size;
+    }
+    size_t left = size;
+    xSemaphoreTake(txLock, portMAX_DELAY);
+    while (running && txBuffer != nullptr && left > 0) {
+        // half the buffer at a time, the task drains it while we wait for the rest
+        size_t piece = min<size_t>(left, BLE_SERIAL_TX_BUFFER / 2);
+        size_t n = xStreamBufferSend(txBuffer, str, piece, pdMS_TO_TICKS(BLE_SERIAL_WRITE_TIMEOUT_MS));
+        if (n == 0) break;
+        str += n;
+        left -= n;
+    }
+    xSemaphoreGive(txLock);
+    bleSerialStats.txDropped += left;
+    return size;
+}
+
+size_t BLESerialService::write(uint8_t *str, size_t size) { return write((const uint8_t *)str, size); }
+
+void BLESerialService::flush() {
+    if (!running || txBuffer == nullptr) return;
+    flushing = true;
+    uint32_t start = millis();
+    while ((!xStreamBufferIsEmpty(txBuffer) || txHeld > 0) && millis() - start < BLE_SERIAL_WRITE_TIMEOUT_MS)
+        vTaskDelay(1);
+    flushing = false;
 }
 
 size_t BLESerialService::println(const String &s) {
     String toSend = s + "\r\n";
-    serial_char->notify(toSend);
-    vTaskDelay(pdMS_TO_TICKS(10)); // Add some delay to ensure data is read by the client
-    return toSend.length();
+    return write((const uint8_t *)toSend.c_str(), toSend.length());
 }
 
-size_t BLESerialService::print(const String &s) {
-    serial_char->notify(s);
-    vTaskDelay(pdMS_TO_TICKS(10));
-    return s.length();
-}
+size_t BLESerialService::print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
 
 size_t BLESerialService::println(size_t n) {
     String s = String(n);
@@ -57,21 +200,38 @@ size_t BLESerialService::println(size_t n) {
 }
 
 void BLESerialService::vprintf(const char *fmt, va_list args) {
-    int size = sprintf(nullptr, fmt, args);
     char str[BUFFER_SIZE];
-    sprintf(str, fmt, args);
+    va_list copy;
+    va_copy(copy, args);
+    int size = vsnprintf(str, sizeof(str), fmt, copy);
+    va_end(copy);
+    if (size < 0) return;
+    if (size < (int)sizeof(str)) {
+        write((const uint8_t *)str, size);
+        return;
+    }
 
-    serial_char->notify(reinterpret_cast<const uint8_t *>(str), size);
-    vTaskDelay(pdMS_TO_TICKS(10));
+    char *big = (char *)malloc(size + 1);
+    if (big == nullptr) return;
+    vsnprintf(big, size + 1, fmt, args);
+    write((const uint8_t *)big, size);
+    free(big);
 }
 
 String BLESerialService::readStringUntil(char terminator) {
-    Serial.println("readStringUntil");
     String result = "";
-    std::string value = serial_char->getValue();
-    for (char c : value) {
-        result += c;
+    if (rxBuffer == nullptr) return result;
+    // a line written in several pieces is read whole, one without terminator after BLE_SERIAL_LINE_MS
+    uint32_t last = millis();
+    while (millis() - last < BLE_SERIAL_LINE_MS) {
+        char c;
+        if (xStreamBufferReceive(rxBuffer, &c, 1, 0) == 0) {
+            vTaskDelay(1);
+            continue;
+        }
         if (c == terminator) break;
+        result += c;
+        last = millis();
     }
     return result;
 }
@@ -93,12 +253,6 @@ size_t BLESerialService::println(const int n, int format) {
 
 size_t BLESerialService::println() { return println(""); }
 
-size_t BLESerialService::write(uint8_t *str, size_t size) {
-    serial_char->notify(str, size);
-    vTaskDelay(pdMS_TO_TICKS(10));
-    return size;
-}
-
 void BLESerialService::setMTU(uint16_t mtu) { this->mtu = mtu; }
 
 #endif
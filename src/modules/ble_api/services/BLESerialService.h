@@ -3,14 +3,67 @@
 #include "BruceBLEService.hpp"
 
 #include <SerialDevice.h>
+#include <freertos/semphr.h>
+#include <freertos/stream_buffer.h>
 
 #define BUFFER_SIZE 128
 
+#define BLE_SERIAL_TX_BUFFER 4096       // output waiting for a notification
+#define BLE_SERIAL_RX_BUFFER 1024       // received writes not read yet
+#define BLE_SERIAL_MAX_PAYLOAD 512      // notification payload cap, MTU - 3 below that
+#define BLE_SERIAL_COALESCE_MS 5        // a short notification waits this long for more output
+#define BLE_SERIAL_INFLIGHT 4           // notifications handed to the stack and not reported sent yet
+#define BLE_SERIAL_STATUS_TIMEOUT_MS 50 // a notification without a status after this counts as sent
+#define BLE_SERIAL_WRITE_TIMEOUT_MS 500 // print() waits this long for room, then drops the rest
+#define BLE_SERIAL_LINE_MS 20           // readStringUntil() waits this long for the rest of a line
+
+// What the BLE console sent and received since it started or the last reset
+struct BleSerialStats {
+    uint32_t txBytes = 0;
+    uint32_t notifications = 0;
+    uint32_t stalls = 0;    // notify() refused for lack of buffers, retried
+    uint32_t txDropped = 0; // output lost: no client, or the client stopped reading
+    uint32_t rxBytes = 0;
+    uint32_t rxDropped = 0;
+    uint32_t busyMs = 0;         // time with output pending, for the sustained rate
+    uint32_t lastBurstBytes = 0; // last run of output until the buffer drained, a file read say
+    uint32_t lastBurstMs = 0;
+
+    void reset(void) { *this = BleSerialStats(); }
+};
+
+extern BleSerialStats bleSerialStats;
+
 class BLESerialCallbacks;
 
+/*
+ * BLE console. Output goes through a stream buffer that a task drains into
+ * notifications of MTU - 3 bytes, a short one only after BLE_SERIAL_COALESCE_MS
+ * without more output. At most BLE_SERIAL_INFLIGHT notifications wait for their
+ * status from the stack, instead of sleeping after each one. Writes from the
+ * client land in a receive ring read by available() and readStringUntil().
+ */
 class BLESerialService : public BruceBLEService, public SerialDevice {
     NimBLECharacteristic *serial_char = nullptr;
     BLESerialCallbacks *callbacks = nullptr;
+    NimBLEServer *server = nullptr;
+    StreamBufferHandle_t txBuffer = nullptr;
+    StreamBufferHandle_t rxBuffer = nullptr;
+    SemaphoreHandle_t txLock = nullptr;  // one writer at a time, kept until the service is destroyed
+    SemaphoreHandle_t credits = nullptr; // notifications that may be in flight
+    TaskHandle_t txTask = nullptr;
+    volatile bool running = false;
+    volatile uint16_t txHeld = 0; // bytes the task took out and has not sent yet
+    volatile bool flushing = false; // send short notifications right away
+
+    static void txTaskFunc(void *pv);
+    void sendLoop(void);
+    bool notifyChunk(const uint8_t *data, size_t size);
+    bool connected(void);
+
+    friend class BLESerialCallbacks;
+    void received(const uint8_t *data, size_t size);
+    void notifyDone(void);
 
 public:
     BLESerialService();
@@ -26,9 +79,12 @@ public:
     void vprintf(const char *str, va_list args) override;
     size_t println(uint32_t n) override;
     size_t write(uint8_t *str, size_t size) override;
-    void flush() override {}
+    size_t write(const uint8_t *str, size_t size);
+    // Waits until the buffered output was handed to the stack
+    void flush() override;
     String readStringUntil(char terminator) override;
     int available() override;
+    int read() override;
     void setMTU(uint16_t mtu);
 };
 #endif
@@ -24,6 +24,7 @@
 #include "modules/ethernet/MACFlooding.h"
 #include <ETH.h>
 #endif
+#include <algorithm>
 #include <globals.h>
 #include <sstream>
 void run_arp_scanner() {
@@ -39,8 +40,10 @@ void run_arp_scanner() {
 #endif
 }
 
-ARPScanner::ARPScanner(esp_netif_t *_esp_net_interface) {
+ARPScanner::ARPScanner(esp_netif_t *_esp_net_interface, uint8_t inFlight, uint8_t retries) {
     esp_net_interface = _esp_net_interface;
+    maxInFlight = constrain(inFlight, 1, ARP_SCAN_MAX_IN_FLIGHT);
+    maxRetries = retries;
     setup();
 }
 
@@ -73,10 +76,146 @@ void toBytes(IPAddress ip, uint8_t *bytes) {
 void ARPScanner::readArpTableETH(netif *iface) {
     for (uint32_t i = 0; i < ARP_TABLE_SIZE; ++i) {
         ip4_addr_t *ip_ret;
+        netif *netif_ret;
         eth_addr *eth_ret;
-        if (etharp_get_entry(i, &ip_ret, &iface, &eth_ret)) { hostslist_eth.emplace_back(ip_ret, eth_ret); }
+        if (!etharp_get_entry(i, &ip_ret, &netif_ret, &eth_ret) || netif_ret != iface) continue;
+        IPAddress ip(ip_ret->addr);
+        auto it = std::find_if(hostslist_eth.begin(), hostslist_eth.end(), [&ip](const Host &host) {
+            return host.ip == ip;
+        });
+        if (it == hostslist_eth.end()) hostslist_eth.emplace_back(ip_ret, eth_ret);
     }
-    etharp_cleanup_netif(iface);
+}
+
+bool ARPScanner::isAnswered(uint32_t ip) {
+    uint32_t idx = ip - sweepFirst;
+    return answered[idx >> 3] & (1 << (idx & 7));
+}
+
+// Single pass over the ARP table: every new entry inside the sweep range is a
+// host that answered. Matching requests are retired and feed the RTT estimate.
+void ARPScanner::harvestArpTable(netif *iface) {
+    uint32_t now = millis();
+
+    LOCK_TCPIP_CORE();
+    for (uint32_t i = 0; i < ARP_TABLE_SIZE; ++i) {
+        ip4_addr_t *ip_ret;
+        netif *netif_ret;
+        eth_addr *eth_ret;
+        if (!etharp_get_entry(i, &ip_ret, &netif_ret, &eth_ret) || netif_ret != iface) continue;
+
+        uint32_t ip = ntohl(ip_ret->addr);
+        if (ip < sweepFirst || ip > sweepLast || isAnswered(ip)) continue;
+
+        uint32_t idx = ip - sweepFirst;
+        answered[idx >> 3] |= 1 << (idx & 7);
+        hostslist_eth.emplace_back(ip_ret, eth_ret);
+        lastFound = hostslist_eth.back().ip.toString();
+
+        for (auto it = pending.begin(); it != pending.end(); ++it) {
+            if (it->ip != ip) continue;
+            uint32_t rtt = now - it->sentAt;
+            rttAvg = rttAvg == 0 ? rtt : (rttAvg * 7 + rtt) / 8;
+            pending.erase(it);
+            break;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+}
+
+// Keeps up to maxInFlight requests outstanding, harvesting the ARP table between
+// refills. Requests that time out are retried in up to maxRetries extra passes.
+void ARPScanner::sweep(netif *iface, uint32_t first, uint32_t last, uint32_t self) {
+    const uint32_t total = last - first + 1;
+    sweepFirst = first;
+    sweepLast = last;
+    answered.assign((total + 7) / 8, 0);
+    pending.clear();
+    pending.reserve(maxInFlight);
+    rttAvg = 0;
+    lastFound = "";
+
+    uint32_t requests = 0;
+    uint32_t retries = 0;
+    uint32_t lastUpdate = 0;
+    uint32_t start = millis();
+    bool aborted = false;
+
+    for (uint8_t pass = 0; pass <= maxRetries && !aborted; pass++) {
+        uint32_t cursor = first;
+        while (true) {
+            LOCK_TCPIP_CORE();
+            while (pending.size() < maxInFlight && cursor <= last) {
+                uint32_t ip = cursor;
+                if (ip == self || isAnswered(ip)) {
+                    cursor++;
+                    continue;
+                }
+                ip4_addr_t ip_be{htonl(ip)};
+                if (etharp_request(iface, &ip_be) != ERR_OK) break; // out of buffers, retry on next round
+                pending.push_back({ip, millis()});
+                cursor++;
+                requests++;
+                if (pass > 0) retries++;
+            }
+            UNLOCK_TCPIP_CORE();
+
+            if (pending.empty() && cursor > last) break;
+
+            vTaskDelay(1);
+            harvestArpTable(iface);
+
+            // Adaptive timeout from the replies seen so far
+            uint32_t timeout = rttAvg == 0 ? 100 : rttAvg * 4;
+            timeout = constrain(timeout, ARP_SCAN_MIN_TIMEOUT, ARP_SCAN_MAX_TIMEOUT);
+            uint32_t now = millis();
+            pending.erase(
+                std::remove_if(
+                    pending.begin(),
+                    pending.end(),
+                    [now, timeout](const PendingRequest &req) { return now - req.sentAt > timeout; }
+                ),
+                pending.end()
+            );
+
+            if (millis() - lastUpdate > 250) {
+                String msg = (pass == 0 ? "Probing " : "Retrying ") + String(cursor - first) + "/" +
+                             String(total) + ", " + String(hostslist_eth.size()) + " found";
+                if (lastFound != "") msg += " " + lastFound;
+                displayRedStripe(msg, getComplementaryColor2(bruceConfig.priColor), bruceConfig.priColor);
+                lastUpdate = millis();
+            }
+
+            if (check(EscPress)) {
+                aborted = true;
+                break;
+            }
+        }
+    }
+
+    // Late replies still land in the table
+    vTaskDelay(ARP_SCAN_MIN_TIMEOUT / portTICK_PERIOD_MS);
+    harvestArpTable(iface);
+
+    uint32_t elapsed = millis() - start;
+    uint8_t prefix = __builtin_clz(total + 1);
+    Serial.printf(
+        "ARP sweep /%u%s: %lu addresses, %lu requests (%lu retries), %lu in flight, %lu ms, %.1f hosts/s, "
+        "rtt %lu ms, %u found\n",
+        prefix,
+        aborted ? " (aborted)" : "",
+        total,
+        requests,
+        retries,
+        (uint32_t)maxInFlight,
+        elapsed,
+        elapsed ? total * 1000.0f / elapsed : 0,
+        rttAvg,
+        hostslist_eth.size()
+    );
+    displayInfo(String(hostslist_eth.size()) + " hosts in " + String(elapsed / 1000.0f, 1) + "s");
+    answered.clear();
+    answered.shrink_to_fit();
 }
 
 #include "ARPSpoofer.h"
@@ -127,7 +266,6 @@ void ping_target(ip_addr_t target) {
 }
 
 void ARPScanner::setup() {
-    LOCK_TCPIP_CORE();
     hostslist_eth.clear();
 
     options.clear();
@@ -151,8 +289,14 @@ void ARPScanner::setup() {
     ip_info.netmask.addr = ntohl(ip_info.netmask.addr);
     gateway = ip_info.gw.addr;
 
-    const uint32_t networkAddress = ntohl(gateway) & ip_info.netmask.addr;
-    const uint32_t broadcast = networkAddress | ~ip_info.netmask.addr;
+    uint32_t netmask = ip_info.netmask.addr;
+    if (~netmask > ARP_SCAN_MAX_HOSTS + 1) netmask = 0xFFFF0000;
+    const uint32_t networkAddress = ip_info.ip.addr & netmask;
+    const uint32_t broadcast = networkAddress | ~netmask;
+    if (broadcast - networkAddress < 2) {
+        Serial.println("Subnet has no hosts to scan");
+        return;
+    }
 
     // get iface
     struct netif *net_iface = (struct netif *)esp_netif_get_netif_impl(esp_net_interface);
@@ -162,48 +306,12 @@ void ARPScanner::setup() {
         return;
     }
 
-    etharp_cleanup_netif(net_iface); // to avoid gateway duplication
-
-    // send arp requests, read table each ARP_TABLE_SIZE requests
-    uint16_t tableReadCounter = 0;
-    uint32_t hostsScanned = 0;
-    const uint32_t totalHosts = broadcast - networkAddress - 1;
-    static uint32_t lastUpdate = 0;
-
-    for (uint32_t ip_le = networkAddress + 1; ip_le < broadcast; ip_le++) {
-        if (ip_le == ip_info.ip.addr || ip_le == gateway) continue;
-
-        ip4_addr_t ip_be{htonl(ip_le)}; // big endian
-
-        hostsScanned++;
-        if (millis() - lastUpdate > 500) { // Update display every 500ms
-            displayRedStripe(
-                "Probing " + String(hostsScanned) + " of " + String(totalHosts) + " hosts",
-                getComplementaryColor2(bruceConfig.priColor),
-                bruceConfig.priColor
-            );
-            lastUpdate = millis();
-        }
-
-        err_t res = etharp_request(net_iface, &ip_be);
-
-        if (res != ERR_OK) {
-            Serial.println("Arp req for: " + IPAddress(ip_be.addr).toString() + "failed with ec: " + res);
-        } else {
-            ++tableReadCounter;
-        }
+    LOCK_TCPIP_CORE();
+    etharp_cleanup_netif(net_iface); // start from an empty table so every entry is a reply
+    UNLOCK_TCPIP_CORE();
 
-        vTaskDelay(arpRequestDelay);
+    sweep(net_iface, networkAddress + 1, broadcast - 1, ip_info.ip.addr);
 
-        // read table if we sent ARP_TABLE_SIZE requests
-        if (tableReadCounter == ARP_TABLE_SIZE) {
-            readArpTableETH(net_iface);
-            tableReadCounter = 0;
-        }
-        // Stops search on EscPress
-        if (check(EscPress)) break;
-    }
-    UNLOCK_TCPIP_CORE();
     auto it = std::find_if(hostslist_eth.begin(), hostslist_eth.end(), [this](const Host &host) {
         return host.ip == gateway;
     });
@@ -213,6 +321,7 @@ void ARPScanner::setup() {
         ip_addr_t target;
         target.type = IPADDR_TYPE_V4;
         target.u_addr.ip4.addr = gateway;
+        wait_ping = true;
         ping_target(target); // Ping target to force ARP request
 
         while (wait_ping) { delay(1); }
@@ -222,12 +331,14 @@ void ARPScanner::setup() {
         ip4_addr_t gateway_ip;
         gateway_ip.addr = gateway;
 
+        LOCK_TCPIP_CORE();
         // Search gateway in the ARP table
         s8_t arp_find_result = etharp_find_addr(net_iface, &gateway_ip, &eth_ret, &ipaddr_ret);
 
         if (arp_find_result < 0) { Serial.println("Gateway MAC not found."); }
 
         readArpTableETH(net_iface); // Update hostlists
+        UNLOCK_TCPIP_CORE();
     }
 
 ScanHostMenu:
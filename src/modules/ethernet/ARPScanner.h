@@ -3,19 +3,44 @@
 
 #include "Arduino.h"
 #include "IPAddress.h"
+#include "lwip/opt.h"
 #include "modules/wifi/scan_hosts.h"
 #include "stdint.h"
 #include <set>
 #include <vector>
 
+// every reply holds an ARP table entry until the next harvest, two are left for the gateway and live traffic
+#define ARP_SCAN_MAX_IN_FLIGHT (ARP_TABLE_SIZE > 4 ? ARP_TABLE_SIZE - 2 : 2)
+#define ARP_SCAN_IN_FLIGHT ARP_SCAN_MAX_IN_FLIGHT // requests outstanding at once
+#define ARP_SCAN_RETRIES 1       // extra passes over the addresses that did not answer
+#define ARP_SCAN_MIN_TIMEOUT 30  // ms, bounds of the adaptive reply timeout
+#define ARP_SCAN_MAX_TIMEOUT 500 // ms
+#define ARP_SCAN_MAX_HOSTS 65534 // larger subnets are limited to the /16 around our address
+
 class ARPScanner {
 private:
+    struct PendingRequest {
+        uint32_t ip; // little endian
+        uint32_t sentAt;
+    };
+
     esp_netif_t *esp_net_interface;
-    TickType_t arpRequestDelay =
-        20u / portTICK_PERIOD_MS; // can be relatively low, helps to not overwhelm the stream
+    uint8_t maxInFlight = ARP_SCAN_IN_FLIGHT;
+    uint8_t maxRetries = ARP_SCAN_RETRIES;
+
+    // sweep state
+    uint32_t sweepFirst = 0;
+    uint32_t sweepLast = 0;
+    std::vector<uint8_t> answered; // one bit per address in the sweep
+    std::vector<PendingRequest> pending;
+    uint32_t rttAvg = 0;
+    String lastFound = "";
 
     void setup();
     void readArpTableETH(netif *iface);
+    void sweep(netif *iface, uint32_t first, uint32_t last, uint32_t self);
+    void harvestArpTable(netif *iface);
+    bool isAnswered(uint32_t ip);
     IPAddress gateway;
 
     std::vector<Host> hostslist_eth;
@@ -24,7 +49,11 @@ private:
 
 public:
     ARPScanner() {};
-    ARPScanner(esp_netif_t *esp_net_interface);
+    ARPScanner(
+        esp_netif_t *esp_net_interface,
+        uint8_t inFlight = ARP_SCAN_IN_FLIGHT,
+        uint8_t retries = ARP_SCAN_RETRIES
+    );
     ~ARPScanner();
 };
 
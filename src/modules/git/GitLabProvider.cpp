@@ -1,5 +1,27 @@
 #include "GitLabProvider.h"
 
+// Fields read by parseRepoFromJson and parseIssueFromJson, the rest of each listing item is skipped
+static JsonDocument repoFilter() {
+    JsonDocument filter;
+    for (const char* key : {"name", "path_with_namespace", "description", "http_url_to_repo", "ssh_url_to_repo",
+                            "web_url", "visibility", "default_branch", "star_count", "forks_count"}) {
+        filter[key] = true;
+    }
+    return filter;
+}
+
+static JsonDocument issueFilter() {
+    JsonDocument filter;
+    for (const char* key : {"iid", "title", "description", "state", "created_at", "updated_at", "web_url",
+                            "labels", "user_notes_count", "merge_request_iid"}) {
+        filter[key] = true;
+    }
+    filter["author"]["username"] = true;
+    filter["assignees"][0]["username"] = true;
+    filter["milestone"]["title"] = true;
+    return filter;
+}
+
 GitLabProvider::GitLabProvider() {
     config.authenticated = false;
     config.apiBaseUrl = GITLAB_API_BASE;
@@ -71,13 +93,10 @@ std::vector<GitRepository> GitLabProvider::listUserRepos() {
     }
     
     String url = buildUrl("/projects", "membership=true&per_page=100");
-    
-    if (!makeRequest("GET", url)) {
-        return repos;
-    }
-    
-    String response = http.getString();
-    parseReposArray(response, repos);
+    fetchList(url, repoFilter(), [this, &repos](JsonObjectConst item) {
+        GitRepository repo;
+        if (parseRepoFromJson(item, repo)) repos.push_back(repo);
+    });
     
     return repos;
 }
@@ -155,13 +174,10 @@ std::vector<GitIssue> GitLabProvider::listIssues(const String& owner, const Stri
     }
     
     String url = buildUrl("/projects/" + projectId + "/issues", "state=" + state + "&per_page=100");
-    
-    if (!makeRequest("GET", url)) {
-        return issues;
-    }
-    
-    String response = http.getString();
-    parseIssuesArray(response, issues);
+    fetchList(url, issueFilter(), [this, &issues](JsonObjectConst item) {
+        GitIssue issue;
+        if (parseIssueFromJson(item, issue)) issues.push_back(issue);
+    });
     
     return issues;
 }
@@ -626,13 +642,10 @@ std::vector<GitRepository> GitLabProvider::searchRepositories(const String& quer
     }
     
     String url = buildUrl("/projects", "search=" + urlEncode(query) + "&per_page=" + String(perPage));
-    
-    if (!makeRequest("GET", url)) {
-        return repos;
-    }
-    
-    String response = http.getString();
-    parseReposArray(response, repos);
+    fetchList(url, repoFilter(), [this, &repos](JsonObjectConst item) {
+        GitRepository repo;
+        if (parseRepoFromJson(item, repo)) repos.push_back(repo);
+    }, nullptr, 1);
     
     return repos;
 }
@@ -684,6 +697,15 @@ bool GitLabProvider::makeRequest(const String& method, const String& url, const
     return success;
 }
 
+bool GitLabProvider::fetchList(const String& url, const JsonDocument& filter, const GitItemHandler& onItem, const char* arrayKey, uint8_t maxPages) {
+    GitRequestSetup setup = [this](HTTPClient& client) {
+        client.setUserAgent(GITLAB_USER_AGENT);
+        client.setTimeout(10000);
+        setAuthHeader(config.token);
+    };
+    return gitFetchList(http, url, setup, filter, onItem, lastError, responseCode, arrayKey, maxPages);
+}
+
 String GitLabProvider::buildUrl(const String& endpoint, const String& params) {
     String url = config.apiBaseUrl;
     
@@ -738,6 +760,10 @@ bool GitLabProvider::parseRepoFromJson(const String& json, GitRepository& repo)
         return false;
     }
     
+    return parseRepoFromJson(doc.as<JsonObjectConst>(), repo);
+}
+
+bool GitLabProvider::parseRepoFromJson(JsonObjectConst doc, GitRepository& repo) {
     repo.name = doc["name"].as<String>();
     repo.fullName = doc["path_with_namespace"].as<String>();
     repo.description = doc["description"].as<String>();
@@ -760,6 +786,10 @@ bool GitLabProvider::parseIssueFromJson(const String& json, GitIssue& issue) {
         return false;
     }
     
+    return parseIssueFromJson(doc.as<JsonObjectConst>(), issue);
+}
+
+bool GitLabProvider::parseIssueFromJson(JsonObjectConst doc, GitIssue& issue) {
     issue.number = doc["iid"];
     issue.title = doc["title"].as<String>();
     issue.body = doc["description"].as<String>();
@@ -774,16 +804,16 @@ bool GitLabProvider::parseIssueFromJson(const String& json, GitIssue& issue) {
     
     // Parse labels
     if (doc.containsKey("labels")) {
-        JsonArray labelArray = doc["labels"];
-        for (JsonVariant label : labelArray) {
+        JsonArrayConst labelArray = doc["labels"];
+        for (JsonVariantConst label : labelArray) {
             issue.labels.push_back(label.as<String>());
         }
     }
     
     // Parse assignees
     if (doc.containsKey("assignees")) {
-        JsonArray assigneeArray = doc["assignees"];
-        for (JsonObject assignee : assigneeArray) {
+        JsonArrayConst assigneeArray = doc["assignees"];
+        for (JsonObjectConst assignee : assigneeArray) {
             issue.assignees.push_back(assignee["username"].as<String>());
         }
     }
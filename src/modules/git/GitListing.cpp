@@ -0,0 +1,202 @@
+#include "GitListing.h"
+#include "core/sd_functions.h"
+#include <esp_rom_crc.h>
+
+GitListingStats gitListingStats;
+
+namespace {
+
+// Reads the body in blocks, counting it and copying it to the cache file when there is one
+class GitBodyStream : public Stream {
+public:
+    GitBodyStream(Stream& in, File* copy) : _in(in), _copy(copy) {}
+
+    int available() override { return (_len - _pos) + _in.available(); }
+    int peek() override { return fill() ? _buf[_pos] : -1; }
+    int read() override { return fill() ? _buf[_pos++] : -1; }
+
+    using Stream::readBytes;
+    size_t readBytes(char* buffer, size_t length) override {
+        size_t n = 0;
+        while (n < length && fill()) {
+            size_t k = min(length - n, _len - _pos);
+            memcpy(buffer + n, _buf + _pos, k);
+            _pos += k;
+            n += k;
+        }
+        return n;
+    }
+
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+
+    uint32_t bytes() const { return _bytes; }
+
+private:
+    Stream& _in;
+    File* _copy;
+    uint8_t _buf[512];
+    size_t _len = 0;
+    size_t _pos = 0;
+    uint32_t _bytes = 0;
+
+    bool fill() {
+        if (_pos < _len) return true;
+        // take what already arrived, wait for a single byte otherwise
+        size_t want = constrain(_in.available(), 1, (int)sizeof(_buf));
+        _len = _in.readBytes((char*)_buf, want);
+        _pos = 0;
+        if (_len == 0) return false;
+        _bytes += _len;
+        if (_copy && *_copy) _copy->write(_buf, _len);
+        return true;
+    }
+};
+
+// Skips to the array, then parses one element at a time
+bool parseArray(Stream& s, const JsonDocument& filter, const char* arrayKey, const GitItemHandler& onItem) {
+    if (arrayKey && !s.find(("\"" + String(arrayKey) + "\"").c_str())) return false;
+    if (!s.find("[")) return false;
+
+    JsonDocument doc;
+    while (true) {
+        while (isspace(s.peek())) s.read();
+        if (s.peek() == ']') return true;
+        DeserializationError err = deserializeJson(doc, s, DeserializationOption::Filter(filter));
+        if (err) return false;
+        onItem(doc.as<JsonObjectConst>());
+        gitListingStats.items++;
+        if (!s.findUntil(",", "]")) return true;
+    }
+}
+
+String nextFromLink(const String& link) {
+    int rel = link.indexOf("rel=\"next\"");
+    if (rel < 0) return "";
+    int end = link.lastIndexOf('>', rel);
+    int start = end < 0 ? -1 : link.lastIndexOf('<', end);
+    if (start < 0) return "";
+    return link.substring(start + 1, end);
+}
+
+// Gitee gives the page count instead of links, the next page is page=<n + 1> of the same URL
+String nextFromPageCount(const String& url, int totalPages) {
+    int page = 1;
+    int at = url.indexOf("page=");
+    while (at > 0 && url[at - 1] != '?' && url[at - 1] != '&') at = url.indexOf("page=", at + 1);
+    if (at > 0) page = url.substring(at + 5).toInt();
+    if (page >= totalPages) return "";
+    if (at < 0) return url + (url.indexOf('?') < 0 ? "?" : "&") + "page=" + String(page + 1);
+    int end = url.indexOf('&', at);
+    return url.substring(0, at) + "page=" + String(page + 1) + (end < 0 ? "" : url.substring(end));
+}
+
+String cachePath(const String& url, const char* ext) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)url.c_str(), url.length());
+    char name[9];
+    snprintf(name, sizeof(name), "%08lx", (unsigned long)crc);
+    return String(GIT_CACHE_DIR "/") + name + ext;
+}
+
+// The .etag file holds the ETag line then the next page line
+bool readCacheMeta(const String& url, String& etag, String& next) {
+    File f = SD.open(cachePath(url, ".etag"), FILE_READ);
+    if (!f) return false;
+    etag = f.readStringUntil('\n');
+    next = f.readStringUntil('\n');
+    f.close();
+    return etag.length() > 0 && SD.exists(cachePath(url, ".json"));
+}
+
+void writeCacheMeta(const String& url, const String& etag, const String& next) {
+    File f = SD.open(cachePath(url, ".etag"), FILE_WRITE, true);
+    if (!f) return;
+    f.print(etag + "\n" + next + "\n");
+    f.close();
+}
+
+void createCacheDir() {
+    if (SD.exists(GIT_CACHE_DIR)) return;
+    if (!SD.exists("/BruceGit")) SD.mkdir("/BruceGit");
+    SD.mkdir(GIT_CACHE_DIR);
+}
+
+} // namespace
+
+bool gitFetchList(
+    HTTPClient& http, const String& url, const GitRequestSetup& setup, const JsonDocument& filter,
+    const GitItemHandler& onItem, String& error, int& responseCode, const char* arrayKey, uint8_t maxPages
+) {
+    gitListingStats = GitListingStats();
+    error = "";
+    bool useCache = setupSdCard();
+    if (useCache) createCacheDir();
+
+    String pageUrl = url;
+    bool ok = true;
+    while (ok && pageUrl.length() > 0 && gitListingStats.pages < maxPages) {
+        String etag, cachedNext;
+        bool cached = useCache && readCacheMeta(pageUrl, etag, cachedNext);
+
+        http.useHTTP10(true); // no chunked encoding, the body is parsed straight from the socket
+        http.begin(pageUrl);
+        setup(http);
+        const char* keys[] = {"ETag", "Link", "total_page"};
+        http.collectHeaders(keys, 3);
+        if (cached) http.addHeader("If-None-Match", etag);
+        responseCode = http.GET();
+        gitListingStats.pages++;
+
+        uint32_t start = millis();
+        String next;
+        if (responseCode == HTTP_CODE_NOT_MODIFIED && cached) {
+            File body = SD.open(cachePath(pageUrl, ".json"), FILE_READ);
+            GitBodyStream stream(body, nullptr);
+            ok = body && parseArray(stream, filter, arrayKey, onItem);
+            gitListingStats.cachedBytes += stream.bytes();
+            gitListingStats.notModified++;
+            body.close();
+            next = cachedNext;
+        } else if (responseCode == HTTP_CODE_OK) {
+            next = nextFromLink(http.header("Link"));
+            if (next.isEmpty() && http.hasHeader("total_page")) {
+                next = nextFromPageCount(pageUrl, http.header("total_page").toInt());
+            }
+            String newEtag = http.header("ETag");
+            File copy; // only pages with an ETag can be revalidated
+            if (useCache && newEtag.length() > 0) {
+                copy = SD.open(cachePath(pageUrl, ".tmp"), FILE_WRITE, true);
+            }
+
+            GitBodyStream stream(*http.getStreamPtr(), &copy);
+            ok = parseArray(stream, filter, arrayKey, onItem);
+            gitListingStats.bytes += stream.bytes();
+            if (copy) {
+                copy.close();
+                String json = cachePath(pageUrl, ".json");
+                SD.remove(json);
+                if (ok && SD.rename(cachePath(pageUrl, ".tmp"), json)) writeCacheMeta(pageUrl, newEtag, next);
+                else SD.remove(cachePath(pageUrl, ".tmp"));
+            }
+        } else {
+            error = "HTTP " + String(responseCode) + ": " + http.getString();
+            ok = false;
+        }
+        if (!ok && error.isEmpty()) error = "JSON parsing error";
+        gitListingStats.parseMs += millis() - start;
+        http.end();
+        pageUrl = next;
+    }
+    http.useHTTP10(false);
+
+    Serial.printf(
+        "[git] %lu items, %u pages (%u not modified): %lu B downloaded, %lu B from cache, %lu ms parsing\n",
+        (unsigned long)gitListingStats.items,
+        gitListingStats.pages,
+        gitListingStats.notModified,
+        (unsigned long)gitListingStats.bytes,
+        (unsigned long)gitListingStats.cachedBytes,
+        (unsigned long)gitListingStats.parseMs
+    );
+    return ok;
+}
@@ -0,0 +1,43 @@
+#ifndef GIT_LISTING_H
+#define GIT_LISTING_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <functional>
+
+#define GIT_CACHE_DIR "/BruceGit/cache" // listing pages kept on SD, keyed by URL
+#define GIT_LIST_MAX_PAGES 5            // pages followed per listing (100 items each)
+
+// What the last listing cost, logged after each one
+struct GitListingStats {
+    uint32_t items = 0;
+    uint16_t pages = 0;
+    uint16_t notModified = 0; // pages answered 304 and replayed from the SD cache
+    uint32_t bytes = 0;       // body bytes downloaded
+    uint32_t cachedBytes = 0; // body bytes read back from the SD cache
+    uint32_t parseMs = 0;     // receiving and parsing the bodies, headers excluded
+};
+
+extern GitListingStats gitListingStats;
+
+// Adds user agent and authentication, called after each HTTPClient::begin()
+typedef std::function<void(HTTPClient& http)> GitRequestSetup;
+typedef std::function<void(JsonObjectConst item)> GitItemHandler;
+
+/*
+ * GETs a JSON array and hands each element, reduced to the fields of `filter`,
+ * to `onItem`. Elements are parsed from the response stream one at a time, so
+ * memory does not depend on the listing size. Next pages (Link rel="next", or
+ * Gitee's total_page header) are followed up to `maxPages`.
+ * With an SD card, pages are cached under GIT_CACHE_DIR with their ETag and
+ * revalidated with If-None-Match: a 304 replays the cached page.
+ * `arrayKey` names the member holding the array ("items" for searches), nullptr for a bare array.
+ */
+bool gitFetchList(
+    HTTPClient& http, const String& url, const GitRequestSetup& setup, const JsonDocument& filter,
+    const GitItemHandler& onItem, String& error, int& responseCode, const char* arrayKey = nullptr,
+    uint8_t maxPages = GIT_LIST_MAX_PAGES
+);
+
+#endif // GIT_LISTING_H
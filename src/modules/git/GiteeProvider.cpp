@@ -1,5 +1,28 @@
 #include "GiteeProvider.h"
 
+// Fields read by parseRepoFromJson and parseIssueFromJson, the rest of each listing item is skipped
+static JsonDocument repoFilter() {
+    JsonDocument filter;
+    for (const char* key : {"name", "full_name", "description", "clone_url", "ssh_url", "html_url", "private",
+                            "default_branch", "stargazers_count", "forks_count"}) {
+        filter[key] = true;
+    }
+    return filter;
+}
+
+static JsonDocument issueFilter() {
+    JsonDocument filter;
+    for (const char* key : {"number", "title", "body", "state", "created_at", "updated_at", "html_url",
+                            "comments", "pull_request"}) {
+        filter[key] = true;
+    }
+    filter["user"]["login"] = true;
+    filter["labels"][0]["name"] = true;
+    filter["assignees"][0]["login"] = true;
+    filter["milestone"]["title"] = true;
+    return filter;
+}
+
 GiteeProvider::GiteeProvider() {
     config.authenticated = false;
     config.apiBaseUrl = GITEE_API_BASE;
@@ -46,13 +69,10 @@ std::vector<GitRepository> GiteeProvider::listUserRepos() {
     }
     
     String url = buildUrl("/user/repos", "sort=updated&per_page=100");
-    
-    if (!makeRequest("GET", url)) {
-        return repos;
-    }
-    
-    String response = http.getString();
-    parseReposArray(response, repos);
+    fetchList(url, repoFilter(), [this, &repos](JsonObjectConst item) {
+        GitRepository repo;
+        if (parseRepoFromJson(item, repo)) repos.push_back(repo);
+    });
     
     return repos;
 }
@@ -114,13 +134,10 @@ std::vector<GitIssue> GiteeProvider::listIssues(const String& owner, const Strin
     }
     
     String url = buildUrl("/repos/" + owner + "/" + repo + "/issues", "state=" + state + "&per_page=100");
-    
-    if (!makeRequest("GET", url)) {
-        return issues;
-    }
-    
-    String response = http.getString();
-    parseIssuesArray(response, issues);
+    fetchList(url, issueFilter(), [this, &issues](JsonObjectConst item) {
+        GitIssue issue;
+        if (parseIssueFromJson(item, issue)) issues.push_back(issue);
+    });
     
     return issues;
 }
@@ -511,24 +528,10 @@ std::vector<GitRepository> GiteeProvider::searchRepositories(const String& query
     }
     
     String url = buildUrl("/search/repositories", "q=" + urlEncode(query) + "&per_page=" + String(perPage));
-    
-    if (!makeRequest("GET", url)) {
-        return repos;
-    }
-    
-    String response = http.getString();
-    DynamicJsonDocument doc(16384);
-    DeserializationError error = deserializeJson(doc, response);
-    
-    if (!error && doc.containsKey("items")) {
-        JsonArray items = doc["items"];
-        for (JsonObject item : items) {
-            GitRepository repo;
-            if (parseRepoFromJson(item.as<String>(), repo)) {
-                repos.push_back(repo);
-            }
-        }
-    }
+    fetchList(url, repoFilter(), [this, &repos](JsonObjectConst item) {
+        GitRepository repo;
+        if (parseRepoFromJson(item, repo)) repos.push_back(repo);
+    }, "items", 1);
     
     return repos;
 }
@@ -582,6 +585,15 @@ bool GiteeProvider::makeRequest(const String& method, const String& url, const S
     return success;
 }
 
+bool GiteeProvider::fetchList(const String& url, const JsonDocument& filter, const GitItemHandler& onItem, const char* arrayKey, uint8_t maxPages) {
+    GitRequestSetup setup = [this](HTTPClient& client) {
+        client.setUserAgent(GITEE_USER_AGENT);
+        client.setTimeout(10000);
+        setAuthHeader(config.token);
+    };
+    return gitFetchList(http, url, setup, filter, onItem, lastError, responseCode, arrayKey, maxPages);
+}
+
 String GiteeProvider::buildUrl(const String& endpoint, const String& params) {
     String url = config.apiBaseUrl;
     
@@ -635,6 +647,10 @@ bool GiteeProvider::parseRepoFromJson(const String& json, GitRepository& repo) {
         return false;
     }
     
+    return parseRepoFromJson(doc.as<JsonObjectConst>(), repo);
+}
+
+bool GiteeProvider::parseRepoFromJson(JsonObjectConst doc, GitRepository& repo) {
     repo.name = doc["name"].as<String>();
     repo.fullName = doc["full_name"].as<String>();
     repo.description = doc["description"].as<String>();
@@ -657,6 +673,10 @@ bool GiteeProvider::parseIssueFromJson(const String& json, GitIssue& issue) {
         return false;
     }
     
+    return parseIssueFromJson(doc.as<JsonObjectConst>(), issue);
+}
+
+bool GiteeProvider::parseIssueFromJson(JsonObjectConst doc, GitIssue& issue) {
     issue.number = doc["number"];
     issue.title = doc["title"].as<String>();
     issue.body = doc["body"].as<String>();
@@ -668,16 +688,16 @@ bool GiteeProvider::parseIssueFromJson(const String& json, GitIssue& issue) {
     
     // Parse labels
     if (doc.containsKey("labels")) {
-        JsonArray labelArray = doc["labels"];
-        for (JsonVariant label : labelArray) {
+        JsonArrayConst labelArray = doc["labels"];
+        for (JsonVariantConst label : labelArray) {
             issue.labels.push_back(label["name"].as<String>());
         }
     }
     
     // Parse assignees
     if (doc.containsKey("assignees")) {
-        JsonArray assigneeArray = doc["assignees"];
-        for (JsonObject assignee : assigneeArray) {
+        JsonArrayConst assigneeArray = doc["assignees"];
+        for (JsonObjectConst assignee : assigneeArray) {
             issue.assignees.push_back(assignee["login"].as<String>());
         }
     }
@@ -2,6 +2,7 @@
 #define GITEE_PROVIDER_H
 
 #include "GitProvider.h"
+#include "GitListing.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
@@ -85,6 +86,7 @@ private:
     bool makeRequest(const String& method, const String& url, const String& data = "");
     String buildUrl(const String& endpoint, const String& params = "");
     String urlEncode(const String& str);
+    bool fetchList(const String& url, const JsonDocument& filter, const GitItemHandler& onItem, const char* arrayKey = nullptr, uint8_t maxPages = GIT_LIST_MAX_PAGES);
     
     // Authentication
     void setAuthHeader(const String& token);
@@ -92,7 +94,9 @@ private:
     
     // JSON parsing helpers
     bool parseRepoFromJson(const String& json, GitRepository& repo);
+    bool parseRepoFromJson(JsonObjectConst obj, GitRepository& repo);
     bool parseIssueFromJson(const String& json, GitIssue& issue);
+    bool parseIssueFromJson(JsonObjectConst obj, GitIssue& issue);
     bool parseUserFromJson(const String& json, GitUser& user);
     bool parseReposArray(const String& json, std::vector<GitRepository>& repos);
     bool parseIssuesArray(const String& json, std::vector<GitIssue>& issues);
@@ -5,6 +5,29 @@
 // Global instance
 GitHubApp githubApp;
 
+// Fields read from listing items, the rest of each item is skipped while parsing
+static JsonDocument repoFilter() {
+    JsonDocument filter;
+    for (const char* key : {"name", "full_name", "description", "clone_url", "ssh_url", "html_url", "private",
+                            "default_branch", "stargazers_count", "forks_count"}) {
+        filter[key] = true;
+    }
+    return filter;
+}
+
+static JsonDocument issueFilter() {
+    JsonDocument filter;
+    for (const char* key : {"number", "title", "body", "state", "created_at", "updated_at", "html_url",
+                            "comments", "pull_request"}) {
+        filter[key] = true;
+    }
+    filter["user"]["login"] = true;
+    filter["labels"][0]["name"] = true;
+    filter["assignees"][0]["login"] = true;
+    filter["milestone"]["title"] = true;
+    return filter;
+}
+
 GitHubApp::GitHubApp() {
     config.token = "";
     config.username = "";
@@ -91,6 +114,14 @@ bool GitHubApp::makeRequest(const String& method, const String& url, const Strin
     }
 }
 
+bool GitHubApp::fetchList(const String& url, const JsonDocument& filter, const GitItemHandler& onItem, const char* arrayKey, uint8_t maxPages) {
+    GitRequestSetup setup = [this](HTTPClient& client) {
+        client.setUserAgent(USER_AGENT);
+        setAuthHeader(config.token);
+    };
+    return gitFetchList(http, url, setup, filter, onItem, lastError, responseCode, arrayKey, maxPages);
+}
+
 String GitHubApp::buildUrl(const String& endpoint, const String& params) {
     String url = GITHUB_API_BASE + endpoint;
     if (params.length() > 0) {
@@ -116,27 +147,13 @@ std::vector<GitHubRepo> GitHubApp::listUserRepos() {
     }
     
     String url = buildUrl("/user/repos", "per_page=100&sort=updated");
-    http.begin(url.c_str());
-    http.setUserAgent(USER_AGENT);
-    setAuthHeader(config.token);
-    
-    responseCode = http.GET();
-    
-    if (responseCode == 200) {
-        String response = http.getString();
-        // Simple JSON parsing for repositories array
-        int start = response.indexOf("[");
-        int end = response.lastIndexOf("]");
-        
-        if (start >= 0 && end > start) {
-            String arrayJson = response.substring(start, end + 1);
-            parseReposArray(arrayJson, repos);
-        }
-    } else {
-        lastError = "Failed to fetch repositories: HTTP " + String(responseCode);
+    if (!fetchList(url, repoFilter(), [this, &repos](JsonObjectConst item) {
+            GitHubRepo repo;
+            if (parseRepoFromJson(item, repo)) repos.push_back(repo);
+        })) {
+        lastError = "Failed to fetch repositories: " + lastError;
     }
     
-    http.end();
     return repos;
 }
 
@@ -208,13 +225,11 @@ std::vector<GitHubIssue> GitHubApp::listIssues(const String& owner, const String
     
     String params = "state=" + state + "&per_page=100";
     String url = buildUrl("/repos/" + owner + "/" + repo + "/issues", params);
+    fetchList(url, issueFilter(), [this, &issues](JsonObjectConst item) {
+        GitHubIssue issue;
+        if (parseIssueFromJson(item, issue)) issues.push_back(issue);
+    });
     
-    if (makeRequest("GET", url)) {
-        String response = http.getString();
-        parseIssuesArray(response, issues);
-    }
-    
-    http.end();
     return issues;
 }
 
@@ -789,21 +804,11 @@ std::vector<GitHubRepo> GitHubApp::searchRepositories(const String& query, int p
     
     String params = "q=" + urlencode(query) + "&per_page=" + String(perPage);
     String url = buildUrl("/search/repositories", params);
+    fetchList(url, repoFilter(), [this, &repos](JsonObjectConst item) {
+        GitHubRepo repo;
+        if (parseRepoFromJson(item, repo)) repos.push_back(repo);
+    }, "items", 1);
     
-    if (makeRequest("GET", url)) {
-        String response = http.getString();
-        // Parse search results
-        int itemsStart = response.indexOf("\"items\":[");
-        if (itemsStart >= 0) {
-            int itemsEnd = response.indexOf("]", itemsStart);
-            if (itemsEnd > itemsStart) {
-                String itemsArray = response.substring(itemsStart + 9, itemsEnd + 1);
-                parseReposArray(itemsArray, repos);
-            }
-        }
-    }
-    
-    http.end();
     return repos;
 }
 
@@ -822,6 +827,41 @@ bool GitHubApp::parseRepoFromJson(const String& json, GitHubRepo& repo) {
     return true;
 }
 
+bool GitHubApp::parseRepoFromJson(JsonObjectConst obj, GitHubRepo& repo) {
+    repo.name = obj["name"].as<String>();
+    repo.fullName = obj["full_name"].as<String>();
+    repo.description = obj["description"] | ""; // null when empty
+    repo.cloneUrl = obj["clone_url"].as<String>();
+    repo.sshUrl = obj["ssh_url"].as<String>();
+    repo.htmlUrl = obj["html_url"].as<String>();
+    repo.isPrivate = obj["private"];
+    repo.defaultBranch = obj["default_branch"].as<String>();
+    repo.stars = obj["stargazers_count"];
+    repo.forks = obj["forks_count"];
+    return true;
+}
+
+bool GitHubApp::parseIssueFromJson(JsonObjectConst obj, GitHubIssue& issue) {
+    issue.number = obj["number"];
+    issue.title = obj["title"].as<String>();
+    issue.body = obj["body"] | "";
+    issue.state = obj["state"].as<String>();
+    issue.author = obj["user"]["login"].as<String>();
+    issue.createdAt = obj["created_at"].as<String>();
+    issue.updatedAt = obj["updated_at"].as<String>();
+    issue.htmlUrl = obj["html_url"].as<String>();
+    for (JsonObjectConst label : obj["labels"].as<JsonArrayConst>()) {
+        issue.labels.push_back(label["name"].as<String>());
+    }
+    for (JsonObjectConst assignee : obj["assignees"].as<JsonArrayConst>()) {
+        issue.assignees.push_back(assignee["login"].as<String>());
+    }
+    if (!obj["milestone"].isNull()) issue.milestone = obj["milestone"]["title"].as<String>();
+    issue.comments = obj["comments"];
+    issue.isPullRequest = !obj["pull_request"].isNull();
+    return true;
+}
+
 bool GitHubApp::parseIssueFromJson(const String& json, GitHubIssue& issue) {
     issue.number = extractJsonValue(json, "\"number\"").toInt();
     issue.title = extractJsonValue(json, "\"title\"");
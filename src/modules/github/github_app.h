@@ -5,6 +5,7 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include "modules/git/GitListing.h"
 #include <string>
 #include <vector>
 
@@ -204,6 +205,7 @@ private:
     bool makeRequest(const String& method, const String& url, const String& data = "");
     String buildUrl(const String& endpoint, const String& params = "");
     String extractJsonValue(const String& json, const String& key);
+    bool fetchList(const String& url, const JsonDocument& filter, const GitItemHandler& onItem, const char* arrayKey = nullptr, uint8_t maxPages = GIT_LIST_MAX_PAGES);
     
     // Authentication
     void setAuthHeader(const String& token);
@@ -211,7 +213,9 @@ private:
     
     // JSON parsing helpers
     bool parseRepoFromJson(const String& json, GitHubRepo& repo);
+    bool parseRepoFromJson(JsonObjectConst obj, GitHubRepo& repo);
     bool parseIssueFromJson(const String& json, GitHubIssue& issue);
+    bool parseIssueFromJson(JsonObjectConst obj, GitHubIssue& issue);
     bool parseUserFromJson(const String& json, GitHubUser& user);
     bool parseReposArray(const String& json, std::vector<GitHubRepo>& repos);
     bool parseIssuesArray(const String& json, std::vector<GitHubIssue>& issues);
@@ -14,10 +14,10 @@
 
 #define MAX_WAIT 5000
 
-GPSTracker::GPSTracker() { setup(); }
+GPSTracker::GPSTracker(TrackWriter::Format format) : format(format) { setup(); }
 
 GPSTracker::~GPSTracker() {
-    add_final_file_data();
+    track.close();
     if (gpsConnected) end();
     ioExpander.turnPinOnOff(IO_EXP_GPS, LOW);
 #ifdef USE_BOOST
@@ -61,6 +61,7 @@ bool GPSTracker::begin_gps() {
 }
 
 void GPSTracker::end() {
+    track.close();
     GPSserial.end();
     restorePins();
 
@@ -123,8 +124,9 @@ void GPSTracker::display_banner() {
     padprintln("");
 
     if (gpsCoordCount > 0) {
-        padprintln("File: " + filename.substring(0, filename.length() - 4), 2);
+        padprintln("File: " + filename.substring(0, filename.lastIndexOf('.')), 2);
         padprintln("GPS Coordinates: " + String(gpsCoordCount), 2);
+        padprintln("Flushes: " + String(track.flushes()), 2);
         padprintf(2, "Distance: %.2fkm\n", distance / 1000);
     }
 
@@ -155,84 +157,43 @@ void GPSTracker::create_filename() {
         gps.time.minute() % 100,
         gps.time.second() % 100
     );
-    filename = String(timestamp) + "_gps_tracker.gpx";
+    filename = String(timestamp) + "_gps_tracker" + (format == TrackWriter::BINARY ? ".btrk" : ".gpx");
 }
 
-void GPSTracker::add_initial_file_data(File file) {
-    file.println("<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>");
-    file.println("<?xml-stylesheet type=\"text/xsl\" href=\"details.xsl\"?>");
-    file.println("<gpx");
-    file.println("  version=\"1.1\"");
-    file.println("  creator=\"Bruce Firmware\"");
-    file.println("  xmlns=\"http://www.topografix.com/GPX/1/1\"");
-    file.println("  xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"");
-    file.println(
-        "  xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd\""
-    );
-    file.println(">");
-    file.println("  <metadata>");
-    file.println("    <name>Bruce GPS Tracker</name>");
-    file.println("    <desc>GPS Tracker using Bruce Firmware</desc>");
-    file.println("    <link href=\"https://bruce.computer\">");
-    file.println("      <text>Bruce Website</text>");
-    file.println("    </link>");
-    file.println("  </metadata>");
-    file.println("  <trk>");
-    file.println("    <name>Bruce Route</name>");
-    file.println("    <desc>GPS route captured by Bruce firmware</desc>");
-    file.println("    <trkseg>");
-}
-
-void GPSTracker::add_final_file_data() {
-    FS *fs;
-    if (!getFsStorage(fs)) return;
-    if (filename == "" || !(*fs).exists("/BruceGPS/" + filename)) return;
-
-    File file = (*fs).open("/BruceGPS/" + filename, FILE_APPEND);
-
-    if (!file) return;
-    file.println("    </trkseg>");
-    file.println("  </trk>");
-    file.println("</gpx>");
-
-    file.close();
-}
-
-void GPSTracker::add_coord() {
+bool GPSTracker::open_track() {
     FS *fs;
     if (!getFsStorage(fs)) {
         padprintln("Storage setup error");
-        returnToMenu = true;
-        return;
+        return false;
     }
 
     if (filename == "") create_filename();
 
     if (!(*fs).exists("/BruceGPS")) (*fs).mkdir("/BruceGPS");
 
-    bool is_new_file = false;
-    if (!(*fs).exists("/BruceGPS/" + filename)) is_new_file = true;
-    File file = (*fs).open("/BruceGPS/" + filename, is_new_file ? FILE_WRITE : FILE_APPEND);
+    return track.begin(fs, "/BruceGPS/" + filename, format);
+}
 
-    if (!file) {
-        padprintln("Failed to open file for writing");
+void GPSTracker::add_coord() {
+    if (!track.isOpen() && !open_track()) {
         returnToMenu = true;
         return;
     }
 
-    if (is_new_file) add_initial_file_data(file);
-
-    file.printf("      <trkpt lat=\"%f\" lon=\"%f\">\n", gps.location.lat(), gps.location.lng());
-    file.println("        <sym>Waypoint</sym>");
-    file.printf("        <ele>%f</ele>\n", gps.altitude.meters());
-    file.printf("        <hdop>%f</hdop>\n", gps.hdop.hdop());
-    file.printf("        <sat>%ld</sat>\n", gps.satellites.value());
-    file.println("      </trkpt>");
+    if (!track.add(
+            gps.location.lat(),
+            gps.location.lng(),
+            gps.altitude.meters(),
+            gps.hdop.hdop(),
+            gps.satellites.value()
+        )) {
+        padprintln("Failed to write track");
+        returnToMenu = true;
+        return;
+    }
 
     gpsCoordCount++;
 
-    file.close();
-
     padprintf(2, "Coord: %.6f, %.6f\n", gps.location.lat(), gps.location.lng());
 }
 
@@ -282,3 +243,19 @@ void GPSTracker::restorePins() {
         rxPinReleased = false;
     }
 }
+
+void exportTrackToGpx() {
+    FS *fs;
+    if (!getFsStorage(fs)) {
+        displayError("Storage setup error", true);
+        return;
+    }
+
+    String binPath = loopSD(*fs, true, "BTRK", "/BruceGPS");
+    if (binPath == "") return;
+
+    String gpxPath = binPath.substring(0, binPath.lastIndexOf('.')) + ".gpx";
+    displayTextLine("Exporting...");
+    if (convertTrackToGpx(*fs, binPath, gpxPath)) displaySuccess("Saved " + gpxPath, true);
+    else displayError("Invalid track file", true);
+}
@@ -9,6 +9,7 @@
 #ifndef __GPS_TRACKER_H__
 #define __GPS_TRACKER_H__
 
+#include "track_writer.h"
 #include <TinyGPS++.h>
 #include <globals.h>
 
@@ -17,7 +18,7 @@ public:
     /////////////////////////////////////////////////////////////////////////////////////
     // Constructor
     /////////////////////////////////////////////////////////////////////////////////////
-    GPSTracker();
+    GPSTracker(TrackWriter::Format format = TrackWriter::GPX);
     ~GPSTracker();
 
     /////////////////////////////////////////////////////////////////////////////////////
@@ -37,6 +38,8 @@ private:
     HardwareSerial GPSserial = HardwareSerial(2);
     int gpsCoordCount = 0;
     bool rxPinReleased = false;
+    TrackWriter::Format format;
+    TrackWriter track;
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Setup
@@ -57,9 +60,11 @@ private:
     /////////////////////////////////////////////////////////////////////////////////////
     void set_position(void);
     void add_coord(void);
-    void add_initial_file_data(File file);
-    void add_final_file_data(void);
+    bool open_track(void);
     void create_filename(void);
 };
 
+// Lets the user pick a binary track and writes it next to it as .gpx
+void exportTrackToGpx(void);
+
 #endif // GPS_TRACKER_H
@@ -0,0 +1,104 @@
+/**
+ * @file track_gpx.h
+ * @brief GPX text of the track writer, without Arduino so the host test builds it
+ * @version 0.1
+ */
+
+#ifndef __TRACK_GPX_H__
+#define __TRACK_GPX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+struct __attribute__((packed)) TrackPoint {
+    int32_t lat;   // degrees * 1e7
+    int32_t lng;   // degrees * 1e7
+    int32_t ele;   // centimeters
+    uint16_t hdop; // hdop * 100
+    uint8_t sats;
+    uint8_t reserved;
+};
+
+#define GPX_POINT_MAX 256 // longest <trkpt> element formatGpxPoint writes
+
+static const char GPX_HEADER[] =
+    "<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>\r\n"
+    "<?xml-stylesheet type=\"text/xsl\" href=\"details.xsl\"?>\r\n"
+    "<gpx\r\n"
+    "  version=\"1.1\"\r\n"
+    "  creator=\"Bruce Firmware\"\r\n"
+    "  xmlns=\"http://www.topografix.com/GPX/1/1\"\r\n"
+    "  xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\r\n"
+    "  xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd\"\r\n"
+    ">\r\n"
+    "  <metadata>\r\n"
+    "    <name>Bruce GPS Tracker</name>\r\n"
+    "    <desc>GPS Tracker using Bruce Firmware</desc>\r\n"
+    "    <link href=\"https://bruce.computer\">\r\n"
+    "      <text>Bruce Website</text>\r\n"
+    "    </link>\r\n"
+    "  </metadata>\r\n"
+    "  <trk>\r\n"
+    "    <name>Bruce Route</name>\r\n"
+    "    <desc>GPS route captured by Bruce firmware</desc>\r\n"
+    "    <trkseg>\r\n";
+static const size_t GPX_HEADER_LEN = sizeof(GPX_HEADER) - 1;
+
+// Kept as a single literal so its length is known when rewinding over it
+static const char GPX_TRAILER[] = "    </trkseg>\r\n  </trk>\r\n</gpx>\r\n";
+static const size_t GPX_TRAILER_LEN = sizeof(GPX_TRAILER) - 1;
+
+// Writes the <trkpt> element of pt into buf, GPX_POINT_MAX bytes, returns its length
+inline size_t formatGpxPoint(char *buf, const TrackPoint &pt) {
+    int len = snprintf(
+        buf,
+        GPX_POINT_MAX,
+        "      <trkpt lat=\"%f\" lon=\"%f\">\r\n"
+        "        <sym>Waypoint</sym>\r\n"
+        "        <ele>%f</ele>\r\n"
+        "        <hdop>%f</hdop>\r\n"
+        "        <sat>%u</sat>\r\n"
+        "      </trkpt>\r\n",
+        pt.lat / 1e7,
+        pt.lng / 1e7,
+        pt.ele / 100.0,
+        pt.hdop / 100.0,
+        pt.sats
+    );
+    if (len <= 0) return 0;
+    return (size_t)len < GPX_POINT_MAX ? len : GPX_POINT_MAX - 1;
+}
+
+/*
+ * Appends points to an open GPX file, a new one gets the header first. The
+ * trailer is rewritten only when the file really ends with it; a file cut
+ * short (power loss in the middle of a flush) or not written by us is
+ * appended to, so nothing already in it is overwritten.
+ */
+template <typename F> bool appendGpxPoints(F &file, bool isNew, const TrackPoint *points, size_t count) {
+    if (isNew) {
+        if (file.write((const uint8_t *)GPX_HEADER, GPX_HEADER_LEN) != GPX_HEADER_LEN) return false;
+    } else {
+        size_t size = file.size();
+        size_t at = size;
+        char tail[GPX_TRAILER_LEN];
+        if (size >= GPX_TRAILER_LEN && file.seek(size - GPX_TRAILER_LEN) &&
+            file.read((uint8_t *)tail, GPX_TRAILER_LEN) == GPX_TRAILER_LEN &&
+            memcmp(tail, GPX_TRAILER, GPX_TRAILER_LEN) == 0) {
+            at = size - GPX_TRAILER_LEN;
+        }
+        // also switches the file from reading to writing
+        if (!file.seek(at)) return false;
+    }
+
+    char buf[GPX_POINT_MAX];
+    for (size_t i = 0; i < count; i++) {
+        size_t len = formatGpxPoint(buf, points[i]);
+        if (file.write((const uint8_t *)buf, len) != len) return false;
+    }
+    return file.write((const uint8_t *)GPX_TRAILER, GPX_TRAILER_LEN) == GPX_TRAILER_LEN;
+}
+
+#endif
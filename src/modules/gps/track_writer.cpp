@@ -0,0 +1,120 @@
+/**
+ * @file track_writer.cpp
+ * @brief Buffered GPS track writer (GPX or compact binary)
+ * @version 0.1
+ */
+
+#include "track_writer.h"
+
+void writeGpxHeader(Print &out) { out.write((const uint8_t *)GPX_HEADER, GPX_HEADER_LEN); }
+
+void writeGpxTrailer(Print &out) { out.write((const uint8_t *)GPX_TRAILER, GPX_TRAILER_LEN); }
+
+size_t writeGpxPoint(Print &out, const TrackPoint &pt) {
+    char buf[GPX_POINT_MAX];
+    return out.write((const uint8_t *)buf, formatGpxPoint(buf, pt));
+}
+
+bool TrackWriter::begin(FS *fs, const String &path, Format format) {
+    close();
+    _fs = fs;
+    _path = path;
+    _format = format;
+    _buffered = 0;
+    _count = 0;
+    _flushes = 0;
+    _lastFlush = millis();
+    return true;
+}
+
+bool TrackWriter::add(double lat, double lng, double ele, double hdop, uint32_t sats) {
+    if (!isOpen()) return false;
+
+    TrackPoint &pt = _buffer[_buffered++];
+    pt.lat = (int32_t)lround(lat * 1e7);
+    pt.lng = (int32_t)lround(lng * 1e7);
+    pt.ele = (int32_t)lround(ele * 100);
+    pt.hdop = (uint16_t)constrain(lround(hdop * 100), 0L, 65535L);
+    pt.sats = sats > 255 ? 255 : sats;
+    pt.reserved = 0;
+    _count++;
+
+    if (_buffered >= TRACK_BUFFER_POINTS || millis() - _lastFlush > TRACK_FLUSH_INTERVAL) return flush();
+    return true;
+}
+
+bool TrackWriter::flush() {
+    _lastFlush = millis();
+    if (!isOpen() || _buffered == 0) return true;
+
+    bool ok = _format == BINARY ? flushBinary() : flushGpx();
+    // on failure the points are dropped so a missing card does not stall the tracker
+    _buffered = 0;
+    if (ok) _flushes++;
+    return ok;
+}
+
+void TrackWriter::close() {
+    flush();
+    _fs = nullptr;
+}
+
+// The file always ends with a valid trailer: each flush rewinds over it,
+// appends the buffered points and writes it again (appendGpxPoints).
+bool TrackWriter::flushGpx() {
+    bool is_new_file = !_fs->exists(_path);
+    File file = _fs->open(_path, is_new_file ? FILE_WRITE : "r+");
+    if (!file) return false;
+    bool ok = appendGpxPoints(file, is_new_file, _buffer, _buffered);
+    file.close();
+    return ok;
+}
+
+bool TrackWriter::flushBinary() {
+    bool is_new_file = !_fs->exists(_path);
+    File file = _fs->open(_path, is_new_file ? FILE_WRITE : FILE_APPEND);
+    if (!file) return false;
+
+    if (is_new_file) {
+        TrackBinHeader header;
+        memcpy(header.magic, TRACK_BIN_MAGIC, 4);
+        header.version = TRACK_BIN_VERSION;
+        header.recordSize = sizeof(TrackPoint);
+        header.reserved = 0;
+        file.write((const uint8_t *)&header, sizeof(header));
+    }
+
+    size_t len = _buffered * sizeof(TrackPoint);
+    bool ok = file.write((const uint8_t *)_buffer, len) == len;
+    file.close();
+    return ok;
+}
+
+bool convertTrackToGpx(FS &fs, const String &binPath, const String &gpxPath) {
+    File in = fs.open(binPath, FILE_READ);
+    if (!in) return false;
+
+    TrackBinHeader header;
+    if (in.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, TRACK_BIN_MAGIC, 4) != 0 || header.version != TRACK_BIN_VERSION ||
+        header.recordSize != sizeof(TrackPoint)) {
+        in.close();
+        return false;
+    }
+
+    File out = fs.open(gpxPath, FILE_WRITE);
+    if (!out) {
+        in.close();
+        return false;
+    }
+
+    writeGpxHeader(out);
+    TrackPoint pt;
+    // a partially written last record (power loss) is ignored
+    while (in.read((uint8_t *)&pt, sizeof(pt)) == sizeof(pt)) writeGpxPoint(out, pt);
+    writeGpxTrailer(out);
+
+    out.close();
+    in.close();
+    return true;
+}
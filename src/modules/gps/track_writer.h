@@ -0,0 +1,65 @@
+/**
+ * @file track_writer.h
+ * @brief Buffered GPS track writer (GPX or compact binary)
+ * @version 0.1
+ */
+
+#ifndef __TRACK_WRITER_H__
+#define __TRACK_WRITER_H__
+
+#include "track_gpx.h"
+#include <FS.h>
+#include <globals.h>
+
+#define TRACK_BUFFER_POINTS 64     // points kept in RAM before a flush
+#define TRACK_FLUSH_INTERVAL 10000 // max ms a point stays in RAM
+
+// Compact binary track (.btrk): 8 byte header followed by fixed size records
+#define TRACK_BIN_MAGIC "BTRK"
+#define TRACK_BIN_VERSION 1
+
+struct __attribute__((packed)) TrackBinHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t recordSize;
+    uint16_t reserved;
+};
+
+class TrackWriter {
+public:
+    enum Format { GPX, BINARY };
+
+    TrackWriter() {}
+    ~TrackWriter() { close(); }
+
+    bool begin(FS *fs, const String &path, Format format);
+    bool add(double lat, double lng, double ele, double hdop, uint32_t sats);
+    bool flush(void);
+    void close(void);
+
+    bool isOpen(void) { return _fs != nullptr; }
+    uint32_t count(void) { return _count; }
+    uint32_t flushes(void) { return _flushes; }
+
+private:
+    FS *_fs = nullptr;
+    String _path = "";
+    Format _format = GPX;
+    TrackPoint _buffer[TRACK_BUFFER_POINTS];
+    uint8_t _buffered = 0;
+    uint32_t _count = 0;
+    uint32_t _flushes = 0;
+    uint32_t _lastFlush = 0;
+
+    bool flushGpx(void);
+    bool flushBinary(void);
+};
+
+void writeGpxHeader(Print &out);
+void writeGpxTrailer(Print &out);
+size_t writeGpxPoint(Print &out, const TrackPoint &pt);
+
+// Converts a .btrk file into a GPX file, returns false on malformed input
+bool convertTrackToGpx(FS &fs, const String &binPath, const String &gpxPath);
+
+#endif
@@ -14,6 +14,10 @@
 #include "current_year.h"
 
 #define MAX_WAIT 5000
+#define CSV_FLUSH_SIZE 4096     // flush the CSV buffer once it grows past this
+#define CSV_FLUSH_INTERVAL 15000 // or once this many ms passed since the last flush
+#define GPS_RX_BUFFER 2048      // room for ~1s of NMEA at 10Hz while the SD is busy
+#define REDRAW_INTERVAL 1000
 
 Wardriving::Wardriving() { setup(); }
 
@@ -36,6 +40,8 @@ void Wardriving::setup() {
     begin_wifi();
     if (!begin_gps()) return;
 
+    csvBuffer.reserve(CSV_FLUSH_SIZE + 512);
+
     vTaskDelay(500 / portTICK_PERIOD_MS);
     return loop();
 }
@@ -47,9 +53,13 @@ void Wardriving::begin_wifi() {
 
 bool Wardriving::begin_gps() {
     releasePins();
+    GPSserial.setRxBufferSize(GPS_RX_BUFFER);
     GPSserial.begin(
         bruceConfigPins.gpsBaudrate, SERIAL_8N1, bruceConfigPins.gps_bus.rx, bruceConfigPins.gps_bus.tx
     );
+    GPSserial.onReceiveError([this](hardwareSerial_error_t err) {
+        if (err == UART_BUFFER_FULL_ERROR || err == UART_FIFO_OVF_ERROR) gpsRxOverflows++;
+    });
 
     int count = 0;
     padprintln("Waiting for GPS data");
@@ -68,6 +78,14 @@ bool Wardriving::begin_gps() {
 }
 
 void Wardriving::end() {
+    if (scanInProgress) {
+        // wait for the pending scan so its results are not lost nor left in the driver
+        uint32_t tmp = millis();
+        while (WiFi.scanComplete() == WIFI_SCAN_RUNNING && millis() - tmp < MAX_WAIT) vTaskDelay(10);
+        poll_scan();
+    }
+    flush_buffer();
+
     wifiDisconnect();
 
     GPSserial.end();
@@ -77,44 +95,55 @@ void Wardriving::end() {
 }
 
 void Wardriving::loop() {
-    int count = 0;
     returnToMenu = false;
-    while (1) {
-        display_banner();
+    startTime = millis();
+    lastGpsData = millis();
+    lastFlush = millis();
+    lastRedraw = 0;
 
+    while (1) {
         if (check(EscPress) || returnToMenu) return end();
 
-        if (GPSserial.available() > 0) {
-            count = 0;
-            while (GPSserial.available() > 0) gps.encode(GPSserial.read());
+        // GPS is drained on every pass, also while a scan is running, so no fix is dropped
+        read_gps();
 
-            if (gps.location.isUpdated()) {
-                padprintln("GPS location updated");
-                set_position();
-                scan_networks();
-            } else {
-                padprintln("GPS location not updated");
-                dump_gps_data();
+        if (scanInProgress) poll_scan();
 
-                if (filename == "" && gps.date.year() >= CURRENT_YEAR && gps.date.year() < CURRENT_YEAR + 5)
-                    create_filename();
-            }
-        } else {
-            if (count > 5) {
-                displayError("GPS not Found!");
-                return end();
-            }
-            padprintln("No GPS data available");
-            count++;
+        if (gps.location.isUpdated() && !scanInProgress) {
+            set_position();
+            scan_networks();
+        }
+
+        if (filename == "" && gps.date.year() >= CURRENT_YEAR && gps.date.year() < CURRENT_YEAR + 5)
+            create_filename();
+
+        if (csvBuffer.length() >= CSV_FLUSH_SIZE ||
+            (csvBuffer.length() > 0 && millis() - lastFlush > CSV_FLUSH_INTERVAL)) {
+            if (!flush_buffer()) return end();
         }
 
-        int tmp = millis();
-        while (millis() - tmp < MAX_WAIT && !gps.location.isUpdated()) {
-            if (check(EscPress) || returnToMenu) return end();
+        if (millis() - lastGpsData > 6 * MAX_WAIT) {
+            displayError("GPS not Found!");
+            return end();
         }
+
+        if (millis() - lastRedraw > REDRAW_INTERVAL) {
+            lastRedraw = millis();
+            display_banner();
+            dump_gps_data();
+            display_stats();
+        }
+
+        vTaskDelay(5 / portTICK_PERIOD_MS);
     }
 }
 
+void Wardriving::read_gps() {
+    if (GPSserial.available() <= 0) return;
+    lastGpsData = millis();
+    while (GPSserial.available() > 0) gps.encode(GPSserial.read());
+}
+
 void Wardriving::set_position() {
     double lat = gps.location.lat();
     double lng = gps.location.lng();
@@ -151,6 +180,22 @@ void Wardriving::dump_gps_data() {
     padprintf(2, "HDOP: %.2f\n", gps.hdop.hdop());
 }
 
+void Wardriving::display_stats() {
+    padprintln("");
+    padprintf(2, "Records/min: %lu\n", records_per_minute());
+    padprintf(2, "GPS lost: %lu\n", lost_gps_sentences());
+    if (scanInProgress) padprintln("Scanning...", 2);
+}
+
+uint32_t Wardriving::records_per_minute() {
+    uint32_t elapsed = millis() - startTime;
+    if (elapsed < 1000) return 0;
+    return (uint64_t)wifiNetworkCount * 60000 / elapsed;
+}
+
+// Sentences rejected by the NMEA checksum plus UART overruns (each one corrupts at least one sentence)
+uint32_t Wardriving::lost_gps_sentences() { return gps.failedChecksum() + gpsRxOverflows; }
+
 String Wardriving::auth_mode_to_string(wifi_auth_mode_t authMode) {
     switch (authMode) {
         case WIFI_AUTH_OPEN: return "OPEN";
@@ -169,16 +214,35 @@ String Wardriving::auth_mode_to_string(wifi_auth_mode_t authMode) {
 void Wardriving::scan_networks() {
     wifiConnected = true;
 
-    int network_amount = WiFi.scanNetworks();
-    if (network_amount == 0) {
-        padprintln("No Wi-Fi networks found", 2);
-        return;
-    }
+    scanFix.lat = gps.location.lat();
+    scanFix.lng = gps.location.lng();
+    scanFix.alt = gps.altitude.meters();
+    scanFix.hdop = gps.hdop.hdop();
+    scanFix.year = gps.date.year();
+    scanFix.month = gps.date.month();
+    scanFix.day = gps.date.day();
+    scanFix.hour = gps.time.hour();
+    scanFix.minute = gps.time.minute();
+    scanFix.second = gps.time.second();
+
+    // async: returns immediately, results are collected by poll_scan()
+    if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) return;
+    scanInProgress = true;
+}
+
+void Wardriving::poll_scan() {
+    int16_t network_amount = WiFi.scanComplete();
+    if (network_amount == WIFI_SCAN_RUNNING) return;
 
-    padprintf(2, "Coord: %.6f, %.6f\n", gps.location.lat(), gps.location.lng());
-    padprintln("Networks Found: " + String(network_amount), 2);
+    scanInProgress = false;
+    if (network_amount > 0) append_to_buffer(network_amount);
+    WiFi.scanDelete();
+}
 
-    return append_to_file(network_amount);
+uint64_t Wardriving::bssid_key(const uint8_t *bssid) {
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) key = (key << 8) | bssid[i];
+    return key;
 }
 
 void Wardriving::create_filename() {
@@ -196,12 +260,59 @@ void Wardriving::create_filename() {
     filename = String(timestamp) + "_wardriving.csv";
 }
 
-void Wardriving::append_to_file(int network_amount) {
+void Wardriving::append_to_buffer(int network_amount) {
+    for (int i = 0; i < network_amount; i++) {
+        uint8_t *bssid = WiFi.BSSID(i);
+        if (bssid == nullptr) continue;
+
+        // Check if MAC was already found in this session
+        if (!registeredMACs.insert(bssid_key(bssid)).second) continue;
+
+        int32_t channel = WiFi.channel(i);
+
+        char buffer[512];
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "%02X:%02X:%02X:%02X:%02X:%02X,\"%s\",[%s],%04d-%02d-%02d %02d:%02d:%02d,%ld,%ld,%ld,%f,%f,%f,%f,,,"
+            "WIFI\n",
+            bssid[0],
+            bssid[1],
+            bssid[2],
+            bssid[3],
+            bssid[4],
+            bssid[5],
+            WiFi.SSID(i).c_str(),
+            auth_mode_to_string(WiFi.encryptionType(i)).c_str(),
+            scanFix.year,
+            scanFix.month,
+            scanFix.day,
+            scanFix.hour,
+            scanFix.minute,
+            scanFix.second,
+            channel,
+            channel != 14 ? 2407 + (channel * 5) : 2484,
+            WiFi.RSSI(i),
+            scanFix.lat,
+            scanFix.lng,
+            scanFix.alt,
+            scanFix.hdop
+        );
+        csvBuffer += buffer;
+
+        wifiNetworkCount++;
+    }
+}
+
+bool Wardriving::flush_buffer() {
+    lastFlush = millis();
+    if (csvBuffer.length() == 0) return true;
+
     FS *fs;
     if (!getFsStorage(fs)) {
-        padprintln("Storage setup error");
-        returnToMenu = true;
-        return;
+        csvBuffer = "";
+        displayError("Storage setup error", true);
+        return false;
     }
 
     if (filename == "") create_filename();
@@ -213,9 +324,9 @@ void Wardriving::append_to_file(int network_amount) {
     File file = (*fs).open("/BruceWardriving/" + filename, is_new_file ? FILE_WRITE : FILE_APPEND);
 
     if (!file) {
-        padprintln("Failed to open file for writing");
-        returnToMenu = true;
-        return;
+        csvBuffer = "";
+        displayError("Failed to open file", true);
+        return false;
     }
 
     if (is_new_file) {
@@ -230,43 +341,11 @@ void Wardriving::append_to_file(int network_amount) {
         );
     }
 
-    for (int i = 0; i < network_amount; i++) {
-        String macAddress = WiFi.BSSIDstr(i);
-
-        // Check if MAC was already found in this session
-        if (registeredMACs.find(macAddress) == registeredMACs.end()) {
-            registeredMACs.insert(macAddress); // Adds MAC to file
-            int32_t channel = WiFi.channel(i);
-
-            char buffer[512];
-            snprintf(
-                buffer,
-                sizeof(buffer),
-                "%s,\"%s\",[%s],%04d-%02d-%02d %02d:%02d:%02d,%ld,%ld,%ld,%f,%f,%f,%f,,,WIFI\n",
-                macAddress.c_str(),
-                WiFi.SSID(i).c_str(),
-                auth_mode_to_string(WiFi.encryptionType(i)).c_str(),
-                gps.date.year(),
-                gps.date.month(),
-                gps.date.day(),
-                gps.time.hour(),
-                gps.time.minute(),
-                gps.time.second(),
-                channel,
-                channel != 14 ? 2407 + (channel * 5) : 2484,
-                WiFi.RSSI(i),
-                gps.location.lat(),
-                gps.location.lng(),
-                gps.altitude.meters(),
-                gps.hdop.hdop() * 1.0
-            );
-            file.print(buffer);
-
-            wifiNetworkCount++;
-        }
-    }
-
+    file.write((const uint8_t *)csvBuffer.c_str(), csvBuffer.length());
     file.close();
+
+    csvBuffer = "";
+    return true;
 }
 
 void Wardriving::releasePins() {
@@ -12,7 +12,7 @@
 #include <TinyGPS++.h>
 #include <esp_wifi_types.h>
 #include <globals.h>
-#include <set>
+#include <unordered_set>
 
 class Wardriving {
 public:
@@ -37,10 +37,33 @@ private:
     String filename = "";
     TinyGPSPlus gps;
     HardwareSerial GPSserial = HardwareSerial(2); // Uses UART2 for GPS
-    std::set<String> registeredMACs;              // Store and track registered MAC
+    std::unordered_set<uint64_t> registeredMACs;  // 48-bit BSSIDs already written this session
     int wifiNetworkCount = 0;                     // Counter fo wifi networks
     bool rxPinReleased = false;
 
+    // Async scan state: the fix is latched when the scan starts so the records
+    // match the position where the networks were heard
+    struct ScanFix {
+        double lat;
+        double lng;
+        double alt;
+        double hdop;
+        uint16_t year;
+        uint8_t month, day, hour, minute, second;
+    };
+    ScanFix scanFix;
+    bool scanInProgress = false;
+
+    // Buffered WiGLE CSV writer
+    String csvBuffer = "";
+    uint32_t lastFlush = 0;
+
+    // Stats
+    uint32_t startTime = 0;
+    uint32_t lastGpsData = 0;
+    uint32_t lastRedraw = 0;
+    volatile uint32_t gpsRxOverflows = 0;
+
     /////////////////////////////////////////////////////////////////////////////////////
     // Setup
     /////////////////////////////////////////////////////////////////////////////////////
@@ -55,15 +78,22 @@ private:
     /////////////////////////////////////////////////////////////////////////////////////
     void display_banner(void);
     void dump_gps_data(void);
+    void display_stats(void);
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Operations
     /////////////////////////////////////////////////////////////////////////////////////
+    void read_gps(void);
     void set_position(void);
     void scan_networks(void);
+    void poll_scan(void);
     String auth_mode_to_string(wifi_auth_mode_t authMode);
-    void append_to_file(int network_amount);
+    uint64_t bssid_key(const uint8_t *bssid);
+    void append_to_buffer(int network_amount);
+    bool flush_buffer(void);
     void create_filename(void);
+    uint32_t records_per_minute(void);
+    uint32_t lost_gps_sentences(void);
 };
 
 #endif // WAR_DRIVING_H
@@ -373,6 +373,7 @@ void mainloop() {
             // decide short vs long after release
             if (millis() - _tmp > 700) {
                 // long press -> exit
+                inputDrain();
                 breakloop = true;
             } else {
                 // short press -> scroll down; consume flag first
@@ -6,6 +6,7 @@
 #include "soc/gpio_struct.h"
 #include "soc/io_mux_reg.h"
 #include <esp_heap_caps.h>
+#include <micSpectrum.h>
 
 #include "driver/i2s_pdm.h"
 #include "driver/i2s_std.h"
@@ -18,11 +19,14 @@ static i2s_chan_handle_t i2s_chan = nullptr;
 #define FFT_SIZE 1024
 #define SPECTRUM_WIDTH 200
 #define SPECTRUM_HEIGHT 124
-#define HISTORY_LEN (SPECTRUM_WIDTH + 1)
+
+#define WAV_HEADER_SIZE 44
+#define MIC_REC_BUFFERS 4           // capture buffers cycling between the reader and writer tasks
+#define MIC_REC_BUFFER_SAMPLES 4096 // per buffer, 85ms at 48kHz
+#define MIC_REC_DMA_FRAMES 512      // per DMA descriptor while recording, 8 descriptors
+#define MIC_REC_STOP 0xFF           // queued by the reader when it exits
 
 static int16_t *i2s_buffer = nullptr;
-static uint8_t *fftHistory = nullptr; // Linear buffer [WIDTH + 1][HEIGHT]
-static uint16_t posData = 0;
 
 #ifndef PIN_CLK
 #define PIN_CLK I2S_PIN_NO_CHANGE
@@ -107,19 +111,22 @@ bool deinitMicroPhone() {
     return err;
 }
 
-bool InitI2SMicroPhone() {
+bool InitI2SMicroPhone(
+    uint32_t sampleRate = 48000, uint32_t dmaFrames = SPECTRUM_HEIGHT,
+    const i2s_event_callbacks_t *callbacks = nullptr
+) {
     // Enable codec, if exists
     _setup_codec_mic(true);
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
     chan_cfg.dma_desc_num = 8;
-    chan_cfg.dma_frame_num = SPECTRUM_HEIGHT;
+    chan_cfg.dma_frame_num = dmaFrames;
     esp_err_t err = i2s_new_channel(&chan_cfg, NULL, &i2s_chan);
 #if defined(MIC_INMP441) // #ifdef PIN_WS // INMP441
     i2s_std_slot_config_t slot_cfg =
         I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO);
     slot_cfg.slot_bit_width = I2S_SLOT_BIT_WIDTH_16BIT;
     const i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(48000),
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sampleRate),
         .slot_cfg = slot_cfg,
         .gpio_cfg = {
                      .mclk = I2S_GPIO_UNUSED,
@@ -142,7 +149,7 @@ bool InitI2SMicroPhone() {
 #else
         i2s_config.clk_cfg.clk_src = i2s_clock_src_t::I2S_CLK_SRC_PLL_160M;
 #endif
-        i2s_config.clk_cfg.sample_rate_hz = 48000;                                     // dummy setting
+        i2s_config.clk_cfg.sample_rate_hz = sampleRate;
         i2s_config.clk_cfg.mclk_multiple = i2s_mclk_multiple_t::I2S_MCLK_MULTIPLE_256; // dummy setting
         i2s_config.slot_cfg.data_bit_width = i2s_data_bit_width_t::I2S_DATA_BIT_WIDTH_16BIT;
         i2s_config.slot_cfg.slot_bit_width = i2s_slot_bit_width_t::I2S_SLOT_BIT_WIDTH_16BIT;
@@ -165,7 +172,7 @@ bool InitI2SMicroPhone() {
         err = i2s_channel_init_std_mode(i2s_chan, &i2s_config);
     } else {
 
-        i2s_pdm_rx_clk_config_t clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(48000);
+        i2s_pdm_rx_clk_config_t clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(sampleRate);
         i2s_pdm_rx_slot_config_t slot_cfg =
             I2S_PDM_RX_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO);
         slot_cfg.slot_bit_width = I2S_SLOT_BIT_WIDTH_16BIT;
@@ -181,6 +188,8 @@ bool InitI2SMicroPhone() {
         if (err == ESP_OK) err = i2s_channel_init_pdm_rx_mode(i2s_chan, &pdm_cfg);
     }
 #endif
+    // callbacks can only be registered before the channel is enabled
+    if (err == ESP_OK && callbacks) err = i2s_channel_register_event_callback(i2s_chan, callbacks, nullptr);
     if (err == ESP_OK) err = i2s_channel_enable(i2s_chan);
     return (err == ESP_OK);
 }
@@ -197,11 +206,21 @@ void mic_test_one_task() {
         frameBuffer = (uint16_t *)malloc(SPECTRUM_WIDTH * SPECTRUM_HEIGHT * sizeof(uint16_t));
     }
 
-    if (!frameBuffer) {
+    MicSpectrum spectrum;
+    if (!frameBuffer || !spectrum.begin(FFT_SIZE)) {
         Serial.println("Error alloc drawing frameBuffer, exiting");
         displayError("Not Enough RAM", true);
+        free(frameBuffer);
         return;
     }
+    memset(frameBuffer, 0, SPECTRUM_WIDTH * SPECTRUM_HEIGHT * sizeof(uint16_t));
+
+    uint16_t palette[256];
+    for (int i = 0; i < 256; i++) {
+        palette[i] = rgb565(ImageData[i * 3 + 0], ImageData[i * 3 + 1], ImageData[i * 3 + 2]);
+    }
+    uint8_t levels[SPECTRUM_HEIGHT];
+
     tft.drawRect(
         tftWidth / 2 - SPECTRUM_WIDTH / 2 - 2,
         tftHeight / 2 - SPECTRUM_HEIGHT / 2 - 2,
@@ -211,38 +230,15 @@ void mic_test_one_task() {
     );
 
     while (1) {
-        fft_config_t *plan = fft_init(FFT_SIZE, FFT_REAL, FFT_FORWARD, NULL, NULL);
         size_t bytesread;
         i2s_channel_read(i2s_chan, (char *)i2s_buffer, FFT_SIZE * sizeof(int16_t), &bytesread, portMAX_DELAY);
+        spectrum.column(i2s_buffer, levels, SPECTRUM_HEIGHT);
 
-        int16_t *samples = (int16_t *)i2s_buffer;
-
-        for (int i = 0; i < FFT_SIZE; i++) { plan->input[i] = (float)samples[i] / 32768.0f; }
-
-        fft_execute(plan);
-
-        for (int i = 1; i < FFT_SIZE / 4 && i < SPECTRUM_HEIGHT; i++) {
-            float re = plan->output[2 * i];
-            float im = plan->output[2 * i + 1];
-            float mag = re * re + im * im;
-            if (mag > 1.0f) mag = 1.0f;
-            uint8_t value = map(mag * 2000, 0, 2000, 0, 255);
-            fftHistory[posData * SPECTRUM_HEIGHT + (SPECTRUM_HEIGHT - i)] = value;
-        }
-
-        posData = (posData + 1) % HISTORY_LEN;
-
-        fft_destroy(plan);
-
-        // Render
+        // scroll one column to the left and draw the new frame on the right
         for (int y = 0; y < SPECTRUM_HEIGHT; y++) {
-            for (int x = 0; x < SPECTRUM_WIDTH; x++) {
-                int index = (x + posData) % HISTORY_LEN;
-                uint8_t val = fftHistory[index * SPECTRUM_HEIGHT + y];
-                uint16_t color =
-                    rgb565(ImageData[val * 3 + 0], ImageData[val * 3 + 1], ImageData[val * 3 + 2]);
-                frameBuffer[y * SPECTRUM_WIDTH + x] = color;
-            }
+            uint16_t *row = frameBuffer + y * SPECTRUM_WIDTH;
+            memmove(row, row + 1, (SPECTRUM_WIDTH - 1) * sizeof(uint16_t));
+            row[SPECTRUM_WIDTH - 1] = palette[levels[y]];
         }
 
         tft.pushImage(
@@ -285,22 +281,17 @@ void mic_test() {
     // Alloc buffers in PSRAM if available
     if (psramFound()) {
         i2s_buffer = (int16_t *)ps_malloc(FFT_SIZE * sizeof(int16_t));
-        fftHistory = (uint8_t *)ps_malloc(HISTORY_LEN * SPECTRUM_HEIGHT);
     } else {
         i2s_buffer = (int16_t *)malloc(FFT_SIZE * sizeof(int16_t));
-        fftHistory = (uint8_t *)malloc(HISTORY_LEN * SPECTRUM_HEIGHT);
     }
-    if (!i2s_buffer || !fftHistory) {
+    if (!i2s_buffer) {
         displayError("Fail to alloc buffers, exiting", true);
         return;
     }
 
-    memset(fftHistory, 0, HISTORY_LEN * SPECTRUM_HEIGHT);
-
     mic_test_one_task();
 
     free(i2s_buffer);
-    free(fftHistory);
 
     delay(10);
     if (deinitMicroPhone()) Serial.println("Fail disabling I2S Driver");
@@ -317,71 +308,184 @@ void mic_test() {
 
 // https://github.com/MhageGH/esp32_SoundRecorder/tree/master
 
-void CreateWavHeader(byte *header, int waveDataSize) {
-    header[0] = 'R';
-    header[1] = 'I';
-    header[2] = 'F';
-    header[3] = 'F';
-    unsigned int fileSizeMinus8 = waveDataSize + 44 - 8;
-    header[4] = (byte)(fileSizeMinus8 & 0xFF);
-    header[5] = (byte)((fileSizeMinus8 >> 8) & 0xFF);
-    header[6] = (byte)((fileSizeMinus8 >> 16) & 0xFF);
-    header[7] = (byte)((fileSizeMinus8 >> 24) & 0xFF);
-    header[8] = 'W';
-    header[9] = 'A';
-    header[10] = 'V';
-    header[11] = 'E';
-    header[12] = 'f';
-    header[13] = 'm';
-    header[14] = 't';
-    header[15] = ' ';
-    header[16] = 0x10; // linear PCM
-    header[17] = 0x00;
-    header[18] = 0x00;
-    header[19] = 0x00;
-    header[20] = 0x01; // linear PCM
-    header[21] = 0x00;
-    header[22] = 0x01; // monoral
-    header[23] = 0x00;
-    header[24] = 0x80; // sampling rate 48000
-    header[25] = 0xBB;
-    header[26] = 0x00;
-    header[27] = 0x00;
-    header[28] = 0x00; // Byte/sec = 48000x2x1 = 96000
-    header[29] = 0x77;
-    header[30] = 0x01;
-    header[31] = 0x00;
-    header[32] = 0x02; // 16bit monoral
-    header[33] = 0x00;
-    header[34] = 0x10; // 16bit
-    header[35] = 0x00;
-    header[36] = 'd';
-    header[37] = 'a';
-    header[38] = 't';
-    header[39] = 'a';
-    header[40] = (byte)(waveDataSize & 0xFF);
-    header[41] = (byte)((waveDataSize >> 8) & 0xFF);
-    header[42] = (byte)((waveDataSize >> 16) & 0xFF);
-    header[43] = (byte)((waveDataSize >> 24) & 0xFF);
+static void writeLE(byte *dst, uint32_t value, uint8_t bytes) {
+    for (uint8_t i = 0; i < bytes; i++) dst[i] = (byte)((value >> (8 * i)) & 0xFF);
 }
 
-void mic_record() {
-    ioExpander.turnPinOnOff(IO_EXP_MIC, HIGH);
+void CreateWavHeader(byte *header, uint32_t waveDataSize, uint32_t sampleRate, uint8_t bitsPerSample) {
+    uint16_t blockAlign = bitsPerSample / 8; // mono
+    memcpy(header, "RIFF", 4);
+    writeLE(header + 4, waveDataSize + WAV_HEADER_SIZE - 8, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    writeLE(header + 16, 16, 4); // fmt chunk size
+    writeLE(header + 20, 1, 2);  // linear PCM
+    writeLE(header + 22, 1, 2);  // monoral
+    writeLE(header + 24, sampleRate, 4);
+    writeLE(header + 28, sampleRate * blockAlign, 4); // Byte/sec
+    writeLE(header + 32, blockAlign, 2);
+    writeLE(header + 34, bitsPerSample, 2);
+    memcpy(header + 36, "data", 4);
+    writeLE(header + 40, waveDataSize, 4);
+}
 
-    bool gpioInput = false;
-    if (!isGPIOOutput(GPIO_NUM_0)) {
-        gpioInput = true;
-        gpio_hold_en(GPIO_NUM_0);
+// Recording runs on two tasks so a slow SD write never stalls the I2S reads:
+// the reader fills a free buffer and hands it to the writer, which stores it
+// and gives it back. If every buffer is waiting on the card, the DMA ring keeps
+// capturing until it overflows, and those overflows are counted from the ISR.
+struct MicRecorder {
+    File file;
+    uint8_t bits = 16;
+    uint8_t count = 0;
+    int16_t *buffers[MIC_REC_BUFFERS] = {};
+    size_t lengths[MIC_REC_BUFFERS] = {};
+    QueueHandle_t freeQueue = nullptr;   // buffers the reader may fill
+    QueueHandle_t filledQueue = nullptr; // buffers waiting for the writer
+    TaskHandle_t owner = nullptr;
+    volatile bool running = false;
+    volatile bool writeError = false;
+    volatile uint32_t dataSize = 0;
+    volatile uint32_t readerStalls = 0; // times the reader found no free buffer
+    volatile uint32_t maxWriteMs = 0;
+};
+
+static MicRecorder rec;
+static volatile uint32_t micOverruns = 0;
+static volatile uint32_t micDroppedBytes = 0;
+
+static bool IRAM_ATTR mic_recv_overflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    micOverruns++;
+    micDroppedBytes += event->size;
+    return false;
+}
+
+static void mic_reader_task(void *param) {
+    uint8_t idx;
+    while (rec.running) {
+        if (xQueueReceive(rec.freeQueue, &idx, 0) != pdTRUE) {
+            rec.readerStalls++;
+            if (xQueueReceive(rec.freeQueue, &idx, pdMS_TO_TICKS(100)) != pdTRUE) continue;
+        }
+        size_t bytesRead = 0;
+        i2s_channel_read(
+            i2s_chan, rec.buffers[idx], MIC_REC_BUFFER_SAMPLES * sizeof(int16_t), &bytesRead, 1000
+        );
+        rec.lengths[idx] = bytesRead;
+        xQueueSend(rec.filledQueue, &idx, portMAX_DELAY);
     }
-    InitI2SMicroPhone();
+    idx = MIC_REC_STOP;
+    xQueueSend(rec.filledQueue, &idx, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
 
-    // Alloc buffers in PSRAM if available
-    if (psramFound()) i2s_buffer = (int16_t *)ps_malloc(FFT_SIZE * sizeof(int16_t));
-    else i2s_buffer = (int16_t *)malloc(FFT_SIZE * sizeof(int16_t));
-    if (!i2s_buffer) {
-        displayError("Fail to alloc buffers, exiting", true);
-        return;
+// Signed 16 bit to unsigned 8 bit PCM, in place
+static size_t mic_to_pcm8(int16_t *samples, size_t count) {
+    uint8_t *out = (uint8_t *)samples;
+    for (size_t i = 0; i < count; i++) out[i] = (uint8_t)((samples[i] >> 8) + 128);
+    return count;
+}
+
+static void mic_writer_task(void *param) {
+    uint8_t idx;
+    while (xQueueReceive(rec.filledQueue, &idx, portMAX_DELAY) == pdTRUE && idx != MIC_REC_STOP) {
+        size_t len = rec.lengths[idx];
+        if (rec.bits == 8) len = mic_to_pcm8(rec.buffers[idx], len / sizeof(int16_t));
+
+        if (len > 0 && !rec.writeError) {
+            uint32_t start = millis();
+            if (rec.file.write((const uint8_t *)rec.buffers[idx], len) == len) rec.dataSize += len;
+            else rec.writeError = true;
+            uint32_t elapsed = millis() - start;
+            if (elapsed > rec.maxWriteMs) rec.maxWriteMs = elapsed;
+        }
+        xQueueSend(rec.freeQueue, &idx, portMAX_DELAY);
+    }
+    xTaskNotifyGive(rec.owner);
+    vTaskDelete(NULL);
+}
+
+static void mic_free_recorder() {
+    for (uint8_t i = 0; i < MIC_REC_BUFFERS; i++) {
+        free(rec.buffers[i]);
+        rec.buffers[i] = nullptr;
     }
+    if (rec.freeQueue) vQueueDelete(rec.freeQueue);
+    if (rec.filledQueue) vQueueDelete(rec.filledQueue);
+    rec.freeQueue = nullptr;
+    rec.filledQueue = nullptr;
+    rec.count = 0;
+}
+
+static bool mic_alloc_recorder() {
+    size_t size = MIC_REC_BUFFER_SAMPLES * sizeof(int16_t);
+    for (rec.count = 0; rec.count < MIC_REC_BUFFERS; rec.count++) {
+        int16_t *buf = (int16_t *)(psramFound() ? ps_malloc(size) : malloc(size));
+        if (!buf) break;
+        rec.buffers[rec.count] = buf;
+    }
+    rec.freeQueue = xQueueCreate(MIC_REC_BUFFERS, sizeof(uint8_t));
+    rec.filledQueue = xQueueCreate(MIC_REC_BUFFERS + 1, sizeof(uint8_t)); // + stop marker
+    if (rec.count < 2 || !rec.freeQueue || !rec.filledQueue) {
+        mic_free_recorder();
+        return false;
+    }
+    for (uint8_t i = 0; i < rec.count; i++) xQueueSend(rec.freeQueue, &i, 0);
+    return true;
+}
+
+static bool mic_start_recorder() {
+    rec.running = true;
+    rec.owner = xTaskGetCurrentTaskHandle();
+    if (xTaskCreate(mic_writer_task, "mic_writer", 4096, nullptr, 4, nullptr) != pdPASS) {
+        rec.running = false;
+        return false;
+    }
+#if SOC_CPU_CORES_NUM > 1
+    BaseType_t res = xTaskCreatePinnedToCore(mic_reader_task, "mic_reader", 3072, nullptr, 6, nullptr, 1);
+#else
+    BaseType_t res = xTaskCreate(mic_reader_task, "mic_reader", 3072, nullptr, 6, nullptr);
+#endif
+    if (res != pdPASS) {
+        // no reader will send the stop marker, do it here so the writer exits
+        rec.running = false;
+        uint8_t stop = MIC_REC_STOP;
+        xQueueSend(rec.filledQueue, &stop, portMAX_DELAY);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        return false;
+    }
+    return true;
+}
+
+static void mic_stop_recorder() {
+    rec.running = false;
+    // the reader finishes its current buffer, the writer drains everything queued
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+static bool mic_select_format(uint32_t &sampleRate, uint8_t &bits) {
+    const uint32_t rates[] = {8000, 16000, 22050, 32000, 44100, 48000};
+    sampleRate = 0;
+    bits = 0;
+
+    options = {};
+    for (uint32_t rate : rates) {
+        options.push_back({(String(rate) + " Hz").c_str(), [rate, &sampleRate]() { sampleRate = rate; }});
+    }
+    loopOptions(options, 5);
+    if (sampleRate == 0) return false;
+
+    options = {
+        {"16 bit", [&bits]() { bits = 16; }},
+        {"8 bit",  [&bits]() { bits = 8; } },
+    };
+    loopOptions(options);
+    options.clear();
+    return bits != 0;
+}
+
+void mic_record() {
+    uint32_t sampleRate;
+    uint8_t bits;
+    if (!mic_select_format(sampleRate, bits)) return;
 
     FS *fs = nullptr;
     if (!getFsStorage(fs) || fs == nullptr) {
@@ -402,17 +506,13 @@ void mic_record() {
     do {
         snprintf(filename, sizeof(filename), "/BruceMIC/recording_%d.wav", index++);
     } while (fs->exists(filename));
-    File audioFile = fs->open(filename, FILE_WRITE, true);
-    if (!audioFile) {
-        displayError("Error creating file", true);
-        return;
-    }
 
     int record_time = 3;
     int last_record_time = -1;
     bool redraw = false;
 
     while (!check(SelPress)) {
+        if (check(EscPress)) return;
         if (check(PrevPress)) { record_time--; }
         if (check(NextPress)) { record_time++; }
 
@@ -435,42 +535,63 @@ void mic_record() {
         }
     }
 
-    const int headerSize = 44;
-    byte header[headerSize] = {0};
+    if (!mic_alloc_recorder()) {
+        displayError("Fail to alloc buffers, exiting", true);
+        return;
+    }
 
-    audioFile.write(header, headerSize);
+    rec.file = fs->open(filename, FILE_WRITE, true);
+    if (!rec.file) {
+        mic_free_recorder();
+        displayError("Error creating file", true);
+        return;
+    }
 
-    unsigned long dataSize = 0;
+    byte header[WAV_HEADER_SIZE] = {0};
+    rec.file.write(header, WAV_HEADER_SIZE);
+    rec.bits = bits;
+    rec.dataSize = 0;
+    rec.readerStalls = 0;
+    rec.maxWriteMs = 0;
+    rec.writeError = false;
+    micOverruns = 0;
+    micDroppedBytes = 0;
+
+    ioExpander.turnPinOnOff(IO_EXP_MIC, HIGH);
+    bool gpioInput = false;
+    if (!isGPIOOutput(GPIO_NUM_0)) {
+        gpioInput = true;
+        gpio_hold_en(GPIO_NUM_0);
+    }
+
+    i2s_event_callbacks_t callbacks = {};
+    callbacks.on_recv_q_ovf = mic_recv_overflow;
+    bool started = InitI2SMicroPhone(sampleRate, MIC_REC_DMA_FRAMES, &callbacks) && mic_start_recorder();
 
-    int bytesPerRead = FFT_SIZE * sizeof(int16_t);
     unsigned long startMillis = millis();
-    if (record_time != 0) {
-        displayRedStripe("Recording...", 0xffff, 0x5db9);
-        while (millis() - startMillis < (unsigned long)record_time * 1000) {
-            size_t bytesRead = 0;
-            i2s_channel_read(i2s_chan, i2s_buffer, bytesPerRead, &bytesRead, 1000);
-            if (bytesRead > 0) {
-                audioFile.write((const uint8_t *)i2s_buffer, bytesRead);
-                dataSize += bytesRead;
-            }
-        }
-    } else {
-        displayRedStripe("Rec... Press Sel to stop", 0xffff, 0x5db9);
-        while (!check(SelPress)) {
-            size_t bytesRead = 0;
-            i2s_channel_read(i2s_chan, (char *)i2s_buffer, bytesPerRead, &bytesRead, 1000);
-
-            if (bytesRead > 0) {
-                audioFile.write((const uint8_t *)i2s_buffer, bytesRead);
-                dataSize += bytesRead;
-            }
+    unsigned long lastDraw = 0;
+    while (started && !rec.writeError) {
+        unsigned long elapsed = millis() - startMillis;
+        if (record_time != 0 && elapsed >= (unsigned long)record_time * 1000) break;
+        if (check(SelPress)) break;
+
+        if (millis() - lastDraw > 500) {
+            lastDraw = millis();
+            String text = String("Rec ") + String(elapsed / 1000) + "s";
+            if (record_time == 0) text += ", Sel to stop";
+            if (micOverruns) text += String(" lost:") + String(micDroppedBytes / sizeof(int16_t));
+            displayRedStripe(text, 0xffff, 0x5db9);
         }
+        vTaskDelay(pdMS_TO_TICKS(20));
     }
+    unsigned long duration = millis() - startMillis;
+    if (started) mic_stop_recorder();
 
-    audioFile.seek(0);
-    CreateWavHeader(header, dataSize);
-    audioFile.write(header, headerSize);
-    audioFile.close();
+    rec.file.seek(0);
+    CreateWavHeader(header, rec.dataSize, sampleRate, bits);
+    rec.file.write(header, WAV_HEADER_SIZE);
+    rec.file.close();
+    mic_free_recorder();
 
     delay(10);
     if (deinitMicroPhone()) Serial.println("Fail disabling I2S Driver");
@@ -481,9 +602,27 @@ void mic_record() {
         pinMode(GPIO_NUM_0, OUTPUT);
         digitalWrite(GPIO_NUM_0, LOW);
     }
-    Serial.println("Recording finished");
-    displaySuccess("Recording Finished", true);
     ioExpander.turnPinOnOff(IO_EXP_MIC, LOW);
+
+    uint32_t dropped = micDroppedBytes / sizeof(int16_t);
+    Serial.printf(
+        "Recording finished: %s, %lu Hz %u bit, %lu bytes in %lu ms, %lu overruns, %lu dropped frames, "
+        "%lu reader stalls, max write %lu ms\n",
+        filename,
+        (unsigned long)sampleRate,
+        bits,
+        (unsigned long)rec.dataSize,
+        duration,
+        (unsigned long)micOverruns,
+        (unsigned long)dropped,
+        (unsigned long)rec.readerStalls,
+        (unsigned long)rec.maxWriteMs
+    );
+
+    if (!started) displayError("Fail to start recorder", true);
+    else if (rec.writeError) displayError("Write failed, recording stopped", true);
+    else if (dropped) displayWarning(String("Saved, lost ") + String(dropped) + " frames", true);
+    else displaySuccess("Recording Finished", true);
 }
 
 #else
@@ -4,6 +4,9 @@
 #endif
 float m_rf_waterfall_start_freq = 433.0;
 float m_rf_waterfall_end_freq = 435.0;
+float m_rf_waterfall_step_khz = 0;
+
+#define WF_ROWS 4 // rows cycling between the sweep task and the renderer
 
 void rf_waterfall() {
     if (bruceConfigPins.rfModule != CC1101_SPI_MODULE) {
@@ -24,6 +27,7 @@ select:
         {"Start Waterfall", [&]() { option = 3; }},
         {"Start Freq.",     [&]() { option = 1; }},
         {"End Freq.",       [&]() { option = 2; }},
+        {"Step",            [&]() { option = 5; }},
         {"Main Menu",       [&]() { option = 4; }},
     };
     idx = loopOptions(options, idx);
@@ -41,6 +45,9 @@ select:
     } else if (option == 2) {
         rf_waterfall_boundary_freq(m_rf_waterfall_end_freq);
         goto select;
+    } else if (option == 5) {
+        rf_waterfall_step();
+        goto select;
     }
 }
 void rf_waterfall_boundary_freq(float &boundary) {
@@ -56,157 +63,312 @@ void rf_waterfall_boundary_freq(float &boundary) {
     options.clear();
 }
 
+void rf_waterfall_step() {
+    const float steps[] = {0, 10, 25, 50, 100, 250, 500};
+    options = {};
+    int ind = 0;
+    for (int i = 0; i < (int)(sizeof(steps) / sizeof(steps[0])); i++) {
+        if (steps[i] == m_rf_waterfall_step_khz) ind = i;
+        String tmp = steps[i] == 0 ? String("Auto") : String(steps[i], 0) + "kHz";
+        float step = steps[i];
+        options.push_back({tmp.c_str(), [step]() { m_rf_waterfall_step_khz = step; }});
+    }
+    loopOptions(options, ind);
+    options.clear();
+}
+
+
 uint16_t swapBytes(uint16_t c) { return (c >> 8) | (c << 8); }
 
+// Tuning and RSSI reads run on their own task, the renderer only converts
+// finished rows through the colormap and pushes them in a single blit.
+struct WaterfallSweep {
+    float start;
+    float step; // MHz between points
+    uint16_t points;
+    bool sharedBus; // CC1101 on the TFT bus, every access must hold busMutex
+    uint8_t *levels; // WF_ROWS rows of `points` levels, 0 = -100dBm, 255 = -30dBm
+    int peakRssi[WF_ROWS];
+    float peakFreq[WF_ROWS];
+    QueueHandle_t freeRows;
+    QueueHandle_t readyRows;
+    SemaphoreHandle_t busMutex;
+    TaskHandle_t owner;
+    volatile bool running;
+    volatile uint32_t sweeps;
+};
+
+static WaterfallSweep wf = {};
+static uint16_t wfColormap[256];
+
+static void rf_waterfall_build_colormap() {
+    for (int raw = 0; raw < 256; raw++) {
+        int level = 255 - raw;
+        uint8_t r = 0, g = 0, b = 0;
+        if (level <= 63) {
+            b = map(level, 0, 63, 64, 255);
+        } else if (level <= 127) {
+            g = map(level, 64, 127, 0, 255);
+            b = map(level, 64, 127, 255, 0);
+        } else if (level <= 191) {
+            r = map(level, 128, 191, 0, 255);
+            g = 255;
+        } else {
+            r = 255;
+            g = map(level, 192, 255, 255, 0);
+        }
+        wfColormap[raw] = swapBytes(tft.color565(r, g, b));
+    }
+}
+
+static inline void rf_waterfall_lock_bus() {
+    if (wf.busMutex) xSemaphoreTake(wf.busMutex, portMAX_DELAY);
+}
+
+static inline void rf_waterfall_unlock_bus() {
+    if (wf.busMutex) xSemaphoreGive(wf.busMutex);
+}
+
+static void rf_waterfall_sweep_task(void *param) {
+    uint8_t row;
+    while (wf.running) {
+        if (xQueueReceive(wf.freeRows, &row, pdMS_TO_TICKS(50)) != pdTRUE) continue;
+
+        uint8_t *levels = wf.levels + row * wf.points;
+        int peak_rssi = -128;
+        float peak_freq = wf.start;
+        for (uint16_t i = 0; i < wf.points; i++) {
+            float f_freq = wf.start + i * wf.step;
+            rf_waterfall_lock_bus();
+            setMHZ(f_freq);
+            // To make sure CC1101 shared with TFT works properly on T-Embed
+            if (wf.sharedBus) {
+                tft.drawPixel(0, 0, 0);
+                delayMicroseconds(150); // T-Embed case, need more time to process
+            } else delayMicroseconds(100);
+
+            int i_rssi = ELECHOUSE_cc1101.getRssi();
+            if (wf.sharedBus) tft.drawPixel(0, 0, 0);
+            rf_waterfall_unlock_bus();
+
+            if (i_rssi > peak_rssi) {
+                peak_rssi = i_rssi;
+                peak_freq = f_freq;
+            }
+            levels[i] = constrain(map(i_rssi, -100, -30, 0, 255), 0, 255);
+        }
+        wf.peakRssi[row] = peak_rssi;
+        wf.peakFreq[row] = peak_freq;
+        wf.sweeps++;
+        xQueueSend(wf.readyRows, &row, portMAX_DELAY);
+        vTaskDelay(1); // busy waits above, let the idle task feed the watchdog
+    }
+    xTaskNotifyGive(wf.owner);
+    vTaskDelete(NULL);
+}
+
+static bool rf_waterfall_start_sweep(float f_start, float f_end, int screen_width) {
+    float span = f_end - f_start;
+    float step = m_rf_waterfall_step_khz / 1000.0;
+    int points = screen_width;
+    if (step > 0 && span > 0) points = constrain((int)(span / step) + 1, 2, screen_width);
+    // a step too fine for the screen is widened so the sweep still covers the span
+    wf.step = (step > 0 && points < screen_width) ? step : span / points;
+    wf.start = f_start;
+
+    if (wf.levels == nullptr || wf.points != points) {
+        free(wf.levels);
+        wf.levels = (uint8_t *)malloc(WF_ROWS * points);
+        if (wf.levels == nullptr) return false;
+    }
+    wf.points = points;
+
+    xQueueReset(wf.freeRows);
+    xQueueReset(wf.readyRows);
+    for (uint8_t i = 0; i < WF_ROWS; i++) xQueueSend(wf.freeRows, &i, 0);
+
+    wf.sweeps = 0;
+    wf.running = true;
+    wf.owner = xTaskGetCurrentTaskHandle();
+#if SOC_CPU_CORES_NUM > 1
+    BaseType_t res =
+        xTaskCreatePinnedToCore(rf_waterfall_sweep_task, "rf_wf_sweep", 4096, nullptr, 2, nullptr, 0);
+#else
+    BaseType_t res = xTaskCreate(rf_waterfall_sweep_task, "rf_wf_sweep", 4096, nullptr, 2, nullptr);
+#endif
+    if (res != pdPASS) wf.running = false;
+    return wf.running;
+}
+
+static void rf_waterfall_stop_sweep() {
+    if (!wf.running) return;
+    wf.running = false;
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+static void rf_waterfall_draw_header(float f_start, float f_end, int selected_item, int screen_width) {
+    rf_waterfall_lock_bus();
+    tft.fillRect(0, 0, screen_width, 10, TFT_BLACK);
+    tft.setTextSize(1);
+    for (int i = 0; i < 4; i++) {
+        int x = i * (screen_width / 4);
+        float f_freq = f_start + (f_end - f_start) * i / 4.0;
+        tft.setCursor(x, 0);
+
+        if ((i == 0 && selected_item == 0) || (i == 3 && selected_item == 1)) {
+            tft.setTextColor(TFT_PINK, TFT_BLACK);
+        } else {
+            tft.setTextColor(TFT_WHITE, TFT_BLACK);
+        }
+        tft.print(String(f_freq, 1));
+    }
+
+    tft.fillRect(0, 20, screen_width, 10, TFT_BLACK);
+    tft.setCursor(3, 20);
+    tft.setTextColor(TFT_DARKCYAN);
+    tft.print("[OK] Item [PREV/NEXT] Value ");
+    tft.setTextColor(selected_item == 2 ? TFT_RED : TFT_WHITE);
+    tft.print("EXIT");
+    rf_waterfall_unlock_bus();
+}
+
 void rf_waterfall_run() {
     float f_start = m_rf_waterfall_start_freq;
     float f_end = m_rf_waterfall_end_freq;
     const int screen_width = tft.width();
     const int screen_height = tft.height();
     const int display_top = screen_height / 5;
-    float f_freq_step;
 
     // Alloc framebuffer
     uint16_t frameBuffer[screen_width] = {0};
 
     int current_line = display_top;
     initRfModule("rx", f_start);
+    rf_waterfall_build_colormap();
+
+    wf.sharedBus = bruceConfigPins.CC1101_bus.mosi == TFT_MOSI;
+    wf.freeRows = xQueueCreate(WF_ROWS, sizeof(uint8_t));
+    wf.readyRows = xQueueCreate(WF_ROWS, sizeof(uint8_t));
+    wf.busMutex = wf.sharedBus ? xSemaphoreCreateMutex() : nullptr;
+    bool ok = wf.freeRows && wf.readyRows && (!wf.sharedBus || wf.busMutex);
+    if (ok) ok = rf_waterfall_start_sweep(f_start, f_end, screen_width);
 
     float max_freq = f_start;
     int max_rssi = -100;
+    float temp_max_freq = f_start;
+    int temp_max_rssi = -100;
     unsigned long lastMaxUpdate = millis();
+    unsigned long lastRateUpdate = millis();
 
     tft.fillRect(0, 0, screen_width, display_top, TFT_BLACK);
 
     int selected_item = 0;
-    bool exitting = false;
-    unsigned long exit_time = 0;
-
-    while (1) {
-        for (int i = 0; i < 4; i++) {
-            int x = i * (screen_width / 4);
-            float f_freq = f_start + (f_end - f_start) * i / 4.0;
-            tft.setCursor(x, 0);
-            tft.setTextSize(1);
+    bool redraw_header = true;
 
-            if (i == 0 && selected_item == 0) {
-                tft.setTextColor(TFT_PINK, TFT_BLACK);
-            } else if (i == 3 && selected_item == 1) {
-                tft.setTextColor(TFT_PINK, TFT_BLACK);
-            } else {
-                tft.setTextColor(TFT_WHITE, TFT_BLACK);
-            }
-
-            tft.drawFastVLine(x, 0, tft.height(), TFT_DARKGREY);
-            tft.print(String(f_freq, 1));
+    while (ok) {
+        if (redraw_header) {
+            rf_waterfall_draw_header(f_start, f_end, selected_item, screen_width);
+            redraw_header = false;
         }
 
-        f_freq_step = (f_end - f_start) / screen_width;
-
-        float temp_max_freq = f_start;
-        int temp_max_rssi = -100;
-
-        float range = abs(f_end - f_start);
-        float step;
-
-        if (range > 100) step = 10;
-        else if (range > 10) step = 1;
-        else if (range > 1) step = 0.1;
-        else if (range > 0.1) step = 0.01;
-        else step = 0.001;
-
-        for (int i = 0; i < screen_width; ++i) {
-            float f_freq = f_start + i * f_freq_step;
-            setMHZ(f_freq);
-            // To make sure CC1101 shared with TFT works properly on T-Embed
-            if (bruceConfigPins.CC1101_bus.mosi == TFT_MOSI) {
-                tft.drawPixel(0, 0, 0);
-                delayMicroseconds(150); // T-Embed case, need more time to process
-            } else delayMicroseconds(100);
-
-            int i_rssi = ELECHOUSE_cc1101.getRssi();
-            // To make sure CC1101 shared with TFT works properly on T-Embed
-            if (bruceConfigPins.CC1101_bus.mosi == TFT_MOSI) tft.drawPixel(0, 0, 0);
-            if (i_rssi > temp_max_rssi) {
-                temp_max_rssi = i_rssi;
-                temp_max_freq = f_freq;
+        uint8_t row;
+        if (xQueueReceive(wf.readyRows, &row, pdMS_TO_TICKS(20)) == pdTRUE) {
+            const uint8_t *levels = wf.levels + row * wf.points;
+            for (int x = 0; x < screen_width; x++) {
+                frameBuffer[x] = wfColormap[levels[x * wf.points / screen_width]];
             }
-
-            int rawLevel = map(i_rssi, -100, -30, 0, 255);
-            int level = 255 - constrain(rawLevel, 0, 255);
-
-            uint8_t r = 0, g = 0, b = 0;
-            if (level <= 63) {
-                b = map(level, 0, 63, 64, 255);
-            } else if (level <= 127) {
-                g = map(level, 64, 127, 0, 255);
-                b = map(level, 64, 127, 255, 0);
-            } else if (level <= 191) {
-                r = map(level, 128, 191, 0, 255);
-                g = 255;
-            } else {
-                r = 255;
-                g = map(level, 192, 255, 255, 0);
+            for (int i = 1; i < 4; i++) frameBuffer[i * (screen_width / 4)] = swapBytes(TFT_DARKGREY);
+            if (wf.peakRssi[row] > temp_max_rssi) {
+                temp_max_rssi = wf.peakRssi[row];
+                temp_max_freq = wf.peakFreq[row];
             }
+            xQueueSend(wf.freeRows, &row, 0);
 
-            uint16_t color = tft.color565(r, g, b);
-            frameBuffer[i] = swapBytes(color);
-            if (check(SelPress)) {
-                selected_item++;
-                if (selected_item > 2) selected_item = 0;
-            }
+            rf_waterfall_lock_bus();
+            tft.drawPixel(0, 0, 0); // Cardputer Case, need to call something to the tft.
+            tft.pushImage(0, current_line, screen_width, 1, frameBuffer);
+            tft.drawFastHLine(0, current_line + 1, screen_width, TFT_DARKGREY);
+            rf_waterfall_unlock_bus();
 
-            if (check(UpPress) || check(NextPress)) {
-                switch (selected_item) {
-                    case 0: f_start += step; break;
-                    case 1: f_end += step; break;
-                    case 2: return;
-                }
-                delay(100);
-            } else if (check(DownPress) || check(PrevPress)) {
-                switch (selected_item) {
-                    case 0: f_start -= step; break;
-                    case 1: f_end -= step; break;
-                    case 2: return;
-                }
-                if (EscPress) EscPress = false; // Reset for StickCs
-                delay(100);
-            }
+            current_line++;
+            if (current_line >= screen_height) current_line = display_top;
         }
-        tft.drawPixel(0, 0, 0); // Cardputer Case, need to call something to the tft.
-        tft.pushImage(0, current_line, screen_width, 1, frameBuffer);
-        tft.drawFastHLine(0, current_line + 1, screen_width, TFT_DARKGREY);
 
         if (millis() - lastMaxUpdate >= 5000) {
             max_rssi = temp_max_rssi;
             max_freq = temp_max_freq;
+            temp_max_rssi = -100;
+            temp_max_freq = f_start;
+            lastMaxUpdate = millis();
+        }
+
+        if (millis() - lastRateUpdate >= 1000) {
+            float rate = wf.sweeps * 1000.0 / (millis() - lastRateUpdate);
+            wf.sweeps = 0;
+            lastRateUpdate = millis();
+
+            rf_waterfall_lock_bus();
             tft.fillRect(0, 10, screen_width, 10, TFT_BLACK);
             tft.setCursor(3, 10);
             tft.setTextSize(1);
             tft.setTextColor(TFT_YELLOW, TFT_BLACK);
-            tft.printf("%d dBm @ %.3f", max_rssi, max_freq);
-
-            lastMaxUpdate = millis();
+            tft.printf("%d dBm @ %.3f  %.1f sw/s", max_rssi, max_freq, rate);
+            rf_waterfall_unlock_bus();
         }
 
-        tft.setCursor(3, 20);
-        tft.setTextColor(TFT_DARKCYAN);
-        tft.print("[OK] Item [PREV/NEXT] Value ");
+        float range = abs(f_end - f_start);
+        float step;
 
-        if (selected_item == 2) {
-            tft.setTextColor(TFT_RED);
-            tft.print("EXIT");
-        } else {
-            tft.setTextColor(TFT_WHITE);
-            tft.print("EXIT");
+        if (range > 100) step = 10;
+        else if (range > 10) step = 1;
+        else if (range > 1) step = 0.1;
+        else if (range > 0.1) step = 0.01;
+        else step = 0.001;
+
+        bool retune = false;
+        if (check(SelPress)) {
+            selected_item++;
+            if (selected_item > 2) selected_item = 0;
+            redraw_header = true;
+        }
+
+        if (check(UpPress) || check(NextPress)) {
+            switch (selected_item) {
+                case 0: f_start += step; break;
+                case 1: f_end += step; break;
+                case 2: ok = false; break;
+            }
+            retune = true;
+        } else if (check(DownPress) || check(PrevPress)) {
+            switch (selected_item) {
+                case 0: f_start -= step; break;
+                case 1: f_end -= step; break;
+                case 2: ok = false; break;
+            }
+            if (EscPress) EscPress = false; // Reset for StickCs
+            retune = true;
         }
 
         if (check(EscPress)) break;
 
-        current_line++;
-        if (current_line >= screen_height) current_line = display_top;
+        if (retune && ok) {
+            rf_waterfall_stop_sweep();
+            ok = rf_waterfall_start_sweep(f_start, f_end, screen_width);
+            redraw_header = true;
+        }
     }
 
+    rf_waterfall_stop_sweep();
+    if (wf.freeRows) vQueueDelete(wf.freeRows);
+    if (wf.readyRows) vQueueDelete(wf.readyRows);
+    if (wf.busMutex) vSemaphoreDelete(wf.busMutex);
+    free(wf.levels);
+    wf.levels = nullptr;
+    wf.points = 0;
+    wf.freeRows = nullptr;
+    wf.readyRows = nullptr;
+    wf.busMutex = nullptr;
+
     returnToMenu = true;
     deinitRfModule();
     delay(10);
@@ -3,9 +3,11 @@
 #include "rf_utils.h"
 
 void rf_waterfall_boundary_freq(float &boundary);
+void rf_waterfall_step();
 void rf_waterfall_run();
 
 extern float m_rf_waterfall_start_freq;
 extern float m_rf_waterfall_end_freq;
+extern float m_rf_waterfall_step_khz; // 0 = one point per screen column
 
 void rf_waterfall();
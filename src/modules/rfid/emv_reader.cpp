@@ -438,7 +438,7 @@ void EMVReader::display_emv(EMVCard card) {
 
     padprintln("Press any key to continue...");
 
-    while (!AnyKeyPress) { delay(100); }
+    while (!check(AnyKeyPress)) { delay(100); }
 
     options = {};
     options.emplace_back("Save", [this, aid, pan, issuedate, validto]() {
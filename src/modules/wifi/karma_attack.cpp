@@ -313,6 +313,7 @@ void karma_setup() {
             }
             LongPress = false;
             if (millis() - _tmp > 700) { // longpress detected to exit
+                inputDrain();
                 returnToMenu = true;
                 break;
             }
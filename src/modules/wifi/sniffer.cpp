@@ -1079,6 +1079,7 @@ void sniffer_setup() {
                 vTaskDelay(10 / portTICK_RATE_MS);
             }
             if (millis() - _tmp > 700) { // longpress detected to exit
+                inputDrain();
                 returnToMenu = true;
                 _pcap_file.close();
                 break;
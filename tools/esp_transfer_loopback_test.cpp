@@ -0,0 +1,100 @@
+/*
+ * Host test of the ESP-NOW file transfer protocol: a sender and a receiver run
+ * against each other over a simulated link losing frames both ways, every
+ * transfer must arrive intact. Prints the throughput on the simulated link.
+ *
+ *   g++ -std=c++17 -O2 -Isrc -Itools/host tools/esp_transfer_loopback_test.cpp \
+ *       src/core/connect/esp_transfer.cpp -lcrypto -o esp_transfer_loopback_test \
+ *       && ./esp_transfer_loopback_test
+ *
+ * The same loopback runs on the device with 'espnow_loopback [loss] [kb]'.
+ */
+#include "host/check.h"
+#include <core/connect/esp_transfer.h>
+#include <stdio.h>
+#include <string.h>
+
+// A START sent again because our answer was lost gets the same answer
+static void testRetriedStart() {
+    uint8_t answer = 0;
+    EspTransferReceiver receiver(
+        [&](const uint8_t *data, size_t) {
+            answer = data[1];
+            return true;
+        },
+        [&](const XferStartFrame &) { return false; },
+        [&](const uint8_t *, size_t) { return true; }
+    );
+    XferStartFrame start;
+    memset(&start, 0, sizeof(start));
+    start.h = {XFER_MAGIC, XFER_START, 7, 0};
+    start.totalBytes = 100;
+    start.chunkSize = XFER_CHUNK_SIZE;
+    start.window = XFER_WINDOW;
+    for (int i = 0; i < 2; i++) {
+        answer = 0;
+        receiver.onFrame((const uint8_t *)&start, sizeof(start), i);
+        CHECK(
+            answer == XFER_ABORT, "START %d to a receiver that cannot open the file: answer %u", i + 1, answer
+        );
+    }
+
+    EspTransferReceiver opened(
+        [&](const uint8_t *data, size_t) {
+            answer = data[1];
+            return true;
+        },
+        [&](const XferStartFrame &) { return true; },
+        [&](const uint8_t *, size_t) { return true; }
+    );
+    for (int i = 0; i < 2; i++) {
+        answer = 0;
+        opened.onFrame((const uint8_t *)&start, sizeof(start), i);
+        CHECK(
+            answer == XFER_START_ACK, "START %d to a receiver that opened the file: answer %u", i + 1, answer
+        );
+    }
+}
+
+int main() {
+    const uint8_t losses[] = {0, 1, 5, 10, 20, 40};
+    const uint32_t sizes[] = {0, 1, XFER_CHUNK_SIZE, XFER_CHUNK_SIZE + 1, 64 * 1024, 1024 * 1024};
+    const uint32_t seeds = 5; // links with different losses for each case
+
+    printf("Loss  Bytes     Frames   Retransmits  Dropped  Link ms   KB/s   Efficiency\n");
+    for (uint8_t loss : losses) {
+        for (uint32_t size : sizes) {
+            XferLoopbackResult sum;
+            for (uint32_t seed = 1; seed <= seeds; seed++) {
+                XferLoopbackResult r = espTransferLoopback(loss, size, seed * 0x9E3779B9u);
+                CHECK(r.ok, "%u%% loss, %u bytes, seed %u: transfer failed", loss, size, seed);
+                sum.dropped += r.dropped;
+                sum.stats.frames += r.stats.frames;
+                sum.stats.retransmits += r.stats.retransmits;
+                sum.stats.bytes += r.stats.bytes;
+                sum.stats.finishedAt += r.stats.elapsed();
+            }
+            if (size < 64 * 1024) continue; // too short for a meaningful rate
+            const XferStats &s = sum.stats;
+            printf(
+                "%3u%%  %-8u  %-7u  %-11u  %-7u  %-8u  %5.1f  %5.0f%%\n",
+                loss,
+                size,
+                s.frames / seeds,
+                s.retransmits / seeds,
+                sum.dropped / seeds,
+                s.elapsed() / seeds,
+                s.kbps(),
+                s.elapsed() ? 100.0 * s.bytes / XFER_CHUNK_SIZE / s.elapsed() : 0.0
+            );
+        }
+    }
+
+    testRetriedStart();
+
+    // a lost link gives up instead of retrying forever
+    XferLoopbackResult dead = espTransferLoopback(100, 4096, 1);
+    CHECK(!dead.ok && dead.stats.elapsed() > 0, "transfer over a dead link did not fail");
+
+    return checkResult();
+}
@@ -0,0 +1,28 @@
+/*
+ * The part of the Arduino MD5Builder the host tools use, on OpenSSL (link with -lcrypto).
+ */
+#ifndef __HOST_MD5_BUILDER_H__
+#define __HOST_MD5_BUILDER_H__
+
+#include <openssl/evp.h>
+#include <stdint.h>
+#include <string.h>
+
+class MD5Builder {
+public:
+    MD5Builder() { _ctx = EVP_MD_CTX_new(); }
+    ~MD5Builder() { EVP_MD_CTX_free(_ctx); }
+    MD5Builder(const MD5Builder &) = delete;
+    MD5Builder &operator=(const MD5Builder &) = delete;
+
+    void begin(void) { EVP_DigestInit_ex(_ctx, EVP_md5(), nullptr); }
+    void add(const uint8_t *data, size_t len) { EVP_DigestUpdate(_ctx, data, len); }
+    void calculate(void) { EVP_DigestFinal_ex(_ctx, _digest, nullptr); }
+    void getBytes(uint8_t *output) { memcpy(output, _digest, sizeof(_digest)); }
+
+private:
+    EVP_MD_CTX *_ctx;
+    uint8_t _digest[16] = {0};
+};
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * Failure counting shared by the host tests in tools/: CHECK() prints the
+ * message of a condition that does not hold and counts it, main() ends with
+ * return checkResult().
+ */
+#ifndef __HOST_CHECK_H__
+#define __HOST_CHECK_H__
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                                                   \
+    do {                                                                                                   \
+        if (!(cond)) {                                                                                     \
+            printf(__VA_ARGS__);                                                                           \
+            printf("\n");                                                                                  \
+            failures++;                                                                                    \
+        }                                                                                                  \
+    } while (0)
+
+// Prints the number of failures or OK, returns the exit status of the test
+static inline int checkResult() {
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Host benchmark of the mic spectrum FFT, a plan built for every frame against the
+ * MicSpectrum plan kept for the session.
+ *
+ *   FFT=.pio/libdeps/<env>/FFT/src
+ *   gcc -O2 -c $FFT/fft.c -o fft.o
+ *   g++ -std=c++17 -O2 -Iinclude -I$FFT tools/mic_fft_bench.cpp fft.o -o mic_fft_bench
+ *   ./mic_fft_bench [seconds per run]
+ *
+ * FFT is the tinyu-zhao/FFT library PlatformIO fetches for the mic boards. Both modes
+ * window the same frames and must produce the same spectrogram columns.
+ */
+#include <chrono>
+#include <micSpectrum.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define SPECTRUM_HEIGHT 124
+
+typedef std::chrono::steady_clock Clock;
+
+// A tone sweeping the band over some noise, like someone whistling at the mic
+static std::vector<int16_t> makeFrames(int size, int count) {
+    std::vector<int16_t> frames(size * count);
+    for (int f = 0; f < count; f++) {
+        float freq = 0.01f + 0.2f * f / count;
+        for (int i = 0; i < size; i++) {
+            float v = 0.4f * sinf(2.0f * (float)M_PI * freq * i) + 0.02f * (rand() % 200 - 100) / 100.0f;
+            frames[f * size + i] = (int16_t)(v * 32767);
+        }
+    }
+    return frames;
+}
+
+// What mic.cpp did before, a new plan and window for each frame
+static void columnFresh(const int16_t *samples, int size, uint8_t *out) {
+    MicSpectrum spectrum;
+    spectrum.begin(size);
+    spectrum.column(samples, out, SPECTRUM_HEIGHT);
+}
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    const int sizes[] = {256, 512, 1024};
+    const int count = 64;
+    bool ok = true;
+
+    printf("Points  Plan per frame  Persistent plan  Speedup   (frames/s)\n");
+    for (int size : sizes) {
+        std::vector<int16_t> frames = makeFrames(size, count);
+        uint8_t fresh[SPECTRUM_HEIGHT], kept[SPECTRUM_HEIGHT];
+
+        MicSpectrum spectrum;
+        if (!spectrum.begin(size)) {
+            fprintf(stderr, "Cannot allocate a %d point plan\n", size);
+            return 1;
+        }
+        for (int f = 0; f < count; f++) {
+            columnFresh(&frames[f * size], size, fresh);
+            spectrum.column(&frames[f * size], kept, SPECTRUM_HEIGHT);
+            if (memcmp(fresh, kept, sizeof(kept)) != 0) ok = false;
+        }
+
+        double rate[2];
+        for (int mode = 0; mode < 2; mode++) {
+            long done = 0;
+            auto start = Clock::now();
+            double elapsed = 0;
+            while (elapsed < seconds) {
+                for (int f = 0; f < count; f++) {
+                    if (mode == 0) columnFresh(&frames[f * size], size, fresh);
+                    else spectrum.column(&frames[f * size], kept, SPECTRUM_HEIGHT);
+                }
+                done += count;
+                elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            }
+            rate[mode] = done / elapsed;
+        }
+        printf("%6d  %14.0f  %15.0f  %6.2fx\n", size, rate[0], rate[1], rate[1] / rate[0]);
+    }
+    printf("Columns %s between the two modes\n", ok ? "match" : "DO NOT MATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+/*
+ * Host test of the incremental tft log: a client applying the deltas in order
+ * must end up with the bytes of the full snapshot, with and without the LZ pass.
+ *
+ *   g++ -std=c++17 -O2 -Iinclude tools/tft_log_delta_test.cpp src/core/tftLogger/tftLogStore.cpp \
+ *       -o tft_log_delta_test && ./tft_log_delta_test
+ */
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <tftLogStore.h>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+// What a WebUI or serial client keeps between requests
+struct LogMirror {
+    Bytes info;
+    Bytes slots[MAX_LOG_ENTRIES];
+    std::string images[MAX_LOG_IMAGES];
+    uint32_t cursor = 0;
+
+    bool apply(const uint8_t *p, size_t n) {
+        const uint8_t *set = nullptr, *cleared = nullptr;
+        int slot = 0;
+        for (size_t pos = 0; pos < n;) {
+            if (pos + 3 > n || p[pos] != LOG_PACKET_HEADER || p[pos + 1] < 3 || pos + p[pos + 1] > n)
+                return false;
+            const uint8_t *packet = p + pos;
+            uint8_t size = packet[1];
+            pos += size;
+
+            if (packet[2] == SCREEN_INFO) {
+                info.assign(packet, packet + size);
+            } else if (packet[2] == LOG_DELTA) {
+                if (size != LOG_DELTA_SIZE) return false;
+                cursor = packet[3] << 24 | packet[4] << 16 | packet[5] << 8 | packet[6];
+                set = packet + 11;
+                cleared = set + MAX_LOG_ENTRIES / 8;
+                for (int i = 0; i < MAX_LOG_ENTRIES; i++) {
+                    if (cleared[i / 8] & (0x80 >> (i % 8))) slots[i].clear();
+                }
+            } else if (packet[2] == LOG_IMAGE) {
+                if (packet[3] >= MAX_LOG_IMAGES) return false;
+                images[packet[3]].assign((const char *)packet + 4, size - 4);
+            } else {
+                if (set == nullptr) return false;
+                while (slot < MAX_LOG_ENTRIES && !(set[slot / 8] & (0x80 >> (slot % 8)))) slot++;
+                if (slot == MAX_LOG_ENTRIES) return false;
+                slots[slot++].assign(packet, packet + size);
+            }
+        }
+        return set != nullptr;
+    }
+
+    // The same layout as TftLogStore::snapshot()
+    Bytes snapshot() {
+        Bytes out = info;
+        for (const Bytes &entry : slots) {
+            if (entry.empty()) continue;
+            if (entry[2] != DRAWIMAGE) {
+                out.insert(out.end(), entry.begin(), entry.end());
+                continue;
+            }
+            const std::string &path = images[entry[12]];
+            size_t start = out.size();
+            out.insert(out.end(), entry.begin(), entry.begin() + 12);
+            out.insert(out.end(), path.begin(), path.end());
+            out[start + 1] = 12 + path.size();
+        }
+        return out;
+    }
+};
+
+static uint32_t rng = 12345;
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1103515245 + 12345;
+    return (rng >> 8) % n;
+}
+
+static void writeUint16(tftLog &l, uint8_t &pos, uint16_t v) {
+    l.data[pos++] = v >> 8;
+    l.data[pos++] = v & 0xFF;
+}
+
+static tftLog randomEntry(TftLogStore &store) {
+    tftLog l;
+    uint8_t pos = 3;
+    l.data[0] = LOG_PACKET_HEADER;
+    uint8_t fn = rnd(4);
+    if (fn == 0) {
+        l.data[2] = FILLRECT;
+        for (int i = 0; i < 5; i++) writeUint16(l, pos, rnd(i < 2 ? 240 : 60));
+    } else if (fn == 1) {
+        static const char *labels[] = {"WiFi", "BLE", "RF", "RFID", "Infrared", "Config", "  12:00  "};
+        const char *text = labels[rnd(7)];
+        l.data[2] = DRAWSTRING;
+        writeUint16(l, pos, 10 + rnd(8) * 20);
+        writeUint16(l, pos, 30 + rnd(6) * 15);
+        writeUint16(l, pos, 1);
+        writeUint16(l, pos, 0xFFFF);
+        writeUint16(l, pos, rnd(2) ? 0x780F : 0);
+        memcpy(l.data + pos, text, strlen(text));
+        pos += strlen(text);
+    } else if (fn == 2) {
+        static const char *paths[] = {"/boot.jpg", "/themes/bruce/wifi.gif", "/img/rf.png", "/img/ir.png"};
+        uint8_t slot = store.imageSlot(paths[rnd(4)]);
+        if (slot == 0xFF) slot = 0;
+        const char *path = store.image(slot);
+        l.data[2] = DRAWIMAGE;
+        writeUint16(l, pos, rnd(4) * 60);
+        writeUint16(l, pos, rnd(2) * 60);
+        writeUint16(l, pos, rnd(2));
+        writeUint16(l, pos, 0);
+        l.data[pos++] = 0;
+        l.data[pos++] = slot;
+        memcpy(l.data + pos, path, strlen(path));
+        pos += strlen(path);
+    } else {
+        l.data[2] = DRAWLINE;
+        for (int i = 0; i < 5; i++) writeUint16(l, pos, rnd(240));
+    }
+    l.data[1] = pos;
+    return l;
+}
+
+static bool checkDelta(TftLogStore &store, LogMirror &client, bool lz, size_t &deltaBytes, size_t &lzBytes) {
+    static uint8_t info[8] = {LOG_PACKET_HEADER, 8, SCREEN_INFO, 0, 240, 0, 135, 1};
+    static uint8_t delta[MAX_LOG_DELTA_SIZE], packed[MAX_LOG_DELTA_SIZE * 2], expanded[MAX_LOG_DELTA_SIZE];
+    size_t size = 0;
+    uint32_t cursor = store.delta(client.cursor, info, sizeof(info), delta, size);
+    deltaBytes += size;
+    const uint8_t *in = delta;
+    if (lz) {
+        size_t packedSize = tftLogCompress(delta, size, packed);
+        lzBytes += packedSize;
+        if (tftLogExpand(packed, packedSize, expanded, sizeof(expanded)) != size) return false;
+        in = expanded;
+    }
+    if (!client.apply(in, size) || client.cursor != cursor) return false;
+
+    static uint8_t full[MAX_LOG_ENTRIES * MAX_LOG_SIZE];
+    size_t fullSize = 0;
+    store.snapshot(info, sizeof(info), full, fullSize);
+    return client.snapshot() == Bytes(full, full + fullSize);
+}
+
+int main() {
+    TftLogStore store;
+    store.setSession(0x5A);
+    LogMirror client, lzClient;
+    int failures = 0;
+    size_t deltaBytes = 0, lzBytes = 0, unused = 0, fullBytes = 0;
+    int requests = 0;
+
+    for (int op = 0; op < 20000; op++) {
+        uint32_t what = rnd(100);
+        if (what < 70) store.push(randomEntry(store));
+        else if (what < 85) store.removeInsideRect(rnd(240), rnd(135), rnd(80), rnd(40));
+        else if (what < 95) store.removeImages(rnd(4) * 60, rnd(2) * 60, rnd(2), 0);
+        else if (what < 97) store.clear();
+
+        if (op % 7 != 0) continue;
+        requests++;
+        if (!checkDelta(store, client, false, deltaBytes, unused)) {
+            printf("op %d: delta does not rebuild the snapshot\n", op);
+            failures++;
+            client = LogMirror();
+        }
+        if (!checkDelta(store, lzClient, true, unused, lzBytes)) {
+            printf("op %d: compressed delta does not rebuild the snapshot\n", op);
+            failures++;
+            lzClient = LogMirror();
+        }
+        uint8_t info[8] = {LOG_PACKET_HEADER, 8, SCREEN_INFO, 0, 240, 0, 135, 1};
+        static uint8_t full[MAX_LOG_ENTRIES * MAX_LOG_SIZE];
+        size_t fullSize = 0;
+        store.snapshot(info, sizeof(info), full, fullSize);
+        fullBytes += fullSize;
+    }
+
+    // a client that joins late, one with a cursor ahead of the store, and one from the previous boot
+    // whose sequence is still below this one
+    LogMirror late, stale, otherBoot;
+    stale.cursor = store.sequence() + 1000;
+    otherBoot.cursor = ((store.sequence() >> 24) % 255 + 1) << 24 | 1;
+    if (!checkDelta(store, late, false, unused, unused)) {
+        printf("cursor 0 does not rebuild the snapshot\n");
+        failures++;
+    }
+    if (!checkDelta(store, stale, false, unused, unused)) {
+        printf("unknown cursor does not rebuild the snapshot\n");
+        failures++;
+    }
+    if (!checkDelta(store, otherBoot, false, unused, unused)) {
+        printf("cursor of another session does not rebuild the snapshot\n");
+        failures++;
+    }
+
+    printf(
+        "%d requests: full snapshots %zu bytes, deltas %zu bytes, deltas with LZ %zu bytes\n",
+        requests,
+        fullBytes,
+        deltaBytes,
+        lzBytes
+    );
+    printf(failures ? "FAILED: %d\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Host test of the GPX track writer: 100k points appended in TrackWriter
+ * sized flushes must give a well-formed file holding every point, and a file
+ * that does not end with our trailer must be appended to, not overwritten.
+ *
+ *   g++ -std=c++17 -O2 -Isrc tools/track_gpx_test.cpp -o track_gpx_test && ./track_gpx_test
+ */
+#include "host/check.h"
+#include <algorithm>
+#include <math.h>
+#include <modules/gps/track_gpx.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#define TRACK_BUFFER_POINTS 64 // as in track_writer.h
+#define TEST_POINTS 100000
+
+typedef std::string Str;
+
+// The part of fs::File the writer uses, over a string
+struct MemFile {
+    Str &data;
+    size_t pos = 0;
+
+    explicit MemFile(Str &data) : data(data) {}
+    size_t size() { return data.size(); }
+    bool seek(uint32_t at) {
+        if (at > data.size()) return false;
+        pos = at;
+        return true;
+    }
+    size_t read(uint8_t *buf, size_t len) {
+        len = std::min(len, data.size() - pos);
+        memcpy(buf, data.data() + pos, len);
+        pos += len;
+        return len;
+    }
+    size_t write(const uint8_t *buf, size_t len) {
+        if (pos > data.size()) return 0;
+        data.replace(pos, std::min(len, data.size() - pos), (const char *)buf, len);
+        pos += len;
+        return len;
+    }
+};
+
+// A drive around a block, with some altitude and fix quality changes
+static TrackPoint makePoint(int i) {
+    TrackPoint pt;
+    pt.lat = (int32_t)lround((-23.5 + 0.01 * sin(i / 500.0)) * 1e7);
+    pt.lng = (int32_t)lround((-46.6 + 0.01 * cos(i / 500.0)) * 1e7);
+    pt.ele = 76000 + (i % 1000) * 3;
+    pt.hdop = 80 + i % 200;
+    pt.sats = 4 + i % 12;
+    pt.reserved = 0;
+    return pt;
+}
+
+// Flushes points [first, last) the way TrackWriter does, reopening the file every time
+static bool writePoints(Str &file, bool isNew, int first, int last) {
+    std::vector<TrackPoint> buffer;
+    for (int i = first; i < last; i++) {
+        buffer.push_back(makePoint(i));
+        if (buffer.size() < TRACK_BUFFER_POINTS && i + 1 < last) continue;
+        MemFile f(file);
+        if (!appendGpxPoints(f, isNew, buffer.data(), buffer.size())) return false;
+        isNew = false;
+        buffer.clear();
+    }
+    return true;
+}
+
+// Tags must nest and close, <?...?> and text are skipped. Returns the <trkpt> count, -1 if malformed.
+static long checkXml(const Str &xml, Str &error) {
+    std::vector<Str> open;
+    long points = 0;
+    bool root = false;
+    for (size_t i = xml.find('<'); i != Str::npos; i = xml.find('<', i)) {
+        size_t end = xml.find('>', i);
+        if (end == Str::npos) {
+            error = "unterminated tag at " + std::to_string(i);
+            return -1;
+        }
+        Str tag = xml.substr(i + 1, end - i - 1);
+        i = end + 1;
+        if (tag[0] == '?') continue;
+        if (tag[0] == '/') {
+            if (open.empty() || open.back() != tag.substr(1)) {
+                error = "</" + tag.substr(1) + "> does not close <" + (open.empty() ? "" : open.back()) + ">";
+                return -1;
+            }
+            open.pop_back();
+            continue;
+        }
+        Str name = tag.substr(0, tag.find_first_of(" \r\n/"));
+        if (open.empty() && root) {
+            error = "<" + name + "> after the root element";
+            return -1;
+        }
+        root = true;
+        if (name == "trkpt") points++;
+        if (tag.back() != '/') open.push_back(name);
+    }
+    if (!open.empty()) {
+        error = "<" + open.back() + "> never closed";
+        return -1;
+    }
+    return points;
+}
+
+static bool endsWithTrailer(const Str &file) {
+    if (file.size() < GPX_TRAILER_LEN) return false;
+    return file.compare(file.size() - GPX_TRAILER_LEN, Str::npos, GPX_TRAILER) == 0;
+}
+
+static void testLongTrack() {
+    Str file;
+    CHECK(writePoints(file, true, 0, TEST_POINTS), "write of %d points failed", TEST_POINTS);
+
+    Str error;
+    long points = checkXml(file, error);
+    CHECK(points == TEST_POINTS, "%d point track: %ld points, %s", TEST_POINTS, points, error.c_str());
+    CHECK(file.compare(0, GPX_HEADER_LEN, GPX_HEADER) == 0, "track does not start with the header");
+    CHECK(endsWithTrailer(file), "track does not end with the trailer");
+
+    // every point in order, at the precision of the text
+    size_t at = 0;
+    for (int i = 0; i < TEST_POINTS; i++) {
+        at = file.find("<trkpt lat=\"", at);
+        if (at == Str::npos) break;
+        double lat = 0, lng = 0;
+        sscanf(file.substr(at, 64).c_str(), "<trkpt lat=\"%lf\" lon=\"%lf\"", &lat, &lng);
+        TrackPoint pt = makePoint(i);
+        if (fabs(lat - pt.lat / 1e7) > 1e-6 || fabs(lng - pt.lng / 1e7) > 1e-6) {
+            CHECK(false, "point %d is %f,%f instead of %f,%f", i, lat, lng, pt.lat / 1e7, pt.lng / 1e7);
+            break;
+        }
+        at++;
+    }
+    printf("%d points, %zu bytes, %zu bytes a point\n", TEST_POINTS, file.size(), file.size() / TEST_POINTS);
+}
+
+static void testForeignTail() {
+    // power lost in the middle of a flush, the file ends inside a point
+    Str file;
+    writePoints(file, true, 0, 100);
+    Str cut = file.substr(0, file.size() - GPX_TRAILER_LEN - 40);
+    Str resumed = cut;
+    CHECK(writePoints(resumed, false, 100, 200), "append to a cut file failed");
+    CHECK(resumed.compare(0, cut.size(), cut) == 0, "append overwrote the end of a cut file");
+    CHECK(endsWithTrailer(resumed), "cut file does not end with the trailer after a flush");
+
+    // closing tags written by another tool, LF only
+    Str other = file.substr(0, file.size() - GPX_TRAILER_LEN) + "    </trkseg>\n  </trk>\n</gpx>\n";
+    Str appended = other;
+    CHECK(writePoints(appended, false, 100, 101), "append to a foreign file failed");
+    CHECK(appended.compare(0, other.size(), other) == 0, "foreign closing tags overwritten");
+
+    // our own trailer is rewound over, the result is the same as one long write
+    Str whole;
+    writePoints(whole, true, 0, 200);
+    Str twice = file;
+    writePoints(twice, false, 100, 200);
+    CHECK(twice == whole, "track written in two sessions differs from one written at once");
+    Str error;
+    CHECK(checkXml(twice, error) == 200, "track written in two sessions: %s", error.c_str());
+}
+
+int main() {
+    testLongTrack();
+    testForeignTail();
+    return checkResult();
+}
@@ -0,0 +1,353 @@
+/*
+ * Host benchmark of the VectorDisplay command stream, single commands against batches.
+ *
+ *   g++ -std=c++17 -O2 -Iinclude tools/vector_display_bench.cpp -o vector_display_bench
+ *   ./vector_display_bench [session.bin] [baud]
+ *
+ * session.bin is a recorded UI session in the tft_logger format (0xAA, size, function,
+ * big endian uint16 arguments, text), what the async serial logger writes. Without it a
+ * built-in menu session is replayed. A frame ends at every fillScreen() and at the end of
+ * the session. The batched stream is decoded again and checked against the single one.
+ */
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#include <VectorDisplay.h>
+
+#define LOG_PACKET_HEADER 0xAA
+// tftFuncs of include/tftLogger.h
+enum {
+    FILLSCREEN = 0,
+    DRAWRECT = 1,
+    FILLRECT = 2,
+    DRAWROUNDRECT = 3,
+    FILLROUNDRECT = 4,
+    DRAWCIRCLE = 5,
+    FILLCIRCLE = 6,
+    DRAWTRIAGLE = 7,
+    FILLTRIANGLE = 8,
+    DRAWELIPSE = 9,
+    FILLELIPSE = 10,
+    DRAWLINE = 11,
+    DRAWCENTRESTRING = 14,
+    DRAWRIGHTSTRING = 15,
+    DRAWSTRING = 16,
+    PRINT = 17,
+    DRAWPIXEL = 19,
+    DRAWFASTVLINE = 20,
+    DRAWFASTHLINE = 21,
+};
+
+class CaptureDisplay : public VectorDisplayClass {
+public:
+    std::vector<uint8_t> out;
+
+    int remoteRead() override { return -1; }
+    void remoteWrite(uint8_t c) override { out.push_back(c); }
+    void remoteWrite(const void *data, size_t n) override {
+        out.insert(out.end(), (const uint8_t *)data, (const uint8_t *)data + n);
+    }
+    size_t remoteAvailable() override { return 0; }
+};
+
+struct Session {
+    std::vector<uint8_t> records;
+    int frames = 0;
+    int skipped = 0;
+};
+
+static void
+writeRecord(Session &session, uint8_t fn, std::initializer_list<uint16_t> values, const char *text) {
+    size_t start = session.records.size();
+    session.records.push_back(LOG_PACKET_HEADER);
+    session.records.push_back(0);
+    session.records.push_back(fn);
+    for (uint16_t v : values) {
+        session.records.push_back(v >> 8);
+        session.records.push_back(v & 0xFF);
+    }
+    if (text) session.records.insert(session.records.end(), text, text + strlen(text));
+    session.records[start + 1] = session.records.size() - start;
+}
+
+// Navigating a 6 entry menu: full redraw on entry, then the two changed rows and the status bar
+static void builtinSession(Session &session) {
+    const char *entries[] = {"WiFi", "BLE", "RF", "RFID", "IR", "Config"};
+    for (int screen = 0; screen < 20; screen++) {
+        writeRecord(session, FILLSCREEN, {TFT_BLACK}, NULL);
+        writeRecord(session, DRAWRECT, {0, 0, 240, 135, TFT_WHITE}, NULL);
+        writeRecord(session, DRAWROUNDRECT, {5, 5, 230, 125, 5, TFT_PURPLE}, NULL);
+        writeRecord(session, DRAWCENTRESTRING, {120, 10, 2, TFT_PURPLE, TFT_BLACK}, "Main Menu");
+        for (int step = 0; step < 12; step++) {
+            int sel = step % 6;
+            for (int i = 0; i < 6; i++) {
+                uint16_t bg = i == sel ? TFT_PURPLE : TFT_BLACK;
+                writeRecord(session, FILLRECT, {10, (uint16_t)(30 + i * 15), 220, 14, bg}, NULL);
+                writeRecord(session, DRAWSTRING, {14, (uint16_t)(32 + i * 15), 1, TFT_WHITE, bg}, entries[i]);
+            }
+            writeRecord(session, FILLRECT, {0, 130, 240, 5, TFT_BLACK}, NULL);
+            writeRecord(session, DRAWRIGHTSTRING, {235, 2, 1, TFT_WHITE, TFT_BLACK}, "12:00      ");
+            writeRecord(session, DRAWFASTHLINE, {0, 20, 240, TFT_PURPLE}, NULL);
+        }
+    }
+}
+
+static uint16_t arg(const uint8_t *record, int i) { return record[3 + i * 2] << 8 | record[4 + i * 2]; }
+
+static void replay(const Session &session, VectorDisplayClass &tft) {
+    const std::vector<uint8_t> &r = session.records;
+    bool drawn = false;
+    for (size_t pos = 0; pos + 3 <= r.size() && r[pos] == LOG_PACKET_HEADER;) {
+        const uint8_t *rec = &r[pos];
+        uint8_t size = rec[1];
+        if (size < 3 || pos + size > r.size()) break;
+        pos += size;
+
+        if (rec[2] == FILLSCREEN && drawn) tft.update();
+        drawn = true;
+        switch (rec[2]) {
+            case FILLSCREEN: tft.fillScreen(arg(rec, 0)); break;
+            case DRAWRECT:
+                tft.drawRect(arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3), arg(rec, 4));
+                break;
+            case FILLRECT:
+                tft.fillRect(arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3), arg(rec, 4));
+                break;
+            case DRAWROUNDRECT:
+                tft.drawRoundRect(
+                    arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3), arg(rec, 4), arg(rec, 5)
+                );
+                break;
+            case FILLROUNDRECT:
+                tft.fillRoundRect(
+                    arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3), arg(rec, 4), arg(rec, 5)
+                );
+                break;
+            case DRAWCIRCLE: tft.drawCircle(arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3)); break;
+            case FILLCIRCLE: tft.fillCircle(arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3)); break;
+            case FILLTRIANGLE:
+                tft.fillTriangle(
+                    arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3), arg(rec, 4), arg(rec, 5), arg(rec, 6)
+                );
+                break;
+            case FILLELIPSE:
+                tft.fillEllipse(arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3), arg(rec, 4));
+                break;
+            case DRAWLINE:
+                tft.drawLine(arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3), arg(rec, 4));
+                break;
+            case DRAWPIXEL: tft.drawPixel(arg(rec, 0), arg(rec, 1), arg(rec, 2)); break;
+            case DRAWFASTVLINE: tft.drawFastVLine(arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3)); break;
+            case DRAWFASTHLINE: tft.drawFastHLine(arg(rec, 0), arg(rec, 1), arg(rec, 2), arg(rec, 3)); break;
+            case DRAWCENTRESTRING:
+            case DRAWRIGHTSTRING:
+            case DRAWSTRING:
+            case PRINT: {
+                std::string text((const char *)rec + 13, size - 13);
+                tft.setTextSize(arg(rec, 2));
+                tft.setTextColor(arg(rec, 3), arg(rec, 4));
+                tft.setCursor(arg(rec, 0), arg(rec, 1));
+                tft.write(text.c_str());
+                break;
+            }
+            default: break;
+        }
+    }
+    tft.update();
+}
+
+static void countFrames(Session &session) {
+    const std::vector<uint8_t> &r = session.records;
+    bool drawn = false;
+    for (size_t pos = 0; pos + 3 <= r.size() && r[pos] == LOG_PACKET_HEADER && r[pos + 1] >= 3;) {
+        uint8_t fn = r[pos + 2];
+        if (fn == FILLSCREEN && drawn) session.frames++;
+        if (fn == DRAWTRIAGLE || fn == DRAWELIPSE || (fn > DRAWLINE && fn < DRAWCENTRESTRING) || fn == 18 ||
+            fn > DRAWFASTHLINE)
+            session.skipped++;
+        drawn = true;
+        pos += r[pos + 1];
+    }
+    session.frames++;
+}
+
+// Length of the command at `p`, -1 for the ones the replay never sends
+static int commandLength(const uint8_t *p, size_t n) {
+    switch (p[0]) {
+        case 'C':
+        case 'E':
+        case 'F': return 3;
+        case 'D': return 4;
+        case 'Y': return 5;
+        case 'A': return 6;
+        case 'B': return 8;
+        case 'L':
+        case 'R': return 11;
+        case 'Q': return 14;
+        case 'J':
+        case 'I': return 9;
+        case 'H':
+        case 'P': return 7;
+        case 'G': return 15;
+        case 'S': return 18;
+        case 'Z': return 19;
+        case 'N':
+        case 'O': return n < 4 ? -1 : 5 + (p[2] | p[3] << 8) * 4;
+        case 'M':
+        case 'U':
+        case 'T': {
+            for (size_t i = p[0] == 'T' ? 6 : p[0] == 'U' ? 3 : 2; i < n; i++)
+                if (p[i] == 0) return i + 2;
+            return -1;
+        }
+        default: return -1;
+    }
+}
+
+// Turns the batches back into single commands
+static bool decode(const std::vector<uint8_t> &in, std::vector<uint8_t> &out) {
+    size_t pos = 0;
+    while (pos < in.size()) {
+        if (in[pos] != 'X') {
+            // polygons too large for a batch go out on their own
+            int n = commandLength(&in[pos], in.size() - pos);
+            if (n < 0 || pos + n > in.size()) return false;
+            out.insert(out.end(), in.begin() + pos, in.begin() + pos + n);
+            pos += n;
+            continue;
+        }
+        VectorDisplayBatchHeader header;
+        if (pos + 2 + sizeof(header) > in.size() || in[pos + 1] != ('X' ^ 0xFF)) return false;
+        memcpy(&header, &in[pos + 2], sizeof(header));
+        const uint8_t *payload = &in[pos + 2 + sizeof(header)];
+        uint16_t crc;
+        if (pos + 2 + sizeof(header) + header.length + sizeof(crc) > in.size()) return false;
+        memcpy(&crc, payload + header.length, sizeof(crc));
+
+        uint16_t check = 0xFFFF;
+        for (const uint8_t *p = &in[pos + 2]; p < payload + header.length; p++) {
+            check ^= (uint16_t)*p << 8;
+            for (int i = 0; i < 8; i++) check = check & 0x8000 ? (check << 1) ^ 0x1021 : check << 1;
+        }
+        if (check != crc) return false;
+        pos += 2 + sizeof(header) + header.length + sizeof(crc);
+
+        std::vector<uint8_t> raw;
+        if (header.flags & VECTOR_DISPLAY_BATCH_RLE) {
+            for (uint16_t i = 0; i < header.length;) {
+                uint8_t n = payload[i++];
+                if (n < 128) {
+                    raw.insert(raw.end(), payload + i, payload + i + n + 1);
+                    i += n + 1;
+                } else if (n > 128) {
+                    raw.insert(raw.end(), 257 - n, payload[i++]);
+                }
+            }
+        } else {
+            raw.assign(payload, payload + header.length);
+        }
+        if (raw.size() != header.rawLength) return false;
+
+        size_t last = 0, lastLength = 0;
+        std::vector<size_t> literals, literalLengths;
+        uint16_t commands = 0;
+        for (size_t i = 0; i < raw.size();) {
+            if (raw[i] == VECTOR_DISPLAY_BATCH_REFERENCE) {
+                if (i + 1 >= raw.size() || raw[i + 1] == 0 || raw[i + 1] > literals.size()) return false;
+                last = literals[literals.size() - raw[i + 1]];
+                lastLength = literalLengths[literals.size() - raw[i + 1]];
+                out.insert(out.end(), raw.begin() + last, raw.begin() + last + lastLength);
+                commands++;
+                i += 2;
+                continue;
+            }
+            if (raw[i] == VECTOR_DISPLAY_BATCH_REPEAT) {
+                if (lastLength == 0 || i + 1 >= raw.size()) return false;
+                for (int r = 0; r < raw[i + 1]; r++) {
+                    out.insert(out.end(), raw.begin() + last, raw.begin() + last + lastLength);
+                    commands++;
+                }
+                i += 2;
+                continue;
+            }
+            int n = commandLength(&raw[i], raw.size() - i);
+            if (n < 0 || i + n > raw.size()) return false;
+            out.insert(out.end(), raw.begin() + i, raw.begin() + i + n);
+            literals.push_back(i);
+            literalLengths.push_back(n);
+            last = i;
+            lastLength = n;
+            commands++;
+            i += n;
+        }
+        if (commands != header.commands) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Session session;
+    if (argc > 1) {
+        FILE *f = fopen(argv[1], "rb");
+        if (!f) {
+            fprintf(stderr, "Cannot open %s\n", argv[1]);
+            return 1;
+        }
+        uint8_t buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            session.records.insert(session.records.end(), buf, buf + n);
+        fclose(f);
+    } else {
+        builtinSession(session);
+    }
+    uint32_t baud = argc > 2 ? atoi(argv[2]) : 115200;
+    countFrames(session);
+
+    CaptureDisplay single, batched;
+    single.setWaitForAck(false);
+    batched.setWaitForAck(false);
+    batched.setBatching(true);
+
+    auto t0 = std::chrono::steady_clock::now();
+    replay(session, single);
+    auto t1 = std::chrono::steady_clock::now();
+    replay(session, batched);
+    auto t2 = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> decoded;
+    bool ok = decode(batched.out, decoded) && decoded == single.out;
+
+    printf("Session: %zu bytes of records, %d frames", session.records.size(), session.frames);
+    if (session.skipped) printf(", %d records not replayed", session.skipped);
+    printf("\nLink: %u baud, 10 bits per byte\n\n", baud);
+    printf("Mode       Commands    Bytes      Packets  Bytes/frame  Frames/s  Encode us/frame\n");
+    CaptureDisplay *modes[] = {&single, &batched};
+    double encode[] = {
+        std::chrono::duration<double, std::micro>(t1 - t0).count(),
+        std::chrono::duration<double, std::micro>(t2 - t1).count()
+    };
+    for (int i = 0; i < 2; i++) {
+        const VectorDisplayBatchStats &s = modes[i]->batchStats;
+        double perFrame = (double)modes[i]->out.size() / session.frames;
+        printf(
+            "%-8s %10u %8zu %12u %12.0f %9.1f %16.1f\n",
+            i == 0 ? "single" : "batched",
+            s.commands,
+            modes[i]->out.size(),
+            i == 0 ? s.commands : s.batches,
+            perFrame,
+            baud / 10.0 / perFrame,
+            encode[i] / session.frames
+        );
+    }
+    const VectorDisplayBatchStats &s = batched.batchStats;
+    printf(
+        "\nRepeat and reference records: %u commands, %.1f%% of the single stream\n",
+        s.repeats,
+        100.0 * batched.out.size() / single.out.size()
+    );
+    printf("Decoded batches %s the single command stream\n", ok ? "match" : "DO NOT MATCH");
+    return ok ? 0 : 2;
+}
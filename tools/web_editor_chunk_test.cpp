@@ -0,0 +1,269 @@
+/*
+ * Host test of the WebUI editor ranges and chunked saves: files read back in
+ * ranges, edited and saved in chunks must come out byte for byte, whatever
+ * falls on a chunk boundary, on a LittleFS-like and on a FAT-like filesystem.
+ *
+ *   g++ -std=c++17 -O2 -Isrc tools/web_editor_chunk_test.cpp -o web_editor_chunk_test \
+ *       && ./web_editor_chunk_test
+ *
+ * The device side calls the helpers of src/core/wifi/web_edit_chunks.h the way
+ * sendFileRange, handleEditChunk and finishEditChunk of web_editor.cpp do, the
+ * client side follows readEditorFile and writeEditorFile of index.js.
+ */
+#include "host/check.h"
+#include <core/wifi/web_edit_chunks.h>
+#include <map>
+#include <stdio.h>
+#include <string>
+
+typedef std::string Str;
+
+// An open file of MemFs, writes append like the temp file writes of the editor
+struct MemFile {
+    Str *data = nullptr;
+
+    explicit operator bool() const { return data != nullptr; }
+    size_t size() { return data->size(); }
+    size_t write(const uint8_t *buf, size_t len) {
+        data->append((const char *)buf, len);
+        return len;
+    }
+    void close() { data = nullptr; }
+};
+
+// In memory filesystem, FAT refuses to rename over an existing file
+struct MemFs {
+    std::map<Str, Str> files;
+    bool fat = false;
+    int renames = 0;
+    int failRename = -1; // index of a rename that fails, like a full or yanked card
+    int powerLoss = -1;  // index of the rename the device never gets to
+
+    bool exists(const Str &path) { return files.count(path) > 0; }
+    MemFile open(const Str &path, const char *mode, bool = false) {
+        if (mode[0] == 'w') files[path].clear();
+        MemFile f;
+        f.data = &files[path]; // "a" creates the file too
+        return f;
+    }
+    bool remove(const Str &path) { return files.erase(path) > 0; }
+    bool rename(const Str &from, const Str &to) {
+        int n = renames++;
+        if (n == failRename || (powerLoss >= 0 && n >= powerLoss)) return false;
+        if (!exists(from) || (fat && exists(to))) return false;
+        files[to] = files[from];
+        files.erase(from);
+        return true;
+    }
+};
+
+// The endpoints, answers are HTTP status codes
+struct Device {
+    MemFs fs;
+
+    int read(const Str &path, uint32_t offset, long length, Str &body, uint32_t &size) {
+        if (!fs.exists(path) && !webEditRestore(fs, path)) return 404;
+        const Str &file = fs.files[path];
+        size = file.size();
+        size_t len;
+        if (!webEditRange(size, offset, length, len)) return 416;
+        body = file.substr(offset, len);
+        return 200;
+    }
+
+    int write(const Str &path, uint32_t offset, const Str &body, bool final, uint32_t &expected) {
+        Str tmp = path + ".tmp";
+        MemFile file;
+        int status = webEditOpenChunk(fs, tmp, offset, file, expected);
+        if (status != 200) return status;
+        file.write((const uint8_t *)body.data(), body.size());
+        file.close();
+        return webEditFinishChunk(fs, tmp, path, final);
+    }
+};
+
+static bool readFile(Device &dev, const Str &path, long chunk, Str &text) {
+    text.clear();
+    uint32_t offset = 0, size = 0;
+    do {
+        Str body;
+        if (dev.read(path, offset, chunk, body, size) != 200) return false;
+        if (body.empty()) break;
+        text += body;
+        offset += body.size();
+    } while (offset < size);
+    return true;
+}
+
+static bool writeFile(Device &dev, const Str &path, const Str &data, size_t chunk) {
+    size_t offset = 0;
+    do {
+        Str piece = data.substr(offset, chunk);
+        bool final = offset + piece.size() >= data.size();
+        uint32_t expected;
+        if (dev.write(path, offset, piece, final, expected) != 200) return false;
+        offset += piece.size();
+    } while (offset < data.size());
+    return true;
+}
+
+// Ranged search, keeps the last needle - 1 bytes of a range to find matches split over two
+static long findInRanges(Device &dev, const Str &path, const Str &needle, long chunk) {
+    Str carry;
+    uint32_t offset = 0, size = 0;
+    do {
+        Str body;
+        if (dev.read(path, offset, chunk, body, size) != 200 || body.empty()) return -1;
+        Str window = carry + body;
+        size_t at = window.find(needle);
+        if (at != Str::npos) return (long)(offset - carry.size() + at);
+        size_t keep = needle.size() > 1 ? needle.size() - 1 : 0;
+        carry = window.substr(window.size() > keep ? window.size() - keep : 0);
+        offset += body.size();
+    } while (offset < size);
+    return -1;
+}
+
+// Text with 2, 3 and 4 byte UTF-8 characters so that boundaries land inside them
+static Str makeText(size_t size) {
+    static const char *words[] = {"config ", "\xc3\xa9t\xc3\xa9 ", "\xe2\x82\xac\xe2\x9c\x93 ",
+                                  "\xf0\x9f\x90\x9f ", "\n"};
+    Str text;
+    for (size_t i = 0; text.size() < size; i++) text += words[(i * 7 + i / 3) % 5];
+    text.resize(size);
+    return text;
+}
+
+static void testRange() {
+    size_t len = 99;
+    CHECK(webEditRange(100, 0, 40, len) && len == 40, "range at the start");
+    CHECK(webEditRange(100, 90, 40, len) && len == 10, "range cut at the end of the file");
+    CHECK(webEditRange(100, 100, 40, len) && len == 0, "range at the end of the file");
+    CHECK(!webEditRange(100, 101, 40, len), "range past the end of the file");
+    CHECK(webEditRange(100, 10, -5, len) && len == 0, "negative length");
+    CHECK(webEditRange(1 << 20, 0, 1 << 20, len) && len == WEB_EDIT_MAX_CHUNK, "range over the maximum");
+}
+
+static void testBoundaries(bool fat) {
+    const long chunks[] = {1, 3, 7, 1000, WEB_EDIT_CHUNK, WEB_EDIT_MAX_CHUNK + 1};
+    const size_t sizes[] = {
+        0, 1, 999, 1000, 1001, 3000, WEB_EDIT_CHUNK - 1, WEB_EDIT_CHUNK, 3 * WEB_EDIT_CHUNK + 2
+    };
+    for (long chunk : chunks) {
+        for (size_t size : sizes) {
+            if (chunk < 16 && size > 4000) continue; // one request per byte, nothing new to learn
+            Device dev;
+            dev.fs.fat = fat;
+            Str original = makeText(size);
+            dev.fs.files["/f.txt"] = original;
+
+            Str text;
+            CHECK(
+                readFile(dev, "/f.txt", chunk, text) && text == original,
+                "%s: read of %zu bytes in %ld byte ranges differs",
+                fat ? "FAT" : "LittleFS",
+                size,
+                chunk
+            );
+
+            // replace the bytes around every range boundary, the edit spans two ranges
+            Str edited = text;
+            for (size_t at = chunk; at + 2 <= edited.size(); at += chunk) edited.replace(at - 1, 2, "<>");
+            edited += "\xe2\x82\xac";
+            size_t saveChunk = chunk < WEB_EDIT_MAX_CHUNK ? chunk : WEB_EDIT_CHUNK;
+            CHECK(
+                writeFile(dev, "/f.txt", edited, saveChunk) && dev.fs.files["/f.txt"] == edited,
+                "%s: save of %zu bytes in %zu byte chunks differs",
+                fat ? "FAT" : "LittleFS",
+                edited.size(),
+                saveChunk
+            );
+            CHECK(
+                dev.fs.files.size() == 1,
+                "%s: save left %zu files behind",
+                fat ? "FAT" : "LittleFS",
+                dev.fs.files.size() - 1
+            );
+
+            // a needle across each boundary, found at its first position
+            if (size < 2 * (size_t)chunk || chunk < 8) continue;
+            Str needle = edited.substr(chunk - 3, 6);
+            CHECK(
+                findInRanges(dev, "/f.txt", needle, chunk) == (long)edited.find(needle),
+                "search across a %ld byte range boundary",
+                chunk
+            );
+            Str last = edited.substr(edited.size() - 5);
+            CHECK(
+                findInRanges(dev, "/f.txt", last, chunk) == (long)edited.find(last),
+                "search of the end of a %zu byte file",
+                edited.size()
+            );
+        }
+    }
+}
+
+static void testResume() {
+    Device dev;
+    dev.fs.files["/f.txt"] = "old";
+    Str data = makeText(10000);
+    uint32_t expected = 0;
+
+    CHECK(dev.write("/f.txt", 0, data.substr(0, 4000), false, expected) == 200, "first chunk");
+    // the answer to the second chunk got lost, the client sends it again
+    CHECK(dev.write("/f.txt", 4000, data.substr(4000, 4000), false, expected) == 200, "second chunk");
+    CHECK(
+        dev.write("/f.txt", 4000, data.substr(4000, 4000), false, expected) == 409 && expected == 8000,
+        "repeated chunk gives %u, not the 8000 to resume from",
+        expected
+    );
+    CHECK(dev.fs.files["/f.txt"] == "old", "unfinished save changed the file");
+    CHECK(dev.write("/f.txt", expected, data.substr(expected), true, expected) == 200, "last chunk");
+    CHECK(dev.fs.files["/f.txt"] == data, "resumed save differs");
+}
+
+static void testFatReplace() {
+    Device dev;
+    dev.fs.fat = true;
+    dev.fs.files["/f.txt"] = "old";
+
+    // the temp file cannot take the place of the old one: the old one comes back
+    dev.fs.failRename = 2;
+    CHECK(!writeFile(dev, "/f.txt", "new", 2), "failed rename reported as saved");
+    CHECK(dev.fs.files["/f.txt"] == "old" && !dev.fs.exists("/f.txt.bak"), "failed rename lost the old file");
+
+    // power lost between the two renames: the old contents wait in the .bak
+    dev.fs.files.erase("/f.txt.tmp");
+    dev.fs.renames = 0;
+    dev.fs.failRename = -1;
+    dev.fs.powerLoss = 2;
+    writeFile(dev, "/f.txt", "new", 2);
+    CHECK(!dev.fs.exists("/f.txt") && dev.fs.files["/f.txt.bak"] == "old", "power loss lost the old file");
+
+    // the next read finds it again
+    dev.fs.powerLoss = -1;
+    Str text;
+    CHECK(readFile(dev, "/f.txt", 2, text) && text == "old", "old file not restored on read");
+    CHECK(!dev.fs.exists("/f.txt.bak"), "restored file still in the .bak");
+
+    // or the next save, which then replaces it as usual
+    dev.fs.files.erase("/f.txt.tmp");
+    dev.fs.renames = 0;
+    dev.fs.powerLoss = 2;
+    writeFile(dev, "/f.txt", "new", 2);
+    dev.fs.powerLoss = -1;
+    CHECK(writeFile(dev, "/f.txt", "newer", 2), "save after a power loss failed");
+    CHECK(
+        dev.fs.files["/f.txt"] == "newer" && dev.fs.files.size() == 1,
+        "save after a power loss left files behind"
+    );
+}
+
+int main() {
+    testRange();
+    testBoundaries(false);
+    testBoundaries(true);
+    testResume();
+    testFatReplace();
+    return checkResult();
+}